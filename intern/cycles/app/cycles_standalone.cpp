@@ -19,9 +19,12 @@
 #include "device/device.h"
 #include "render/buffers.h"
 #include "render/camera.h"
+#include "render/film.h"
 #include "render/integrator.h"
 #include "render/scene.h"
 #include "render/session.h"
+#include "render/stats.h"
+#include "render/tile_output.h"
 
 #include "util/util_args.h"
 #include "util/util_foreach.h"
@@ -54,6 +57,11 @@ struct Options {
   bool quiet;
   bool show_help, interactive, pause;
   string output_path;
+  bool stream_output, output_half;
+  string pass_names;
+  vector<Pass> passes;
+  TileImageOutput tile_output;
+  string profile_path;
 } options;
 
 static void session_print(const string &str)
@@ -120,10 +128,74 @@ static BufferParams &session_buffer_params()
   buffer_params.height = options.height;
   buffer_params.full_width = options.width;
   buffer_params.full_height = options.height;
+  buffer_params.passes = options.passes;
 
   return buffer_params;
 }
 
+static void write_render_tile(RenderTile &rtile)
+{
+  rtile.buffers->copy_from_device();
+
+  if (!options.tile_output.write_tile(rtile)) {
+    session_print(options.tile_output.error);
+  }
+}
+
+static bool tile_output_open()
+{
+  TileImageOutput &tile_output = options.tile_output;
+  tile_output.filepath = options.output_path;
+  tile_output.use_half = options.output_half;
+  tile_output.tile_size = options.session_params.tile_size;
+  tile_output.exposure = options.scene->film->get_exposure();
+
+  if (!tile_output.open(session_buffer_params(), options.session_params.samples)) {
+    fprintf(stderr, "%s\n", tile_output.error.c_str());
+    return false;
+  }
+
+  options.session->write_render_tile_cb = write_render_tile;
+  return true;
+}
+
+static bool passes_parse()
+{
+  /* Combined is always rendered, for display and for writing the output image. */
+  Pass::add(PASS_COMBINED, options.passes);
+
+  if (options.pass_names.empty()) {
+    return true;
+  }
+
+  const NodeEnum *pass_types = Pass::get_node_type()->find_input(ustring("type"))->enum_values;
+
+  vector<string> tokens;
+  string_split(tokens, options.pass_names, ",");
+
+  foreach (const string &token, tokens) {
+    /* Passes are given by type, optionally followed by a name, as needed for AOVs. */
+    const size_t separator = token.find(':');
+    const ustring type_name(token.substr(0, separator));
+    const string name = (separator == string::npos) ? "" : token.substr(separator + 1);
+
+    if (!pass_types->exists(type_name)) {
+      fprintf(stderr, "Unknown pass type: %s\n", type_name.c_str());
+      return false;
+    }
+
+    const PassType type = (PassType)(*pass_types)[type_name];
+    if ((type == PASS_AOV_COLOR || type == PASS_AOV_VALUE) && name.empty()) {
+      fprintf(stderr, "AOV pass needs a name: %s:<name>\n", type_name.c_str());
+      return false;
+    }
+
+    Pass::add(type, options.passes, name.empty() ? NULL : name.c_str());
+  }
+
+  return true;
+}
+
 static void scene_init()
 {
   options.scene = new Scene(options.scene_params, options.session->device);
@@ -131,6 +203,9 @@ static void scene_init()
   /* Read XML */
   xml_read_file(options.scene, options.filepath.c_str());
 
+  /* Passes */
+  options.scene->film->tag_passes_update(options.scene, options.passes);
+
   /* Camera width/height override? */
   if (!(options.width == 0 || options.height == 0)) {
     options.scene->camera->set_full_width(options.width);
@@ -147,7 +222,10 @@ static void scene_init()
 
 static void session_init()
 {
-  options.session_params.write_render_cb = write_render;
+  /* When streaming tiles to the output file, no full frame buffer is kept for writing. */
+  if (!options.stream_output) {
+    options.session_params.write_render_cb = write_render;
+  }
   options.session = new Session(options.session_params);
 
   if (options.session_params.background && !options.quiet)
@@ -161,17 +239,55 @@ static void session_init()
   scene_init();
   options.session->scene = options.scene;
 
+  if (options.stream_output && !tile_output_open()) {
+    exit(EXIT_FAILURE);
+  }
+
   options.session->reset(session_buffer_params(), options.session_params.samples);
   options.session->start();
 }
 
+static void write_profile()
+{
+  RenderStats stats;
+  options.session->collect_statistics(&stats);
+
+  if (!stats.has_profiling) {
+    fprintf(stderr, "Profiling information not available (only works with CPU rendering)\n");
+    return;
+  }
+
+  string json = stats.json_report();
+  if (!path_write_text(options.profile_path, json)) {
+    fprintf(stderr, "Failed to write profile to %s\n", options.profile_path.c_str());
+  }
+}
+
 static void session_exit()
 {
+  if (options.session && options.session_params.background && !options.quiet) {
+    double total_time, render_time;
+    options.session->progress.get_time(total_time, render_time);
+    if (render_time > 0.0) {
+      printf("\nRender time: %.2fs, %.0f samples per second",
+             render_time,
+             options.session->progress.get_pixel_samples() / render_time);
+    }
+  }
+
+  if (options.session && !options.profile_path.empty()) {
+    write_profile();
+  }
+
   if (options.session) {
     delete options.session;
     options.session = NULL;
   }
 
+  if (options.tile_output.is_open() && !options.tile_output.close()) {
+    fprintf(stderr, "%s\n", options.tile_output.error.c_str());
+  }
+
   if (options.session_params.background && !options.quiet) {
     session_print("Finished Rendering.");
     printf("\n");
@@ -414,6 +530,21 @@ static void options_parse(int argc, const char **argv)
              "--output %s",
              &options.output_path,
              "File path to write output image",
+             "--stream-output",
+             &options.stream_output,
+             "Write finished tiles directly to a tiled OpenEXR output file, without keeping the "
+             "full image in memory (background mode only)",
+             "--half",
+             &options.output_half,
+             "Write half float channels when streaming output",
+             "--passes %s",
+             &options.pass_names,
+             "Comma separated render passes to write when streaming output, for example "
+             "normal,diffuse_color,aov_value:name",
+             "--profile %s",
+             &options.profile_path,
+             "Write per-shader, per-object and per-ray-type profiling information to a JSON file "
+             "in Chrome trace format (CPU only)",
              "--threads %d",
              &options.session_params.threads,
              "CPU Rendering Threads",
@@ -490,8 +621,11 @@ static void options_parse(int argc, const char **argv)
   options.session_params.background = true;
 #endif
 
-  /* Use progressive rendering */
-  options.session_params.progressive = true;
+  options.session_params.use_profiling = !options.profile_path.empty();
+
+  /* Use progressive rendering, except when streaming tiles since progressive rendering keeps
+   * the buffers of all tiles around until the last sample. */
+  options.session_params.progressive = !options.stream_output;
 
   /* find matching device */
   DeviceType device_type = Device::type_from_string(devicename.c_str());
@@ -527,6 +661,18 @@ static void options_parse(int argc, const char **argv)
     fprintf(stderr, "No file path specified\n");
     exit(EXIT_FAILURE);
   }
+  else if (options.stream_output &&
+           (!options.session_params.background || options.output_path == "")) {
+    fprintf(stderr, "Streaming output requires background mode and an output file path\n");
+    exit(EXIT_FAILURE);
+  }
+  else if (!options.pass_names.empty() && !options.stream_output) {
+    fprintf(stderr, "Render passes can only be written when streaming output\n");
+    exit(EXIT_FAILURE);
+  }
+  else if (!passes_parse()) {
+    exit(EXIT_FAILURE);
+  }
 
   /* For smoother Viewport */
   options.session_params.start_resolution = 64;
@@ -71,6 +71,11 @@ def _configure_argument_parser():
     parser.add_argument("--cycles-print-stats",
                         help="Print rendering statistics to stderr",
                         action='store_true')
+    parser.add_argument("--cycles-profile",
+                        help="Write per-shader, per-object and per-ray-type profiling information "
+                             "of CPU renders to a JSON file in Chrome trace format, with the view "
+                             "layer name and frame number appended",
+                        default=None)
     parser.add_argument("--cycles-device",
                         help="Set the device to use for Cycles, overriding user preferences and the scene setting."
                              "Valid options are 'CPU', 'CUDA', 'OPTIX' or 'OPENCL'."
@@ -108,6 +113,10 @@ def _parse_command_line():
         import _cycles
         _cycles.enable_print_stats()
 
+    if args.cycles_profile:
+        import _cycles
+        _cycles.set_profile_output(args.cycles_profile)
+
     if args.cycles_device:
         import _cycles
         _cycles.set_device_override(args.cycles_device)
@@ -399,6 +399,12 @@ class CyclesRenderSettings(bpy.types.PropertyGroup):
         min=0.0, max=1.0,
         default=0.01,
     )
+    use_light_tree: BoolProperty(
+        name="Light Tree",
+        description="Pick lights based on their distance to the shading point, which reduces noise in scenes "
+        "with many lights. Not used when sampling all lights with Branched Path Tracing",
+        default=False,
+    )
 
     use_adaptive_sampling: BoolProperty(
         name="Use Adaptive Sampling",
@@ -419,6 +425,11 @@ class CyclesRenderSettings(bpy.types.PropertyGroup):
         min=0, max=4096,
         default=0,
     )
+    use_adaptive_denoising_estimate: BoolProperty(
+        name="Denoising Estimate",
+        description="Stop sampling tiles once the noise left after denoising is estimated to be below the threshold. Requires NLM denoising and only works on the CPU",
+        default=False,
+    )
 
     min_light_bounces: IntProperty(
         name="Min Light Bounces",
@@ -695,6 +706,11 @@ class CyclesRenderSettings(bpy.types.PropertyGroup):
         description="Use special type BVH optimized for hair (uses more ram but renders faster)",
         default=True,
     )
+    debug_use_hair_leaf_keys: BoolProperty(
+        name="Use Hair Leaf Keys",
+        description="Store hair control points in BVH leaves to test several segments at once (uses more ram)",
+        default=False,
+    )
     debug_bvh_time_steps: IntProperty(
         name="BVH Time Steps",
         description="Split BVH primitives by this number of time steps to speed up render time in cost of memory",
@@ -716,6 +732,12 @@ class CyclesRenderSettings(bpy.types.PropertyGroup):
         "but time can be saved by manually stopping the render when the noise is low enough)",
         default=False,
     )
+    use_adaptive_tiles: BoolProperty(
+        name="Adaptive Tiles",
+        description="Split the remaining tiles at the end of the render, so that threads which "
+        "run out of tiles can help finishing the last ones instead of waiting for them (CPU only)",
+        default=True,
+    )
 
     bake_type: EnumProperty(
         name="Bake Type",
@@ -808,6 +830,32 @@ class CyclesRenderSettings(bpy.types.PropertyGroup):
         items=enum_texture_limit
     )
 
+    texture_downscale_limit_render: IntProperty(
+        name="Render Texture Downscale Limit",
+        description="Downscale the largest image textures in final rendering until all textures fit into this "
+        "amount of memory (in megabytes, 0 for no limit)",
+        min=0, max=1024 * 1024,
+        default=0,
+        subtype='UNSIGNED',
+    )
+
+    texture_cache_size: IntProperty(
+        name="Texture Cache",
+        description="Sample image files on demand through a tiled texture cache of this size in final rendering, "
+        "instead of loading them fully into memory (in megabytes, 0 to disable). Only used for CPU rendering "
+        "with SVM",
+        min=0, max=1024 * 1024,
+        default=0,
+        subtype='UNSIGNED',
+    )
+
+    use_compact_geometry: BoolProperty(
+        name="Compact Geometry",
+        description="Store vertex normals, UV maps and triangle indices in a reduced precision encoding, "
+        "lowering memory usage of large meshes at a small cost in render time",
+        default=False,
+    )
+
     use_fast_gi: BoolProperty(
         name="Fast GI Approximation",
         description="Approximate diffuse indirect light with background tinted ambient occlusion. This provides fast alternative to full global illumination, for interactive viewport rendering or final renders with reduced quality",
@@ -845,6 +893,8 @@ class CyclesRenderSettings(bpy.types.PropertyGroup):
         default='EMBREE',
     )
     debug_use_cpu_split_kernel: BoolProperty(name="Split Kernel", default=False)
+    debug_cpu_split_kernel_batch_size: IntProperty(name="Split Kernel Batch Size", default=256, min=1, max=65536)
+    debug_use_cpu_svm_specialization: BoolProperty(name="SVM Specialization", default=True)
 
     debug_use_cuda_adaptive_compile: BoolProperty(name="Adaptive Compile", default=False)
     debug_use_cuda_split_kernel: BoolProperty(name="Split Kernel", default=False)
@@ -248,6 +248,7 @@ class CYCLES_RENDER_PT_sampling_adaptive(CyclesButtonsPanel, Panel):
         col = layout.column(align=True)
         col.prop(cscene, "adaptive_threshold", text="Noise Threshold")
         col.prop(cscene, "adaptive_min_samples", text="Min Samples")
+        col.prop(cscene, "use_adaptive_denoising_estimate")
 
 
 class CYCLES_RENDER_PT_sampling_denoising(CyclesButtonsPanel, Panel):
@@ -321,6 +322,7 @@ class CYCLES_RENDER_PT_sampling_advanced(CyclesButtonsPanel, Panel):
         col.prop(cscene, "min_light_bounces")
         col.prop(cscene, "min_transparent_bounces")
         col.prop(cscene, "light_sampling_threshold", text="Light Threshold")
+        col.prop(cscene, "use_light_tree")
 
         if cscene.progressive != 'PATH' and use_branched_path(context):
             col = layout.column(align=True)
@@ -730,6 +732,11 @@ class CYCLES_RENDER_PT_performance_tiles(CyclesButtonsPanel, Panel):
         sub.active = not rd.use_save_buffers and not cscene.use_adaptive_sampling
         sub.prop(cscene, "use_progressive_refine")
 
+        sub = col.column()
+        sub.active = (use_cpu(context) and not rd.use_save_buffers and
+                      not cscene.use_progressive_refine)
+        sub.prop(cscene, "use_adaptive_tiles")
+
 
 class CYCLES_RENDER_PT_performance_acceleration_structure(CyclesButtonsPanel, Panel):
     bl_label = "Acceleration Structure"
@@ -759,6 +766,7 @@ class CYCLES_RENDER_PT_performance_acceleration_structure(CyclesButtonsPanel, Pa
         sub = col.column()
         sub.active = not use_embree
         sub.prop(cscene, "debug_use_hair_bvh")
+        sub.prop(cscene, "debug_use_hair_leaf_keys")
         sub = col.column()
         sub.active = not cscene.debug_use_spatial_splits and not use_embree
         sub.prop(cscene, "debug_bvh_time_steps")
@@ -774,12 +782,18 @@ class CYCLES_RENDER_PT_performance_final_render(CyclesButtonsPanel, Panel):
         layout.use_property_decorate = False
 
         scene = context.scene
+        cscene = scene.cycles
         rd = scene.render
 
         col = layout.column()
 
         col.prop(rd, "use_save_buffers")
         col.prop(rd, "use_persistent_data", text="Persistent Data")
+        col.prop(cscene, "use_compact_geometry")
+
+        sub = col.column()
+        sub.active = use_cpu(context) and not cscene.shading_system
+        sub.prop(cscene, "texture_cache_size", text="Texture Cache (MB)")
 
 
 class CYCLES_RENDER_PT_performance_viewport(CyclesButtonsPanel, Panel):
@@ -2019,6 +2033,10 @@ class CYCLES_RENDER_PT_debug(CyclesButtonsPanel, Panel):
         row.prop(cscene, "debug_use_cpu_avx2", toggle=True)
         col.prop(cscene, "debug_bvh_layout")
         col.prop(cscene, "debug_use_cpu_split_kernel")
+        sub = col.column()
+        sub.active = cscene.debug_use_cpu_split_kernel
+        sub.prop(cscene, "debug_cpu_split_kernel_batch_size")
+        col.prop(cscene, "debug_use_cpu_svm_specialization")
 
         col.separator()
 
@@ -2108,6 +2126,7 @@ class CYCLES_RENDER_PT_simplify_render(CyclesButtonsPanel, Panel):
         col.prop(rd, "simplify_subdivision_render", text="Max Subdivision")
         col.prop(rd, "simplify_child_particles_render", text="Child Particles")
         col.prop(cscene, "texture_limit_render", text="Texture Limit")
+        col.prop(cscene, "texture_downscale_limit_render", text="Downscale Textures (MB)")
 
 
 class CYCLES_RENDER_PT_simplify_culling(CyclesButtonsPanel, Panel):
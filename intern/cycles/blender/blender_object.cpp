@@ -198,31 +198,11 @@ Object *BlenderSync::sync_object(BL::Depsgraph &b_depsgraph,
     return NULL;
   }
 
-  /* Visibility flags for both parent and child. */
-  PointerRNA cobject = RNA_pointer_get(&b_ob.ptr, "cycles");
-  bool use_holdout = b_parent.holdout_get(PointerRNA_NULL, b_view_layer);
-  uint visibility = object_ray_visibility(b_ob) & PATH_RAY_ALL_VISIBILITY;
-
-  if (b_parent.ptr.data != b_ob.ptr.data) {
-    visibility &= object_ray_visibility(b_parent);
-  }
-
-  /* TODO: make holdout objects on excluded layer invisible for non-camera rays. */
-#if 0
-  if (use_holdout && (layer_flag & view_layer.exclude_layer)) {
-    visibility &= ~(PATH_RAY_ALL_VISIBILITY - PATH_RAY_CAMERA);
-  }
-#endif
-
-  /* Clear camera visibility for indirect only objects. */
-  bool use_indirect_only = !use_holdout &&
-                           b_parent.indirect_only_get(PointerRNA_NULL, b_view_layer);
-  if (use_indirect_only) {
-    visibility &= ~PATH_RAY_CAMERA;
-  }
+  const ObjectSettings &settings = sync_object_settings(
+      b_view_layer, b_ob, b_parent, b_ob_instance);
 
   /* Don't export completely invisible objects. */
-  if (visibility == 0) {
+  if (settings.visibility == 0) {
     return NULL;
   }
 
@@ -283,48 +263,26 @@ Object *BlenderSync::sync_object(BL::Depsgraph &b_depsgraph,
   }
 
   /* holdout */
-  object->set_use_holdout(use_holdout);
-
-  object->set_visibility(visibility);
+  object->set_use_holdout(settings.use_holdout);
 
-  object->set_is_shadow_catcher(b_ob.is_shadow_catcher());
+  object->set_visibility(settings.visibility);
 
-  float shadow_terminator_shading_offset = get_float(cobject, "shadow_terminator_offset");
-  object->set_shadow_terminator_shading_offset(shadow_terminator_shading_offset);
-
-  float shadow_terminator_geometry_offset = get_float(cobject,
-                                                      "shadow_terminator_geometry_offset");
-  object->set_shadow_terminator_geometry_offset(shadow_terminator_geometry_offset);
-
-  float ao_distance = get_float(cobject, "ao_distance");
-  if (ao_distance == 0.0f && b_parent.ptr.data != b_ob.ptr.data) {
-    PointerRNA cparent = RNA_pointer_get(&b_parent.ptr, "cycles");
-    ao_distance = get_float(cparent, "ao_distance");
-  }
-  object->set_ao_distance(ao_distance);
+  object->set_is_shadow_catcher(settings.is_shadow_catcher);
+  object->set_shadow_terminator_shading_offset(settings.shadow_terminator_shading_offset);
+  object->set_shadow_terminator_geometry_offset(settings.shadow_terminator_geometry_offset);
+  object->set_ao_distance(settings.ao_distance);
 
   /* sync the asset name for Cryptomatte */
-  BL::Object parent = b_ob.parent();
-  ustring parent_name;
-  if (parent) {
-    while (parent.parent()) {
-      parent = parent.parent();
-    }
-    parent_name = parent.name();
-  }
-  else {
-    parent_name = b_ob.name();
-  }
-  object->set_asset_name(parent_name);
+  object->set_asset_name(settings.asset_name);
 
   /* object sync
    * transform comparison should not be needed, but duplis don't work perfect
    * in the depsgraph and may not signal changes, so this is a workaround */
   if (object->is_modified() || object_updated ||
       (object->get_geometry() && object->get_geometry()->is_modified())) {
-    object->name = b_ob.name().c_str();
-    object->set_pass_id(b_ob.pass_index());
-    object->set_color(get_float3(b_ob.color()));
+    object->name = settings.name;
+    object->set_pass_id(settings.pass_id);
+    object->set_color(settings.color);
     object->set_tfm(tfm);
 
     /* dupli texture coordinates and random_id */
@@ -353,6 +311,74 @@ Object *BlenderSync::sync_object(BL::Depsgraph &b_depsgraph,
   return object;
 }
 
+const BlenderSync::ObjectSettings &BlenderSync::sync_object_settings(BL::ViewLayer &b_view_layer,
+                                                                   BL::Object &b_ob,
+                                                                   BL::Object &b_parent,
+                                                                   BL::Object &b_ob_instance)
+{
+  /* Instances of the same object by the same parent share all these settings, look them up
+   * only for the first one. */
+  const std::pair<void *, void *> key(b_parent.ptr.data, b_ob_instance.ptr.data);
+  map<std::pair<void *, void *>, ObjectSettings>::iterator it = object_settings.find(key);
+  if (it != object_settings.end()) {
+    return it->second;
+  }
+
+  ObjectSettings &settings = object_settings[key];
+
+  /* Visibility flags for both parent and child. */
+  PointerRNA cobject = RNA_pointer_get(&b_ob.ptr, "cycles");
+  settings.use_holdout = b_parent.holdout_get(PointerRNA_NULL, b_view_layer);
+  settings.visibility = object_ray_visibility(b_ob) & PATH_RAY_ALL_VISIBILITY;
+
+  if (b_parent.ptr.data != b_ob.ptr.data) {
+    settings.visibility &= object_ray_visibility(b_parent);
+  }
+
+  /* TODO: make holdout objects on excluded layer invisible for non-camera rays. */
+#if 0
+  if (use_holdout && (layer_flag & view_layer.exclude_layer)) {
+    visibility &= ~(PATH_RAY_ALL_VISIBILITY - PATH_RAY_CAMERA);
+  }
+#endif
+
+  /* Clear camera visibility for indirect only objects. */
+  bool use_indirect_only = !settings.use_holdout &&
+                           b_parent.indirect_only_get(PointerRNA_NULL, b_view_layer);
+  if (use_indirect_only) {
+    settings.visibility &= ~PATH_RAY_CAMERA;
+  }
+
+  settings.is_shadow_catcher = b_ob.is_shadow_catcher();
+  settings.shadow_terminator_shading_offset = get_float(cobject, "shadow_terminator_offset");
+  settings.shadow_terminator_geometry_offset = get_float(cobject,
+                                                         "shadow_terminator_geometry_offset");
+
+  settings.ao_distance = get_float(cobject, "ao_distance");
+  if (settings.ao_distance == 0.0f && b_parent.ptr.data != b_ob.ptr.data) {
+    PointerRNA cparent = RNA_pointer_get(&b_parent.ptr, "cycles");
+    settings.ao_distance = get_float(cparent, "ao_distance");
+  }
+
+  /* Asset name for Cryptomatte. */
+  BL::Object parent = b_ob.parent();
+  if (parent) {
+    while (parent.parent()) {
+      parent = parent.parent();
+    }
+    settings.asset_name = ustring(parent.name());
+  }
+  else {
+    settings.asset_name = ustring(b_ob.name());
+  }
+
+  settings.name = ustring(b_ob.name());
+  settings.pass_id = b_ob.pass_index();
+  settings.color = get_float3(b_ob.color());
+
+  return settings;
+}
+
 /* This function mirrors drw_uniform_property_lookup in draw_instance_data.cpp */
 static bool lookup_property(BL::ID b_id, const string &name, float4 *r_value)
 {
@@ -525,6 +551,10 @@ void BlenderSync::sync_procedural(BL::Object &b_ob,
 
   procedural->set_use_prefetch(cache_file.use_prefetch());
   procedural->set_prefetch_cache_size(cache_file.prefetch_cache_size());
+  procedural->set_stream_window(cache_file.stream_window());
+  /* The scene and its procedurals are only kept for the next frame with persistent data. */
+  procedural->set_prefetch_next_window(b_engine.render() &&
+                                       b_engine.render().use_persistent_data());
 
   /* create or update existing AlembicObjects */
   ustring object_path = ustring(b_mesh_cache.object_path());
@@ -574,6 +604,9 @@ void BlenderSync::sync_objects(BL::Depsgraph &b_depsgraph,
     geometry_motion_synced.clear();
   }
 
+  /* Object settings may have changed since the previous sync. */
+  object_settings.clear();
+
   /* initialize culling */
   BlenderObjectCulling culling(scene, b_scene);
 
@@ -88,6 +88,8 @@ bool debug_flags_sync_from_scene(BL::Scene b_scene)
   flags.cpu.sse2 = get_boolean(cscene, "debug_use_cpu_sse2");
   flags.cpu.bvh_layout = (BVHLayout)get_enum(cscene, "debug_bvh_layout");
   flags.cpu.split_kernel = get_boolean(cscene, "debug_use_cpu_split_kernel");
+  flags.cpu.split_kernel_batch_size = get_int(cscene, "debug_cpu_split_kernel_batch_size");
+  flags.cpu.svm_specialization = get_boolean(cscene, "debug_use_cpu_svm_specialization");
   /* Synchronize CUDA flags. */
   flags.cuda.adaptive_compile = get_boolean(cscene, "debug_use_cuda_adaptive_compile");
   flags.cuda.split_kernel = get_boolean(cscene, "debug_use_cuda_split_kernel");
@@ -1012,6 +1014,17 @@ static PyObject *enable_print_stats_func(PyObject * /*self*/, PyObject * /*args*
   Py_RETURN_NONE;
 }
 
+static PyObject *set_profile_output_func(PyObject * /*self*/, PyObject *arg)
+{
+  PyObject *path_string = PyObject_Str(arg);
+  BlenderSession::profile_filepath = PyUnicode_AsUTF8(path_string);
+  Py_DECREF(path_string);
+
+  VLOG(1) << "Writing profiling information to " << BlenderSession::profile_filepath;
+
+  Py_RETURN_NONE;
+}
+
 static PyObject *get_device_types_func(PyObject * /*self*/, PyObject * /*args*/)
 {
   vector<DeviceType> device_types = Device::available_types();
@@ -1097,6 +1110,7 @@ static PyMethodDef methods[] = {
 
     /* Statistics. */
     {"enable_print_stats", enable_print_stats_func, METH_NOARGS, ""},
+    {"set_profile_output", set_profile_output_func, METH_O, ""},
 
     /* Resumable render */
     {"set_resumable_chunk", set_resumable_chunk_func, METH_VARARGS, ""},
@@ -38,6 +38,7 @@
 #include "util/util_hash.h"
 #include "util/util_logging.h"
 #include "util/util_murmurhash.h"
+#include "util/util_path.h"
 #include "util/util_progress.h"
 #include "util/util_time.h"
 
@@ -54,6 +55,7 @@ int BlenderSession::current_resumable_chunk = 0;
 int BlenderSession::start_resumable_chunk = 0;
 int BlenderSession::end_resumable_chunk = 0;
 bool BlenderSession::print_render_stats = false;
+string BlenderSession::profile_filepath = "";
 
 BlenderSession::BlenderSession(BL::RenderEngine &b_engine,
                                BL::Preferences &b_userpref,
@@ -420,6 +422,35 @@ static void add_cryptomatte_layer(BL::RenderResult &b_rr, string name, string ma
   render_add_metadata(b_rr, prefix + "manifest", manifest);
 }
 
+void BlenderSession::write_profile()
+{
+  RenderStats stats;
+  session->collect_statistics(&stats);
+  if (!stats.has_profiling) {
+    return;
+  }
+
+  /* Separate files for every view layer and frame, written next to each other. */
+  const string filename = path_filename(profile_filepath);
+  const size_t extension_start = filename.rfind('.');
+  const string extension = (extension_start != string::npos) ? filename.substr(extension_start) :
+                                                               "";
+  const string base = profile_filepath.substr(0, profile_filepath.size() - extension.size());
+  const string filepath = string_printf("%s_%s_%04d%s",
+                                        base.c_str(),
+                                        b_rlay_name.c_str(),
+                                        b_scene.frame_current(),
+                                        extension.c_str());
+
+  string json = stats.json_report();
+  if (path_write_text(filepath, json)) {
+    printf("Cycles: Wrote profile to %s\n", filepath.c_str());
+  }
+  else {
+    fprintf(stderr, "Cycles: Failed to write profile to %s\n", filepath.c_str());
+  }
+}
+
 void BlenderSession::stamp_view_layer_metadata(Scene *scene, const string &view_layer_name)
 {
   BL::RenderResult b_rr = b_engine.get_result();
@@ -578,6 +609,10 @@ void BlenderSession::render(BL::Depsgraph &b_depsgraph_)
       printf("Render statistics:\n%s\n", stats.full_report().c_str());
     }
 
+    if (!b_engine.is_preview() && background && !profile_filepath.empty()) {
+      write_profile();
+    }
+
     if (session->progress.get_cancel())
       break;
   }
@@ -592,6 +627,10 @@ void BlenderSession::render(BL::Depsgraph &b_depsgraph_)
   session->progress.get_time(total_time, render_time);
   VLOG(1) << "Total render time: " << total_time;
   VLOG(1) << "Render time (without synchronization): " << render_time;
+  if (render_time > 0.0) {
+    VLOG(1) << "Render samples per second: "
+            << session->progress.get_pixel_samples() / render_time;
+  }
 
   /* clear callback */
   session->write_render_tile_cb = function_null;
@@ -688,6 +727,12 @@ void BlenderSession::bake(BL::Depsgraph &b_depsgraph_,
   if (object_found && !session->progress.get_cancel()) {
     session->start();
     session->wait();
+
+    if (background && print_render_stats) {
+      RenderStats stats;
+      session->collect_statistics(&stats);
+      printf("Render statistics:\n%s\n", stats.full_report().c_str());
+    }
   }
 
   session->read_bake_tile_cb = function_null;
@@ -148,9 +148,14 @@ class BlenderSession {
 
   static bool print_render_stats;
 
+  /* File path to write profiling information to, with the view layer and frame appended. */
+  static string profile_filepath;
+
  protected:
   void stamp_view_layer_metadata(Scene *scene, const string &view_layer_name);
 
+  void write_profile();
+
   void do_write_update_render_result(BL::RenderLayer &b_rlay,
                                      RenderTile &rtile,
                                      bool do_update_only);
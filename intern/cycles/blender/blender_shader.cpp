@@ -1303,6 +1303,7 @@ void BlenderSync::sync_materials(BL::Depsgraph &b_depsgraph, bool update_all)
     if (shader_map.add_or_update(&shader, b_mat) || update_all) {
       ShaderGraph *graph = new ShaderGraph();
 
+      const ustring prev_name = shader->name;
       shader->name = b_mat.name().c_str();
       shader->set_pass_id(b_mat.pass_index());
 
@@ -1331,6 +1332,14 @@ void BlenderSync::sync_materials(BL::Depsgraph &b_depsgraph, bool update_all)
       shader->set_volume_step_rate(get_float(cmat, "volume_step_rate"));
       shader->set_displacement_method(get_displacement_method(cmat));
 
+      /* Keep the compiled shader when nothing changed, which is common with persistent data
+       * where all shaders are synced again for every frame with animated images. */
+      if (shader->name == prev_name && !shader->is_modified() &&
+          !shader->graph_is_modified(graph)) {
+        delete graph;
+        continue;
+      }
+
       shader->set_graph(graph);
 
       /* By simplifying the shader graph as soon as possible, some
@@ -1487,8 +1496,13 @@ void BlenderSync::sync_world(BL::Depsgraph &b_depsgraph, BL::SpaceView3D &b_v3d,
       background->set_ao_distance(FLT_MAX);
     }
 
-    shader->set_graph(graph);
-    shader->tag_update(scene);
+    if (shader->is_modified() || shader->graph_is_modified(graph)) {
+      shader->set_graph(graph);
+      shader->tag_update(scene);
+    }
+    else {
+      delete graph;
+    }
   }
 
   PointerRNA cscene = RNA_pointer_get(&b_scene.ptr, "cycles");
@@ -1547,8 +1561,13 @@ void BlenderSync::sync_lights(BL::Depsgraph &b_depsgraph, bool update_all)
         graph->connect(emission->output("Emission"), out->input("Surface"));
       }
 
-      shader->set_graph(graph);
-      shader->tag_update(scene);
+      if (shader->is_modified() || shader->graph_is_modified(graph)) {
+        shader->set_graph(graph);
+        shader->tag_update(scene);
+      }
+      else {
+        delete graph;
+      }
     }
   }
 }
@@ -334,6 +334,7 @@ void BlenderSync::sync_integrator()
   integrator->set_sample_all_lights_direct(get_boolean(cscene, "sample_all_lights_direct"));
   integrator->set_sample_all_lights_indirect(get_boolean(cscene, "sample_all_lights_indirect"));
   integrator->set_light_sampling_threshold(get_float(cscene, "light_sampling_threshold"));
+  integrator->set_use_light_tree(get_boolean(cscene, "use_light_tree"));
 
   SamplingPattern sampling_pattern = (SamplingPattern)get_enum(
       cscene, "sampling_pattern", SAMPLING_NUM_PATTERNS, SAMPLING_PATTERN_SOBOL);
@@ -344,9 +345,12 @@ void BlenderSync::sync_integrator()
     sampling_pattern = SAMPLING_PATTERN_PMJ;
     adaptive_min_samples = get_int(cscene, "adaptive_min_samples");
     integrator->set_adaptive_threshold(get_float(cscene, "adaptive_threshold"));
+    integrator->set_adaptive_denoising_estimate(
+        get_boolean(cscene, "use_adaptive_denoising_estimate"));
   }
   else {
     integrator->set_adaptive_threshold(0.0f);
+    integrator->set_adaptive_denoising_estimate(false);
   }
 
   integrator->set_sampling_pattern(sampling_pattern);
@@ -779,6 +783,7 @@ SceneParams BlenderSync::get_scene_params(BL::Scene &b_scene, bool background)
 
   params.use_bvh_spatial_split = RNA_boolean_get(&cscene, "debug_use_spatial_splits");
   params.use_bvh_unaligned_nodes = RNA_boolean_get(&cscene, "debug_use_hair_bvh");
+  params.use_bvh_curve_leaf_keys = RNA_boolean_get(&cscene, "debug_use_hair_leaf_keys");
   params.num_bvh_time_steps = RNA_int_get(&cscene, "debug_bvh_time_steps");
 
   PointerRNA csscene = RNA_pointer_get(&b_scene.ptr, "cycles_curves");
@@ -800,6 +805,23 @@ SceneParams BlenderSync::get_scene_params(BL::Scene &b_scene, bool background)
     params.texture_limit = 0;
   }
 
+  const int texture_downscale_limit = RNA_int_get(&cscene, "texture_downscale_limit_render");
+  if (background && texture_downscale_limit > 0 && b_scene.render().use_simplify()) {
+    params.texture_downscale_limit = (size_t)texture_downscale_limit * 1024 * 1024;
+  }
+  else {
+    params.texture_downscale_limit = 0;
+  }
+
+  if (background) {
+    params.texture_cache_size = (size_t)get_int(cscene, "texture_cache_size") * 1024 * 1024;
+  }
+  else {
+    params.texture_cache_size = 0;
+  }
+
+  params.compact_geometry = get_boolean(cscene, "use_compact_geometry");
+
   params.bvh_layout = DebugFlags().cpu.bvh_layout;
 
   params.background = background;
@@ -942,6 +964,11 @@ SessionParams BlenderSync::get_session_params(BL::RenderEngine &b_engine,
   else
     params.progressive = true;
 
+  /* Split tiles at the end of final renders. Split tiles would not match the tiles of the
+   * save buffers file. */
+  params.adaptive_tiles = background && !params.progressive && !b_r.use_save_buffers() &&
+                          get_boolean(cscene, "use_adaptive_tiles");
+
   /* shading system - scene level needs full refresh */
   const bool shadingsystem = RNA_boolean_get(&cscene, "shading_system");
 
@@ -961,7 +988,8 @@ SessionParams BlenderSync::get_session_params(BL::RenderEngine &b_engine,
   }
 
   params.use_profiling = params.device.has_profiling && !b_engine.is_preview() && background &&
-                         BlenderSession::print_render_stats;
+                         (BlenderSession::print_render_stats ||
+                          !BlenderSession::profile_filepath.empty());
 
   return params;
 }
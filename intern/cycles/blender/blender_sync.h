@@ -151,6 +151,27 @@ class BlenderSync {
                       TaskPool *geom_task_pool);
   void sync_object_motion_init(BL::Object &b_parent, BL::Object &b_ob, Object *object);
 
+  /* Object settings that only depend on the instanced object and its parent, and so are the same
+   * for all instances of an object created by the same instancer. They are looked up once per
+   * sync instead of through RNA for every instance. */
+  struct ObjectSettings {
+    uint visibility;
+    bool use_holdout;
+    bool is_shadow_catcher;
+    float shadow_terminator_shading_offset;
+    float shadow_terminator_geometry_offset;
+    float ao_distance;
+    ustring name;
+    ustring asset_name;
+    int pass_id;
+    float3 color;
+  };
+
+  const ObjectSettings &sync_object_settings(BL::ViewLayer &b_view_layer,
+                                             BL::Object &b_ob,
+                                             BL::Object &b_parent,
+                                             BL::Object &b_ob_instance);
+
   void sync_procedural(BL::Object &b_ob,
                        BL::MeshSequenceCacheModifier &b_mesh_cache,
                        bool has_subdivision);
@@ -232,6 +253,7 @@ class BlenderSync {
   set<Geometry *> geometry_synced;
   set<Geometry *> geometry_motion_synced;
   set<float> motion_times;
+  map<std::pair<void *, void *>, ObjectSettings> object_settings;
   void *world_map;
   bool world_recalc;
   BlenderViewportParameters viewport_parameters;
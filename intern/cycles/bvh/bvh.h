@@ -54,6 +54,11 @@ struct PackedBVH {
   array<uint> prim_tri_index;
   /* Continuous storage of triangle vertices. */
   array<float4> prim_tri_verts;
+  /* Mapping from primitive index to index in curve keys array, -1 for other primitives. */
+  array<uint> prim_curve_index;
+  /* Continuous storage of curve segments in leaf order, each a bounding sphere followed by the
+   * four control points. */
+  array<float4> prim_curve_keys;
   /* primitive type - triangle or strand */
   array<int> prim_type;
   /* visibility visibilitys for primitives */
@@ -83,6 +88,9 @@ class BVH {
   vector<Geometry *> geometry;
   vector<Object *> objects;
 
+  /* Timing of the last build, only filled in by builders which track it. */
+  BVHBuildTimes build_times;
+
   static BVH *create(const BVHParams &params,
                      const vector<Geometry *> &geometry,
                      const vector<Object *> &objects,
@@ -27,6 +27,7 @@
 
 #include "util/util_foreach.h"
 #include "util/util_progress.h"
+#include "util/util_time.h"
 
 CCL_NAMESPACE_BEGIN
 
@@ -59,6 +60,7 @@ void BVH2::build(Progress &progress, Stats *)
                      params,
                      progress);
   BVHNode *bvh2_root = bvh_build.run();
+  build_times = bvh_build.times;
 
   if (progress.get_cancel()) {
     if (bvh2_root != NULL) {
@@ -82,6 +84,7 @@ void BVH2::build(Progress &progress, Stats *)
   }
 
   /* pack triangles */
+  double pack_start_time = time_dt();
   progress.set_substatus("Packing BVH triangles and strands");
   pack_primitives();
 
@@ -93,6 +96,7 @@ void BVH2::build(Progress &progress, Stats *)
   /* pack nodes */
   progress.set_substatus("Packing BVH nodes");
   pack_nodes(root);
+  build_times.pack = time_dt() - pack_start_time;
 
   /* free build nodes */
   root->deleteSubtree();
@@ -100,11 +104,16 @@ void BVH2::build(Progress &progress, Stats *)
 
 void BVH2::refit(Progress &progress)
 {
-  progress.set_substatus("Packing BVH primitives");
-  pack_primitives();
-
-  if (progress.get_cancel())
-    return;
+  /* The scene BVH has the object BVHs merged into its arrays, so primitives can not be packed
+   * again from scratch. Vertices of geometry with transform applied are updated while refitting
+   * the leaves instead. */
+  if (!params.top_level) {
+    progress.set_substatus("Packing BVH primitives");
+    pack_primitives();
+
+    if (progress.get_cancel())
+      return;
+  }
 
   progress.set_substatus("Refitting BVH nodes");
   refit_nodes();
@@ -315,8 +324,6 @@ void BVH2::pack_nodes(const BVHNode *root)
 
 void BVH2::refit_nodes()
 {
-  assert(!params.top_level);
-
   BoundBox bbox = BoundBox::empty;
   uint visibility = 0;
   refit_node(0, (pack.root_index == -1) ? true : false, bbox, visibility);
@@ -331,7 +338,13 @@ void BVH2::refit_node(int idx, bool leaf, BoundBox &bbox, uint &visibility)
     const int c0 = data[0].x;
     const int c1 = data[0].y;
 
-    refit_primitives(c0, c1, bbox, visibility);
+    if (c0 < 0) {
+      /* Object instance leaf in the scene BVH. */
+      refit_primitives(~c0, ~c0 + 1, bbox, visibility);
+    }
+    else {
+      refit_primitives(c0, c1, bbox, visibility);
+    }
 
     /* TODO(sergey): De-duplicate with pack_leaf(). */
     float4 leaf_data[BVH_NODE_LEAF_SIZE];
@@ -395,6 +408,11 @@ void BVH2::refit_primitives(int start, int end, BoundBox &bbox, uint &visibility
 
         curve.bounds_grow(k, &hair->get_curve_keys()[0], &hair->get_curve_radius()[0], bbox);
 
+        if (params.top_level && params.use_curve_leaf_keys && pack.prim_curve_index[prim] != -1) {
+          float4 *curve_keys = &pack.prim_curve_keys[pack.prim_curve_index[prim]];
+          pack_curve_segment(prim, prim_offset, curve_keys);
+        }
+
         /* Motion curves. */
         if (hair->get_use_motion_blur()) {
           Attribute *attr = hair->attributes.find(ATTR_STD_MOTION_VERTEX_POSITION);
@@ -418,6 +436,13 @@ void BVH2::refit_primitives(int start, int end, BoundBox &bbox, uint &visibility
 
         triangle.bounds_grow(vpos, bbox);
 
+        if (params.top_level) {
+          const uint tri_vindex = pack.prim_tri_index[prim];
+          pack.prim_tri_verts[tri_vindex + 0] = float3_to_float4(vpos[triangle.v[0]]);
+          pack.prim_tri_verts[tri_vindex + 1] = float3_to_float4(vpos[triangle.v[1]]);
+          pack.prim_tri_verts[tri_vindex + 2] = float3_to_float4(vpos[triangle.v[2]]);
+        }
+
         /* Motion triangles. */
         if (mesh->use_motion_blur) {
           Attribute *attr = mesh->attributes.find(ATTR_STD_MOTION_VERTEX_POSITION);
@@ -457,16 +482,60 @@ void BVH2::pack_triangle(int idx, float4 tri_verts[3])
   tri_verts[2] = float3_to_float4(v2);
 }
 
+/* Curves */
+
+/* Store the control points of a curve segment along with a sphere that bounds it. The sphere
+ * bounds the Bezier control points of the Catmull-Rom segment, which contain the curve. */
+void BVH2::pack_curve_segment(int idx, int prim_offset, float4 curve_keys[CURVE_LEAF_KEYS_SIZE])
+{
+  int tob = pack.prim_object[idx];
+  assert(tob >= 0 && tob < objects.size());
+  const Hair *hair = static_cast<const Hair *>(objects[tob]->get_geometry());
+
+  const Hair::Curve curve = hair->get_curve(pack.prim_index[idx] - prim_offset);
+  const int k0 = curve.first_key + PRIMITIVE_UNPACK_SEGMENT(pack.prim_type[idx]);
+  const int k1 = k0 + 1;
+  const int ka = max(k0 - 1, curve.first_key);
+  const int kb = min(k1 + 1, curve.first_key + curve.num_keys - 1);
+  const int keys[4] = {ka, k0, k1, kb};
+
+  const float3 *hair_keys = &hair->get_curve_keys()[0];
+  const float *hair_radius = &hair->get_curve_radius()[0];
+
+  float4 *P = curve_keys + 1;
+  for (int i = 0; i < 4; i++) {
+    const float3 co = hair_keys[keys[i]];
+    P[i] = make_float4(co.x, co.y, co.z, hair_radius[keys[i]]);
+  }
+
+  const float4 bezier[4] = {
+      P[1], P[1] + (P[2] - P[0]) / 6.0f, P[2] - (P[3] - P[1]) / 6.0f, P[2]};
+  const float3 center = float4_to_float3(bezier[0] + bezier[1] + bezier[2] + bezier[3]) * 0.25f;
+
+  float distance = 0.0f, radius = 0.0f;
+  for (int i = 0; i < 4; i++) {
+    distance = max(distance, len(float4_to_float3(bezier[i]) - center));
+    radius = max(radius, fabsf(bezier[i].w));
+  }
+
+  curve_keys[0] = make_float4(center.x, center.y, center.z, distance + radius);
+}
+
 void BVH2::pack_primitives()
 {
   const size_t tidx_size = pack.prim_index.size();
   size_t num_prim_triangles = 0;
-  /* Count number of triangles primitives in BVH. */
+  size_t num_prim_curves = 0;
+  /* Count number of triangles and static curve primitives in BVH. */
   for (unsigned int i = 0; i < tidx_size; i++) {
     if ((pack.prim_index[i] != -1)) {
       if ((pack.prim_type[i] & PRIMITIVE_ALL_TRIANGLE) != 0) {
         ++num_prim_triangles;
       }
+      else if (params.use_curve_leaf_keys &&
+               (pack.prim_type[i] & (PRIMITIVE_CURVE_THICK | PRIMITIVE_CURVE_RIBBON)) != 0) {
+        ++num_prim_curves;
+      }
     }
   }
   /* Reserve size for arrays. */
@@ -474,11 +543,23 @@ void BVH2::pack_primitives()
   pack.prim_tri_index.resize(tidx_size);
   pack.prim_tri_verts.clear();
   pack.prim_tri_verts.resize(num_prim_triangles * 3);
+  pack.prim_curve_index.clear();
+  if (params.use_curve_leaf_keys) {
+    pack.prim_curve_index.resize(tidx_size);
+  }
+  pack.prim_curve_keys.clear();
+  pack.prim_curve_keys.resize(num_prim_curves * CURVE_LEAF_KEYS_SIZE);
   pack.prim_visibility.clear();
   pack.prim_visibility.resize(tidx_size);
   /* Fill in all the arrays. */
   size_t prim_triangle_index = 0;
+  size_t prim_curve_index = 0;
   for (unsigned int i = 0; i < tidx_size; i++) {
+    pack.prim_tri_index[i] = -1;
+    if (params.use_curve_leaf_keys) {
+      pack.prim_curve_index[i] = -1;
+    }
+
     if (pack.prim_index[i] != -1) {
       int tob = pack.prim_object[i];
       Object *ob = objects[tob];
@@ -487,13 +568,16 @@ void BVH2::pack_primitives()
         pack.prim_tri_index[i] = 3 * prim_triangle_index;
         ++prim_triangle_index;
       }
-      else {
-        pack.prim_tri_index[i] = -1;
+      else if (params.use_curve_leaf_keys &&
+               (pack.prim_type[i] & (PRIMITIVE_CURVE_THICK | PRIMITIVE_CURVE_RIBBON)) != 0) {
+        const size_t curve_index = CURVE_LEAF_KEYS_SIZE * prim_curve_index;
+        pack_curve_segment(i, 0, &pack.prim_curve_keys[curve_index]);
+        pack.prim_curve_index[i] = curve_index;
+        ++prim_curve_index;
       }
       pack.prim_visibility[i] = ob->visibility_for_tracing();
     }
     else {
-      pack.prim_tri_index[i] = -1;
       pack.prim_visibility[i] = 0;
     }
   }
@@ -523,9 +607,11 @@ void BVH2::pack_instances(size_t nodes_size, size_t leaf_nodes_size)
   /* reserve */
   size_t prim_index_size = pack.prim_index.size();
   size_t prim_tri_verts_size = pack.prim_tri_verts.size();
+  size_t prim_curve_keys_size = pack.prim_curve_keys.size();
 
   size_t pack_prim_index_offset = prim_index_size;
   size_t pack_prim_tri_verts_offset = prim_tri_verts_size;
+  size_t pack_prim_curve_keys_offset = prim_curve_keys_size;
   size_t pack_nodes_offset = nodes_size;
   size_t pack_leaf_nodes_offset = leaf_nodes_size;
   size_t object_offset = 0;
@@ -536,6 +622,7 @@ void BVH2::pack_instances(size_t nodes_size, size_t leaf_nodes_size)
     if (geom->need_build_bvh(params.bvh_layout)) {
       prim_index_size += bvh->pack.prim_index.size();
       prim_tri_verts_size += bvh->pack.prim_tri_verts.size();
+      prim_curve_keys_size += bvh->pack.prim_curve_keys.size();
       nodes_size += bvh->pack.nodes.size();
       leaf_nodes_size += bvh->pack.leaf_nodes.size();
     }
@@ -547,6 +634,10 @@ void BVH2::pack_instances(size_t nodes_size, size_t leaf_nodes_size)
   pack.prim_visibility.resize(prim_index_size);
   pack.prim_tri_verts.resize(prim_tri_verts_size);
   pack.prim_tri_index.resize(prim_index_size);
+  pack.prim_curve_keys.resize(prim_curve_keys_size);
+  if (params.use_curve_leaf_keys) {
+    pack.prim_curve_index.resize(prim_index_size);
+  }
   pack.nodes.resize(nodes_size);
   pack.leaf_nodes.resize(leaf_nodes_size);
   pack.object_node.resize(objects.size());
@@ -561,6 +652,9 @@ void BVH2::pack_instances(size_t nodes_size, size_t leaf_nodes_size)
   uint *pack_prim_visibility = (pack.prim_visibility.size()) ? &pack.prim_visibility[0] : NULL;
   float4 *pack_prim_tri_verts = (pack.prim_tri_verts.size()) ? &pack.prim_tri_verts[0] : NULL;
   uint *pack_prim_tri_index = (pack.prim_tri_index.size()) ? &pack.prim_tri_index[0] : NULL;
+  float4 *pack_prim_curve_keys = (pack.prim_curve_keys.size()) ? &pack.prim_curve_keys[0] : NULL;
+  uint *pack_prim_curve_index = (pack.prim_curve_index.size()) ? &pack.prim_curve_index[0] :
+                                                                 NULL;
   int4 *pack_nodes = (pack.nodes.size()) ? &pack.nodes[0] : NULL;
   int4 *pack_leaf_nodes = (pack.leaf_nodes.size()) ? &pack.leaf_nodes[0] : NULL;
   float2 *pack_prim_time = (pack.prim_time.size()) ? &pack.prim_time[0] : NULL;
@@ -610,17 +704,29 @@ void BVH2::pack_instances(size_t nodes_size, size_t leaf_nodes_size)
       int *bvh_prim_type = &bvh->pack.prim_type[0];
       uint *bvh_prim_visibility = &bvh->pack.prim_visibility[0];
       uint *bvh_prim_tri_index = &bvh->pack.prim_tri_index[0];
+      uint *bvh_prim_curve_index = bvh->pack.prim_curve_index.size() ?
+                                       &bvh->pack.prim_curve_index[0] :
+                                       NULL;
       float2 *bvh_prim_time = bvh->pack.prim_time.size() ? &bvh->pack.prim_time[0] : NULL;
 
       for (size_t i = 0; i < bvh_prim_index_size; i++) {
         if (bvh->pack.prim_type[i] & PRIMITIVE_ALL_CURVE) {
           pack_prim_index[pack_prim_index_offset] = bvh_prim_index[i] + geom_prim_offset;
           pack_prim_tri_index[pack_prim_index_offset] = -1;
+          if (pack_prim_curve_index != NULL) {
+            pack_prim_curve_index[pack_prim_index_offset] =
+                (bvh_prim_curve_index != NULL && bvh_prim_curve_index[i] != -1) ?
+                    bvh_prim_curve_index[i] + pack_prim_curve_keys_offset :
+                    -1;
+          }
         }
         else {
           pack_prim_index[pack_prim_index_offset] = bvh_prim_index[i] + geom_prim_offset;
           pack_prim_tri_index[pack_prim_index_offset] = bvh_prim_tri_index[i] +
                                                         pack_prim_tri_verts_offset;
+          if (pack_prim_curve_index != NULL) {
+            pack_prim_curve_index[pack_prim_index_offset] = -1;
+          }
         }
 
         pack_prim_type[pack_prim_index_offset] = bvh_prim_type[i];
@@ -642,6 +748,15 @@ void BVH2::pack_instances(size_t nodes_size, size_t leaf_nodes_size)
       pack_prim_tri_verts_offset += prim_tri_size;
     }
 
+    /* Merge curve keys data. */
+    if (bvh->pack.prim_curve_keys.size()) {
+      const size_t prim_curve_size = bvh->pack.prim_curve_keys.size();
+      memcpy(pack_prim_curve_keys + pack_prim_curve_keys_offset,
+             &bvh->pack.prim_curve_keys[0],
+             prim_curve_size * sizeof(float4));
+      pack_prim_curve_keys_offset += prim_curve_size;
+    }
+
     /* merge nodes */
     if (bvh->pack.leaf_nodes.size()) {
       int4 *leaf_nodes_offset = &bvh->pack.leaf_nodes[0];
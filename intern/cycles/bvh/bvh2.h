@@ -100,6 +100,7 @@ class BVH2 : public BVH {
   /* triangles and strands */
   void pack_primitives();
   void pack_triangle(int idx, float4 storage[3]);
+  void pack_curve_segment(int idx, int prim_offset, float4 storage[CURVE_LEAF_KEYS_SIZE]);
 
   /* merge instance BVH's */
   void pack_instances(size_t nodes_size, size_t leaf_nodes_size);
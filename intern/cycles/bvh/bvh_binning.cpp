@@ -23,7 +23,10 @@
 
 #include "util/util_algorithm.h"
 #include "util/util_boundbox.h"
+#include "util/util_foreach.h"
+#include "util/util_tbb.h"
 #include "util/util_types.h"
+#include "util/util_vector.h"
 
 CCL_NAMESPACE_BEGIN
 
@@ -105,63 +108,41 @@ BVHObjectBinning::BVHObjectBinning(const BVHRange &job,
     bin_bounds[i][0] = bin_bounds[i][1] = bin_bounds[i][2] = BoundBox::empty;
   }
 
-  /* map geometry to bins, unrolled once */
-  {
-    int64_t i;
-
-    for (i = 0; i < int64_t(size()) - 1; i += 2) {
-      prefetch_L2(&prims[start() + i + 8]);
-
-      /* map even and odd primitive to bin */
-      const BVHReference &prim0 = prims[start() + i + 0];
-      const BVHReference &prim1 = prims[start() + i + 1];
-
-      BoundBox bounds0 = get_prim_bounds(prim0);
-      BoundBox bounds1 = get_prim_bounds(prim1);
-
-      int4 bin0 = get_bin(bounds0);
-      int4 bin1 = get_bin(bounds1);
-
-      /* increase bounds for bins for even primitive */
-      int b00 = (int)extract<0>(bin0);
-      bin_count[b00][0]++;
-      bin_bounds[b00][0].grow(bounds0);
-      int b01 = (int)extract<1>(bin0);
-      bin_count[b01][1]++;
-      bin_bounds[b01][1].grow(bounds0);
-      int b02 = (int)extract<2>(bin0);
-      bin_count[b02][2]++;
-      bin_bounds[b02][2].grow(bounds0);
-
-      /* increase bounds of bins for odd primitive */
-      int b10 = (int)extract<0>(bin1);
-      bin_count[b10][0]++;
-      bin_bounds[b10][0].grow(bounds1);
-      int b11 = (int)extract<1>(bin1);
-      bin_count[b11][1]++;
-      bin_bounds[b11][1].grow(bounds1);
-      int b12 = (int)extract<2>(bin1);
-      bin_count[b12][2]++;
-      bin_bounds[b12][2].grow(bounds1);
+  /* map geometry to bins */
+  if (size() < PARALLEL_MIN_SIZE) {
+    bin_primitives(prims, start(), end(), bin_bounds, bin_count);
+  }
+  else {
+    /* Large ranges only happen at the top of the tree, where there is no
+     * other work to run in parallel yet. Bin blocks of primitives on all
+     * threads into thread local bins and merge them afterwards. */
+    struct ThreadBins {
+      BoundBox bounds[MAX_BINS][4];
+      int4 count[MAX_BINS];
+    };
+
+    ThreadBins empty_bins;
+    for (size_t i = 0; i < num_bins; i++) {
+      empty_bins.count[i] = make_int4(0);
+      empty_bins.bounds[i][0] = empty_bins.bounds[i][1] = empty_bins.bounds[i][2] =
+          BoundBox::empty;
     }
 
-    /* for uneven number of primitives */
-    if (i < int64_t(size())) {
-      /* map primitive to bin */
-      const BVHReference &prim0 = prims[start() + i];
-      BoundBox bounds0 = get_prim_bounds(prim0);
-      int4 bin0 = get_bin(bounds0);
-
-      /* increase bounds of bins */
-      int b00 = (int)extract<0>(bin0);
-      bin_count[b00][0]++;
-      bin_bounds[b00][0].grow(bounds0);
-      int b01 = (int)extract<1>(bin0);
-      bin_count[b01][1]++;
-      bin_bounds[b01][1].grow(bounds0);
-      int b02 = (int)extract<2>(bin0);
-      bin_count[b02][2]++;
-      bin_bounds[b02][2].grow(bounds0);
+    enumerable_thread_specific<ThreadBins> thread_bins(empty_bins);
+
+    parallel_for(blocked_range<int>(start(), end(), PARALLEL_BLOCK_SIZE),
+                 [&](const blocked_range<int> &r) {
+                   ThreadBins &bins = thread_bins.local();
+                   bin_primitives(prims, r.begin(), r.end(), bins.bounds, bins.count);
+                 });
+
+    for (const ThreadBins &bins : thread_bins) {
+      for (size_t i = 0; i < num_bins; i++) {
+        bin_count[i] = bin_count[i] + bins.count[i];
+        bin_bounds[i][0].grow(bins.bounds[i][0]);
+        bin_bounds[i][1].grow(bins.bounds[i][1]);
+        bin_bounds[i][2].grow(bins.bounds[i][2]);
+      }
     }
   }
 
@@ -226,24 +207,86 @@ BVHObjectBinning::BVHObjectBinning(const BVHRange &job,
   leafSAH = bounds_.half_area() * blocks(size());
 }
 
-void BVHObjectBinning::split(BVHReference *prims,
-                             BVHObjectBinning &left_o,
-                             BVHObjectBinning &right_o) const
+void BVHObjectBinning::bin_primitives(const BVHReference *prims,
+                                      int begin,
+                                      int end,
+                                      BoundBox bin_bounds[][4],
+                                      int4 bin_count[]) const
 {
-  size_t N = size();
+  /* map geometry to bins, unrolled once */
+  int64_t i;
+
+  for (i = begin; i < int64_t(end) - 1; i += 2) {
+    prefetch_L2(&prims[i + 8]);
+
+    /* map even and odd primitive to bin */
+    const BVHReference &prim0 = prims[i + 0];
+    const BVHReference &prim1 = prims[i + 1];
+
+    BoundBox bounds0 = get_prim_bounds(prim0);
+    BoundBox bounds1 = get_prim_bounds(prim1);
+
+    int4 bin0 = get_bin(bounds0);
+    int4 bin1 = get_bin(bounds1);
+
+    /* increase bounds for bins for even primitive */
+    int b00 = (int)extract<0>(bin0);
+    bin_count[b00][0]++;
+    bin_bounds[b00][0].grow(bounds0);
+    int b01 = (int)extract<1>(bin0);
+    bin_count[b01][1]++;
+    bin_bounds[b01][1].grow(bounds0);
+    int b02 = (int)extract<2>(bin0);
+    bin_count[b02][2]++;
+    bin_bounds[b02][2].grow(bounds0);
+
+    /* increase bounds of bins for odd primitive */
+    int b10 = (int)extract<0>(bin1);
+    bin_count[b10][0]++;
+    bin_bounds[b10][0].grow(bounds1);
+    int b11 = (int)extract<1>(bin1);
+    bin_count[b11][1]++;
+    bin_bounds[b11][1].grow(bounds1);
+    int b12 = (int)extract<2>(bin1);
+    bin_count[b12][2]++;
+    bin_bounds[b12][2].grow(bounds1);
+  }
 
-  BoundBox lgeom_bounds = BoundBox::empty;
-  BoundBox rgeom_bounds = BoundBox::empty;
-  BoundBox lcent_bounds = BoundBox::empty;
-  BoundBox rcent_bounds = BoundBox::empty;
+  /* for uneven number of primitives */
+  if (i < int64_t(end)) {
+    /* map primitive to bin */
+    const BVHReference &prim0 = prims[i];
+    BoundBox bounds0 = get_prim_bounds(prim0);
+    int4 bin0 = get_bin(bounds0);
+
+    /* increase bounds of bins */
+    int b00 = (int)extract<0>(bin0);
+    bin_count[b00][0]++;
+    bin_bounds[b00][0].grow(bounds0);
+    int b01 = (int)extract<1>(bin0);
+    bin_count[b01][1]++;
+    bin_bounds[b01][1].grow(bounds0);
+    int b02 = (int)extract<2>(bin0);
+    bin_count[b02][2]++;
+    bin_bounds[b02][2].grow(bounds0);
+  }
+}
 
-  int64_t l = 0, r = N - 1;
+int BVHObjectBinning::partition_primitives(BVHReference *prims,
+                                           int begin,
+                                           int end,
+                                           BoundBox &lgeom_bounds,
+                                           BoundBox &lcent_bounds,
+                                           BoundBox &rgeom_bounds,
+                                           BoundBox &rcent_bounds) const
+{
+  int64_t l = begin, r = int64_t(end) - 1;
 
   while (l <= r) {
-    prefetch_L2(&prims[start() + l + 8]);
-    prefetch_L2(&prims[start() + r - 8]);
+    prefetch_L2(&prims[l + 8]);
+    prefetch_L2(&prims[r - 8]);
 
-    BVHReference prim = prims[start() + l];
+    BVHReference prim = prims[l];
     BoundBox unaligned_bounds = get_prim_bounds(prim);
     float3 unaligned_center = unaligned_bounds.center2();
     float3 center = prim.bounds().center2();
@@ -256,14 +299,111 @@ void BVHObjectBinning::split(BVHReference *prims,
     else {
       rgeom_bounds.grow(prim.bounds());
       rcent_bounds.grow(center);
-      swap(prims[start() + l], prims[start() + r]);
+      swap(prims[l], prims[r]);
       r--;
     }
   }
+
+  return int(l - begin);
+}
+
+int BVHObjectBinning::parallel_partition_primitives(BVHReference *prims,
+                                                    BoundBox &lgeom_bounds,
+                                                    BoundBox &lcent_bounds,
+                                                    BoundBox &rgeom_bounds,
+                                                    BoundBox &rcent_bounds) const
+{
+  struct Block {
+    int begin, end, num_left;
+    BoundBox lgeom_bounds, lcent_bounds, rgeom_bounds, rcent_bounds;
+  };
+
+  /* Partition every block in place in parallel, which leaves each block with
+   * its left primitives followed by its right primitives. */
+  const int num_blocks = divide_up(size(), PARALLEL_BLOCK_SIZE);
+  vector<Block> blocks(num_blocks);
+
+  parallel_for(blocked_range<int>(0, num_blocks, 1), [&](const blocked_range<int> &r) {
+    for (int b = r.begin(); b != r.end(); b++) {
+      Block &block = blocks[b];
+      block.begin = start() + b * PARALLEL_BLOCK_SIZE;
+      block.end = min(block.begin + PARALLEL_BLOCK_SIZE, end());
+      block.lgeom_bounds = block.lcent_bounds = BoundBox::empty;
+      block.rgeom_bounds = block.rcent_bounds = BoundBox::empty;
+      block.num_left = partition_primitives(prims,
+                                            block.begin,
+                                            block.end,
+                                            block.lgeom_bounds,
+                                            block.lcent_bounds,
+                                            block.rgeom_bounds,
+                                            block.rcent_bounds);
+    }
+  });
+
+  int num_left = 0;
+  foreach (const Block &block, blocks) {
+    num_left += block.num_left;
+    lgeom_bounds.grow(block.lgeom_bounds);
+    lcent_bounds.grow(block.lcent_bounds);
+    rgeom_bounds.grow(block.rgeom_bounds);
+    rcent_bounds.grow(block.rcent_bounds);
+  }
+
+  /* Right primitives which ended up before the split point and left
+   * primitives which ended up after it come in equal numbers, swap them
+   * pairwise to finish the partition. */
+  const int mid = start() + num_left;
+  vector<int2> misplaced_right, misplaced_left;
+  foreach (const Block &block, blocks) {
+    const int block_mid = block.begin + block.num_left;
+    if (block_mid < min(block.end, mid)) {
+      misplaced_right.push_back(make_int2(block_mid, min(block.end, mid)));
+    }
+    if (max(block.begin, mid) < block_mid) {
+      misplaced_left.push_back(make_int2(max(block.begin, mid), block_mid));
+    }
+  }
+
+  size_t r = 0, l = 0;
+  int ri = (r < misplaced_right.size()) ? misplaced_right[r].x : 0;
+  int li = (l < misplaced_left.size()) ? misplaced_left[l].x : 0;
+  while (r < misplaced_right.size() && l < misplaced_left.size()) {
+    swap(prims[ri], prims[li]);
+    if (++ri == misplaced_right[r].y && ++r < misplaced_right.size()) {
+      ri = misplaced_right[r].x;
+    }
+    if (++li == misplaced_left[l].y && ++l < misplaced_left.size()) {
+      li = misplaced_left[l].x;
+    }
+  }
+
+  return num_left;
+}
+
+void BVHObjectBinning::split(BVHReference *prims,
+                             BVHObjectBinning &left_o,
+                             BVHObjectBinning &right_o) const
+{
+  size_t N = size();
+
+  BoundBox lgeom_bounds = BoundBox::empty;
+  BoundBox rgeom_bounds = BoundBox::empty;
+  BoundBox lcent_bounds = BoundBox::empty;
+  BoundBox rcent_bounds = BoundBox::empty;
+
+  size_t l;
+  if (N < PARALLEL_MIN_SIZE) {
+    l = partition_primitives(
+        prims, start(), end(), lgeom_bounds, lcent_bounds, rgeom_bounds, rcent_bounds);
+  }
+  else {
+    l = parallel_partition_primitives(
+        prims, lgeom_bounds, lcent_bounds, rgeom_bounds, rcent_bounds);
+  }
+
   /* finish */
-  if (l != 0 && N - 1 - r != 0) {
-    right_o = BVHObjectBinning(BVHRange(rgeom_bounds, rcent_bounds, start() + l, N - 1 - r),
-                               prims);
+  if (l != 0 && N - l != 0) {
+    right_o = BVHObjectBinning(BVHRange(rgeom_bounds, rcent_bounds, start() + l, N - l), prims);
     left_o = BVHObjectBinning(BVHRange(lgeom_bounds, lcent_bounds, start(), l), prims);
     return;
   }
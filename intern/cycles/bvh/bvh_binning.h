@@ -27,12 +27,13 @@ CCL_NAMESPACE_BEGIN
 
 class BVHBuild;
 
-/* Single threaded object binner. Finds the split with the best SAH heuristic
+/* Object binner. Finds the split with the best SAH heuristic
  * by testing for each dimension multiple partitionings for regular spaced
  * partition locations. A partitioning for a partition location is computed,
  * by putting primitives whose centroid is on the left and right of the split
  * location to different sets. The SAH is evaluated by computing the number of
- * blocks occupied by the primitives in the partitions. */
+ * blocks occupied by the primitives in the partitions. Large ranges are binned
+ * and split using multiple threads. */
 
 class BVHObjectBinning : public BVHRange {
  public:
@@ -71,6 +72,33 @@ class BVHObjectBinning : public BVHRange {
   enum { MAX_BINS = 32 };
   enum { LOG_BLOCK_SIZE = 2 };
 
+  /* Ranges with at least this many primitives are binned and partitioned in
+   * parallel, in blocks of the given size. */
+  enum { PARALLEL_MIN_SIZE = 65536 };
+  enum { PARALLEL_BLOCK_SIZE = 16384 };
+
+  /* Accumulate the primitives in [begin, end) into the bins. */
+  void bin_primitives(const BVHReference *prims,
+                      int begin,
+                      int end,
+                      BoundBox bin_bounds[][4],
+                      int4 bin_count[]) const;
+
+  /* Partition [begin, end) in place around the split, returning the number of
+   * primitives that went to the left. */
+  int partition_primitives(BVHReference *prims,
+                           int begin,
+                           int end,
+                           BoundBox &lgeom_bounds,
+                           BoundBox &lcent_bounds,
+                           BoundBox &rgeom_bounds,
+                           BoundBox &rcent_bounds) const;
+  int parallel_partition_primitives(BVHReference *prims,
+                                    BoundBox &lgeom_bounds,
+                                    BoundBox &lcent_bounds,
+                                    BoundBox &rgeom_bounds,
+                                    BoundBox &rcent_bounds) const;
+
   /* computes the bin numbers for each dimension for a box. */
   __forceinline int4 get_bin(const BoundBox &box) const
   {
@@ -372,7 +372,9 @@ BVHNode *BVHBuild::run()
   BVHRange root;
 
   /* add references */
+  double add_references_start_time = time_dt();
   add_references(root);
+  times.add_references = time_dt() - add_references_start_time;
 
   if (progress.get_cancel())
     return NULL;
@@ -428,6 +430,8 @@ BVHNode *BVHBuild::run()
   /* clean up temporary memory usage by threads */
   spatial_storage.clear();
 
+  times.build_nodes = time_dt() - build_start_time;
+
   /* delete if we canceled */
   if (rootnode) {
     if (progress.get_cancel()) {
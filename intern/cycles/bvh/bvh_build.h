@@ -57,6 +57,9 @@ class BVHBuild {
 
   BVHNode *run();
 
+  /* Time spent in the phases of run(). */
+  BVHBuildTimes times;
+
  protected:
   friend class BVHMixedSplit;
   friend class BVHObjectSplit;
@@ -88,6 +88,10 @@ class BVHParams {
   /* Same as in SceneParams. */
   int bvh_type;
 
+  /* Store the control points of static curve segments with a bounding sphere in BVH2 leaves,
+   * see SceneParams. */
+  bool use_curve_leaf_keys;
+
   /* These are needed for Embree. */
   int curve_subdivisions;
 
@@ -120,6 +124,7 @@ class BVHParams {
     num_motion_triangle_steps = 0;
 
     bvh_type = 0;
+    use_curve_leaf_keys = false;
 
     curve_subdivisions = 4;
   }
@@ -309,6 +314,22 @@ struct BVHSpatialStorage {
   vector<BVHReference> new_references;
 };
 
+/* BVH Build Times
+ *
+ * Time in seconds spent in the individual phases of a BVH build, reported as
+ * part of the scene update statistics.
+ */
+
+struct BVHBuildTimes {
+  double add_references;
+  double build_nodes;
+  double pack;
+
+  BVHBuildTimes() : add_references(0.0), build_nodes(0.0), pack(0.0)
+  {
+  }
+};
+
 CCL_NAMESPACE_END
 
 #endif /* __BVH_PARAMS_H__ */
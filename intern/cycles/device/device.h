@@ -78,6 +78,7 @@ class DeviceInfo {
   bool display_device;               /* GPU is used as a display device. */
   bool has_half_images;              /* Support half-float textures. */
   bool has_nanovdb;                  /* Support NanoVDB volumes. */
+  bool has_texture_cache;            /* Image textures sampled through a texture cache. */
   bool has_volume_decoupled;         /* Decoupled volume shading. */
   bool has_branched_path;            /* Supports branched path tracing. */
   bool has_adaptive_stop_per_sample; /* Per-sample adaptive sampling stopping. */
@@ -100,6 +101,7 @@ class DeviceInfo {
     display_device = false;
     has_half_images = false;
     has_nanovdb = false;
+    has_texture_cache = false;
     has_volume_decoupled = false;
     has_branched_path = true;
     has_adaptive_stop_per_sample = false;
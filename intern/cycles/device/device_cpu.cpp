@@ -219,6 +219,9 @@ class CPUDevice : public Device {
       filter_detect_outliers_kernel;
   KernelFunctions<void (*)(int, int, float *, float *, float *, float *, int *, int)>
       filter_combine_halves_kernel;
+  KernelFunctions<void (*)(
+      int, int, int, float *, int *, int, int, int, int, int, int, float *)>
+      filter_estimate_error_kernel;
 
   KernelFunctions<void (*)(
       int, int, float *, float *, float *, float *, int *, int, int, int, float, float)>
@@ -294,6 +297,7 @@ class CPUDevice : public Device {
         REGISTER_KERNEL(filter_write_feature),
         REGISTER_KERNEL(filter_detect_outliers),
         REGISTER_KERNEL(filter_combine_halves),
+        REGISTER_KERNEL(filter_estimate_error),
         REGISTER_KERNEL(filter_nlm_calc_difference),
         REGISTER_KERNEL(filter_nlm_blur),
         REGISTER_KERNEL(filter_nlm_calc_weight),
@@ -910,6 +914,49 @@ class CPUDevice : public Device {
     return (!any);
   }
 
+  /* Test if the error left after denoising is estimated to be below the adaptive threshold for
+   * all pixels of the tile, even if the per-pixel noise is still above it. In that case all
+   * pixels are marked as converged, so progressive rendering does not sample them again. */
+  bool adaptive_sampling_denoised_converged(KernelGlobals *kg, RenderTile &tile, int sample)
+  {
+    /* Window of neighboring pixels, smaller than the denoising radius to keep the estimate cheap
+     * compared to rendering. This can only underestimate how much noise the denoiser removes. */
+    const int radius = 4;
+    const float threshold = kernel_data.integrator.adaptive_threshold;
+    int4 rect = make_int4(tile.x, tile.y, tile.x + tile.w, tile.y + tile.h);
+    float *render_buffer = (float *)tile.buffer;
+
+    for (int y = tile.y; y < tile.y + tile.h; y++) {
+      for (int x = tile.x; x < tile.x + tile.w; x++) {
+        float error;
+        filter_estimate_error_kernel()(x,
+                                       y,
+                                       sample,
+                                       render_buffer,
+                                       &rect.x,
+                                       tile.offset,
+                                       tile.stride,
+                                       kernel_data.film.pass_stride,
+                                       kernel_data.film.pass_denoising_data,
+                                       kernel_data.film.pass_sample_count,
+                                       radius,
+                                       &error);
+        if (!(error < threshold)) {
+          return false;
+        }
+      }
+    }
+
+    for (int y = tile.y; y < tile.y + tile.h; y++) {
+      for (int x = tile.x; x < tile.x + tile.w; x++) {
+        int index = tile.offset + x + y * tile.stride;
+        float *buffer = render_buffer + index * kernel_data.film.pass_stride;
+        buffer[kernel_data.film.pass_adaptive_aux_buffer + 3] = 1.0f;
+      }
+    }
+    return true;
+  }
+
   void adaptive_sampling_post(const RenderTile &tile, KernelGlobals *kg)
   {
     float *render_buffer = (float *)tile.buffer;
@@ -980,7 +1027,10 @@ class CPUDevice : public Device {
       tile.sample = sample + 1;
 
       if (task.adaptive_sampling.use && task.adaptive_sampling.need_filter(sample)) {
-        const bool stop = adaptive_sampling_filter(kg, tile, sample);
+        bool stop = adaptive_sampling_filter(kg, tile, sample);
+        if (!stop && task.adaptive_sampling.use_denoising_estimate) {
+          stop = adaptive_sampling_denoised_converged(kg, tile, sample + 1);
+        }
         if (stop) {
           const int num_progress_samples = end_sample - sample;
           tile.sample = end_sample;
@@ -1625,7 +1675,13 @@ int2 CPUSplitKernel::split_kernel_global_size(device_memory & /*kg*/,
                                               device_memory & /*data*/,
                                               DeviceTask & /*task*/)
 {
-  return make_int2(1, 1);
+  /* Every render thread runs its own split kernel, so the global size is the
+   * number of path states the stages loop over. Processing them as a batch
+   * keeps each stage hot in the instruction cache and lets shader_sort group
+   * rays by shader before evaluation. */
+  const int batch_size = max(DebugFlags().cpu.split_kernel_batch_size, 1);
+  VLOG(1) << "CPU split kernel batch size: " << batch_size << ".";
+  return make_int2(batch_size, 1);
 }
 
 uint64_t CPUSplitKernel::state_buffer_size(device_memory &kernel_globals,
@@ -1655,6 +1711,7 @@ void device_cpu_info(vector<DeviceInfo> &devices)
   info.has_osl = true;
   info.has_half_images = true;
   info.has_nanovdb = true;
+  info.has_texture_cache = true;
   info.has_profiling = true;
   info.denoisers = DENOISER_NLM;
   if (openimagedenoise_supported()) {
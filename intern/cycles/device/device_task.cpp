@@ -148,7 +148,8 @@ void DeviceTask::update_progress(RenderTile *rtile, int pixel_samples)
 
 /* Adaptive Sampling */
 
-AdaptiveSampling::AdaptiveSampling() : use(true), adaptive_step(0), min_samples(0)
+AdaptiveSampling::AdaptiveSampling()
+    : use(true), use_denoising_estimate(false), adaptive_step(0), min_samples(0)
 {
 }
 
@@ -123,6 +123,8 @@ class AdaptiveSampling {
   bool need_filter(int sample) const;
 
   bool use;
+  /* Stop tiles early based on the error estimated to be left after denoising. */
+  bool use_denoising_estimate;
   int adaptive_step;
   int min_samples;
 };
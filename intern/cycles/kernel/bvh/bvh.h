@@ -158,6 +158,8 @@ ccl_device_intersect bool scene_intersect(KernelGlobals *kg,
                                           Intersection *isect)
 {
   PROFILING_INIT(kg, PROFILING_INTERSECT);
+  PROFILING_RAY(kg, visibility);
+  PROFILING_INTERSECT_OBJECT(kg, OBJECT_NONE);
 
 #ifdef __KERNEL_OPTIX__
   uint p0 = 0;
@@ -246,6 +248,8 @@ ccl_device_intersect bool scene_intersect_local(KernelGlobals *kg,
                                                 int max_hits)
 {
   PROFILING_INIT(kg, PROFILING_INTERSECT_LOCAL);
+  /* Only the local object is intersected, whichever BVH is used. */
+  PROFILING_INTERSECT_OBJECT(kg, local_object);
 
 #  ifdef __KERNEL_OPTIX__
   uint p0 = ((uint64_t)lcg_state) & 0xFFFFFFFF;
@@ -361,6 +365,8 @@ ccl_device_intersect bool scene_intersect_shadow_all(KernelGlobals *kg,
                                                      uint *num_hits)
 {
   PROFILING_INIT(kg, PROFILING_INTERSECT_SHADOW_ALL);
+  PROFILING_RAY(kg, visibility);
+  PROFILING_INTERSECT_OBJECT(kg, OBJECT_NONE);
 
 #  ifdef __KERNEL_OPTIX__
   uint p0 = ((uint64_t)isect) & 0xFFFFFFFF;
@@ -445,6 +451,7 @@ ccl_device_intersect bool scene_intersect_volume(KernelGlobals *kg,
                                                  const uint visibility)
 {
   PROFILING_INIT(kg, PROFILING_INTERSECT_VOLUME);
+  PROFILING_INTERSECT_OBJECT(kg, OBJECT_NONE);
 
 #  ifdef __KERNEL_OPTIX__
   uint p0 = 0;
@@ -505,6 +512,7 @@ ccl_device_intersect uint scene_intersect_volume_all(KernelGlobals *kg,
                                                      const uint visibility)
 {
   PROFILING_INIT(kg, PROFILING_INTERSECT_VOLUME_ALL);
+  PROFILING_INTERSECT_OBJECT(kg, OBJECT_NONE);
 
   if (!scene_intersect_valid(ray)) {
     return false;
@@ -41,6 +41,35 @@ ccl_device_forceinline int bvh_aligned_node_intersect(KernelGlobals *kg,
 #ifdef __VISIBILITY_FLAG__
   float4 cnodes = kernel_tex_fetch(__bvh_nodes, node_addr + 0);
 #endif
+#if defined(__KERNEL_SSE2__) && defined(__KERNEL_SSE__)
+  /* Intersect both children at once. Every node row holds the bounds of one
+   * axis as { c0lo, c1lo, c0hi, c1hi }, so swapping the halves of the slab
+   * distances gives the near and far distances of both children in the lower
+   * two lanes. */
+  const ssef *bvh_nodes = (ssef *)&kg->__bvh_nodes.data[node_addr];
+
+  const ssef tx = (bvh_nodes[1] - ssef(P.x)) * ssef(idir.x);
+  const ssef ty = (bvh_nodes[2] - ssef(P.y)) * ssef(idir.y);
+  const ssef tz = (bvh_nodes[3] - ssef(P.z)) * ssef(idir.z);
+  const ssef tx_swap = shuffle<2, 3, 0, 1>(tx);
+  const ssef ty_swap = shuffle<2, 3, 0, 1>(ty);
+  const ssef tz_swap = shuffle<2, 3, 0, 1>(tz);
+
+  const ssef tnear = max(max(min(tx, tx_swap), min(ty, ty_swap)),
+                         max(min(tz, tz_swap), ssef(0.0f)));
+  const ssef tfar = min(min(max(tx, tx_swap), max(ty, ty_swap)), min(max(tz, tz_swap), ssef(t)));
+  const int mask = movemask(tfar >= tnear) & 3;
+
+  dist[0] = extract<0>(tnear);
+  dist[1] = extract<1>(tnear);
+
+#  ifdef __VISIBILITY_FLAG__
+  return mask & (((__float_as_uint(cnodes.x) & visibility) ? 1 : 0) |
+                 ((__float_as_uint(cnodes.y) & visibility) ? 2 : 0));
+#  else
+  return mask;
+#  endif
+#else
   float4 node0 = kernel_tex_fetch(__bvh_nodes, node_addr + 1);
   float4 node1 = kernel_tex_fetch(__bvh_nodes, node_addr + 2);
   float4 node2 = kernel_tex_fetch(__bvh_nodes, node_addr + 3);
@@ -67,13 +96,14 @@ ccl_device_forceinline int bvh_aligned_node_intersect(KernelGlobals *kg,
   dist[0] = c0min;
   dist[1] = c1min;
 
-#ifdef __VISIBILITY_FLAG__
+#  ifdef __VISIBILITY_FLAG__
   /* this visibility test gives a 5% performance hit, how to solve? */
   return (((c0max >= c0min) && (__float_as_uint(cnodes.x) & visibility)) ? 1 : 0) |
          (((c1max >= c1min) && (__float_as_uint(cnodes.y) & visibility)) ? 2 : 0);
-#else
+#  else
   return ((c0max >= c0min) ? 1 : 0) | ((c1max >= c1min) ? 2 : 0);
-#endif
+#  endif
+#endif /* __KERNEL_SSE2__ && __KERNEL_SSE__ */
 }
 
 ccl_device_forceinline bool bvh_unaligned_node_intersect_child(KernelGlobals *kg,
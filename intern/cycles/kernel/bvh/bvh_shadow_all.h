@@ -131,11 +131,18 @@ ccl_device_inline
           const int prim_addr2 = __float_as_int(leaf.y);
           const uint type = __float_as_int(leaf.w);
           const uint p_type = type & PRIMITIVE_ALL;
+#if BVH_FEATURE(BVH_HAIR)
+          const int leaf_prim_addr = prim_addr;
+          uint curve_mask = 0;
+#endif
 
           /* pop */
           node_addr = traversal_stack[stack_ptr];
           --stack_ptr;
 
+          PROFILING_INTERSECT_OBJECT(
+              kg, (object != OBJECT_NONE) ? object : kernel_tex_fetch(__prim_object, prim_addr));
+
           /* primitive intersection */
           while (prim_addr < prim_addr2) {
             kernel_assert((kernel_tex_fetch(__prim_type, prim_addr) & PRIMITIVE_ALL) == p_type);
@@ -162,9 +169,22 @@ ccl_device_inline
               case PRIMITIVE_MOTION_CURVE_THICK:
               case PRIMITIVE_CURVE_RIBBON:
               case PRIMITIVE_MOTION_CURVE_RIBBON: {
+                /* Cull segments four at a time, at the first segment of every group. */
+                const int group = (prim_addr - leaf_prim_addr) & 3;
+                if (group == 0) {
+                  const int num_prims = min(prim_addr2 - prim_addr, 4);
+                  curve_mask = curve_leaf_cull(kg, P, dir, isect_t, prim_addr, num_prims);
+                }
+                if (!(curve_mask & (1 << group))) {
+                  PROFILING_CURVE_SEGMENTS(kg, visibility, 1, 0, 0);
+                  hit = false;
+                  break;
+                }
+
                 const uint curve_type = kernel_tex_fetch(__prim_type, prim_addr);
                 hit = curve_intersect(
                     kg, isect_array, P, dir, visibility, object, prim_addr, ray->time, curve_type);
+                PROFILING_CURVE_SEGMENTS(kg, visibility, 0, 1, hit ? 1 : 0);
                 break;
               }
 #endif
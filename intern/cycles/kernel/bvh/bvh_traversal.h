@@ -131,6 +131,9 @@ ccl_device_noinline bool BVH_FUNCTION_FULL_NAME(BVH)(KernelGlobals *kg,
           node_addr = traversal_stack[stack_ptr];
           --stack_ptr;
 
+          PROFILING_INTERSECT_OBJECT(
+              kg, (object != OBJECT_NONE) ? object : kernel_tex_fetch(__prim_object, prim_addr));
+
           /* primitive intersection */
           switch (type & PRIMITIVE_ALL) {
             case PRIMITIVE_TRIANGLE: {
@@ -163,16 +166,36 @@ ccl_device_noinline bool BVH_FUNCTION_FULL_NAME(BVH)(KernelGlobals *kg,
             case PRIMITIVE_MOTION_CURVE_THICK:
             case PRIMITIVE_CURVE_RIBBON:
             case PRIMITIVE_MOTION_CURVE_RIBBON: {
-              for (; prim_addr < prim_addr2; prim_addr++) {
-                const uint curve_type = kernel_tex_fetch(__prim_type, prim_addr);
-                kernel_assert((curve_type & PRIMITIVE_ALL) == (type & PRIMITIVE_ALL));
-                const bool hit = curve_intersect(
-                    kg, isect, P, dir, visibility, object, prim_addr, ray->time, curve_type);
-                if (hit) {
-                  /* shadow ray early termination */
-                  if (visibility & PATH_RAY_SHADOW_OPAQUE)
-                    return true;
+              /* Cull segments four at a time before the full curve intersection. */
+              for (; prim_addr < prim_addr2; prim_addr += 4) {
+                const int num_prims = min(prim_addr2 - prim_addr, 4);
+                const uint mask = curve_leaf_cull(kg, P, dir, isect->t, prim_addr, num_prims);
+                int num_tested = 0, num_hits = 0;
+
+                for (int i = 0; i < num_prims; i++) {
+                  if (!(mask & (1 << i))) {
+                    continue;
+                  }
+
+                  const int curve_addr = prim_addr + i;
+                  const uint curve_type = kernel_tex_fetch(__prim_type, curve_addr);
+                  kernel_assert((curve_type & PRIMITIVE_ALL) == (type & PRIMITIVE_ALL));
+                  const bool hit = curve_intersect(
+                      kg, isect, P, dir, visibility, object, curve_addr, ray->time, curve_type);
+                  num_tested++;
+                  if (hit) {
+                    num_hits++;
+                    /* shadow ray early termination */
+                    if (visibility & PATH_RAY_SHADOW_OPAQUE) {
+                      PROFILING_CURVE_SEGMENTS(
+                          kg, visibility, i + 1 - num_tested, num_tested, num_hits);
+                      return true;
+                    }
+                  }
                 }
+
+                PROFILING_CURVE_SEGMENTS(
+                    kg, visibility, num_prims - num_tested, num_tested, num_hits);
               }
               break;
             }
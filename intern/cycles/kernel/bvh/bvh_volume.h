@@ -133,6 +133,9 @@ ccl_device_inline
           node_addr = traversal_stack[stack_ptr];
           --stack_ptr;
 
+          PROFILING_INTERSECT_OBJECT(
+              kg, (object != OBJECT_NONE) ? object : kernel_tex_fetch(__prim_object, prim_addr));
+
           /* primitive intersection */
           switch (type & PRIMITIVE_ALL) {
             case PRIMITIVE_TRIANGLE: {
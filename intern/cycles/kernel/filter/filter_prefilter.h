@@ -300,4 +300,108 @@ ccl_device void kernel_filter_combine_halves(int x,
   }
 }
 
+/* Helpers to read denoising features from the render buffer. */
+
+ccl_device_inline int filter_estimate_num_samples(const ccl_global float *pixel,
+                                                  int sample_count_offset,
+                                                  int sample)
+{
+  if (sample_count_offset) {
+    /* The sample count is negated while the tile is being rendered. */
+    return max((int)fabsf(pixel[sample_count_offset]), 1);
+  }
+  return sample;
+}
+
+ccl_device_inline float3 filter_estimate_mean(const ccl_global float *data, float scale)
+{
+  return make_float3(data[0], data[1], data[2]) * scale;
+}
+
+ccl_device_inline float3 filter_estimate_variance(const ccl_global float *data, int n)
+{
+  /* Approximate variance as E[x^2] - 1/N * (E[x])^2, as in kernel_filter_get_feature. */
+  float3 sum = make_float3(data[0], data[1], data[2]);
+  float3 sum_sq = make_float3(data[3], data[4], data[5]);
+  return max(sum_sq - sum * sum / n, make_float3(0.0f, 0.0f, 0.0f)) / (n * (n - 1));
+}
+
+/* Estimate the error that is left in a pixel after denoising, used to stop sampling tiles
+ * that the denoiser is expected to clean up already.
+ *
+ * Neighboring pixels are weighted by the difference of their normal, albedo and depth features,
+ * scaled by the feature variances like the denoiser does. The effective number of pixels that
+ * can be averaged then reduces the color variance of the center pixel. The result is on the same
+ * scale as the per-pixel error of kernel_do_adaptive_stopping, so it can be compared against the
+ * adaptive sampling threshold.
+ * Parameters:
+ * - sample: The sample amount in the buffer, used if there is no sample count pass.
+ * - rect: The tile area (lower pixels inclusive, upper pixels exclusive).
+ * - radius: Half size of the window of neighboring pixels.
+ */
+ccl_device float kernel_filter_estimate_error(int x,
+                                              int y,
+                                              int sample,
+                                              const ccl_global float *buffer,
+                                              int4 rect,
+                                              int offset,
+                                              int stride,
+                                              int pass_stride,
+                                              int denoising_offset,
+                                              int sample_count_offset,
+                                              int radius)
+{
+  const ccl_global float *center = buffer + (offset + y * stride + x) * pass_stride;
+  const int n = filter_estimate_num_samples(center, sample_count_offset, sample);
+  if (n < 2) {
+    /* Can't compute variance with single sample. */
+    return 1e10f;
+  }
+
+  /* Feature offsets in the denoising data pass, see DENOISING_PASS_* in kernel_types.h. */
+  const ccl_global float *data = center + denoising_offset;
+  const float inv_n = 1.0f / n;
+  const float3 normal = filter_estimate_mean(data, inv_n);
+  const float3 albedo = filter_estimate_mean(data + 6, inv_n);
+  const float3 color = filter_estimate_mean(data + 20, inv_n);
+  const float depth = data[12] * inv_n;
+  const float normal_var = average(filter_estimate_variance(data, n));
+  const float albedo_var = average(filter_estimate_variance(data + 6, n));
+  const float depth_var = max(0.0f, data[13] - depth * depth * n) / (n * (n - 1));
+  const float3 color_var = filter_estimate_variance(data + 20, n);
+
+  /* Feature bandwidths, depth is relative to the depth of the center pixel. */
+  const float normal_h = 0.04f + normal_var;
+  const float albedo_h = 0.01f + albedo_var;
+  const float depth_h = 0.0025f * depth * depth + 1e-6f + depth_var;
+
+  float weight_sum = 0.0f, weight_sq_sum = 0.0f;
+  for (int y1 = max(y - radius, rect.y); y1 < min(y + radius + 1, rect.w); y1++) {
+    for (int x1 = max(x - radius, rect.x); x1 < min(x + radius + 1, rect.z); x1++) {
+      const ccl_global float *pixel = buffer + (offset + y1 * stride + x1) * pass_stride;
+      const int n1 = filter_estimate_num_samples(pixel, sample_count_offset, sample);
+      const float inv_n1 = 1.0f / n1;
+      const ccl_global float *data1 = pixel + denoising_offset;
+
+      const float3 normal1 = filter_estimate_mean(data1, inv_n1);
+      const float3 albedo1 = filter_estimate_mean(data1 + 6, inv_n1);
+      const float depth1 = data1[12] * inv_n1;
+
+      const float distance = len_squared(normal - normal1) / normal_h +
+                             len_squared(albedo - albedo1) / albedo_h +
+                             (depth - depth1) * (depth - depth1) / depth_h;
+      const float weight = expf(-distance);
+      weight_sum += weight;
+      weight_sq_sum += weight * weight;
+    }
+  }
+
+  /* Effective number of pixels averaged by the denoiser, at least the center pixel itself. */
+  const float num_effective = max(weight_sum * weight_sum / max(weight_sq_sum, 1e-10f), 1.0f);
+  const float3 denoised_var = color_var / num_effective;
+
+  const float error = sqrtf(denoised_var.x) + sqrtf(denoised_var.y) + sqrtf(denoised_var.z);
+  return error / (n * 0.0001f + sqrtf(max(n * (color.x + color.y + color.z), 0.0f)));
+}
+
 CCL_NAMESPACE_END
@@ -96,6 +96,18 @@ ccl_device_inline AttributeDescriptor find_attribute(KernelGlobals *kg,
   return desc;
 }
 
+/* Float2 attribute storage
+ *
+ * With compact geometry float2 attributes are stored as two half floats packed into a uint. */
+
+ccl_device_inline float2 attribute_float2_fetch(KernelGlobals *kg, int offset)
+{
+  if (kernel_data.bvh.compact_geometry) {
+    return half2_to_float2(kernel_tex_fetch(__attributes_half2, offset));
+  }
+  return kernel_tex_fetch(__attributes_float2, offset);
+}
+
 /* Transform matrix attribute on meshes */
 
 ccl_device Transform primitive_attribute_matrix(KernelGlobals *kg,
@@ -75,8 +75,8 @@ ccl_device float2 curve_attribute_float2(KernelGlobals *kg,
     int k0 = __float_as_int(curvedata.x) + PRIMITIVE_UNPACK_SEGMENT(sd->type);
     int k1 = k0 + 1;
 
-    float2 f0 = kernel_tex_fetch(__attributes_float2, desc.offset + k0);
-    float2 f1 = kernel_tex_fetch(__attributes_float2, desc.offset + k1);
+    float2 f0 = attribute_float2_fetch(kg, desc.offset + k0);
+    float2 f1 = attribute_float2_fetch(kg, desc.offset + k1);
 
 #  ifdef __RAY_DIFFERENTIALS__
     if (dx)
@@ -102,7 +102,7 @@ ccl_device float2 curve_attribute_float2(KernelGlobals *kg,
     if (desc.element & (ATTR_ELEMENT_CURVE | ATTR_ELEMENT_OBJECT | ATTR_ELEMENT_MESH)) {
       const int offset = (desc.element == ATTR_ELEMENT_CURVE) ? desc.offset + sd->prim :
                                                                 desc.offset;
-      return kernel_tex_fetch(__attributes_float2, offset);
+      return attribute_float2_fetch(kg, offset);
     }
     else {
       return make_float2(0.0f, 0.0f);
@@ -619,6 +619,80 @@ ccl_device_inline bool ribbon_intersect(const float3 ray_org,
   return false;
 }
 
+/* Cull up to four curve segments of a BVH leaf against the ray, using the bounding sphere
+ * stored with their control points. Returns a bit mask of segments that may be hit. Segments
+ * without packed control points, like motion curves, are never culled. */
+ccl_device_forceinline uint curve_leaf_cull(KernelGlobals *kg,
+                                           const float3 P,
+                                           const float3 dir,
+                                           const float tmax,
+                                           const int prim_addr,
+                                           const int num_prims)
+{
+  const uint all_mask = (1 << num_prims) - 1;
+  if (!kernel_data.bvh.have_curve_leaf_keys) {
+    return all_mask;
+  }
+
+  uint keys_index[4];
+  uint unpacked_mask = 0;
+  for (int i = 0; i < 4; i++) {
+    keys_index[i] = (i < num_prims) ? kernel_tex_fetch(__prim_curve_index, prim_addr + i) :
+                                      (uint)-1;
+    if (keys_index[i] == (uint)-1) {
+      unpacked_mask |= (1 << i);
+    }
+  }
+
+  const float dd = dot(dir, dir);
+  const float inv_dd = 1.0f / dd;
+  const float inv_len = sqrtf(inv_dd);
+
+#  if defined(__KERNEL_SSE2__) && defined(__KERNEL_SSE__)
+  /* Test all four spheres at once, the leaf stores them as rows so transpose to columns. */
+  ssef sphere[4];
+  for (int i = 0; i < 4; i++) {
+    sphere[i] = (keys_index[i] != (uint)-1) ?
+                    kernel_tex_fetch_ssef(__prim_curve_keys, keys_index[i]) :
+                    ssef(0.0f);
+  }
+
+  ssef cx, cy, cz, r;
+  transpose(sphere[0], sphere[1], sphere[2], sphere[3], cx, cy, cz, r);
+
+  const ssef ocx = cx - ssef(P.x);
+  const ssef ocy = cy - ssef(P.y);
+  const ssef ocz = cz - ssef(P.z);
+  const ssef tc_dd = ocx * ssef(dir.x) + ocy * ssef(dir.y) + ocz * ssef(dir.z);
+  const ssef dist_sq = ocx * ocx + ocy * ocy + ocz * ocz - tc_dd * tc_dd * ssef(inv_dd);
+  const ssef tc = tc_dd * ssef(inv_dd);
+  const ssef tr = r * ssef(inv_len);
+
+  const sseb hit = (dist_sq <= r * r) & (tc - tr <= ssef(tmax)) & (tc + tr >= ssef(0.0f));
+  const uint hit_mask = movemask(hit);
+#  else
+  uint hit_mask = 0;
+  for (int i = 0; i < num_prims; i++) {
+    if (keys_index[i] == (uint)-1) {
+      continue;
+    }
+
+    const float4 sphere = kernel_tex_fetch(__prim_curve_keys, keys_index[i]);
+    const float3 oc = float4_to_float3(sphere) - P;
+    const float tc_dd = dot(oc, dir);
+    const float dist_sq = dot(oc, oc) - tc_dd * tc_dd * inv_dd;
+    const float tc = tc_dd * inv_dd;
+    const float tr = sphere.w * inv_len;
+
+    if (dist_sq <= sphere.w * sphere.w && tc - tr <= tmax && tc + tr >= 0.0f) {
+      hit_mask |= (1 << i);
+    }
+  }
+#  endif
+
+  return (hit_mask | unpacked_mask) & all_mask;
+}
+
 ccl_device_forceinline bool curve_intersect(KernelGlobals *kg,
                                             Intersection *isect,
                                             const float3 P,
@@ -652,7 +726,17 @@ ccl_device_forceinline bool curve_intersect(KernelGlobals *kg,
   int kb = min(k1 + 1, __float_as_int(v00.x) + __float_as_int(v00.y) - 1);
 
   float4 curve[4];
-  if (!is_motion) {
+  const uint keys_index = (kernel_data.bvh.have_curve_leaf_keys) ?
+                              kernel_tex_fetch(__prim_curve_index, curveAddr) :
+                              (uint)-1;
+  if (keys_index != (uint)-1) {
+    /* Control points stored in the BVH leaf, next to the bounding sphere. */
+    curve[0] = kernel_tex_fetch(__prim_curve_keys, keys_index + 1);
+    curve[1] = kernel_tex_fetch(__prim_curve_keys, keys_index + 2);
+    curve[2] = kernel_tex_fetch(__prim_curve_keys, keys_index + 3);
+    curve[3] = kernel_tex_fetch(__prim_curve_keys, keys_index + 4);
+  }
+  else if (!is_motion) {
     curve[0] = kernel_tex_fetch(__curve_keys, ka);
     curve[1] = kernel_tex_fetch(__curve_keys, k0);
     curve[2] = kernel_tex_fetch(__curve_keys, k1);
@@ -331,7 +331,7 @@ ccl_device float2 patch_eval_float2(KernelGlobals *kg,
     *dv = make_float2(0.0f, 0.0f);
 
   for (int i = 0; i < num_control; i++) {
-    float2 v = kernel_tex_fetch(__attributes_float2, offset + indices[i]);
+    float2 v = attribute_float2_fetch(kg, offset + indices[i]);
 
     val += v * weights[i];
     if (du)
@@ -31,7 +31,7 @@ ccl_device_inline void subd_triangle_patch_uv(KernelGlobals *kg,
                                               const ShaderData *sd,
                                               float2 uv[3])
 {
-  uint4 tri_vindex = kernel_tex_fetch(__tri_vindex, sd->prim);
+  uint4 tri_vindex = triangle_vindex(kg, sd->prim);
 
   uv[0] = kernel_tex_fetch(__tri_patch_uv, tri_vindex.x);
   uv[1] = kernel_tex_fetch(__tri_patch_uv, tri_vindex.y);
@@ -296,8 +296,7 @@ ccl_device_noinline float2 subd_triangle_attribute_float2(KernelGlobals *kg,
     if (dy)
       *dy = make_float2(0.0f, 0.0f);
 
-    return kernel_tex_fetch(__attributes_float2,
-                            desc.offset + subd_triangle_patch_face(kg, patch));
+    return attribute_float2_fetch(kg, desc.offset + subd_triangle_patch_face(kg, patch));
   }
   else if (desc.element == ATTR_ELEMENT_VERTEX || desc.element == ATTR_ELEMENT_VERTEX_MOTION) {
     float2 uv[3];
@@ -305,10 +304,10 @@ ccl_device_noinline float2 subd_triangle_attribute_float2(KernelGlobals *kg,
 
     uint4 v = subd_triangle_patch_indices(kg, patch);
 
-    float2 f0 = kernel_tex_fetch(__attributes_float2, desc.offset + v.x);
-    float2 f1 = kernel_tex_fetch(__attributes_float2, desc.offset + v.y);
-    float2 f2 = kernel_tex_fetch(__attributes_float2, desc.offset + v.z);
-    float2 f3 = kernel_tex_fetch(__attributes_float2, desc.offset + v.w);
+    float2 f0 = attribute_float2_fetch(kg, desc.offset + v.x);
+    float2 f1 = attribute_float2_fetch(kg, desc.offset + v.y);
+    float2 f2 = attribute_float2_fetch(kg, desc.offset + v.z);
+    float2 f3 = attribute_float2_fetch(kg, desc.offset + v.w);
 
     if (subd_triangle_patch_num_corners(kg, patch) != 4) {
       f1 = (f1 + f0) * 0.5f;
@@ -337,10 +336,10 @@ ccl_device_noinline float2 subd_triangle_attribute_float2(KernelGlobals *kg,
 
     float2 f0, f1, f2, f3;
 
-    f0 = kernel_tex_fetch(__attributes_float2, corners[0] + desc.offset);
-    f1 = kernel_tex_fetch(__attributes_float2, corners[1] + desc.offset);
-    f2 = kernel_tex_fetch(__attributes_float2, corners[2] + desc.offset);
-    f3 = kernel_tex_fetch(__attributes_float2, corners[3] + desc.offset);
+    f0 = attribute_float2_fetch(kg, corners[0] + desc.offset);
+    f1 = attribute_float2_fetch(kg, corners[1] + desc.offset);
+    f2 = attribute_float2_fetch(kg, corners[2] + desc.offset);
+    f3 = attribute_float2_fetch(kg, corners[3] + desc.offset);
 
     if (subd_triangle_patch_num_corners(kg, patch) != 4) {
       f1 = (f1 + f0) * 0.5f;
@@ -366,7 +365,7 @@ ccl_device_noinline float2 subd_triangle_attribute_float2(KernelGlobals *kg,
     if (dy)
       *dy = make_float2(0.0f, 0.0f);
 
-    return kernel_tex_fetch(__attributes_float2, desc.offset);
+    return attribute_float2_fetch(kg, desc.offset);
   }
   else {
     if (dx)
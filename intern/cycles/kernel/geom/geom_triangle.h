@@ -22,11 +22,40 @@
 
 CCL_NAMESPACE_BEGIN
 
+/* Vertex indices of a triangle. The w component is the offset of the triangle in
+ * __prim_tri_verts. */
+ccl_device_inline uint4 triangle_vindex(KernelGlobals *kg, int prim)
+{
+  if (!kernel_data.bvh.compact_geometry) {
+    return kernel_tex_fetch(__tri_vindex, prim);
+  }
+
+  const uint2 packed = kernel_tex_fetch(__tri_vindex_compact, prim);
+  const uint verts = kernel_tex_fetch(__tri_vindex_verts, prim);
+
+  if (packed.y & TRI_VINDEX_OVERFLOW) {
+    const uint2 v = kernel_tex_fetch(__tri_vindex_overflow, packed.y & ~TRI_VINDEX_OVERFLOW);
+    return make_uint4(packed.x, v.x, v.y, verts);
+  }
+
+  const uint2 v = tri_vindex_unpack_deltas(packed.x, packed.y);
+  return make_uint4(packed.x, v.x, v.y, verts);
+}
+
+/* Vertex normal, in object space unless the object transform was applied. */
+ccl_device_inline float3 triangle_vertex_normal(KernelGlobals *kg, uint vert)
+{
+  if (kernel_data.bvh.compact_geometry) {
+    return oct_to_float3(kernel_tex_fetch(__tri_vnormal_oct, vert));
+  }
+  return float4_to_float3(kernel_tex_fetch(__tri_vnormal, vert));
+}
+
 /* Normal on triangle. */
 ccl_device_inline float3 triangle_normal(KernelGlobals *kg, ShaderData *sd)
 {
   /* load triangle vertices */
-  const uint4 tri_vindex = kernel_tex_fetch(__tri_vindex, sd->prim);
+  const uint4 tri_vindex = triangle_vindex(kg, sd->prim);
   const float3 v0 = float4_to_float3(kernel_tex_fetch(__prim_tri_verts, tri_vindex.w + 0));
   const float3 v1 = float4_to_float3(kernel_tex_fetch(__prim_tri_verts, tri_vindex.w + 1));
   const float3 v2 = float4_to_float3(kernel_tex_fetch(__prim_tri_verts, tri_vindex.w + 2));
@@ -45,7 +74,7 @@ ccl_device_inline void triangle_point_normal(
     KernelGlobals *kg, int object, int prim, float u, float v, float3 *P, float3 *Ng, int *shader)
 {
   /* load triangle vertices */
-  const uint4 tri_vindex = kernel_tex_fetch(__tri_vindex, prim);
+  const uint4 tri_vindex = triangle_vindex(kg, prim);
   float3 v0 = float4_to_float3(kernel_tex_fetch(__prim_tri_verts, tri_vindex.w + 0));
   float3 v1 = float4_to_float3(kernel_tex_fetch(__prim_tri_verts, tri_vindex.w + 1));
   float3 v2 = float4_to_float3(kernel_tex_fetch(__prim_tri_verts, tri_vindex.w + 2));
@@ -69,7 +98,7 @@ ccl_device_inline void triangle_point_normal(
 
 ccl_device_inline void triangle_vertices(KernelGlobals *kg, int prim, float3 P[3])
 {
-  const uint4 tri_vindex = kernel_tex_fetch(__tri_vindex, prim);
+  const uint4 tri_vindex = triangle_vindex(kg, prim);
   P[0] = float4_to_float3(kernel_tex_fetch(__prim_tri_verts, tri_vindex.w + 0));
   P[1] = float4_to_float3(kernel_tex_fetch(__prim_tri_verts, tri_vindex.w + 1));
   P[2] = float4_to_float3(kernel_tex_fetch(__prim_tri_verts, tri_vindex.w + 2));
@@ -82,13 +111,13 @@ ccl_device_inline void triangle_vertices_and_normals(KernelGlobals *kg,
                                                      float3 P[3],
                                                      float3 N[3])
 {
-  const uint4 tri_vindex = kernel_tex_fetch(__tri_vindex, prim);
+  const uint4 tri_vindex = triangle_vindex(kg, prim);
   P[0] = float4_to_float3(kernel_tex_fetch(__prim_tri_verts, tri_vindex.w + 0));
   P[1] = float4_to_float3(kernel_tex_fetch(__prim_tri_verts, tri_vindex.w + 1));
   P[2] = float4_to_float3(kernel_tex_fetch(__prim_tri_verts, tri_vindex.w + 2));
-  N[0] = float4_to_float3(kernel_tex_fetch(__tri_vnormal, tri_vindex.x));
-  N[1] = float4_to_float3(kernel_tex_fetch(__tri_vnormal, tri_vindex.y));
-  N[2] = float4_to_float3(kernel_tex_fetch(__tri_vnormal, tri_vindex.z));
+  N[0] = triangle_vertex_normal(kg, tri_vindex.x);
+  N[1] = triangle_vertex_normal(kg, tri_vindex.y);
+  N[2] = triangle_vertex_normal(kg, tri_vindex.z);
 }
 
 /* Interpolate smooth vertex normal from vertices */
@@ -97,10 +126,10 @@ ccl_device_inline float3
 triangle_smooth_normal(KernelGlobals *kg, float3 Ng, int prim, float u, float v)
 {
   /* load triangle vertices */
-  const uint4 tri_vindex = kernel_tex_fetch(__tri_vindex, prim);
-  float3 n0 = float4_to_float3(kernel_tex_fetch(__tri_vnormal, tri_vindex.x));
-  float3 n1 = float4_to_float3(kernel_tex_fetch(__tri_vnormal, tri_vindex.y));
-  float3 n2 = float4_to_float3(kernel_tex_fetch(__tri_vnormal, tri_vindex.z));
+  const uint4 tri_vindex = triangle_vindex(kg, prim);
+  float3 n0 = triangle_vertex_normal(kg, tri_vindex.x);
+  float3 n1 = triangle_vertex_normal(kg, tri_vindex.y);
+  float3 n2 = triangle_vertex_normal(kg, tri_vindex.z);
 
   float3 N = safe_normalize((1.0f - u - v) * n2 + u * n0 + v * n1);
 
@@ -111,10 +140,10 @@ ccl_device_inline float3 triangle_smooth_normal_unnormalized(
     KernelGlobals *kg, ShaderData *sd, float3 Ng, int prim, float u, float v)
 {
   /* load triangle vertices */
-  const uint4 tri_vindex = kernel_tex_fetch(__tri_vindex, prim);
-  float3 n0 = float4_to_float3(kernel_tex_fetch(__tri_vnormal, tri_vindex.x));
-  float3 n1 = float4_to_float3(kernel_tex_fetch(__tri_vnormal, tri_vindex.y));
-  float3 n2 = float4_to_float3(kernel_tex_fetch(__tri_vnormal, tri_vindex.z));
+  const uint4 tri_vindex = triangle_vindex(kg, prim);
+  float3 n0 = triangle_vertex_normal(kg, tri_vindex.x);
+  float3 n1 = triangle_vertex_normal(kg, tri_vindex.y);
+  float3 n2 = triangle_vertex_normal(kg, tri_vindex.z);
 
   /* ensure that the normals are in object space */
   if (sd->object_flag & SD_OBJECT_TRANSFORM_APPLIED) {
@@ -136,7 +165,7 @@ ccl_device_inline void triangle_dPdudv(KernelGlobals *kg,
                                        ccl_addr_space float3 *dPdv)
 {
   /* fetch triangle vertex coordinates */
-  const uint4 tri_vindex = kernel_tex_fetch(__tri_vindex, prim);
+  const uint4 tri_vindex = triangle_vindex(kg, prim);
   const float3 p0 = float4_to_float3(kernel_tex_fetch(__prim_tri_verts, tri_vindex.w + 0));
   const float3 p1 = float4_to_float3(kernel_tex_fetch(__prim_tri_verts, tri_vindex.w + 1));
   const float3 p2 = float4_to_float3(kernel_tex_fetch(__prim_tri_verts, tri_vindex.w + 2));
@@ -155,7 +184,7 @@ ccl_device float triangle_attribute_float(
     float f0, f1, f2;
 
     if (desc.element & (ATTR_ELEMENT_VERTEX | ATTR_ELEMENT_VERTEX_MOTION)) {
-      const uint4 tri_vindex = kernel_tex_fetch(__tri_vindex, sd->prim);
+      const uint4 tri_vindex = triangle_vindex(kg, sd->prim);
       f0 = kernel_tex_fetch(__attributes_float, desc.offset + tri_vindex.x);
       f1 = kernel_tex_fetch(__attributes_float, desc.offset + tri_vindex.y);
       f2 = kernel_tex_fetch(__attributes_float, desc.offset + tri_vindex.z);
@@ -205,16 +234,16 @@ ccl_device float2 triangle_attribute_float2(KernelGlobals *kg,
     float2 f0, f1, f2;
 
     if (desc.element & (ATTR_ELEMENT_VERTEX | ATTR_ELEMENT_VERTEX_MOTION)) {
-      const uint4 tri_vindex = kernel_tex_fetch(__tri_vindex, sd->prim);
-      f0 = kernel_tex_fetch(__attributes_float2, desc.offset + tri_vindex.x);
-      f1 = kernel_tex_fetch(__attributes_float2, desc.offset + tri_vindex.y);
-      f2 = kernel_tex_fetch(__attributes_float2, desc.offset + tri_vindex.z);
+      const uint4 tri_vindex = triangle_vindex(kg, sd->prim);
+      f0 = attribute_float2_fetch(kg, desc.offset + tri_vindex.x);
+      f1 = attribute_float2_fetch(kg, desc.offset + tri_vindex.y);
+      f2 = attribute_float2_fetch(kg, desc.offset + tri_vindex.z);
     }
     else {
       const int tri = desc.offset + sd->prim * 3;
-      f0 = kernel_tex_fetch(__attributes_float2, tri + 0);
-      f1 = kernel_tex_fetch(__attributes_float2, tri + 1);
-      f2 = kernel_tex_fetch(__attributes_float2, tri + 2);
+      f0 = attribute_float2_fetch(kg, tri + 0);
+      f1 = attribute_float2_fetch(kg, tri + 1);
+      f2 = attribute_float2_fetch(kg, tri + 2);
     }
 
 #ifdef __RAY_DIFFERENTIALS__
@@ -237,7 +266,7 @@ ccl_device float2 triangle_attribute_float2(KernelGlobals *kg,
     if (desc.element & (ATTR_ELEMENT_FACE | ATTR_ELEMENT_OBJECT | ATTR_ELEMENT_MESH)) {
       const int offset = (desc.element == ATTR_ELEMENT_FACE) ? desc.offset + sd->prim :
                                                                desc.offset;
-      return kernel_tex_fetch(__attributes_float2, offset);
+      return attribute_float2_fetch(kg, offset);
     }
     else {
       return make_float2(0.0f, 0.0f);
@@ -255,7 +284,7 @@ ccl_device float3 triangle_attribute_float3(KernelGlobals *kg,
     float3 f0, f1, f2;
 
     if (desc.element & (ATTR_ELEMENT_VERTEX | ATTR_ELEMENT_VERTEX_MOTION)) {
-      const uint4 tri_vindex = kernel_tex_fetch(__tri_vindex, sd->prim);
+      const uint4 tri_vindex = triangle_vindex(kg, sd->prim);
       f0 = float4_to_float3(kernel_tex_fetch(__attributes_float3, desc.offset + tri_vindex.x));
       f1 = float4_to_float3(kernel_tex_fetch(__attributes_float3, desc.offset + tri_vindex.y));
       f2 = float4_to_float3(kernel_tex_fetch(__attributes_float3, desc.offset + tri_vindex.z));
@@ -306,7 +335,7 @@ ccl_device float4 triangle_attribute_float4(KernelGlobals *kg,
     float4 f0, f1, f2;
 
     if (desc.element & (ATTR_ELEMENT_VERTEX | ATTR_ELEMENT_VERTEX_MOTION)) {
-      const uint4 tri_vindex = kernel_tex_fetch(__tri_vindex, sd->prim);
+      const uint4 tri_vindex = triangle_vindex(kg, sd->prim);
       f0 = kernel_tex_fetch(__attributes_float3, desc.offset + tri_vindex.x);
       f1 = kernel_tex_fetch(__attributes_float3, desc.offset + tri_vindex.y);
       f2 = kernel_tex_fetch(__attributes_float3, desc.offset + tri_vindex.z);
@@ -90,6 +90,125 @@ ccl_device float4 volume_attribute_float4(KernelGlobals *kg,
   }
 }
 
+/* Empty Space Skipping
+ *
+ * Volume objects may have a coarse occupancy grid, one bit per cell of a few
+ * voxels, marking cells that contain active voxels. Since the shader is only
+ * evaluated inside the bounds of active voxels anyway, any cell without them
+ * contributes nothing and can be stepped over without shading. */
+
+ccl_device_inline bool volume_occupancy_cell_set(KernelGlobals *kg,
+                                                 const KernelVolumeOccupancy *kocc,
+                                                 const int3 cell)
+{
+  const int index = (cell.z * kocc->res_y + cell.y) * kocc->res_x + cell.x;
+  const uint bits = kernel_tex_fetch(__volume_occupancy, kocc->offset + (index >> 5));
+  return (bits & (1u << (index & 31))) != 0;
+}
+
+ccl_device_inline void volume_occupancy_axis_init(
+    float P, float D, int cell, float t, float *t_next, float *t_delta, int *step)
+{
+  if (D > 0.0f) {
+    *t_next = t + ((float)(cell + 1) - P) / D;
+    *t_delta = 1.0f / D;
+    *step = 1;
+  }
+  else if (D < 0.0f) {
+    *t_next = t + ((float)cell - P) / D;
+    *t_delta = -1.0f / D;
+    *step = -1;
+  }
+  else {
+    *t_next = FLT_MAX;
+    *t_delta = FLT_MAX;
+    *step = 0;
+  }
+}
+
+/* Returns the distance along the ray up to which the volume of the object is
+ * known to be empty, starting from t. Returns t when nothing is known, and
+ * FLT_MAX when the ray does not pass through any occupied cell anymore. */
+
+ccl_device float volume_occupancy_empty_until(KernelGlobals *kg,
+                                              int object,
+                                              const Ray *ray,
+                                              float t)
+{
+  const KernelVolumeOccupancy kocc = kernel_tex_fetch(__object_volume_occupancy, object);
+  if (kocc.offset == -1) {
+    return t;
+  }
+
+  /* Transform ray into cell space, distances along the ray are preserved. */
+  const Transform itfm = object_fetch_transform(kg, object, OBJECT_INVERSE_TRANSFORM);
+  const float3 P = transform_point(&kocc.object_to_cell, transform_point(&itfm, ray->P));
+  const float3 D = transform_direction(&kocc.object_to_cell,
+                                       transform_direction(&itfm, ray->D));
+  const float3 res = make_float3((float)kocc.res_x, (float)kocc.res_y, (float)kocc.res_z);
+
+  /* Clip against the grid bounds. */
+  const float3 idir = rcp(D);
+  const float3 t0 = (zero_float3() - P) * idir;
+  const float3 t1 = (res - P) * idir;
+  const float3 tmin3 = min(t0, t1);
+  const float3 tmax3 = max(t0, t1);
+  const float tnear = max(max3(tmin3), t);
+  const float tfar = min3(tmax3);
+
+  if (!(tnear < tfar)) {
+    /* Comparison fails for NaN too, in which case nothing is known. */
+    return (tnear >= tfar) ? FLT_MAX : t;
+  }
+
+  /* Walk a limited number of cells, stopping at the first occupied one. */
+  const float3 start = P + D * tnear;
+  int3 cell = make_int3(clamp((int)floorf(start.x), 0, kocc.res_x - 1),
+                        clamp((int)floorf(start.y), 0, kocc.res_y - 1),
+                        clamp((int)floorf(start.z), 0, kocc.res_z - 1));
+
+  float3 t_next, t_delta;
+  int3 step;
+  volume_occupancy_axis_init(start.x, D.x, cell.x, tnear, &t_next.x, &t_delta.x, &step.x);
+  volume_occupancy_axis_init(start.y, D.y, cell.y, tnear, &t_next.y, &t_delta.y, &step.y);
+  volume_occupancy_axis_init(start.z, D.z, cell.z, tnear, &t_next.z, &t_delta.z, &step.z);
+
+  float t_cell = tnear;
+
+  for (int i = 0; i < VOLUME_OCCUPANCY_MAX_WALK; i++) {
+    if (volume_occupancy_cell_set(kg, &kocc, cell)) {
+      return t_cell;
+    }
+
+    if (t_next.x < t_next.y && t_next.x < t_next.z) {
+      t_cell = t_next.x;
+      t_next.x += t_delta.x;
+      cell.x += step.x;
+      if (cell.x < 0 || cell.x >= kocc.res_x) {
+        return FLT_MAX;
+      }
+    }
+    else if (t_next.y < t_next.z) {
+      t_cell = t_next.y;
+      t_next.y += t_delta.y;
+      cell.y += step.y;
+      if (cell.y < 0 || cell.y >= kocc.res_y) {
+        return FLT_MAX;
+      }
+    }
+    else {
+      t_cell = t_next.z;
+      t_next.z += t_delta.z;
+      cell.z += step.z;
+      if (cell.z < 0 || cell.z >= kocc.res_z) {
+        return FLT_MAX;
+      }
+    }
+  }
+
+  return t_cell;
+}
+
 #endif
 
 CCL_NAMESPACE_END
@@ -240,7 +240,19 @@ ccl_device void kernel_bake_evaluate(
   if (prim == -1)
     return;
 
-  prim += kernel_data.bake.tri_offset;
+  int object = kernel_data.bake.object_index;
+  int tri_offset = kernel_data.bake.tri_offset;
+
+  if (object == OBJECT_NONE) {
+    /* Batch of objects, each occupying a range of rows of the buffer. */
+    const uint2 row = kernel_tex_fetch(__bake_rows, y);
+    object = row.x;
+    tri_offset = row.y;
+    if (object == OBJECT_NONE)
+      return;
+  }
+
+  prim += tri_offset;
 
   /* Random number generator. */
   uint rng_hash = hash_uint(seed) ^ kernel_data.integrator.seed;
@@ -270,7 +282,6 @@ ccl_device void kernel_bake_evaluate(
   }
 
   /* Shader data setup. */
-  int object = kernel_data.bake.object_index;
   int shader;
   float3 P, Ng;
 
@@ -101,6 +101,12 @@
 #ifdef make_int4
 #  undef make_int4
 #endif
+#ifdef make_uint2
+#  undef make_uint2
+#endif
+#ifdef make_uint4
+#  undef make_uint4
+#endif
 #ifdef make_uchar4
 #  undef make_uchar4
 #endif
@@ -111,6 +117,8 @@
 #define make_int2(x, y) ((int2)(x, y))
 #define make_int3(x, y, z) ((int3)(x, y, z))
 #define make_int4(x, y, z, w) ((int4)(x, y, z, w))
+#define make_uint2(x, y) ((uint2)(x, y))
+#define make_uint4(x, y, z, w) ((uint4)(x, y, z, w))
 #define make_uchar4(x, y, z, w) ((uchar4)(x, y, z, w))
 
 /* math functions */
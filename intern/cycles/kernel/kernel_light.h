@@ -35,6 +35,138 @@ typedef struct LightSample {
   LightType type; /* type of light */
 } LightSample;
 
+/* Light Tree
+ *
+ * Picks lights proportional to their energy divided by the squared distance
+ * to the shading point, estimated from the bounds of the tree nodes. The
+ * distribution is still used to choose between mesh lights and lamps, the
+ * tree then replaces the emitter it picked with one that is more likely to
+ * matter at the shading point. */
+
+ccl_device_inline float light_tree_node_importance(KernelGlobals *kg, int node, float3 P)
+{
+  const ccl_global KernelLightTreeNode *knode = &kernel_tex_fetch(__light_tree_nodes, node);
+  const float3 bounds_min = make_float3(
+      knode->bounds_min[0], knode->bounds_min[1], knode->bounds_min[2]);
+  const float3 bounds_max = make_float3(
+      knode->bounds_max[0], knode->bounds_max[1], knode->bounds_max[2]);
+
+  /* Clamp the distance to the size of the node, so emitters close to or
+   * around the shading point do not get an arbitrarily high importance. */
+  const float3 centroid = 0.5f * (bounds_min + bounds_max);
+  const float radius_squared = 0.25f * len_squared(bounds_max - bounds_min);
+  const float distance_squared = max(len_squared(P - centroid), max(radius_squared, 1e-12f));
+
+  return knode->energy / distance_squared;
+}
+
+/* Probability of descending into the first child of an inner node. */
+ccl_device_inline float light_tree_first_child_prob(KernelGlobals *kg,
+                                                    int node,
+                                                    int second_child,
+                                                    float3 P)
+{
+  const float first_importance = light_tree_node_importance(kg, node + 1, P);
+  const float second_importance = light_tree_node_importance(kg, second_child, P);
+  const float total_importance = first_importance + second_importance;
+
+  return (total_importance > 0.0f) ? first_importance / total_importance : 0.5f;
+}
+
+/* Returns the distribution index of the sampled emitter, and its probability in pdf. */
+ccl_device int light_tree_sample(KernelGlobals *kg, int node, float3 P, float *randu, float *pdf)
+{
+  float u = *randu;
+  float prob = 1.0f;
+  int child = kernel_tex_fetch(__light_tree_nodes, node).child;
+
+  while (child >= 0) {
+    const float first_prob = light_tree_first_child_prob(kg, node, child, P);
+
+    if (u < first_prob) {
+      node = node + 1;
+      u = u / first_prob;
+      prob *= first_prob;
+    }
+    else {
+      node = child;
+      u = (u - first_prob) / (1.0f - first_prob);
+      prob *= 1.0f - first_prob;
+    }
+
+    child = kernel_tex_fetch(__light_tree_nodes, node).child;
+  }
+
+  /* Rescale to reuse random number, like the light distribution does. */
+  *randu = clamp(u, 0.0f, 1.0f);
+  *pdf = prob;
+
+  return ~child;
+}
+
+/* Probability of picking the emitter from the tree, by walking up from its leaf. */
+ccl_device float light_tree_pdf(KernelGlobals *kg, int distribution_index, float3 P)
+{
+  const uint leaf = kernel_tex_fetch(__light_tree_leaf, distribution_index);
+  if (leaf == ~0u) {
+    return 0.0f;
+  }
+
+  int node = leaf;
+  int parent = kernel_tex_fetch(__light_tree_nodes, node).parent;
+  float pdf = 1.0f;
+
+  while (parent >= 0) {
+    const int second_child = kernel_tex_fetch(__light_tree_nodes, parent).child;
+    const float first_prob = light_tree_first_child_prob(kg, parent, second_child, P);
+
+    pdf *= (node == parent + 1) ? first_prob : 1.0f - first_prob;
+
+    node = parent;
+    parent = kernel_tex_fetch(__light_tree_nodes, node).parent;
+  }
+
+  return pdf;
+}
+
+/* Replace an emitter picked from the light distribution by one picked from the tree. Distant and
+ * background lights are not part of the tree and are kept. */
+ccl_device int light_tree_sample_distribution(
+    KernelGlobals *kg, int index, float3 P, float *randu, float *pdf)
+{
+  const int prim = kernel_tex_fetch(__light_distribution, index).prim;
+
+  if (prim >= 0) {
+    return light_tree_sample(kg, kernel_data.integrator.light_tree_triangle_root, P, randu, pdf);
+  }
+  else if (kernel_tex_fetch(__light_tree_leaf, index) != ~0u) {
+    return light_tree_sample(kg, kernel_data.integrator.light_tree_lamp_root, P, randu, pdf);
+  }
+
+  *pdf = 1.0f;
+  return index;
+}
+
+/* The pdf of lamps assumes all lights are picked uniformly. Any lamp in the tree was picked
+ * instead of one of the local lamps, so the probability scales by their number. */
+ccl_device_inline float light_tree_lamp_pdf_scale(KernelGlobals *kg, float tree_pdf)
+{
+  return kernel_data.integrator.light_tree_num_local_lights * tree_pdf;
+}
+
+ccl_device float light_tree_lamp_pdf(KernelGlobals *kg, int lamp, float3 P)
+{
+  /* Lamps follow the mesh lights in the light distribution. */
+  const int index = kernel_data.integrator.num_distribution -
+                    kernel_data.integrator.num_all_lights + lamp;
+
+  if (kernel_tex_fetch(__light_tree_leaf, index) == ~0u) {
+    return 1.0f;
+  }
+
+  return light_tree_lamp_pdf_scale(kg, light_tree_pdf(kg, index, P));
+}
+
 /* Regular Light */
 
 ccl_device_inline bool lamp_light_sample(
@@ -330,6 +462,10 @@ ccl_device bool lamp_light_eval(
 
   ls->pdf *= kernel_data.integrator.pdf_lights;
 
+  if (kernel_data.integrator.use_light_tree) {
+    ls->pdf *= light_tree_lamp_pdf(kg, lamp, P);
+  }
+
   return true;
 }
 
@@ -365,6 +501,60 @@ ccl_device_inline bool triangle_world_space_vertices(
   return has_motion;
 }
 
+/* The pdf of triangles assumes they are picked proportional to their area. With the light tree
+ * they are picked with the probability of the tree instead. */
+ccl_device float light_tree_triangle_pdf_scale(KernelGlobals *kg,
+                                               int object,
+                                               int prim,
+                                               float tree_pdf)
+{
+  float3 V[3];
+  triangle_world_space_vertices(kg, object, prim, -1.0f, V);
+  const float area = triangle_area(V[0], V[1], V[2]);
+
+  if (UNLIKELY(area == 0.0f)) {
+    return 0.0f;
+  }
+
+  return tree_pdf * kernel_data.integrator.light_tree_triangle_area / area;
+}
+
+/* Find the light distribution index of an emissive triangle. Mesh lights are
+ * stored ordered by object and primitive, so this is a binary search. */
+ccl_device int light_distribution_triangle_index(KernelGlobals *kg, int object, int prim)
+{
+  const int num_triangles = kernel_data.integrator.num_distribution -
+                            kernel_data.integrator.num_all_lights;
+  int first = 0;
+  int len = num_triangles;
+
+  while (len > 0) {
+    const int half_len = len >> 1;
+    const int middle = first + half_len;
+    const ccl_global KernelLightDistribution *kdistribution = &kernel_tex_fetch(
+        __light_distribution, middle);
+    const int middle_object = kdistribution->mesh_light.object_id;
+
+    if (middle_object < object || (middle_object == object && kdistribution->prim < prim)) {
+      first = middle + 1;
+      len = len - half_len - 1;
+    }
+    else {
+      len = half_len;
+    }
+  }
+
+  if (first < num_triangles) {
+    const ccl_global KernelLightDistribution *kdistribution = &kernel_tex_fetch(
+        __light_distribution, first);
+    if (kdistribution->mesh_light.object_id == object && kdistribution->prim == prim) {
+      return first;
+    }
+  }
+
+  return -1;
+}
+
 ccl_device_inline float triangle_light_pdf_area(KernelGlobals *kg,
                                                 const float3 Ng,
                                                 const float3 I,
@@ -385,6 +575,18 @@ ccl_device_forceinline float triangle_light_pdf(KernelGlobals *kg, ShaderData *s
    * and simple area sampling, comparing the distance to the triangle plane
    * to the length of the edges of the triangle. */
 
+  float tree_scale = 1.0f;
+  if (kernel_data.integrator.use_light_tree) {
+    const int index = light_distribution_triangle_index(kg, sd->object, sd->prim);
+    if (index == -1) {
+      return 0.0f;
+    }
+
+    const float3 Px = sd->P + sd->I * t;
+    const float tree_pdf = light_tree_pdf(kg, index, Px);
+    tree_scale = light_tree_triangle_pdf_scale(kg, sd->object, sd->prim, tree_pdf);
+  }
+
   float3 V[3];
   bool has_motion = triangle_world_space_vertices(kg, sd->object, sd->prim, sd->time, V);
 
@@ -427,11 +629,11 @@ ccl_device_forceinline float triangle_light_pdf(KernelGlobals *kg, ShaderData *s
         area = 0.5f * len(N);
       }
       const float pdf = area * kernel_data.integrator.pdf_triangles;
-      return pdf / solid_angle;
+      return tree_scale * pdf / solid_angle;
     }
   }
   else {
-    float pdf = triangle_light_pdf_area(kg, sd->Ng, sd->I, t);
+    float pdf = tree_scale * triangle_light_pdf_area(kg, sd->Ng, sd->I, t);
     if (has_motion) {
       const float area = 0.5f * len(N);
       if (UNLIKELY(area == 0.0f)) {
@@ -669,10 +871,16 @@ ccl_device_noinline bool light_sample(KernelGlobals *kg,
                                       int bounce,
                                       LightSample *ls)
 {
+  float tree_pdf = 1.0f;
+
   if (lamp < 0) {
     /* sample index */
     int index = light_distribution_sample(kg, &randu);
 
+    if (kernel_data.integrator.use_light_tree) {
+      index = light_tree_sample_distribution(kg, index, P, &randu, &tree_pdf);
+    }
+
     /* fetch light data */
     const ccl_global KernelLightDistribution *kdistribution = &kernel_tex_fetch(
         __light_distribution, index);
@@ -684,17 +892,33 @@ ccl_device_noinline bool light_sample(KernelGlobals *kg,
 
       triangle_light_sample(kg, prim, object, randu, randv, time, ls, P);
       ls->shader |= shader_flag;
+
+      if (kernel_data.integrator.use_light_tree) {
+        ls->pdf *= light_tree_triangle_pdf_scale(kg, object, prim, tree_pdf);
+      }
+
       return (ls->pdf > 0.0f);
     }
 
     lamp = -prim - 1;
+
+    if (kernel_data.integrator.use_light_tree &&
+        kernel_tex_fetch(__light_tree_leaf, index) != ~0u) {
+      tree_pdf = light_tree_lamp_pdf_scale(kg, tree_pdf);
+    }
   }
 
   if (UNLIKELY(light_select_reached_max_bounces(kg, lamp, bounce))) {
     return false;
   }
 
-  return lamp_light_sample(kg, lamp, randu, randv, P, ls);
+  if (!lamp_light_sample(kg, lamp, randu, randv, P, ls)) {
+    return false;
+  }
+
+  ls->pdf *= tree_pdf;
+
+  return (ls->pdf > 0.0f);
 }
 
 ccl_device_inline int light_select_num_samples(KernelGlobals *kg, int index)
@@ -34,11 +34,30 @@ CCL_NAMESPACE_BEGIN
     if ((object) != PRIM_NONE) { \
       profiling_helper.set_object(object); \
     }
+#  define PROFILING_SHADER_EVALUATED(shader) \
+    if ((shader) != SHADER_NONE) { \
+      profiling_helper.add_shader_eval((shader)&SHADER_MASK); \
+    }
+#  define PROFILING_RAY_TYPE(visibility) \
+    (((visibility)&PATH_RAY_SHADOW) ? \
+         PROFILING_RAY_SHADOW : \
+         ((visibility)&PATH_RAY_CAMERA) ? PROFILING_RAY_CAMERA : PROFILING_RAY_INDIRECT)
+#  define PROFILING_RAY(kg, visibility) (kg)->profiler.add_ray(PROFILING_RAY_TYPE(visibility))
+#  define PROFILING_INTERSECT_OBJECT(kg, object) \
+    if ((kg)->profiler.active) { \
+      (kg)->profiler.intersect_object = (object); \
+    }
+#  define PROFILING_CURVE_SEGMENTS(kg, visibility, culled, tested, hits) \
+    (kg)->profiler.add_curve_segments(PROFILING_RAY_TYPE(visibility), culled, tested, hits)
 #else
 #  define PROFILING_INIT(kg, event)
 #  define PROFILING_EVENT(event)
 #  define PROFILING_SHADER(shader)
 #  define PROFILING_OBJECT(object)
+#  define PROFILING_SHADER_EVALUATED(shader)
+#  define PROFILING_RAY(kg, visibility)
+#  define PROFILING_INTERSECT_OBJECT(kg, object)
+#  define PROFILING_CURVE_SEGMENTS(kg, visibility, culled, tested, hits)
 #endif /* __KERNEL_CPU__ */
 
 CCL_NAMESPACE_END
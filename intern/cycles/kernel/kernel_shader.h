@@ -1060,6 +1060,7 @@ ccl_device void shader_eval_surface(KernelGlobals *kg,
                                     int path_flag)
 {
   PROFILING_INIT(kg, PROFILING_SHADER_EVAL);
+  PROFILING_SHADER_EVALUATED(sd->shader);
 
   /* If path is being terminated, we are tracing a shadow ray or evaluating
    * emission, then we don't need to store closures. The emission and shadow
@@ -1088,7 +1089,15 @@ ccl_device void shader_eval_surface(KernelGlobals *kg,
 #endif
   {
 #ifdef __SVM__
-    svm_eval_nodes(kg, sd, state, buffer, SHADER_TYPE_SURFACE, path_flag);
+#  ifdef __KERNEL_CPU__
+    if (sd->flag & SD_SVM_BASIC_SURFACE) {
+      svm_eval_nodes_basic_surface(kg, sd, state, path_flag);
+    }
+    else
+#  endif
+    {
+      svm_eval_nodes(kg, sd, state, buffer, SHADER_TYPE_SURFACE, path_flag);
+    }
 #else
     if (sd->object == OBJECT_NONE) {
       sd->closure_emission_background = make_float3(0.8f, 0.8f, 0.8f);
@@ -23,6 +23,8 @@ KERNEL_TEX(float4, __bvh_nodes)
 KERNEL_TEX(float4, __bvh_leaf_nodes)
 KERNEL_TEX(float4, __prim_tri_verts)
 KERNEL_TEX(uint, __prim_tri_index)
+KERNEL_TEX(float4, __prim_curve_keys)
+KERNEL_TEX(uint, __prim_curve_index)
 KERNEL_TEX(uint, __prim_type)
 KERNEL_TEX(uint, __prim_visibility)
 KERNEL_TEX(uint, __prim_index)
@@ -36,6 +38,7 @@ KERNEL_TEX(Transform, __object_motion_pass)
 KERNEL_TEX(DecomposedTransform, __object_motion)
 KERNEL_TEX(uint, __object_flag)
 KERNEL_TEX(float, __object_volume_step)
+KERNEL_TEX(KernelVolumeOccupancy, __object_volume_occupancy)
 
 /* cameras */
 KERNEL_TEX(DecomposedTransform, __camera_motion)
@@ -47,6 +50,12 @@ KERNEL_TEX(uint4, __tri_vindex)
 KERNEL_TEX(uint, __tri_patch)
 KERNEL_TEX(float2, __tri_patch_uv)
 
+/* triangles, compact geometry storage */
+KERNEL_TEX(uint, __tri_vnormal_oct)
+KERNEL_TEX(uint2, __tri_vindex_compact)
+KERNEL_TEX(uint, __tri_vindex_verts)
+KERNEL_TEX(uint2, __tri_vindex_overflow)
+
 /* curves */
 KERNEL_TEX(float4, __curves)
 KERNEL_TEX(float4, __curve_keys)
@@ -54,16 +63,22 @@ KERNEL_TEX(float4, __curve_keys)
 /* patches */
 KERNEL_TEX(uint, __patches)
 
+/* volumes */
+KERNEL_TEX(uint, __volume_occupancy)
+
 /* attributes */
 KERNEL_TEX(uint4, __attributes_map)
 KERNEL_TEX(float, __attributes_float)
 KERNEL_TEX(float2, __attributes_float2)
+KERNEL_TEX(uint, __attributes_half2)
 KERNEL_TEX(float4, __attributes_float3)
 KERNEL_TEX(uchar4, __attributes_uchar4)
 
 /* lights */
 KERNEL_TEX(KernelLightDistribution, __light_distribution)
 KERNEL_TEX(KernelLight, __lights)
+KERNEL_TEX(KernelLightTreeNode, __light_tree_nodes)
+KERNEL_TEX(uint, __light_tree_leaf)
 KERNEL_TEX(float2, __light_background_marginal_cdf)
 KERNEL_TEX(float2, __light_background_conditional_cdf)
 
@@ -86,4 +101,7 @@ KERNEL_TEX(TextureInfo, __texture_info)
 /* ies lights */
 KERNEL_TEX(float, __ies)
 
+/* bake */
+KERNEL_TEX(uint2, __bake_rows)
+
 #undef KERNEL_TEX
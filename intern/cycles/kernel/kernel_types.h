@@ -62,6 +62,10 @@ CCL_NAMESPACE_BEGIN
 #define ID_NONE (0.0f)
 
 #define VOLUME_STACK_SIZE 32
+#define VOLUME_OCCUPANCY_MAX_WALK 16
+
+/* Bounding sphere and four control points stored per curve segment in BVH leaves. */
+#define CURVE_LEAF_KEYS_SIZE 5
 
 /* Split kernel constants */
 #define WORK_POOL_SIZE_GPU 64
@@ -683,6 +687,40 @@ typedef enum PrimitiveType {
 #define PRIMITIVE_PACK_SEGMENT(type, segment) ((segment << PRIMITIVE_NUM_TOTAL) | (type))
 #define PRIMITIVE_UNPACK_SEGMENT(type) (type >> PRIMITIVE_NUM_TOTAL)
 
+/* Compact triangle vertex indices store the first vertex index verbatim and the offsets of the
+ * other two vertices as signed 15 bit integers. Triangles whose offsets do not fit set the
+ * overflow bit instead, and the remaining bits index a table holding both vertex indices. */
+#define TRI_VINDEX_DELTA_BITS 15
+#define TRI_VINDEX_DELTA_MAX ((1 << (TRI_VINDEX_DELTA_BITS - 1)) - 1)
+#define TRI_VINDEX_DELTA_MASK ((1u << TRI_VINDEX_DELTA_BITS) - 1)
+#define TRI_VINDEX_OVERFLOW (1u << 31)
+
+/* Pack the offsets of the second and third vertex from the first, returns false when they do
+ * not fit and the triangle needs the overflow table. */
+ccl_device_inline bool tri_vindex_pack_deltas(uint v0, uint v1, uint v2, uint *r_deltas)
+{
+  const int d1 = (int)(v1 - v0);
+  const int d2 = (int)(v2 - v0);
+  if (d1 < -TRI_VINDEX_DELTA_MAX || d1 > TRI_VINDEX_DELTA_MAX || d2 < -TRI_VINDEX_DELTA_MAX ||
+      d2 > TRI_VINDEX_DELTA_MAX) {
+    return false;
+  }
+  *r_deltas = ((uint)d1 & TRI_VINDEX_DELTA_MASK) |
+              (((uint)d2 & TRI_VINDEX_DELTA_MASK) << TRI_VINDEX_DELTA_BITS);
+  return true;
+}
+
+/* Second and third vertex index from the first and the packed offsets. */
+ccl_device_inline uint2 tri_vindex_unpack_deltas(uint v0, uint deltas)
+{
+  /* Sign extend the offsets. */
+  const int sign = 1 << (TRI_VINDEX_DELTA_BITS - 1);
+  const int d1 = (int)(deltas & TRI_VINDEX_DELTA_MASK) - ((int)(deltas & sign) << 1);
+  const int d2 = (int)((deltas >> TRI_VINDEX_DELTA_BITS) & TRI_VINDEX_DELTA_MASK) -
+                 ((int)((deltas >> TRI_VINDEX_DELTA_BITS) & sign) << 1);
+  return make_uint2(v0 + d1, v0 + d2);
+}
+
 typedef enum CurveShapeType {
   CURVE_RIBBON = 0,
   CURVE_THICK = 1,
@@ -866,11 +904,13 @@ enum ShaderDataFlag {
   SD_NEED_VOLUME_ATTRIBUTES = (1 << 28),
   /* Shader has emission */
   SD_HAS_EMISSION = (1 << 29),
+  /* Surface shader only uses nodes handled by the specialized SVM loop. */
+  SD_SVM_BASIC_SURFACE = (1 << 30),
 
   SD_SHADER_FLAGS = (SD_USE_MIS | SD_HAS_TRANSPARENT_SHADOW | SD_HAS_VOLUME | SD_HAS_ONLY_VOLUME |
                      SD_HETEROGENEOUS_VOLUME | SD_HAS_BSSRDF_BUMP | SD_VOLUME_EQUIANGULAR |
                      SD_VOLUME_MIS | SD_VOLUME_CUBIC | SD_HAS_BUMP | SD_HAS_DISPLACEMENT |
-                     SD_HAS_CONSTANT_EMISSION | SD_NEED_VOLUME_ATTRIBUTES)
+                     SD_HAS_CONSTANT_EMISSION | SD_NEED_VOLUME_ATTRIBUTES | SD_SVM_BASIC_SURFACE)
 };
 
 /* Object flags. */
@@ -1333,6 +1373,13 @@ typedef struct KernelIntegrator {
   /* mis */
   int use_lamp_mis;
 
+  /* light tree */
+  int use_light_tree;
+  int light_tree_triangle_root;
+  int light_tree_lamp_root;
+  int light_tree_num_local_lights;
+  float light_tree_triangle_area;
+
   /* sampler */
   int sampling_pattern;
   int aa_samples;
@@ -1351,7 +1398,7 @@ typedef struct KernelIntegrator {
 
   int max_closures;
 
-  int pad1, pad2;
+  int pad1;
 } KernelIntegrator;
 static_assert_align(KernelIntegrator, 16);
 
@@ -1378,6 +1425,12 @@ typedef struct KernelBVH {
   int use_bvh_steps;
   int curve_subdivisions;
 
+  /* Normals, float2 attributes and triangle indices use compact storage. */
+  int compact_geometry;
+  /* Curve segments are stored with their control points in __prim_curve_keys. */
+  int have_curve_leaf_keys;
+  int pad4, pad5;
+
   /* Custom BVH */
 #ifdef __KERNEL_OPTIX__
   OptixTraversableHandle scene;
@@ -1401,6 +1454,7 @@ typedef struct KernelTables {
 static_assert_align(KernelTables, 16);
 
 typedef struct KernelBake {
+  /* OBJECT_NONE when baking a batch of objects, looked up per row in __bake_rows. */
   int object_index;
   int tri_offset;
   int type;
@@ -1454,6 +1508,17 @@ typedef struct KernelObject {
 } KernelObject;
 static_assert_align(KernelObject, 16);
 
+/* Coarse occupancy bitmask of volume grids, to skip empty space when ray marching. */
+typedef struct KernelVolumeOccupancy {
+  /* Transform from object space to cell coordinates. */
+  Transform object_to_cell;
+
+  /* Offset into __volume_occupancy, -1 if unknown. */
+  int offset;
+  int res_x, res_y, res_z;
+} KernelVolumeOccupancy;
+static_assert_align(KernelVolumeOccupancy, 16);
+
 typedef struct KernelSpotLight {
   float radius;
   float invarea;
@@ -1516,6 +1581,18 @@ typedef struct KernelLightDistribution {
 } KernelLightDistribution;
 static_assert_align(KernelLightDistribution, 16);
 
+/* Light tree node. The first child of an inner node directly follows it, the second child is
+ * stored in child. Leaves store the light distribution index of their emitter as ~child. */
+typedef struct KernelLightTreeNode {
+  float bounds_min[3];
+  float energy;
+  float bounds_max[3];
+  int child;
+  int parent;
+  int pad1, pad2, pad3;
+} KernelLightTreeNode;
+static_assert_align(KernelLightTreeNode, 16);
+
 typedef struct KernelParticle {
   int index;
   float age;
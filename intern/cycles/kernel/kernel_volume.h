@@ -146,6 +146,58 @@ ccl_device float volume_stack_step_size(KernelGlobals *kg, ccl_addr_space Volume
   return step_size;
 }
 
+/* Distance along the ray from t up to which all volumes in the stack are known
+ * to be empty. Only volume objects with an occupancy grid can be skipped, any
+ * other volume in the stack makes the result t. */
+ccl_device float volume_stack_empty_until(KernelGlobals *kg,
+                                          ccl_addr_space VolumeStack *stack,
+                                          const Ray *ray,
+                                          float t)
+{
+  float empty_t = FLT_MAX;
+
+  for (int i = 0; stack[i].shader != SHADER_NONE && empty_t > t; i++) {
+    const int object = stack[i].object;
+    if (object == OBJECT_NONE) {
+      return t;
+    }
+    empty_t = fminf(empty_t, volume_occupancy_empty_until(kg, object, ray, t));
+  }
+
+  return empty_t;
+}
+
+/* Advance step index past steps that lie entirely in empty space, returns
+ * true if the step at the new index needs no shading. */
+ccl_device_inline bool kernel_volume_skip_empty(KernelGlobals *kg,
+                                                ccl_addr_space VolumeStack *stack,
+                                                const Ray *ray,
+                                                float t,
+                                                float step_size,
+                                                float steps_offset,
+                                                int *step)
+{
+  if (step_size >= ray->t) {
+    return false;
+  }
+
+  const float empty_t = fminf(volume_stack_empty_until(kg, stack, ray, t), ray->t);
+  if (empty_t <= t) {
+    return false;
+  }
+
+  /* Clamp in float before converting, ray->t may be FLT_MAX. Stepping stops at the maximum
+   * number of steps anyway. */
+  const float max_steps = (float)kernel_data.integrator.volume_max_steps;
+  const int last_step = (int)min(floorf(empty_t / step_size - steps_offset), max_steps);
+  if (last_step < *step) {
+    return false;
+  }
+
+  *step = last_step;
+  return true;
+}
+
 ccl_device int volume_stack_sampling_method(KernelGlobals *kg, VolumeStack *stack)
 {
   if (kernel_data.integrator.num_all_lights == 0)
@@ -249,6 +301,10 @@ ccl_device void kernel_volume_shadow_heterogeneous(KernelGlobals *kg,
   float3 sum = zero_float3();
 
   for (int i = 0; i < max_steps; i++) {
+    /* skip over empty space */
+    const bool empty = kernel_volume_skip_empty(
+        kg, state->volume_stack, ray, t, step_size, steps_offset, &i);
+
     /* advance to new position */
     float new_t = min(ray->t, (i + steps_offset) * step_size);
     float dt = new_t - t;
@@ -257,7 +313,7 @@ ccl_device void kernel_volume_shadow_heterogeneous(KernelGlobals *kg,
     float3 sigma_t = zero_float3();
 
     /* compute attenuation over segment */
-    if (volume_shader_extinction_sample(kg, sd, state, new_P, &sigma_t)) {
+    if (!empty && volume_shader_extinction_sample(kg, sd, state, new_P, &sigma_t)) {
       /* Compute expf() only for every Nth step, to save some calculations
        * because exp(a)*exp(b) = exp(a+b), also do a quick VOLUME_THROUGHPUT_EPSILON
        * check then. */
@@ -598,6 +654,10 @@ kernel_volume_integrate_heterogeneous_distance(KernelGlobals *kg,
   bool has_scatter = false;
 
   for (int i = 0; i < max_steps; i++) {
+    /* skip over empty space */
+    const bool empty = kernel_volume_skip_empty(
+        kg, state->volume_stack, ray, t, step_size, steps_offset, &i);
+
     /* advance to new position */
     float new_t = min(ray->t, (i + steps_offset) * step_size);
     float dt = new_t - t;
@@ -606,7 +666,7 @@ kernel_volume_integrate_heterogeneous_distance(KernelGlobals *kg,
     VolumeShaderCoefficients coeff ccl_optional_struct_init;
 
     /* compute segment */
-    if (volume_shader_sample(kg, sd, state, new_P, &coeff)) {
+    if (!empty && volume_shader_sample(kg, sd, state, new_P, &coeff)) {
       int closure_flag = sd->flag;
       float3 new_tp;
       float3 transmittance;
@@ -830,6 +890,10 @@ ccl_device void kernel_volume_decoupled_record(KernelGlobals *kg,
   VolumeStep *step = segment->steps;
 
   for (int i = 0; i < max_steps; i++, step++) {
+    /* skip over empty space, recorded as a single empty step */
+    const bool empty = kernel_volume_skip_empty(
+        kg, state->volume_stack, ray, t, step_size, steps_offset, &i);
+
     /* advance to new position */
     float new_t = min(ray->t, (i + steps_offset) * step_size);
     float dt = new_t - t;
@@ -838,7 +902,7 @@ ccl_device void kernel_volume_decoupled_record(KernelGlobals *kg,
     VolumeShaderCoefficients coeff ccl_optional_struct_init;
 
     /* compute segment */
-    if (volume_shader_sample(kg, sd, state, new_P, &coeff)) {
+    if (!empty && volume_shader_sample(kg, sd, state, new_P, &coeff)) {
       int closure_flag = sd->flag;
       float3 sigma_t = coeff.sigma_t;
 
@@ -63,6 +63,19 @@ void KERNEL_FUNCTION_FULL_NAME(filter_detect_outliers)(int x,
 void KERNEL_FUNCTION_FULL_NAME(filter_combine_halves)(
     int x, int y, float *mean, float *variance, float *a, float *b, int *prefilter_rect, int r);
 
+void KERNEL_FUNCTION_FULL_NAME(filter_estimate_error)(int x,
+                                                      int y,
+                                                      int sample,
+                                                      float *buffer,
+                                                      int *rect,
+                                                      int offset,
+                                                      int stride,
+                                                      int pass_stride,
+                                                      int denoising_offset,
+                                                      int sample_count_offset,
+                                                      int radius,
+                                                      float *error);
+
 void KERNEL_FUNCTION_FULL_NAME(filter_construct_transform)(float *buffer,
                                                            TileInfo *tiles,
                                                            int x,
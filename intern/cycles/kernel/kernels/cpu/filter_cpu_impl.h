@@ -139,6 +139,36 @@ void KERNEL_FUNCTION_FULL_NAME(filter_combine_halves)(
 #endif
 }
 
+void KERNEL_FUNCTION_FULL_NAME(filter_estimate_error)(int x,
+                                                      int y,
+                                                      int sample,
+                                                      float *buffer,
+                                                      int *rect,
+                                                      int offset,
+                                                      int stride,
+                                                      int pass_stride,
+                                                      int denoising_offset,
+                                                      int sample_count_offset,
+                                                      int radius,
+                                                      float *error)
+{
+#ifdef KERNEL_STUB
+  STUB_ASSERT(KERNEL_ARCH, filter_estimate_error);
+#else
+  *error = kernel_filter_estimate_error(x,
+                                        y,
+                                        sample,
+                                        buffer,
+                                        load_int4(rect),
+                                        offset,
+                                        stride,
+                                        pass_stride,
+                                        denoising_offset,
+                                        sample_count_offset,
+                                        radius);
+#endif
+}
+
 void KERNEL_FUNCTION_FULL_NAME(filter_construct_transform)(float *buffer,
                                                            TileInfo *tile_info,
                                                            int x,
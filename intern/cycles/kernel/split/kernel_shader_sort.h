@@ -16,6 +16,53 @@
 
 CCL_NAMESPACE_BEGIN
 
+#ifdef __KERNEL_CPU__
+/* Order two entries of the sort block by shader, ties keep queue order. */
+ccl_device_inline bool shader_sort_less(const uint *value, ushort a, ushort b)
+{
+  return (value[a] < value[b]) || (value[a] == value[b] && a < b);
+}
+
+ccl_device_inline void shader_sort_sift_down(const uint *value,
+                                             ushort *index,
+                                             uint root,
+                                             uint num)
+{
+  while (2 * root + 1 < num) {
+    uint child = 2 * root + 1;
+    if (child + 1 < num && shader_sort_less(value, index[child], index[child + 1])) {
+      child++;
+    }
+    if (!shader_sort_less(value, index[root], index[child])) {
+      return;
+    }
+    ushort tmp = index[root];
+    index[root] = index[child];
+    index[child] = tmp;
+    root = child;
+  }
+}
+
+/* On the CPU a single work item owns the whole block, so the bitonic network
+ * used by OpenCL degenerates to a serial sort. Heap sort works in place on the
+ * index array without any extra storage. */
+ccl_device void shader_sort_block_cpu(const uint *value, ushort *index, uint num)
+{
+  if (num < 2) {
+    return;
+  }
+  for (uint i = num / 2; i-- > 0;) {
+    shader_sort_sift_down(value, index, i, num);
+  }
+  for (uint end = num - 1; end > 0; end--) {
+    ushort tmp = index[0];
+    index[0] = index[end];
+    index[end] = tmp;
+    shader_sort_sift_down(value, index, 0, end);
+  }
+}
+#endif /* __KERNEL_CPU__ */
+
 ccl_device void kernel_shader_sort(KernelGlobals *kg, ccl_local_param ShaderSortLocals *locals)
 {
 #ifndef __KERNEL_CUDA__
@@ -54,7 +101,6 @@ ccl_device void kernel_shader_sort(KernelGlobals *kg, ccl_local_param ShaderSort
   }
   ccl_barrier(CCL_LOCAL_MEM_FENCE);
 
-  /* skip sorting for cpu split kernel */
 #  ifdef __KERNEL_OPENCL__
 
   /* bitonic sort */
@@ -77,6 +123,12 @@ ccl_device void kernel_shader_sort(KernelGlobals *kg, ccl_local_param ShaderSort
       }
     }
   }
+#  elif defined(__KERNEL_CPU__)
+  uint num = qsize - offset;
+  if (num > SHADER_SORT_BLOCK_SIZE) {
+    num = SHADER_SORT_BLOCK_SIZE;
+  }
+  shader_sort_block_cpu(local_value, local_index, num);
 #  endif /* __KERNEL_OPENCL__ */
 
   /* copy to destination */
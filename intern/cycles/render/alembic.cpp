@@ -23,6 +23,7 @@
 #include "render/object.h"
 #include "render/scene.h"
 #include "render/shader.h"
+#include "render/stats.h"
 
 #include "util/util_foreach.h"
 #include "util/util_logging.h"
@@ -40,7 +41,7 @@ CCL_NAMESPACE_BEGIN
 
 template<typename SchemaType>
 static vector<FaceSetShaderIndexPair> parse_face_sets_for_shader_assignment(
-    SchemaType &schema, const array<Node *> &used_shaders)
+    SchemaType &schema, const vector<ustring> &shader_names)
 {
   vector<FaceSetShaderIndexPair> result;
 
@@ -54,15 +55,15 @@ static vector<FaceSetShaderIndexPair> parse_face_sets_for_shader_assignment(
   for (const std::string &face_set_name : face_set_names) {
     int shader_index = 0;
 
-    for (Node *node : used_shaders) {
-      if (node->name == face_set_name) {
+    for (const ustring &shader_name : shader_names) {
+      if (shader_name == face_set_name) {
         break;
       }
 
       ++shader_index;
     }
 
-    if (shader_index >= used_shaders.size()) {
+    if (shader_index >= shader_names.size()) {
       /* use the first shader instead if none was found */
       shader_index = 0;
     }
@@ -452,6 +453,7 @@ bool AlembicObject::has_data_loaded() const
 void AlembicObject::load_data_in_cache(CachedData &cached_data,
                                        AlembicProcedural *proc,
                                        IPolyMeshSchema &schema,
+                                       const AlembicLoadParams &params,
                                        Progress &progress)
 {
   /* Only load data for the original Geometry. */
@@ -469,7 +471,7 @@ void AlembicObject::load_data_in_cache(CachedData &cached_data,
   data.face_indices = schema.getFaceIndicesProperty();
   data.normals = schema.getNormalsParam();
   data.num_samples = schema.getNumSamples();
-  data.shader_face_sets = parse_face_sets_for_shader_assignment(schema, get_used_shaders());
+  data.shader_face_sets = parse_face_sets_for_shader_assignment(schema, params.shader_names);
 
   read_geometry_data(proc, cached_data, data, progress);
 
@@ -480,19 +482,19 @@ void AlembicObject::load_data_in_cache(CachedData &cached_data,
   /* Use the schema as the base compound property to also be able to look for top level properties.
    */
   read_attributes(
-      proc, cached_data, schema, schema.getUVsParam(), get_requested_attributes(), progress);
+      proc, cached_data, schema, schema.getUVsParam(), params.requested_attributes, progress);
 
   if (progress.get_cancel()) {
     return;
   }
 
   cached_data.invalidate_last_loaded_time(true);
-  data_loaded = true;
 }
 
 void AlembicObject::load_data_in_cache(CachedData &cached_data,
                                        AlembicProcedural *proc,
                                        ISubDSchema &schema,
+                                       const AlembicLoadParams &params,
                                        Progress &progress)
 {
   /* Only load data for the original Geometry. */
@@ -502,7 +504,7 @@ void AlembicObject::load_data_in_cache(CachedData &cached_data,
 
   cached_data.clear();
 
-  if (this->get_ignore_subdivision()) {
+  if (params.ignore_subdivision) {
     PolyMeshSchemaData data;
     data.topology_variance = schema.getTopologyVariance();
     data.time_sampling = schema.getTimeSampling();
@@ -511,7 +513,7 @@ void AlembicObject::load_data_in_cache(CachedData &cached_data,
     data.face_indices = schema.getFaceIndicesProperty();
     data.num_samples = schema.getNumSamples();
     data.velocities = schema.getVelocitiesProperty();
-    data.shader_face_sets = parse_face_sets_for_shader_assignment(schema, get_used_shaders());
+    data.shader_face_sets = parse_face_sets_for_shader_assignment(schema, params.shader_names);
 
     read_geometry_data(proc, cached_data, data, progress);
 
@@ -522,10 +524,9 @@ void AlembicObject::load_data_in_cache(CachedData &cached_data,
     /* Use the schema as the base compound property to also be able to look for top level
      * properties. */
     read_attributes(
-        proc, cached_data, schema, schema.getUVsParam(), get_requested_attributes(), progress);
+        proc, cached_data, schema, schema.getUVsParam(), params.requested_attributes, progress);
 
     cached_data.invalidate_last_loaded_time(true);
-    data_loaded = true;
     return;
   }
 
@@ -547,7 +548,7 @@ void AlembicObject::load_data_in_cache(CachedData &cached_data,
   data.holes = schema.getHolesProperty();
   data.subdivision_scheme = schema.getSubdivisionSchemeProperty();
   data.velocities = schema.getVelocitiesProperty();
-  data.shader_face_sets = parse_face_sets_for_shader_assignment(schema, get_used_shaders());
+  data.shader_face_sets = parse_face_sets_for_shader_assignment(schema, params.shader_names);
 
   read_geometry_data(proc, cached_data, data, progress);
 
@@ -558,15 +559,15 @@ void AlembicObject::load_data_in_cache(CachedData &cached_data,
   /* Use the schema as the base compound property to also be able to look for top level properties.
    */
   read_attributes(
-      proc, cached_data, schema, schema.getUVsParam(), get_requested_attributes(), progress);
+      proc, cached_data, schema, schema.getUVsParam(), params.requested_attributes, progress);
 
   cached_data.invalidate_last_loaded_time(true);
-  data_loaded = true;
 }
 
 void AlembicObject::load_data_in_cache(CachedData &cached_data,
                                        AlembicProcedural *proc,
                                        const ICurvesSchema &schema,
+                                       const AlembicLoadParams &params,
                                        Progress &progress)
 {
   /* Only load data for the original Geometry. */
@@ -588,8 +589,8 @@ void AlembicObject::load_data_in_cache(CachedData &cached_data,
   data.topology_variance = schema.getTopologyVariance();
   data.num_samples = schema.getNumSamples();
   data.num_vertices = schema.getNumVerticesProperty();
-  data.default_radius = proc->get_default_radius();
-  data.radius_scale = get_radius_scale();
+  data.default_radius = params.default_radius;
+  data.radius_scale = params.radius_scale;
 
   read_geometry_data(proc, cached_data, data, progress);
 
@@ -600,10 +601,9 @@ void AlembicObject::load_data_in_cache(CachedData &cached_data,
   /* Use the schema as the base compound property to also be able to look for top level properties.
    */
   read_attributes(
-      proc, cached_data, schema, schema.getUVsParam(), get_requested_attributes(), progress);
+      proc, cached_data, schema, schema.getUVsParam(), params.requested_attributes, progress);
 
   cached_data.invalidate_last_loaded_time(true);
-  data_loaded = true;
 }
 
 void AlembicObject::setup_transform_cache(CachedData &cached_data, float scale)
@@ -669,6 +669,27 @@ AttributeRequestSet AlembicObject::get_requested_attributes()
   return requested_attributes;
 }
 
+AlembicLoadParams AlembicObject::get_load_params(const AlembicProcedural *proc)
+{
+  AlembicLoadParams params;
+
+  /* Instances do not load any data. */
+  if (instance_of) {
+    return params;
+  }
+
+  params.ignore_subdivision = ignore_subdivision;
+  params.radius_scale = radius_scale;
+  params.default_radius = proc->get_default_radius();
+
+  foreach (Node *node, used_shaders) {
+    params.shader_names.push_back(node->name);
+  }
+
+  params.requested_attributes = get_requested_attributes();
+  return params;
+}
+
 /* Update existing attributes and remove any attribute not in the cached_data, those attributes
  * were added by Cycles (e.g. face normals) */
 static void update_attributes(AttributeSet &attributes, CachedData &cached_data, double frame_time)
@@ -738,6 +759,8 @@ NODE_DEFINE(AlembicProcedural)
 
   SOCKET_BOOLEAN(use_prefetch, "Use Prefetch", true);
   SOCKET_INT(prefetch_cache_size, "Prefetch Cache Size", 4096);
+  SOCKET_INT(stream_window, "Stream Window", 0);
+  SOCKET_BOOLEAN(prefetch_next_window, "Prefetch Next Window", false);
 
   return type;
 }
@@ -746,10 +769,21 @@ AlembicProcedural::AlembicProcedural() : Procedural(get_node_type())
 {
   objects_loaded = false;
   scene_ = nullptr;
+  load_frame_rate_ = 24.0;
+  has_resident_range_ = false;
+  has_prefetch_range_ = false;
+  last_stream_frame_ = 0.0;
+  prefetch_memory_used_ = 0;
+  stream_hits_ = 0;
+  stream_misses_ = 0;
+  peak_memory_used_ = 0;
 }
 
 AlembicProcedural::~AlembicProcedural()
 {
+  prefetch_progress_.set_cancel("Alembic procedural deleted");
+  prefetch_pool_.cancel();
+
   ccl::set<Geometry *> geometries_set;
   ccl::set<Object *> objects_set;
   ccl::set<AlembicObject *> abc_objects_set;
@@ -784,6 +818,11 @@ void AlembicProcedural::generate(Scene *scene, Progress &progress)
   assert(scene_ == nullptr || scene_ == scene);
   scene_ = scene;
 
+  /* The data for the next frames may still be loading in the background, wait for it before
+   * accessing the archive or the caches. */
+  prefetch_pool_.wait_work();
+  peak_memory_used_ = std::max(peak_memory_used_, prefetch_memory_used_.load());
+
   if (frame < start_frame || frame > end_frame) {
     clear_modified();
     return;
@@ -826,6 +865,8 @@ void AlembicProcedural::generate(Scene *scene, Progress &progress)
   if (!archive.valid()) {
     Alembic::AbcCoreFactory::IFactory factory;
     factory.setPolicy(Alembic::Abc::ErrorHandler::kQuietNoopPolicy);
+    /* Allow objects to be prefetched in parallel. */
+    factory.setOgawaNumStreams(max(TaskScheduler::num_threads(), 1));
     archive = factory.getArchive(filepath.c_str());
 
     if (!archive.valid()) {
@@ -865,6 +906,18 @@ void AlembicProcedural::generate(Scene *scene, Progress &progress)
     }
   }
 
+  if (use_prefetch_is_modified() || stream_window_is_modified()) {
+    /* Reload the data for the new window size, or for the entire frame range. */
+    for (Node *node : objects) {
+      AlembicObject *object = static_cast<AlembicObject *>(node);
+      object->prefetched_data_.clear();
+      object->has_prefetched_data = false;
+      object->data_loaded = false;
+    }
+    has_resident_range_ = false;
+    has_prefetch_range_ = false;
+  }
+
   if (prefetch_cache_size_is_modified()) {
     /* Check whether the current memory usage fits in the new requested size,
      * abort the render if it is any higher. */
@@ -891,7 +944,7 @@ void AlembicProcedural::generate(Scene *scene, Progress &progress)
 
     /* skip constant objects */
     if (object->is_constant() && !object->is_modified() && !object->need_shader_update &&
-        !scale_is_modified()) {
+        !object->need_data_update && !scale_is_modified()) {
       continue;
     }
 
@@ -906,9 +959,14 @@ void AlembicProcedural::generate(Scene *scene, Progress &progress)
     }
 
     object->need_shader_update = false;
+    object->need_data_update = false;
     object->clear_modified();
   }
 
+  if (use_streaming()) {
+    start_prefetch();
+  }
+
   clear_modified();
 }
 
@@ -923,6 +981,18 @@ void AlembicProcedural::tag_update(Scene *scene)
   scene->procedural_manager->tag_update();
 }
 
+void AlembicProcedural::collect_statistics(RenderStats *stats)
+{
+  if (stream_hits_ + stream_misses_ == 0) {
+    return;
+  }
+
+  stats->procedurals.stream_hits += stream_hits_;
+  stats->procedurals.stream_misses += stream_misses_;
+  stats->procedurals.peak_memory += peak_memory_used_;
+  stats->procedurals.memory_limit += get_prefetch_cache_size_in_bytes();
+}
+
 AlembicObject *AlembicProcedural::get_or_create_object(const ustring &path)
 {
   foreach (Node *node, objects) {
@@ -1355,8 +1425,43 @@ void AlembicProcedural::walk_hierarchy(
   }
 }
 
+void AlembicProcedural::load_object_data(AlembicObject *object,
+                                         CachedData &cached_data,
+                                         const AlembicLoadParams &params,
+                                         Progress &progress)
+{
+  if (object->schema_type == AlembicObject::POLY_MESH) {
+    IPolyMesh polymesh(object->iobject, Alembic::Abc::kWrapExisting);
+    IPolyMeshSchema schema = polymesh.getSchema();
+    object->load_data_in_cache(cached_data, this, schema, params, progress);
+  }
+  else if (object->schema_type == AlembicObject::CURVES) {
+    ICurves curves(object->iobject, Alembic::Abc::kWrapExisting);
+    ICurvesSchema schema = curves.getSchema();
+    object->load_data_in_cache(cached_data, this, schema, params, progress);
+  }
+  else if (object->schema_type == AlembicObject::SUBD) {
+    ISubD subd_mesh(object->iobject, Alembic::Abc::kWrapExisting);
+    ISubDSchema schema = subd_mesh.getSchema();
+    object->load_data_in_cache(cached_data, this, schema, params, progress);
+  }
+}
+
 void AlembicProcedural::build_caches(Progress &progress)
 {
+  if (use_streaming()) {
+    update_stream_window((double)(frame - frame_offset));
+  }
+  else if (use_prefetch) {
+    load_range_.start_frame = (double)start_frame;
+    load_range_.end_frame = (double)end_frame;
+  }
+  else {
+    load_range_.start_frame = (double)frame;
+    load_range_.end_frame = (double)frame;
+  }
+  load_frame_rate_ = (double)frame_rate;
+
   size_t memory_used = 0;
 
   for (Node *node : objects) {
@@ -1368,9 +1473,9 @@ void AlembicProcedural::build_caches(Progress &progress)
 
     if (object->schema_type == AlembicObject::POLY_MESH) {
       if (!object->has_data_loaded()) {
-        IPolyMesh polymesh(object->iobject, Alembic::Abc::kWrapExisting);
-        IPolyMeshSchema schema = polymesh.getSchema();
-        object->load_data_in_cache(object->get_cached_data(), this, schema, progress);
+        load_object_data(
+            object, object->get_cached_data(), object->get_load_params(this), progress);
+        object->data_loaded = !progress.get_cancel();
       }
       else if (object->need_shader_update) {
         IPolyMesh polymesh(object->iobject, Alembic::Abc::kWrapExisting);
@@ -1386,16 +1491,16 @@ void AlembicProcedural::build_caches(Progress &progress)
     else if (object->schema_type == AlembicObject::CURVES) {
       if (!object->has_data_loaded() || default_radius_is_modified() ||
           object->radius_scale_is_modified()) {
-        ICurves curves(object->iobject, Alembic::Abc::kWrapExisting);
-        ICurvesSchema schema = curves.getSchema();
-        object->load_data_in_cache(object->get_cached_data(), this, schema, progress);
+        load_object_data(
+            object, object->get_cached_data(), object->get_load_params(this), progress);
+        object->data_loaded = !progress.get_cancel();
       }
     }
     else if (object->schema_type == AlembicObject::SUBD) {
       if (!object->has_data_loaded()) {
-        ISubD subd_mesh(object->iobject, Alembic::Abc::kWrapExisting);
-        ISubDSchema schema = subd_mesh.getSchema();
-        object->load_data_in_cache(object->get_cached_data(), this, schema, progress);
+        load_object_data(
+            object, object->get_cached_data(), object->get_load_params(this), progress);
+        object->data_loaded = !progress.get_cancel();
       }
       else if (object->need_shader_update) {
         ISubD subd_mesh(object->iobject, Alembic::Abc::kWrapExisting);
@@ -1423,9 +1528,136 @@ void AlembicProcedural::build_caches(Progress &progress)
     }
   }
 
+  peak_memory_used_ = std::max(peak_memory_used_, memory_used);
+
   VLOG(1) << "AlembicProcedural memory usage : " << string_human_readable_size(memory_used);
 }
 
+void AlembicProcedural::update_stream_window(double current_frame)
+{
+  const bool new_frame = !has_resident_range_ || current_frame != last_stream_frame_;
+  last_stream_frame_ = current_frame;
+
+  if (has_resident_range_ && resident_range_.contains(current_frame)) {
+    if (new_frame) {
+      for (Node *node : objects) {
+        AlembicObject *object = static_cast<AlembicObject *>(node);
+        if (!object->instance_of && object->schema_type != AlembicObject::INVALID) {
+          stream_hits_++;
+        }
+      }
+    }
+    return;
+  }
+
+  const bool use_prefetched_data = has_prefetch_range_ && prefetch_range_.contains(current_frame);
+
+  if (use_prefetched_data) {
+    resident_range_ = prefetch_range_;
+  }
+  else {
+    resident_range_.start_frame = current_frame;
+    resident_range_.end_frame = current_frame + stream_window - 1;
+  }
+  has_resident_range_ = true;
+  has_prefetch_range_ = false;
+  load_range_ = resident_range_;
+
+  for (Node *node : objects) {
+    AlembicObject *object = static_cast<AlembicObject *>(node);
+
+    if (object->instance_of || object->schema_type == AlembicObject::INVALID) {
+      continue;
+    }
+
+    if (use_prefetched_data && object->has_prefetched_data) {
+      std::swap(object->cached_data_, object->prefetched_data_);
+      stream_hits_++;
+    }
+    else {
+      /* Loaded on demand in build_caches(). */
+      object->data_loaded = false;
+      stream_misses_++;
+    }
+
+    object->prefetched_data_.clear();
+    object->has_prefetched_data = false;
+    object->need_data_update = true;
+  }
+
+  VLOG(1) << "AlembicProcedural streaming frames " << resident_range_.start_frame << " to "
+          << resident_range_.end_frame << (use_prefetched_data ? " (prefetched)" : "");
+}
+
+void AlembicProcedural::start_prefetch()
+{
+  /* Only prefetch for final renders, and only if the procedural is kept for the next frame as
+   * the prefetched data is lost otherwise. */
+  if (!scene_->params.background || !prefetch_next_window || !has_resident_range_ ||
+      has_prefetch_range_) {
+    return;
+  }
+
+  FrameRange next_range;
+  next_range.start_frame = resident_range_.end_frame + 1;
+  next_range.end_frame = resident_range_.end_frame + stream_window;
+
+  if (next_range.start_frame > (double)(end_frame - frame_offset)) {
+    return;
+  }
+
+  size_t memory_used = 0;
+  for (Node *node : objects) {
+    AlembicObject *object = static_cast<AlembicObject *>(node);
+    memory_used += object->get_cached_data().memory_used();
+  }
+
+  prefetch_range_ = next_range;
+  has_prefetch_range_ = true;
+  load_range_ = next_range;
+  prefetch_memory_used_ = memory_used;
+
+  /* The sockets and shaders are modified by the synchronization of the next frame while the data
+   * loads, so the tasks only use copies of what they need. The archive, the objects and the load
+   * range are only modified in generate() after waiting for the tasks. */
+  const size_t memory_limit = get_prefetch_cache_size_in_bytes();
+
+  for (Node *node : objects) {
+    AlembicObject *object = static_cast<AlembicObject *>(node);
+
+    if (object->instance_of || object->schema_type == AlembicObject::INVALID) {
+      continue;
+    }
+
+    const AlembicLoadParams params = object->get_load_params(this);
+    prefetch_pool_.push(
+        [this, object, params, memory_limit] { prefetch_object(object, params, memory_limit); });
+  }
+}
+
+void AlembicProcedural::prefetch_object(AlembicObject *object,
+                                        const AlembicLoadParams &params,
+                                        size_t memory_limit)
+{
+  if (prefetch_progress_.get_cancel() || prefetch_memory_used_ > memory_limit) {
+    return;
+  }
+
+  load_object_data(object, object->prefetched_data_, params, prefetch_progress_);
+
+  const size_t object_memory_used = object->prefetched_data_.memory_used();
+  const size_t memory_used = (prefetch_memory_used_ += object_memory_used);
+
+  if (prefetch_progress_.get_cancel() || memory_used > memory_limit) {
+    /* Over budget, the data of this object is loaded when its frames are rendered instead. */
+    object->prefetched_data_.clear();
+    prefetch_memory_used_ -= object_memory_used;
+    return;
+  }
+
+  object->has_prefetched_data = true;
+}
+
 CCL_NAMESPACE_END
 
 #endif
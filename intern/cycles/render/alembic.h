@@ -19,10 +19,15 @@
 #include "graph/node.h"
 #include "render/attribute.h"
 #include "render/procedural.h"
+#include "util/util_progress.h"
 #include "util/util_set.h"
+#include "util/util_task.h"
 #include "util/util_transform.h"
 #include "util/util_vector.h"
 
+#include <algorithm>
+#include <atomic>
+
 #ifdef WITH_ALEMBIC
 
 #  include <Alembic/AbcCoreFactory/All.h>
@@ -290,9 +295,23 @@ template<typename T> class DataStore {
  private:
   const TimeIndexPair &get_index_for_time(double time) const
   {
-    std::pair<size_t, Alembic::Abc::chrono_t> index_pair;
-    index_pair = time_sampling.getNearIndex(time, index_data_map.size());
-    return index_data_map[index_pair.first];
+    /* The entries only cover the sample times that were loaded, which do not necessarily start at
+     * the first sample of the TimeSampling, so look for the entry nearest to the time. */
+    auto it = std::lower_bound(
+        index_data_map.begin(),
+        index_data_map.end(),
+        time,
+        [](const TimeIndexPair &pair, double value) { return pair.time < value; });
+
+    if (it == index_data_map.end()) {
+      return index_data_map.back();
+    }
+
+    if (it != index_data_map.begin() && (time - (it - 1)->time) < (it->time - time)) {
+      --it;
+    }
+
+    return *it;
   }
 };
 
@@ -351,6 +370,20 @@ struct CachedData {
   size_t memory_used() const;
 };
 
+/* Inputs for loading the data of an AlembicObject, besides the archive and the frames to load.
+ * They are copied on the main thread, as data prefetched in the background loads while the
+ * sockets and shaders they come from are synchronized for the next frame. */
+struct AlembicLoadParams {
+  bool ignore_subdivision = false;
+  float radius_scale = 1.0f;
+  float default_radius = 0.0f;
+
+  /* Names of the used shaders in order, matched against the names of the FaceSets. */
+  vector<ustring> shader_names;
+
+  AttributeRequestSet requested_attributes;
+};
+
 /* Representation of an Alembic object for the AlembicProcedural.
  *
  * The AlembicObject holds the path to the Alembic IObject inside of the archive that is desired
@@ -395,14 +428,17 @@ class AlembicObject : public Node {
   void load_data_in_cache(CachedData &cached_data,
                           AlembicProcedural *proc,
                           Alembic::AbcGeom::IPolyMeshSchema &schema,
+                          const AlembicLoadParams &params,
                           Progress &progress);
   void load_data_in_cache(CachedData &cached_data,
                           AlembicProcedural *proc,
                           Alembic::AbcGeom::ISubDSchema &schema,
+                          const AlembicLoadParams &params,
                           Progress &progress);
   void load_data_in_cache(CachedData &cached_data,
                           AlembicProcedural *proc,
                           const Alembic::AbcGeom::ICurvesSchema &schema,
+                          const AlembicLoadParams &params,
                           Progress &progress);
 
   bool has_data_loaded() const;
@@ -444,13 +480,25 @@ class AlembicObject : public Node {
 
   Object *object = nullptr;
 
+  /* Set once cached_data_ is loaded, prefetched data is tracked by has_prefetched_data. */
   bool data_loaded = false;
 
+  /* Set when the cached data was replaced by the data for another window of frames, so that the
+   * Geometry is updated even if the new data is constant. */
+  bool need_data_update = false;
+
   CachedData cached_data_;
 
+  /* Data for the next window of frames when streaming, loaded in the background. */
+  CachedData prefetched_data_;
+  bool has_prefetched_data = false;
+
   void setup_transform_cache(CachedData &cached_data, float scale);
 
   AttributeRequestSet get_requested_attributes();
+
+  /* Copy the inputs for loading the data, on the main thread. */
+  AlembicLoadParams get_load_params(const AlembicProcedural *proc);
 };
 
 /* Procedural to render objects from a single Alembic archive.
@@ -461,6 +509,10 @@ class AlembicObject : public Node {
  * This procedural will load the data set for the entire animation in memory on the first frame,
  * and directly set the data for the new frames on the created Nodes if needed. This allows for
  * faster updates between frames as it avoids reseeking the data on disk.
+ *
+ * For caches too large to fit in memory, a stream window can be set instead. Only the data for
+ * that many frames is kept in memory, and for final renders the data for the next window is loaded
+ * in the background while the current frame renders.
  */
 class AlembicProcedural : public Procedural {
   Alembic::AbcGeom::IArchive archive;
@@ -503,9 +555,19 @@ class AlembicProcedural : public Procedural {
   NODE_SOCKET_API(bool, use_prefetch)
 
   /* Memory limit for the cache, if the data does not fit within this limit, rendering is aborted.
+   * When streaming, this includes the data prefetched for the next window of frames.
    */
   NODE_SOCKET_API(int, prefetch_cache_size)
 
+  /* Number of frames whose data is kept in memory when prefetching, 0 to keep the data for the
+   * entire frame range. */
+  NODE_SOCKET_API(int, stream_window)
+
+  /* Load the data for the next window of frames while the current frame renders. This is only
+   * useful if the procedural is kept for the next frame, as with persistent data, otherwise the
+   * data is lost when the scene is freed. */
+  NODE_SOCKET_API(bool, prefetch_next_window)
+
   AlembicProcedural();
   ~AlembicProcedural();
 
@@ -516,6 +578,31 @@ class AlembicProcedural : public Procedural {
   /* Tag for an update only if something was modified. */
   void tag_update(Scene *scene);
 
+  void collect_statistics(RenderStats *stats);
+
+  /* Range of frames, inclusive. */
+  struct FrameRange {
+    double start_frame = 0.0;
+    double end_frame = 0.0;
+
+    bool contains(double frame) const
+    {
+      return frame >= start_frame && frame <= end_frame;
+    }
+  };
+
+  /* Frames to load the data for. This is only modified while no data is being prefetched, so
+   * loading can happen on worker threads without reading the sockets. */
+  const FrameRange &get_load_range() const
+  {
+    return load_range_;
+  }
+
+  double get_load_frame_rate() const
+  {
+    return load_frame_rate_;
+  }
+
   /* This should be called by scene exporters to request the rendering of an object located
    * in the Alembic archive at the given path.
    *
@@ -556,6 +643,46 @@ class AlembicProcedural : public Procedural {
 
   void build_caches(Progress &progress);
 
+  /* Load the data of the object for the frames in the load range into the cache. */
+  void load_object_data(AlembicObject *object,
+                        CachedData &cached_data,
+                        const AlembicLoadParams &params,
+                        Progress &progress);
+
+  bool use_streaming() const
+  {
+    return use_prefetch && stream_window > 0;
+  }
+
+  /* Make the window of frames containing the current frame resident, swapping in the prefetched
+   * data if it covers the frame. Objects without data for the frame are tagged for loading. */
+  void update_stream_window(double current_frame);
+
+  /* Start loading the data for the window of frames following the resident one. */
+  void start_prefetch();
+  void prefetch_object(AlembicObject *object,
+                       const AlembicLoadParams &params,
+                       size_t memory_limit);
+
+  FrameRange load_range_;
+  double load_frame_rate_;
+
+  FrameRange resident_range_;
+  bool has_resident_range_;
+  FrameRange prefetch_range_;
+  bool has_prefetch_range_;
+  double last_stream_frame_;
+
+  TaskPool prefetch_pool_;
+  Progress prefetch_progress_;
+  /* Memory used by the resident data and the data prefetched so far. */
+  std::atomic<size_t> prefetch_memory_used_;
+
+  /* Statistics, counted per object for every new frame. */
+  int stream_hits_;
+  int stream_misses_;
+  size_t peak_memory_used_;
+
   size_t get_prefetch_cache_size_in_bytes() const
   {
     /* prefetch_cache_size is in megabytes, so convert to bytes. */
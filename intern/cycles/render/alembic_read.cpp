@@ -44,23 +44,12 @@ static set<chrono_t> get_relevant_sample_times(AlembicProcedural *proc,
     return result;
   }
 
-  double start_frame;
-  double end_frame;
+  /* The entire animation, the current frame, or the window of frames to stream in. */
+  const AlembicProcedural::FrameRange &range = proc->get_load_range();
 
-  if (proc->get_use_prefetch()) {
-    // load the data for the entire animation
-    start_frame = static_cast<double>(proc->get_start_frame());
-    end_frame = static_cast<double>(proc->get_end_frame());
-  }
-  else {
-    // load the data for the current frame
-    start_frame = static_cast<double>(proc->get_frame());
-    end_frame = start_frame;
-  }
-
-  const double frame_rate = static_cast<double>(proc->get_frame_rate());
-  const double start_time = start_frame / frame_rate;
-  const double end_time = (end_frame + 1) / frame_rate;
+  const double frame_rate = proc->get_load_frame_rate();
+  const double start_time = range.start_frame / frame_rate;
+  const double end_time = (range.end_frame + 1) / frame_rate;
 
   const size_t start_index = time_sampling.getFloorIndex(start_time, num_samples).first;
   const size_t end_index = time_sampling.getCeilIndex(end_time, num_samples).first;
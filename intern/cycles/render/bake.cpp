@@ -23,6 +23,8 @@
 #include "render/stats.h"
 
 #include "util/util_foreach.h"
+#include "util/util_logging.h"
+#include "util/util_map.h"
 
 CCL_NAMESPACE_BEGIN
 
@@ -87,7 +89,7 @@ BakeManager::~BakeManager()
 
 bool BakeManager::get_baking()
 {
-  return !object_name.empty();
+  return !object_name.empty() || !jobs.empty();
 }
 
 void BakeManager::set(Scene *scene,
@@ -96,6 +98,47 @@ void BakeManager::set(Scene *scene,
                       int pass_filter_)
 {
   object_name = object_name_;
+  jobs.clear();
+
+  set_passes(scene, type_, pass_filter_);
+}
+
+int BakeManager::set_jobs(
+    Scene *scene, vector<BakeJob> &jobs_, int width, ShaderEvalType type_, int pass_filter_)
+{
+  object_name.clear();
+
+  int height = 0;
+  foreach (BakeJob &job, jobs_) {
+    job.y = height;
+    job.height = divide_up(job.num_pixels, width);
+    height += job.height;
+  }
+
+  jobs = jobs_;
+
+  set_passes(scene, type_, pass_filter_);
+
+  return height;
+}
+
+const vector<BakeJob> &BakeManager::get_jobs() const
+{
+  return jobs;
+}
+
+const BakeJob *BakeManager::find_job(int y) const
+{
+  foreach (const BakeJob &job, jobs) {
+    if (y >= job.y && y < job.y + job.height) {
+      return &job;
+    }
+  }
+  return NULL;
+}
+
+void BakeManager::set_passes(Scene *scene, ShaderEvalType type_, int pass_filter_)
+{
   type = type_;
   pass_filter = shader_type_to_pass_filter(type_, pass_filter_);
 
@@ -139,6 +182,12 @@ void BakeManager::device_update(Device * /*device*/,
   kbake->type = type;
   kbake->pass_filter = pass_filter;
 
+  if (!jobs.empty()) {
+    device_update_jobs(dscene, scene);
+    need_update_ = false;
+    return;
+  }
+
   int object_index = 0;
   foreach (Object *object, scene->objects) {
     const Geometry *geom = object->get_geometry();
@@ -155,8 +204,52 @@ void BakeManager::device_update(Device * /*device*/,
   need_update_ = false;
 }
 
-void BakeManager::device_free(Device * /*device*/, DeviceScene * /*dscene*/)
+void BakeManager::device_update_jobs(DeviceScene *dscene, Scene *scene)
+{
+  KernelIntegrator *kintegrator = &dscene->data.integrator;
+  KernelBake *kbake = &dscene->data.bake;
+
+  kbake->object_index = OBJECT_NONE;
+  kbake->tri_offset = 0;
+
+  map<std::string, int> object_map;
+  for (size_t i = 0; i < scene->objects.size(); i++) {
+    const Geometry *geom = scene->objects[i]->get_geometry();
+    if (geom->geometry_type == Geometry::MESH) {
+      object_map.insert(std::make_pair(scene->objects[i]->name.string(), (int)i));
+    }
+  }
+
+  const BakeJob &last_job = jobs.back();
+  uint2 *rows = dscene->bake_rows.alloc(last_job.y + last_job.height);
+  int num_aa_samples = 1;
+
+  foreach (const BakeJob &job, jobs) {
+    uint2 row = make_uint2(OBJECT_NONE, 0);
+
+    map<std::string, int>::const_iterator it = object_map.find(job.object_name);
+    if (it != object_map.end()) {
+      Object *object = scene->objects[it->second];
+      row = make_uint2(it->second, object->get_geometry()->prim_offset);
+      num_aa_samples = max(num_aa_samples, aa_samples(scene, object, type));
+    }
+    else {
+      VLOG(1) << "Bake object " << job.object_name << " not found.";
+    }
+
+    for (int y = job.y; y < job.y + job.height; y++) {
+      rows[y] = row;
+    }
+  }
+
+  kintegrator->aa_samples = num_aa_samples;
+
+  dscene->bake_rows.copy_to_device();
+}
+
+void BakeManager::device_free(Device * /*device*/, DeviceScene *dscene)
 {
+  dscene->bake_rows.free();
 }
 
 void BakeManager::tag_update()
@@ -25,12 +25,40 @@
 
 CCL_NAMESPACE_BEGIN
 
+/* Object baked as part of a batch. All jobs share one bake buffer, with the
+ * pixels of each job starting at a new row, so that the scene is synced once
+ * and tiles of all objects are spread over the render threads. */
+struct BakeJob {
+  BakeJob() : num_pixels(0), y(0), height(0)
+  {
+  }
+
+  std::string object_name;
+  /* UV map the primitive and differential passes of this job were computed from, and the image
+   * its rows are written to. Cycles does not read these, they let the read and write tile
+   * callbacks of the integration find the data of a row. The same object can be baked into
+   * several images with one job each. */
+  std::string uv_map;
+  std::string image_name;
+  int num_pixels;
+
+  /* Rows of the bake buffer used by this job, set by BakeManager::set_jobs. */
+  int y;
+  int height;
+};
+
 class BakeManager {
  public:
   BakeManager();
   ~BakeManager();
 
   void set(Scene *scene, const std::string &object_name, ShaderEvalType type, int pass_filter);
+  /* Bake multiple objects into a buffer of the given width, returns the buffer height. */
+  int set_jobs(
+      Scene *scene, vector<BakeJob> &jobs, int width, ShaderEvalType type, int pass_filter);
+  const vector<BakeJob> &get_jobs() const;
+  /* Job the given row of the bake buffer belongs to, NULL when not baking a batch. */
+  const BakeJob *find_job(int y) const;
   bool get_baking();
 
   void device_update(Device *device, DeviceScene *dscene, Scene *scene, Progress &progress);
@@ -41,10 +69,14 @@ class BakeManager {
   bool need_update() const;
 
  private:
+  void set_passes(Scene *scene, ShaderEvalType type, int pass_filter);
+  void device_update_jobs(DeviceScene *dscene, Scene *scene);
+
   bool need_update_;
   ShaderEvalType type;
   int pass_filter;
   std::string object_name;
+  vector<BakeJob> jobs;
 };
 
 CCL_NAMESPACE_END
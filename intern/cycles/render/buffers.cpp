@@ -257,12 +257,26 @@ bool RenderBuffers::get_denoising_pass_rect(
 bool RenderBuffers::get_pass_rect(
     const string &name, float exposure, int sample, int components, float *pixels)
 {
-  if (buffer.data() == NULL) {
+  /* Pass is identified by both type and name, multiple of the same type
+   * may exist with a different name. */
+  for (size_t j = 0; j < params.passes.size(); j++) {
+    if (params.passes[j].name == name) {
+      return get_pass_rect(j, exposure, sample, components, pixels);
+    }
+  }
+
+  return false;
+}
+
+bool RenderBuffers::get_pass_rect(
+    int pass_index, float exposure, int sample, int components, float *pixels)
+{
+  if (buffer.data() == NULL || pass_index < 0 || pass_index >= (int)params.passes.size()) {
     return false;
   }
 
   float *sample_count = NULL;
-  if (name == "Combined") {
+  if (params.passes[pass_index].type == PASS_COMBINED) {
     int sample_offset = 0;
     for (size_t j = 0; j < params.passes.size(); j++) {
       Pass &pass = params.passes[j];
@@ -282,9 +296,7 @@ bool RenderBuffers::get_pass_rect(
   for (size_t j = 0; j < params.passes.size(); j++) {
     Pass &pass = params.passes[j];
 
-    /* Pass is identified by both type and name, multiple of the same type
-     * may exist with a different name. */
-    if (pass.name != name) {
+    if (j != (size_t)pass_index) {
       pass_offset += pass.components;
       continue;
     }
@@ -90,6 +90,9 @@ class RenderBuffers {
   bool copy_from_device();
   bool get_pass_rect(
       const string &name, float exposure, int sample, int components, float *pixels);
+  /* Get pass by its index in the buffer parameters, for unnamed passes. */
+  bool get_pass_rect(
+      int pass_index, float exposure, int sample, int components, float *pixels);
   bool get_denoising_pass_rect(
       int offset, float exposure, int sample, int components, float *pixels);
   bool set_pass_rect(PassType type, int components, float *pixels, int samples);
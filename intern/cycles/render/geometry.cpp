@@ -38,6 +38,7 @@
 #include "kernel/osl/osl_globals.h"
 
 #include "util/util_foreach.h"
+#include "util/util_half.h"
 #include "util/util_logging.h"
 #include "util/util_progress.h"
 #include "util/util_task.h"
@@ -242,6 +243,11 @@ void Geometry::compute_bvh(
       bparams.num_motion_curve_steps = params->num_bvh_time_steps;
       bparams.bvh_type = params->bvh_type;
       bparams.curve_subdivisions = params->curve_subdivisions();
+      bparams.use_curve_leaf_keys = params->use_bvh_curve_leaf_keys;
+      if (bparams.use_curve_leaf_keys) {
+        /* Segments of a leaf are culled together, so put more than one in a leaf. */
+        bparams.max_curve_leaf_size = 4;
+      }
 
       delete bvh;
       bvh = BVH::create(bparams, geometry, objects, device);
@@ -546,6 +552,38 @@ void GeometryManager::update_svm_attributes(Device *,
   dscene->attributes_map.copy_to_device();
 }
 
+/* Compact geometry storage, see triangle_vindex(), triangle_vertex_normal() and
+ * attribute_float2_fetch() for the kernel side. */
+
+static void pack_normals_compact(const vector<float4> &vnormal, uint *vnormal_oct)
+{
+  for (size_t i = 0; i < vnormal.size(); i++) {
+    vnormal_oct[i] = float3_to_oct(float4_to_float3(vnormal[i]));
+  }
+}
+
+static void pack_tri_vindex_compact(const vector<uint4> &tri_vindex,
+                                    uint2 *tri_vindex_compact,
+                                    uint *tri_vindex_verts,
+                                    vector<uint2> &tri_vindex_overflow)
+{
+  for (size_t i = 0; i < tri_vindex.size(); i++) {
+    const uint4 v = tri_vindex[i];
+    uint deltas;
+
+    if (tri_vindex_pack_deltas(v.x, v.y, v.z, &deltas)) {
+      tri_vindex_compact[i] = make_uint2(v.x, deltas);
+    }
+    else {
+      tri_vindex_compact[i] = make_uint2(v.x,
+                                         TRI_VINDEX_OVERFLOW | (uint)tri_vindex_overflow.size());
+      tri_vindex_overflow.push_back(make_uint2(v.y, v.z));
+    }
+
+    tri_vindex_verts[i] = v.w;
+  }
+}
+
 static void update_attribute_element_size(Geometry *geom,
                                           Attribute *mattr,
                                           AttributePrimitive prim,
@@ -840,10 +878,11 @@ void GeometryManager::device_update_attributes(Device *device,
   dscene->attributes_float3.alloc(attr_float3_size);
   dscene->attributes_uchar4.alloc(attr_uchar4_size);
 
-  /* The order of those flags needs to match that of AttrKernelDataType. */
+  /* The order of those flags needs to match that of AttrKernelDataType. With compact geometry
+   * the float2 array only lives during the update, so it has to be filled in completely. */
   const bool attributes_need_realloc[4] = {
       dscene->attributes_float.need_realloc(),
-      dscene->attributes_float2.need_realloc(),
+      dscene->attributes_float2.need_realloc() || scene->params.compact_geometry,
       dscene->attributes_float3.need_realloc(),
       dscene->attributes_uchar4.need_realloc(),
   };
@@ -969,7 +1008,19 @@ void GeometryManager::device_update_attributes(Device *device,
   progress.set_status("Updating Mesh", "Copying Attributes to device");
 
   dscene->attributes_float.copy_to_device_if_modified();
-  dscene->attributes_float2.copy_to_device_if_modified();
+  if (scene->params.compact_geometry) {
+    /* Store float2 attributes in half precision and drop the full precision copy. */
+    const size_t attr_half2_size = dscene->attributes_float2.size();
+    uint *attr_half2 = dscene->attributes_half2.alloc(attr_half2_size);
+    for (size_t i = 0; i < attr_half2_size; i++) {
+      attr_half2[i] = float2_to_half2(dscene->attributes_float2[i]);
+    }
+    dscene->attributes_half2.copy_to_device();
+    dscene->attributes_float2.free();
+  }
+  else {
+    dscene->attributes_float2.copy_to_device_if_modified();
+  }
   dscene->attributes_float3.copy_to_device_if_modified();
   dscene->attributes_uchar4.copy_to_device_if_modified();
 
@@ -1053,6 +1104,9 @@ void GeometryManager::mesh_calc_offset(Scene *scene, BVHLayout bvh_layout)
 void GeometryManager::device_update_mesh(
     Device *, DeviceScene *dscene, Scene *scene, bool for_displacement, Progress &progress)
 {
+  /* Set before displacement shaders get to read the mesh data. */
+  dscene->data.bvh.compact_geometry = scene->params.compact_geometry;
+
   /* Count. */
   size_t vert_size = 0;
   size_t tri_size = 0;
@@ -1118,18 +1172,55 @@ void GeometryManager::device_update_mesh(
     /* normals */
     progress.set_status("Updating Mesh", "Computing normals");
 
+    const bool compact = scene->params.compact_geometry;
+
     uint *tri_shader = dscene->tri_shader.alloc(tri_size);
-    float4 *vnormal = dscene->tri_vnormal.alloc(vert_size);
-    uint4 *tri_vindex = dscene->tri_vindex.alloc(tri_size);
+    float4 *vnormal = NULL;
+    uint4 *tri_vindex = NULL;
+    uint *vnormal_oct = NULL;
+    uint2 *tri_vindex_compact = NULL;
+    uint *tri_vindex_verts = NULL;
     uint *tri_patch = dscene->tri_patch.alloc(tri_size);
     float2 *tri_patch_uv = dscene->tri_patch_uv.alloc(vert_size);
 
+    if (compact) {
+      vnormal_oct = dscene->tri_vnormal_oct.alloc(vert_size);
+      tri_vindex_compact = dscene->tri_vindex_compact.alloc(tri_size);
+      tri_vindex_verts = dscene->tri_vindex_verts.alloc(tri_size);
+    }
+    else {
+      vnormal = dscene->tri_vnormal.alloc(vert_size);
+      tri_vindex = dscene->tri_vindex.alloc(tri_size);
+    }
+
     const bool copy_all_data = dscene->tri_shader.need_realloc() ||
                                dscene->tri_vindex.need_realloc() ||
                                dscene->tri_vnormal.need_realloc() ||
+                               dscene->tri_vnormal_oct.need_realloc() ||
+                               dscene->tri_vindex_compact.need_realloc() ||
+                               dscene->tri_vindex_verts.need_realloc() ||
                                dscene->tri_patch.need_realloc() ||
                                dscene->tri_patch_uv.need_realloc();
 
+    /* Compact triangle indices share one overflow table, so they are packed for all meshes
+     * as soon as one of them changes. */
+    bool pack_all_verts = copy_all_data;
+    if (compact && !pack_all_verts) {
+      foreach (Geometry *geom, scene->geometry) {
+        if (geom->geometry_type == Geometry::MESH || geom->geometry_type == Geometry::VOLUME) {
+          Mesh *mesh = static_cast<Mesh *>(geom);
+          if (mesh->triangles_is_modified() || mesh->vert_patch_uv_is_modified()) {
+            pack_all_verts = true;
+            break;
+          }
+        }
+      }
+    }
+
+    vector<float4> mesh_vnormal;
+    vector<uint4> mesh_tri_vindex;
+    vector<uint2> tri_vindex_overflow;
+
     foreach (Geometry *geom, scene->geometry) {
       if (geom->geometry_type == Geometry::MESH || geom->geometry_type == Geometry::VOLUME) {
         Mesh *mesh = static_cast<Mesh *>(geom);
@@ -1140,16 +1231,33 @@ void GeometryManager::device_update_mesh(
         }
 
         if (mesh->verts_is_modified() || copy_all_data) {
-          mesh->pack_normals(&vnormal[mesh->vert_offset]);
+          if (compact) {
+            mesh_vnormal.resize(mesh->get_verts().size());
+            mesh->pack_normals(mesh_vnormal.data());
+            pack_normals_compact(mesh_vnormal, &vnormal_oct[mesh->vert_offset]);
+          }
+          else {
+            mesh->pack_normals(&vnormal[mesh->vert_offset]);
+          }
         }
 
-        if (mesh->triangles_is_modified() || mesh->vert_patch_uv_is_modified() || copy_all_data) {
+        if (mesh->triangles_is_modified() || mesh->vert_patch_uv_is_modified() ||
+            pack_all_verts) {
+          if (compact) {
+            mesh_tri_vindex.resize(mesh->num_triangles());
+          }
           mesh->pack_verts(tri_prim_index,
-                           &tri_vindex[mesh->prim_offset],
+                           (compact) ? mesh_tri_vindex.data() : &tri_vindex[mesh->prim_offset],
                            &tri_patch[mesh->prim_offset],
                            &tri_patch_uv[mesh->vert_offset],
                            mesh->vert_offset,
                            mesh->prim_offset);
+          if (compact) {
+            pack_tri_vindex_compact(mesh_tri_vindex,
+                                    &tri_vindex_compact[mesh->prim_offset],
+                                    &tri_vindex_verts[mesh->prim_offset],
+                                    tri_vindex_overflow);
+          }
         }
 
         if (progress.get_cancel())
@@ -1157,12 +1265,26 @@ void GeometryManager::device_update_mesh(
       }
     }
 
+    if (compact && pack_all_verts) {
+      uint2 *overflow = dscene->tri_vindex_overflow.alloc(tri_vindex_overflow.size());
+      std::copy(tri_vindex_overflow.begin(), tri_vindex_overflow.end(), overflow);
+      dscene->tri_vindex_overflow.tag_modified();
+    }
+
     /* vertex coordinates */
     progress.set_status("Updating Mesh", "Copying Mesh to device");
 
     dscene->tri_shader.copy_to_device_if_modified();
-    dscene->tri_vnormal.copy_to_device_if_modified();
-    dscene->tri_vindex.copy_to_device_if_modified();
+    if (compact) {
+      dscene->tri_vnormal_oct.copy_to_device_if_modified();
+      dscene->tri_vindex_compact.copy_to_device_if_modified();
+      dscene->tri_vindex_verts.copy_to_device_if_modified();
+      dscene->tri_vindex_overflow.copy_to_device_if_modified();
+    }
+    else {
+      dscene->tri_vnormal.copy_to_device_if_modified();
+      dscene->tri_vindex.copy_to_device_if_modified();
+    }
     dscene->tri_patch.copy_to_device_if_modified();
     dscene->tri_patch_uv.copy_to_device_if_modified();
   }
@@ -1248,7 +1370,8 @@ void GeometryManager::device_update_mesh(
 void GeometryManager::device_update_bvh(Device *device,
                                         DeviceScene *dscene,
                                         Scene *scene,
-                                        Progress &progress)
+                                        Progress &progress,
+                                        bool only_deformed)
 {
   /* bvh build */
   progress.set_status("Updating Scene BVH", "Building");
@@ -1264,11 +1387,18 @@ void GeometryManager::device_update_bvh(Device *device,
   bparams.num_motion_curve_steps = scene->params.num_bvh_time_steps;
   bparams.bvh_type = scene->params.bvh_type;
   bparams.curve_subdivisions = scene->params.curve_subdivisions();
+  bparams.use_curve_leaf_keys = scene->params.use_bvh_curve_leaf_keys;
+  if (bparams.use_curve_leaf_keys) {
+    bparams.max_curve_leaf_size = 4;
+  }
 
   VLOG(1) << "Using " << bvh_layout_name(bparams.bvh_layout) << " layout.";
 
+  /* BVH2 can refit the scene BVH when its topology is unchanged, which is the case when only
+   * geometry with transform applied deformed. */
   const bool can_refit = scene->bvh != nullptr &&
-                         (bparams.bvh_layout == BVHLayout::BVH_LAYOUT_OPTIX);
+                         (bparams.bvh_layout == BVHLayout::BVH_LAYOUT_OPTIX ||
+                          (bparams.bvh_layout == BVHLayout::BVH_LAYOUT_BVH2 && only_deformed));
 
   PackFlags pack_flags = PackFlags::PACK_NONE;
 
@@ -1285,13 +1415,39 @@ void GeometryManager::device_update_bvh(Device *device,
     bvh = scene->bvh = BVH::create(bparams, scene->geometry, scene->objects, device);
   }
 
+  const bool has_bvh2_layout = (bparams.bvh_layout == BVH_LAYOUT_BVH2);
+
+  if (has_bvh2_layout && can_refit) {
+    /* The packed BVH was handed over to the device arrays by the previous update, take it back
+     * so it can be refit in place. */
+    PackedBVH &bvh_pack = static_cast<BVH2 *>(bvh)->pack;
+    dscene->bvh_nodes.give_data(bvh_pack.nodes);
+    dscene->bvh_leaf_nodes.give_data(bvh_pack.leaf_nodes);
+    dscene->object_node.give_data(bvh_pack.object_node);
+    dscene->prim_tri_index.give_data(bvh_pack.prim_tri_index);
+    dscene->prim_tri_verts.give_data(bvh_pack.prim_tri_verts);
+    dscene->prim_curve_index.give_data(bvh_pack.prim_curve_index);
+    dscene->prim_curve_keys.give_data(bvh_pack.prim_curve_keys);
+    dscene->prim_type.give_data(bvh_pack.prim_type);
+    dscene->prim_visibility.give_data(bvh_pack.prim_visibility);
+    dscene->prim_index.give_data(bvh_pack.prim_index);
+    dscene->prim_object.give_data(bvh_pack.prim_object);
+    dscene->prim_time.give_data(bvh_pack.prim_time);
+  }
+
   device->build_bvh(bvh, progress, can_refit);
 
   if (progress.get_cancel()) {
     return;
   }
 
-  const bool has_bvh2_layout = (bparams.bvh_layout == BVH_LAYOUT_BVH2);
+  if (has_bvh2_layout && !can_refit && scene->update_stats) {
+    scene->update_stats->bvh.times.add_entry(
+        {"scene BVH (add references)", bvh->build_times.add_references});
+    scene->update_stats->bvh.times.add_entry(
+        {"scene BVH (build nodes)", bvh->build_times.build_nodes});
+    scene->update_stats->bvh.times.add_entry({"scene BVH (pack)", bvh->build_times.pack});
+  }
 
   PackedBVH pack;
   if (has_bvh2_layout) {
@@ -1397,6 +1553,12 @@ void GeometryManager::device_update_bvh(Device *device,
     dscene->prim_tri_verts.steal_data(pack.prim_tri_verts);
     dscene->prim_tri_verts.copy_to_device();
   }
+  if (pack.prim_curve_keys.size()) {
+    dscene->prim_curve_index.steal_data(pack.prim_curve_index);
+    dscene->prim_curve_index.copy_to_device();
+    dscene->prim_curve_keys.steal_data(pack.prim_curve_keys);
+    dscene->prim_curve_keys.copy_to_device();
+  }
   if (pack.prim_type.size() && (dscene->prim_type.need_realloc() || has_bvh2_layout)) {
     dscene->prim_type.steal_data(pack.prim_type);
     dscene->prim_type.copy_to_device();
@@ -1421,6 +1583,7 @@ void GeometryManager::device_update_bvh(Device *device,
   dscene->data.bvh.root = pack.root_index;
   dscene->data.bvh.use_bvh_steps = (scene->params.num_bvh_time_steps != 0);
   dscene->data.bvh.curve_subdivisions = scene->params.curve_subdivisions();
+  dscene->data.bvh.have_curve_leaf_keys = (dscene->prim_curve_keys.size() != 0);
   /* The scene handle is set in 'CPUDevice::const_copy_to' and 'OptiXDevice::const_copy_to' */
   dscene->data.bvh.scene = 0;
 }
@@ -1561,6 +1724,10 @@ void GeometryManager::device_update_preprocess(Device *device, Scene *scene, Pro
         }
       }
 
+      if (shader->need_update_volume_occupancy && geom->geometry_type == Geometry::VOLUME) {
+        geom->tag_modified();
+      }
+
       if (shader->need_update_displacement) {
         /* tag displacement related sockets as modified */
         if (geom->is_mesh()) {
@@ -1645,6 +1812,8 @@ void GeometryManager::device_update_preprocess(Device *device, Scene *scene, Pro
     dscene->object_node.tag_realloc();
     dscene->prim_tri_verts.tag_realloc();
     dscene->prim_tri_index.tag_realloc();
+    dscene->prim_curve_keys.tag_realloc();
+    dscene->prim_curve_index.tag_realloc();
     dscene->prim_type.tag_realloc();
     dscene->prim_visibility.tag_realloc();
     dscene->prim_index.tag_realloc();
@@ -1654,10 +1823,15 @@ void GeometryManager::device_update_preprocess(Device *device, Scene *scene, Pro
     if (device_update_flags & DEVICE_MESH_DATA_NEEDS_REALLOC) {
       dscene->tri_vnormal.tag_realloc();
       dscene->tri_vindex.tag_realloc();
+      dscene->tri_vnormal_oct.tag_realloc();
+      dscene->tri_vindex_compact.tag_realloc();
+      dscene->tri_vindex_verts.tag_realloc();
+      dscene->tri_vindex_overflow.tag_realloc();
       dscene->tri_patch.tag_realloc();
       dscene->tri_patch_uv.tag_realloc();
       dscene->tri_shader.tag_realloc();
       dscene->patches.tag_realloc();
+      dscene->volume_occupancy.tag_realloc();
     }
 
     if (device_update_flags & DEVICE_CURVE_DATA_NEEDS_REALLOC) {
@@ -1681,9 +1855,11 @@ void GeometryManager::device_update_preprocess(Device *device, Scene *scene, Pro
   if (device_update_flags & ATTR_FLOAT2_NEEDS_REALLOC) {
     dscene->attributes_map.tag_realloc();
     dscene->attributes_float2.tag_realloc();
+    dscene->attributes_half2.tag_realloc();
   }
   else if (device_update_flags & ATTR_FLOAT2_MODIFIED) {
     dscene->attributes_float2.tag_modified();
+    dscene->attributes_half2.tag_modified();
   }
 
   if (device_update_flags & ATTR_FLOAT3_NEEDS_REALLOC) {
@@ -1706,6 +1882,7 @@ void GeometryManager::device_update_preprocess(Device *device, Scene *scene, Pro
     /* if anything else than vertices or shaders are modified, we would need to reallocate, so
      * these are the only arrays that can be updated */
     dscene->tri_vnormal.tag_modified();
+    dscene->tri_vnormal_oct.tag_modified();
     dscene->tri_shader.tag_modified();
   }
 
@@ -1877,6 +2054,8 @@ void GeometryManager::device_update(Device *device,
         progress.set_status("Updating Mesh", msg);
 
         mesh->subd_params->camera = dicing_camera;
+        /* Interactive sessions re-tessellate on many edits, keep diced geometry around. */
+        mesh->subd_params->use_dice_cache = !scene->params.background;
         DiagSplit dsplit(*mesh->subd_params);
         mesh->tessellate(&dsplit);
 
@@ -1998,6 +2177,9 @@ void GeometryManager::device_update(Device *device,
    * change. */
   bool need_update_scene_bvh = (scene->bvh == nullptr ||
                                 (update_flags & (TRANSFORM_MODIFIED | VISIBILITY_MODIFIED)) != 0);
+  /* Whether the scene BVH only needs to follow deformed geometry with unchanged topology.
+   * Instanced geometry has its own BVH merged into the scene one, which needs a rebuild. */
+  bool scene_bvh_only_deformed = !need_update_scene_bvh;
   {
     scoped_callback_timer timer([scene](double time) {
       if (scene->update_stats) {
@@ -2010,6 +2192,10 @@ void GeometryManager::device_update(Device *device,
     foreach (Geometry *geom, scene->geometry) {
       if (geom->is_modified() || geom->need_update_bvh_for_offset) {
         need_update_scene_bvh = true;
+        if (geom->need_update_rebuild || geom->need_update_bvh_for_offset ||
+            geom->is_instanced()) {
+          scene_bvh_only_deformed = false;
+        }
         pool.push(function_bind(
             &Geometry::compute_bvh, geom, device, dscene, &scene->params, &progress, i, num_bvh));
         if (geom->need_build_bvh(bvh_layout)) {
@@ -2027,6 +2213,7 @@ void GeometryManager::device_update(Device *device,
     shader->need_update_uvs = false;
     shader->need_update_attribute = false;
     shader->need_update_displacement = false;
+    shader->need_update_volume_occupancy = false;
   }
 
   Scene::MotionType need_motion = scene->need_motion();
@@ -2054,7 +2241,7 @@ void GeometryManager::device_update(Device *device,
         scene->update_stats->geometry.times.add_entry({"device_update (build scene BVH)", time});
       }
     });
-    device_update_bvh(device, dscene, scene, progress);
+    device_update_bvh(device, dscene, scene, progress, scene_bvh_only_deformed);
     if (progress.get_cancel()) {
       return;
     }
@@ -2078,6 +2265,8 @@ void GeometryManager::device_update(Device *device,
     }
   }
 
+  device_update_volume_occupancy(dscene, scene);
+
   if (true_displacement_used) {
     /* Re-tag flags for update, so they're re-evaluated
      * for meshes with correct bounding boxes.
@@ -2107,6 +2296,8 @@ void GeometryManager::device_update(Device *device,
   dscene->object_node.clear_modified();
   dscene->prim_tri_verts.clear_modified();
   dscene->prim_tri_index.clear_modified();
+  dscene->prim_curve_keys.clear_modified();
+  dscene->prim_curve_index.clear_modified();
   dscene->prim_type.clear_modified();
   dscene->prim_visibility.clear_modified();
   dscene->prim_index.clear_modified();
@@ -2117,12 +2308,18 @@ void GeometryManager::device_update(Device *device,
   dscene->tri_patch.clear_modified();
   dscene->tri_vnormal.clear_modified();
   dscene->tri_patch_uv.clear_modified();
+  dscene->tri_vnormal_oct.clear_modified();
+  dscene->tri_vindex_compact.clear_modified();
+  dscene->tri_vindex_verts.clear_modified();
+  dscene->tri_vindex_overflow.clear_modified();
   dscene->curves.clear_modified();
   dscene->curve_keys.clear_modified();
   dscene->patches.clear_modified();
+  dscene->volume_occupancy.clear_modified();
   dscene->attributes_map.clear_modified();
   dscene->attributes_float.clear_modified();
   dscene->attributes_float2.clear_modified();
+  dscene->attributes_half2.clear_modified();
   dscene->attributes_float3.clear_modified();
   dscene->attributes_uchar4.clear_modified();
 }
@@ -2134,6 +2331,8 @@ void GeometryManager::device_free(Device *device, DeviceScene *dscene, bool forc
   dscene->object_node.free_if_need_realloc(force_free);
   dscene->prim_tri_verts.free_if_need_realloc(force_free);
   dscene->prim_tri_index.free_if_need_realloc(force_free);
+  dscene->prim_curve_keys.free_if_need_realloc(force_free);
+  dscene->prim_curve_index.free_if_need_realloc(force_free);
   dscene->prim_type.free_if_need_realloc(force_free);
   dscene->prim_visibility.free_if_need_realloc(force_free);
   dscene->prim_index.free_if_need_realloc(force_free);
@@ -2144,12 +2343,18 @@ void GeometryManager::device_free(Device *device, DeviceScene *dscene, bool forc
   dscene->tri_vindex.free_if_need_realloc(force_free);
   dscene->tri_patch.free_if_need_realloc(force_free);
   dscene->tri_patch_uv.free_if_need_realloc(force_free);
+  dscene->tri_vnormal_oct.free_if_need_realloc(force_free);
+  dscene->tri_vindex_compact.free_if_need_realloc(force_free);
+  dscene->tri_vindex_verts.free_if_need_realloc(force_free);
+  dscene->tri_vindex_overflow.free_if_need_realloc(force_free);
   dscene->curves.free_if_need_realloc(force_free);
   dscene->curve_keys.free_if_need_realloc(force_free);
   dscene->patches.free_if_need_realloc(force_free);
+  dscene->volume_occupancy.free_if_need_realloc(force_free);
   dscene->attributes_map.free_if_need_realloc(force_free);
   dscene->attributes_float.free_if_need_realloc(force_free);
   dscene->attributes_float2.free_if_need_realloc(force_free);
+  dscene->attributes_half2.free_if_need_realloc(force_free);
   dscene->attributes_float3.free_if_need_realloc(force_free);
   dscene->attributes_uchar4.free_if_need_realloc(force_free);
 
@@ -2190,6 +2395,22 @@ void GeometryManager::collect_statistics(const Scene *scene, RenderStats *stats)
     stats->mesh.geometry.add_entry(
         NamedSizeEntry(string(geometry->name.c_str()), geometry->get_total_size_in_bytes()));
   }
+
+  if (scene->params.compact_geometry) {
+    const DeviceScene &dscene = scene->dscene;
+    const size_t tri_vindex_full_size = dscene.tri_vindex_compact.size() * sizeof(uint4);
+    const size_t tri_vindex_size = dscene.tri_vindex_compact.size() * sizeof(uint2) +
+                                   dscene.tri_vindex_verts.size() * sizeof(uint) +
+                                   dscene.tri_vindex_overflow.size() * sizeof(uint2);
+
+    stats->mesh.compact_geometry.add_entry(NamedSizeEntry(
+        "Normals", dscene.tri_vnormal_oct.size() * (sizeof(float4) - sizeof(uint))));
+    stats->mesh.compact_geometry.add_entry(NamedSizeEntry(
+        "Triangle indices",
+        (tri_vindex_full_size > tri_vindex_size) ? tri_vindex_full_size - tri_vindex_size : 0));
+    stats->mesh.compact_geometry.add_entry(NamedSizeEntry(
+        "Float2 attributes", dscene.attributes_half2.size() * (sizeof(float2) - sizeof(uint))));
+  }
 }
 
 CCL_NAMESPACE_END
@@ -214,6 +214,8 @@ class GeometryManager {
 
     VISIBILITY_MODIFIED = (1 << 11),
 
+    SHADER_VOLUME_MODIFIED = (1 << 12),
+
     /* tag everything in the manager for an update */
     UPDATE_ALL = ~0u,
 
@@ -244,6 +246,7 @@ class GeometryManager {
   bool displace(Device *device, DeviceScene *dscene, Scene *scene, Mesh *mesh, Progress &progress);
 
   void create_volume_mesh(Volume *volume, Progress &progress);
+  void device_update_volume_occupancy(DeviceScene *dscene, Scene *scene);
 
   /* Attributes */
   void update_osl_attributes(Device *device,
@@ -271,7 +274,11 @@ class GeometryManager {
                                 Scene *scene,
                                 Progress &progress);
 
-  void device_update_bvh(Device *device, DeviceScene *dscene, Scene *scene, Progress &progress);
+  void device_update_bvh(Device *device,
+                         DeviceScene *dscene,
+                         Scene *scene,
+                         Progress &progress,
+                         bool only_deformed);
 
   void device_update_displacement_images(Device *device, Scene *scene, Progress &progress);
 
@@ -742,6 +742,33 @@ void ShaderGraph::break_cycles(ShaderNode *node, vector<bool> &visited, vector<b
   on_stack[node->id] = false;
 }
 
+static void shader_node_hash(ShaderNode *node, MD5Hash &md5)
+{
+  node->hash(md5);
+  foreach (ShaderInput *input, node->inputs) {
+    int link_id = (input->link) ? input->link->parent->id : 0;
+    md5.append((uint8_t *)&link_id, sizeof(link_id));
+    md5.append((input->link) ? input->link->name().c_str() : "");
+  }
+
+  if (node->special_type == SHADER_SPECIAL_TYPE_OSL) {
+    /* Hash takes into account socket values, to detect changes
+     * in the code of the node we need an exception. */
+    OSLNode *oslnode = static_cast<OSLNode *>(node);
+    md5.append(oslnode->bytecode_hash);
+  }
+  else if (node->special_type == SHADER_SPECIAL_TYPE_IMAGE_SLOT) {
+    /* Builtin images are not sockets, so include the image slots to detect
+     * e.g. a new frame of an image sequence. */
+    ImageSlotTextureNode *image_node = static_cast<ImageSlotTextureNode *>(node);
+    const int num_tiles = image_node->handle.num_tiles();
+    for (int i = 0; i < num_tiles; i++) {
+      const int slot = image_node->handle.svm_slot(i);
+      md5.append((uint8_t *)&slot, sizeof(slot));
+    }
+  }
+}
+
 void ShaderGraph::compute_displacement_hash()
 {
   /* Compute hash of all nodes linked to displacement, to detect if we need
@@ -758,24 +785,24 @@ void ShaderGraph::compute_displacement_hash()
 
   MD5Hash md5;
   foreach (ShaderNode *node, nodes_displace) {
-    node->hash(md5);
-    foreach (ShaderInput *input, node->inputs) {
-      int link_id = (input->link) ? input->link->parent->id : 0;
-      md5.append((uint8_t *)&link_id, sizeof(link_id));
-      md5.append((input->link) ? input->link->name().c_str() : "");
-    }
-
-    if (node->special_type == SHADER_SPECIAL_TYPE_OSL) {
-      /* Hash takes into account socket values, to detect changes
-       * in the code of the node we need an exception. */
-      OSLNode *oslnode = static_cast<OSLNode *>(node);
-      md5.append(oslnode->bytecode_hash);
-    }
+    shader_node_hash(node, md5);
   }
 
   displacement_hash = md5.get_hex();
 }
 
+void ShaderGraph::compute_hash()
+{
+  /* Compute hash of the entire graph, to detect if a re-synced shader
+   * actually changed and needs to be compiled again. */
+  MD5Hash md5;
+  foreach (ShaderNode *node, nodes) {
+    shader_node_hash(node, md5);
+  }
+
+  hash = md5.get_hex();
+}
+
 void ShaderGraph::clean(Scene *scene)
 {
   /* Graph simplification */
@@ -21,6 +21,7 @@
 #include "render/image_vdb.h"
 #include "render/scene.h"
 #include "render/stats.h"
+#include "render/texture_cache.h"
 
 #include "util/util_foreach.h"
 #include "util/util_image.h"
@@ -77,6 +78,8 @@ const char *name_from_type(ImageDataType type)
       return "nanovdb_float";
     case IMAGE_DATA_TYPE_NANOVDB_FLOAT3:
       return "nanovdb_float3";
+    case IMAGE_DATA_TYPE_TEXTURE_CACHE:
+      return "texture_cache";
     case IMAGE_DATA_NUM_TYPES:
       assert(!"System enumerator type, should never be used");
       return "";
@@ -85,6 +88,41 @@ const char *name_from_type(ImageDataType type)
   return "";
 }
 
+/* Bytes per pixel of the device texture, 0 for types which can not be resized. */
+size_t pixel_size_from_type(ImageDataType type)
+{
+  switch (type) {
+    case IMAGE_DATA_TYPE_FLOAT4:
+      return 4 * sizeof(float);
+    case IMAGE_DATA_TYPE_HALF4:
+      return 4 * sizeof(half);
+    case IMAGE_DATA_TYPE_USHORT4:
+      return 4 * sizeof(uint16_t);
+    case IMAGE_DATA_TYPE_BYTE4:
+      return 4 * sizeof(uchar);
+    case IMAGE_DATA_TYPE_FLOAT:
+      return sizeof(float);
+    case IMAGE_DATA_TYPE_HALF:
+      return sizeof(half);
+    case IMAGE_DATA_TYPE_USHORT:
+      return sizeof(uint16_t);
+    case IMAGE_DATA_TYPE_BYTE:
+      return sizeof(uchar);
+    default:
+      return 0;
+  }
+}
+
+/* Device memory used by an image scaled by the given factor, matching the dimensions computed
+ * by util_image_resize_pixels(). */
+size_t scaled_image_size(const ImageMetaData &metadata, const float scale_factor)
+{
+  const size_t width = max((size_t)((float)metadata.width * scale_factor), (size_t)1);
+  const size_t height = max((size_t)((float)metadata.height * scale_factor), (size_t)1);
+  const size_t depth = max((size_t)((float)metadata.depth * scale_factor), (size_t)1);
+  return width * height * depth * pixel_size_from_type(metadata.type);
+}
+
 }  // namespace
 
 /* Image Handle */
@@ -300,17 +338,21 @@ ImageManager::ImageManager(const DeviceInfo &info)
 {
   need_update_ = true;
   osl_texture_system = NULL;
+  texture_cache = NULL;
   animation_frame = 0;
 
   /* Set image limits */
   features.has_half_float = info.has_half_images;
   features.has_nanovdb = info.has_nanovdb;
+  has_texture_cache = info.has_texture_cache;
 }
 
 ImageManager::~ImageManager()
 {
   for (size_t slot = 0; slot < images.size(); slot++)
     assert(!images[slot]);
+
+  delete texture_cache;
 }
 
 void ImageManager::set_osl_texture_system(void *texture_system)
@@ -318,6 +360,15 @@ void ImageManager::set_osl_texture_system(void *texture_system)
   osl_texture_system = texture_system;
 }
 
+void ImageManager::texture_cache_init(const size_t memory_limit)
+{
+  /* Must be set before image metadata is loaded, since it changes the color space handling of
+   * cached images in the shader nodes. */
+  if (has_texture_cache && memory_limit > 0 && texture_cache == NULL) {
+    texture_cache = new TextureCache(memory_limit);
+  }
+}
+
 bool ImageManager::set_animation_frame_update(int frame)
 {
   if (frame != animation_frame) {
@@ -357,6 +408,12 @@ void ImageManager::load_image_metadata(Image *img)
 
   metadata.detect_colorspace();
 
+  if (use_texture_cache(img) && metadata.channels != 1) {
+    /* The texture cache converts to scene linear at lookup time, only sRGB is left to the
+     * kernel. */
+    metadata.compress_as_srgb = (metadata.colorspace == u_colorspace_srgb);
+  }
+
   assert(features.has_half_float ||
          (metadata.type != IMAGE_DATA_TYPE_HALF4 && metadata.type != IMAGE_DATA_TYPE_HALF));
   assert(features.has_nanovdb || (metadata.type != IMAGE_DATA_TYPE_NANOVDB_FLOAT ||
@@ -442,8 +499,10 @@ int ImageManager::add_image_slot(ImageLoader *loader,
   img->need_metadata = true;
   img->need_load = !(osl_texture_system && !img->loader->osl_filepath().empty());
   img->builtin = builtin;
+  img->texture_limit = 0;
   img->users = 1;
   img->mem = NULL;
+  img->cache_image = NULL;
 
   images[slot] = img;
 
@@ -486,6 +545,119 @@ static bool image_associate_alpha(ImageManager::Image *img)
            img->params.alpha_type == IMAGE_ALPHA_CHANNEL_PACKED);
 }
 
+bool ImageManager::use_texture_cache(Image *img)
+{
+  if (texture_cache == NULL || img->loader->osl_filepath().empty()) {
+    return false;
+  }
+
+  /* Only 2D images that the texture system returns the same as they are loaded into memory:
+   * it expands grayscale to RGB and always associates alpha. Missing files are left to the
+   * regular loading to get the missing texture color. */
+  const ImageMetaData &metadata = img->metadata;
+  if (metadata.depth > 1 || metadata.use_transform_3d) {
+    return false;
+  }
+  return metadata.channels == 1 || metadata.channels == 3 ||
+         (metadata.channels == 4 && image_associate_alpha(img));
+}
+
+void ImageManager::downscale_to_memory_limit(Scene *scene)
+{
+  /* Choose a resolution for every image that is about to be loaded so that all textures fit
+   * into the memory limit. The largest texture is halved first, which keeps the relative loss
+   * of detail similar across images instead of reducing small textures to nothing. */
+  const size_t memory_limit = scene->params.texture_downscale_limit;
+  const int texture_limit = scene->params.texture_limit;
+
+  struct ImageScale {
+    Image *img;
+    size_t max_size;
+    float scale_factor;
+    size_t size;
+  };
+  vector<ImageScale> scales;
+  size_t total_size = 0;
+
+  foreach (Image *img, images) {
+    if (img == NULL || img->users == 0) {
+      continue;
+    }
+    if (!img->need_load) {
+      if (img->mem) {
+        total_size += img->mem->memory_size();
+      }
+      continue;
+    }
+
+    img->texture_limit = 0;
+    if (memory_limit == 0) {
+      continue;
+    }
+
+    load_image_metadata(img);
+    if (use_texture_cache(img)) {
+      /* Does not use texture memory, the texture cache has its own budget. */
+      continue;
+    }
+
+    const ImageMetaData &metadata = img->metadata;
+    const size_t max_size = max(max(metadata.width, metadata.height), metadata.depth);
+    if (max_size == 0 || pixel_size_from_type(metadata.type) == 0) {
+      continue;
+    }
+
+    /* Start from the resolution the scene texture limit already gives. */
+    float scale_factor = 1.0f;
+    while (texture_limit > 0 && max_size * scale_factor > texture_limit) {
+      scale_factor *= 0.5f;
+    }
+
+    ImageScale scale = {img, max_size, scale_factor, scaled_image_size(metadata, scale_factor)};
+    scales.push_back(scale);
+    total_size += scale.size;
+  }
+
+  if (memory_limit == 0 || total_size <= memory_limit) {
+    return;
+  }
+
+  const size_t full_size = total_size;
+  while (total_size > memory_limit) {
+    ImageScale *largest = NULL;
+    foreach (ImageScale &scale, scales) {
+      if (scale.max_size * scale.scale_factor >= 2.0f &&
+          (largest == NULL || scale.size > largest->size)) {
+        largest = &scale;
+      }
+    }
+    if (largest == NULL) {
+      break;
+    }
+
+    largest->scale_factor *= 0.5f;
+    const size_t size = scaled_image_size(largest->img->metadata, largest->scale_factor);
+    total_size -= largest->size - size;
+    largest->size = size;
+  }
+
+  if (total_size > memory_limit) {
+    LOG(WARNING) << "Textures do not fit into the texture memory limit of "
+                 << string_human_readable_size(memory_limit) << " even at lowest resolution.";
+  }
+
+  foreach (const ImageScale &scale, scales) {
+    if (scale.scale_factor < 1.0f) {
+      /* Rounded up so file_load_image() arrives at the same scale factor for odd sizes. */
+      scale.img->texture_limit = (int)ceilf(scale.max_size * scale.scale_factor);
+    }
+  }
+
+  VLOG(1) << "Texture memory limit " << string_human_readable_size(memory_limit)
+          << ", reduced textures from " << string_human_readable_size(full_size) << " to "
+          << string_human_readable_size(total_size) << ".";
+}
+
 template<TypeDesc::BASETYPE FileFormat, typename StorageType>
 bool ImageManager::file_load_image(Image *img, int texture_limit)
 {
@@ -652,10 +824,12 @@ void ImageManager::device_load_image(Device *device, Scene *scene, int slot, Pro
 
   progress->set_status("Updating Images", "Loading " + img->loader->name());
 
-  const int texture_limit = scene->params.texture_limit;
+  const int texture_limit = (img->texture_limit > 0) ? img->texture_limit :
+                                                       scene->params.texture_limit;
 
   load_image_metadata(img);
-  ImageDataType type = img->metadata.type;
+  ImageDataType type = use_texture_cache(img) ? IMAGE_DATA_TYPE_TEXTURE_CACHE :
+                                                img->metadata.type;
 
   /* Name for debugging. */
   img->mem_name = string_printf("__tex_image_%s_%03d", name_from_type(type), slot);
@@ -673,7 +847,24 @@ void ImageManager::device_load_image(Device *device, Scene *scene, int slot, Pro
   img->mem->info.transform_3d = img->metadata.transform_3d;
 
   /* Create new texture. */
-  if (type == IMAGE_DATA_TYPE_FLOAT4) {
+  if (type == IMAGE_DATA_TYPE_TEXTURE_CACHE) {
+    /* Sampled on demand, the texture only holds a pointer to the cache image. */
+    if (img->cache_image == NULL) {
+      const ustring colorspace = (img->metadata.compress_as_srgb || img->metadata.channels == 1) ?
+                                     u_colorspace_raw :
+                                     img->metadata.colorspace;
+      img->cache_image = texture_cache->add_image(img->loader->osl_filepath(),
+                                                  colorspace,
+                                                  img->params.interpolation,
+                                                  img->params.extension);
+    }
+
+    thread_scoped_lock device_lock(device_mutex);
+    TextureCacheImage **pixels = (TextureCacheImage **)img->mem->alloc(
+        sizeof(TextureCacheImage *), 0);
+    pixels[0] = img->cache_image;
+  }
+  else if (type == IMAGE_DATA_TYPE_FLOAT4) {
     if (!file_load_image<TypeDesc::FLOAT, float>(img, texture_limit)) {
       /* on failure to load, we set a 1x1 pixels pink image */
       thread_scoped_lock device_lock(device_mutex);
@@ -799,6 +990,10 @@ void ImageManager::device_free_image(Device *, int slot)
     delete img->mem;
   }
 
+  if (img->cache_image) {
+    texture_cache->remove_image(img->cache_image);
+  }
+
   delete img->loader;
   delete img;
   images[slot] = NULL;
@@ -816,6 +1011,8 @@ void ImageManager::device_update(Device *device, Scene *scene, Progress &progres
     }
   });
 
+  downscale_to_memory_limit(scene);
+
   TaskPool pool;
   for (size_t slot = 0; slot < images.size(); slot++) {
     Image *img = images[slot];
@@ -854,6 +1051,8 @@ void ImageManager::device_load_builtin(Device *device, Scene *scene, Progress &p
     return;
   }
 
+  downscale_to_memory_limit(scene);
+
   TaskPool pool;
   for (size_t slot = 0; slot < images.size(); slot++) {
     Image *img = images[slot];
@@ -887,8 +1086,22 @@ void ImageManager::device_free(Device *device)
 void ImageManager::collect_statistics(RenderStats *stats)
 {
   foreach (const Image *image, images) {
-    stats->image.textures.add_entry(
-        NamedSizeEntry(image->loader->name(), image->mem->memory_size()));
+    const size_t mem_size = image->mem->memory_size();
+    stats->image.textures.add_entry(NamedSizeEntry(image->loader->name(), mem_size));
+
+    const size_t full_size = scaled_image_size(image->metadata, 1.0f);
+    if (image->cache_image == NULL && full_size > mem_size &&
+        image->mem->data_width < image->metadata.width) {
+      stats->image.num_downscaled++;
+      stats->image.full_size += full_size;
+    }
+    else {
+      stats->image.full_size += mem_size;
+    }
+  }
+
+  if (texture_cache) {
+    texture_cache->collect_statistics(stats);
   }
 }
 
@@ -39,6 +39,7 @@ class Progress;
 class RenderStats;
 class Scene;
 class ColorSpaceProcessor;
+class TextureCache;
 class VDBImageLoader;
 
 /* Image Parameters */
@@ -192,6 +193,7 @@ class ImageManager {
   void device_free_builtin(Device *device);
 
   void set_osl_texture_system(void *texture_system);
+  void texture_cache_init(const size_t memory_limit);
   bool set_animation_frame_update(int frame);
 
   void collect_statistics(RenderStats *stats);
@@ -210,9 +212,15 @@ class ImageManager {
     bool need_load;
     bool builtin;
 
+    /* Maximum resolution chosen to fit the texture memory limit, 0 if not limited. */
+    int texture_limit;
+
     string mem_name;
     device_texture *mem;
 
+    /* Set when the image is sampled through the texture cache instead of loaded into memory. */
+    TextureCacheImage *cache_image;
+
     int users;
     thread_mutex mutex;
   };
@@ -229,11 +237,16 @@ class ImageManager {
   vector<Image *> images;
   void *osl_texture_system;
 
+  bool has_texture_cache;
+  TextureCache *texture_cache;
+
   int add_image_slot(ImageLoader *loader, const ImageParams &params, const bool builtin);
   void add_image_user(int slot);
   void remove_image_user(int slot);
 
   void load_image_metadata(Image *img);
+  bool use_texture_cache(Image *img);
+  void downscale_to_memory_limit(Scene *scene);
 
   template<TypeDesc::BASETYPE FileFormat, typename StorageType>
   bool file_load_image(Image *img, int texture_limit);
@@ -20,6 +20,7 @@
 #include "render/film.h"
 #include "render/graph.h"
 #include "render/integrator.h"
+#include "render/light_tree.h"
 #include "render/mesh.h"
 #include "render/nodes.h"
 #include "render/object.h"
@@ -27,6 +28,7 @@
 #include "render/shader.h"
 #include "render/stats.h"
 
+#include "util/util_algorithm.h"
 #include "util/util_foreach.h"
 #include "util/util_hash.h"
 #include "util/util_logging.h"
@@ -284,13 +286,35 @@ bool LightManager::object_usable_as_light(Object *object)
   return false;
 }
 
-void LightManager::device_update_distribution(Device *,
+/* Rough estimate of the power emitted per unit area by a shader, for the light tree. Shaders
+ * with textured or otherwise varying emission count as unit strength. */
+static float shader_emission_estimate(Shader *shader)
+{
+  float3 emission;
+  if (shader->is_constant_emission(&emission)) {
+    return max(average(emission), 0.0f);
+  }
+  return 1.0f;
+}
+
+void LightManager::device_update_distribution(Device *device,
                                               DeviceScene *dscene,
                                               Scene *scene,
                                               Progress &progress)
 {
   progress.set_status("Updating Lights", "Computing distribution");
 
+  /* The light tree replaces picking a light at random. Sampling all lights in the branched path
+   * integrator relies on the fixed probabilities of the light distribution. */
+  Integrator *integrator = scene->integrator;
+  const bool sample_all_lights = integrator->get_method() == Integrator::BRANCHED_PATH &&
+                                 device->info.has_branched_path &&
+                                 (integrator->get_sample_all_lights_direct() ||
+                                  integrator->get_sample_all_lights_indirect());
+  const bool use_light_tree = integrator->get_use_light_tree() && !sample_all_lights;
+  vector<LightTreeEmitter> triangle_emitters;
+  vector<LightTreeEmitter> lamp_emitters;
+
   /* count */
   size_t num_lights = 0;
   size_t num_portals = 0;
@@ -374,6 +398,9 @@ void LightManager::device_update_distribution(Device *,
       use_light_visibility = true;
     }
 
+    Shader *estimate_shader = NULL;
+    float estimate = 0.0f;
+
     size_t mesh_num_triangles = mesh->num_triangles();
     for (size_t i = 0; i < mesh_num_triangles; i++) {
       int shader_index = mesh->get_shader()[i];
@@ -382,6 +409,7 @@ void LightManager::device_update_distribution(Device *,
                            scene->default_surface;
 
       if (shader->get_use_mis() && shader->has_surface_emission) {
+        const int distribution_index = offset;
         distribution[offset].totarea = totarea;
         distribution[offset].prim = i + mesh->prim_offset;
         distribution[offset].mesh_light.shader_flag = shader_flag;
@@ -402,7 +430,23 @@ void LightManager::device_update_distribution(Device *,
           p3 = transform_point(&tfm, p3);
         }
 
-        totarea += triangle_area(p1, p2, p3);
+        const float area = triangle_area(p1, p2, p3);
+        totarea += area;
+
+        if (use_light_tree) {
+          if (shader != estimate_shader) {
+            estimate_shader = shader;
+            estimate = shader_emission_estimate(shader);
+          }
+
+          LightTreeEmitter emitter;
+          emitter.bounds = BoundBox(p1);
+          emitter.bounds.grow(p2);
+          emitter.bounds.grow(p3);
+          emitter.energy = area * estimate;
+          emitter.distribution_index = distribution_index;
+          triangle_emitters.push_back(emitter);
+        }
       }
     }
 
@@ -426,6 +470,22 @@ void LightManager::device_update_distribution(Device *,
     distribution[offset].lamp.size = light->size;
     totarea += lightarea;
 
+    if (use_light_tree && light->light_type != LIGHT_DISTANT &&
+        light->light_type != LIGHT_BACKGROUND) {
+      /* Distant and background lights have no position, they keep being picked uniformly. */
+      float3 extent = make_float3(light->size, light->size, light->size);
+      if (light->light_type == LIGHT_AREA) {
+        extent = 0.5f * (fabs(light->axisu * (light->sizeu * light->size)) +
+                         fabs(light->axisv * (light->sizev * light->size)));
+      }
+
+      LightTreeEmitter emitter;
+      emitter.bounds = BoundBox(light->co - extent, light->co + extent);
+      emitter.energy = max(average(light->strength), 0.0f);
+      emitter.distribution_index = offset;
+      lamp_emitters.push_back(emitter);
+    }
+
     if (light->light_type == LIGHT_DISTANT) {
       use_lamp_mis |= (light->angle > 0.0f && light->use_mis);
     }
@@ -490,6 +550,40 @@ void LightManager::device_update_distribution(Device *,
 
     kintegrator->use_lamp_mis = use_lamp_mis;
 
+    /* Light tree */
+    if (use_light_tree && (!triangle_emitters.empty() || !lamp_emitters.empty())) {
+      vector<KernelLightTreeNode> nodes;
+      uint *leaf_nodes = dscene->light_tree_leaf.alloc(num_distribution);
+      std::fill(leaf_nodes, leaf_nodes + num_distribution, ~0u);
+
+      const int num_local_lights = lamp_emitters.size();
+      const int triangle_root = LightTree::build(triangle_emitters, nodes, leaf_nodes);
+      const int lamp_root = LightTree::build(lamp_emitters, nodes, leaf_nodes);
+
+      KernelLightTreeNode *knodes = dscene->light_tree_nodes.alloc(nodes.size());
+      std::copy(nodes.begin(), nodes.end(), knodes);
+
+      kintegrator->use_light_tree = true;
+      kintegrator->light_tree_triangle_root = triangle_root;
+      kintegrator->light_tree_lamp_root = lamp_root;
+      kintegrator->light_tree_num_local_lights = num_local_lights;
+      kintegrator->light_tree_triangle_area = trianglearea;
+
+      dscene->light_tree_nodes.copy_to_device();
+      dscene->light_tree_leaf.copy_to_device();
+
+      VLOG(1) << "Light tree with " << nodes.size() << " nodes over "
+              << triangle_emitters.size() << " triangles and " << num_local_lights
+              << " lights.";
+    }
+    else {
+      kintegrator->use_light_tree = false;
+      kintegrator->light_tree_triangle_root = -1;
+      kintegrator->light_tree_lamp_root = -1;
+      kintegrator->light_tree_num_local_lights = 0;
+      kintegrator->light_tree_triangle_area = 0.0f;
+    }
+
     /* bit of an ugly hack to compensate for emitting triangles influencing
      * amount of samples we get for this pass */
     kfilm->pass_shadow_scale = 1.0f;
@@ -526,6 +620,7 @@ void LightManager::device_update_distribution(Device *,
     kintegrator->pdf_triangles = 0.0f;
     kintegrator->pdf_lights = 0.0f;
     kintegrator->use_lamp_mis = false;
+    kintegrator->use_light_tree = false;
 
     kbackground->num_portals = 0;
     kbackground->portal_offset = 0;
@@ -1027,6 +1122,8 @@ void LightManager::device_free(Device *, DeviceScene *dscene, const bool free_ba
 {
   dscene->light_distribution.free();
   dscene->lights.free();
+  dscene->light_tree_nodes.free();
+  dscene->light_tree_leaf.free();
   if (free_background) {
     dscene->light_background_marginal_cdf.free();
     dscene->light_background_conditional_cdf.free();
@@ -0,0 +1,93 @@
+/*
+ * Copyright 2011-2021 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "render/light_tree.h"
+
+#include "util/util_algorithm.h"
+
+CCL_NAMESPACE_BEGIN
+
+int LightTree::build(vector<LightTreeEmitter> &emitters,
+                     vector<KernelLightTreeNode> &nodes,
+                     uint *leaf_nodes)
+{
+  if (emitters.empty()) {
+    return -1;
+  }
+
+  nodes.reserve(nodes.size() + 2 * emitters.size() - 1);
+  return build_recursive(&emitters[0], emitters.size(), -1, nodes, leaf_nodes);
+}
+
+int LightTree::build_recursive(LightTreeEmitter *emitters,
+                               int num_emitters,
+                               int parent,
+                               vector<KernelLightTreeNode> &nodes,
+                               uint *leaf_nodes)
+{
+  BoundBox bounds = BoundBox::empty;
+  BoundBox centroid_bounds = BoundBox::empty;
+  float energy = 0.0f;
+
+  for (int i = 0; i < num_emitters; i++) {
+    bounds.grow(emitters[i].bounds);
+    centroid_bounds.grow(emitters[i].bounds.center());
+    energy += emitters[i].energy;
+  }
+
+  const int index = nodes.size();
+  nodes.resize(index + 1);
+
+  KernelLightTreeNode &knode = nodes[index];
+  knode.bounds_min[0] = bounds.min.x;
+  knode.bounds_min[1] = bounds.min.y;
+  knode.bounds_min[2] = bounds.min.z;
+  knode.bounds_max[0] = bounds.max.x;
+  knode.bounds_max[1] = bounds.max.y;
+  knode.bounds_max[2] = bounds.max.z;
+  knode.energy = energy;
+  knode.parent = parent;
+  knode.pad1 = knode.pad2 = knode.pad3 = 0;
+
+  if (num_emitters == 1) {
+    knode.child = ~emitters[0].distribution_index;
+    leaf_nodes[emitters[0].distribution_index] = index;
+    return index;
+  }
+
+  /* Split at the median centroid along the largest axis. */
+  const float3 size = centroid_bounds.size();
+  const int axis = (size.x >= size.y && size.x >= size.z) ? 0 : (size.y >= size.z) ? 1 : 2;
+  const int mid = num_emitters / 2;
+
+  std::nth_element(emitters,
+                   emitters + mid,
+                   emitters + num_emitters,
+                   [axis](const LightTreeEmitter &a, const LightTreeEmitter &b) {
+                     return a.bounds.center()[axis] < b.bounds.center()[axis];
+                   });
+
+  /* The first child directly follows this node. Note that the reference to
+   * this node is not valid anymore after adding children. */
+  build_recursive(emitters, mid, index, nodes, leaf_nodes);
+  const int second_child = build_recursive(
+      emitters + mid, num_emitters - mid, index, nodes, leaf_nodes);
+  nodes[index].child = second_child;
+
+  return index;
+}
+
+CCL_NAMESPACE_END
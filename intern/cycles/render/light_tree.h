@@ -0,0 +1,63 @@
+/*
+ * Copyright 2011-2021 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __LIGHT_TREE_H__
+#define __LIGHT_TREE_H__
+
+#include "kernel/kernel_types.h"
+
+#include "util/util_boundbox.h"
+#include "util/util_types.h"
+#include "util/util_vector.h"
+
+CCL_NAMESPACE_BEGIN
+
+/* Light Tree Emitter
+ *
+ * A triangle or lamp in the light distribution, with the bounds and energy the
+ * kernel uses to estimate its contribution to a shading point. */
+struct LightTreeEmitter {
+  BoundBox bounds;
+  float energy;
+  int distribution_index;
+};
+
+/* Light Tree
+ *
+ * Binary tree over emitters, built by splitting at the median centroid along
+ * the largest axis. Every leaf holds a single emitter, so the kernel can pick a
+ * light by descending the tree and compute the probability of any light by
+ * walking from its leaf back up to the root. */
+class LightTree {
+ public:
+  /* Build a tree over the emitters, which are reordered in the process. Nodes
+   * are appended to the given array and the node of every emitter is written
+   * to leaf_nodes at its distribution index. Returns the root node index. */
+  static int build(vector<LightTreeEmitter> &emitters,
+                   vector<KernelLightTreeNode> &nodes,
+                   uint *leaf_nodes);
+
+ protected:
+  static int build_recursive(LightTreeEmitter *emitters,
+                             int num_emitters,
+                             int parent,
+                             vector<KernelLightTreeNode> &nodes,
+                             uint *leaf_nodes);
+};
+
+CCL_NAMESPACE_END
+
+#endif /* __LIGHT_TREE_H__ */
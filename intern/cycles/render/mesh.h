@@ -46,6 +46,7 @@ class Scene;
 class SceneParams;
 class AttributeRequest;
 struct SubdParams;
+struct DiceCache;
 class DiagSplit;
 struct PackedPatchTable;
 
@@ -193,6 +194,7 @@ class Mesh : public Geometry {
   friend class ObjectManager;
 
   SubdParams *subd_params = nullptr;
+  DiceCache *dice_cache = nullptr;
 
  public:
   /* Functions */
@@ -42,6 +42,15 @@ CCL_NAMESPACE_BEGIN
 
 /* Global state of object transform update. */
 
+/* Object data that only depends on the geometry, computed once for all objects that instance
+ * the same geometry. */
+struct UpdateObjectGeometryInfo {
+  uint flag;
+  int numkeys;
+  int numverts;
+  int numsteps;
+};
+
 struct UpdateObjectTransformState {
   /* Global state used by device_update_object_transform().
    * Common for both threaded and non-threaded update.
@@ -58,12 +67,16 @@ struct UpdateObjectTransformState {
   /* Motion offsets for each object. */
   array<uint> motion_offset;
 
+  /* Geometry data, indexed by the index of the geometry in the scene. */
+  vector<UpdateObjectGeometryInfo> geometry_info;
+
   /* Packed object arrays. Those will be filled in. */
   uint *object_flag;
   KernelObject *objects;
   Transform *object_motion_pass;
   DecomposedTransform *object_motion;
   float *object_volume_step;
+  KernelVolumeOccupancy *object_volume_occupancy;
 
   /* Flags which will be synchronized to Integrator. */
   bool have_motion;
@@ -369,6 +382,39 @@ float Object::compute_volume_step_size() const
   return step_size;
 }
 
+KernelVolumeOccupancy Object::compute_volume_occupancy() const
+{
+  KernelVolumeOccupancy kocc;
+  kocc.offset = -1;
+
+  /* Motion blurred objects are looked up with an interpolated transform. */
+  if (geometry->geometry_type != Geometry::VOLUME || use_motion()) {
+    return kocc;
+  }
+
+  const Volume *volume = static_cast<const Volume *>(geometry);
+  if (volume->occupancy.empty()) {
+    return kocc;
+  }
+
+  /* Same as when building the grid, density from spatially varying nodes can be non-zero
+   * outside of the voxels. The grid may also be from before a shader change. */
+  foreach (Node *node, volume->get_used_shaders()) {
+    const Shader *shader = static_cast<const Shader *>(node);
+    if (shader->has_volume && shader->has_volume_spatial_varying) {
+      return kocc;
+    }
+  }
+
+  kocc.object_to_cell = volume->occupancy.object_to_cell;
+  kocc.offset = volume->occupancy_offset;
+  kocc.res_x = volume->occupancy.resolution.x;
+  kocc.res_y = volume->occupancy.resolution.y;
+  kocc.res_z = volume->occupancy.resolution.z;
+
+  return kocc;
+}
+
 int Object::get_device_index() const
 {
   return index;
@@ -407,7 +453,8 @@ void ObjectManager::device_update_object_transform(UpdateObjectTransformState *s
   Transform *object_motion_pass = state->object_motion_pass;
 
   Geometry *geom = ob->geometry;
-  uint flag = 0;
+  const UpdateObjectGeometryInfo &geom_info = state->geometry_info[geom->index];
+  uint flag = geom_info.flag;
 
   /* Compute transformations. */
   Transform tfm = ob->tfm;
@@ -436,14 +483,6 @@ void ObjectManager::device_update_object_transform(UpdateObjectTransformState *s
     state->have_motion = true;
   }
 
-  if (geom->geometry_type == Geometry::MESH) {
-    /* TODO: why only mesh? */
-    Mesh *mesh = static_cast<Mesh *>(geom);
-    if (mesh->attributes.find(ATTR_STD_MOTION_VERTEX_POSITION)) {
-      flag |= SD_OBJECT_HAS_VERTEX_MOTION;
-    }
-  }
-
   if (state->need_motion == Scene::MOTION_PASS) {
     /* Clear motion array if there is no actual motion. */
     ob->update_motion();
@@ -490,17 +529,11 @@ void ObjectManager::device_update_object_transform(UpdateObjectTransformState *s
   kobject.dupli_generated[0] = ob->dupli_generated[0];
   kobject.dupli_generated[1] = ob->dupli_generated[1];
   kobject.dupli_generated[2] = ob->dupli_generated[2];
-  kobject.numkeys = (geom->geometry_type == Geometry::HAIR) ?
-                        static_cast<Hair *>(geom)->get_curve_keys().size() :
-                        0;
+  kobject.numkeys = geom_info.numkeys;
   kobject.dupli_uv[0] = ob->dupli_uv[0];
   kobject.dupli_uv[1] = ob->dupli_uv[1];
-  int totalsteps = geom->get_motion_steps();
-  kobject.numsteps = (totalsteps - 1) / 2;
-  kobject.numverts = (geom->geometry_type == Geometry::MESH ||
-                      geom->geometry_type == Geometry::VOLUME) ?
-                         static_cast<Mesh *>(geom)->get_verts().size() :
-                         0;
+  kobject.numsteps = geom_info.numsteps;
+  kobject.numverts = geom_info.numverts;
   kobject.patch_map_offset = 0;
   kobject.attribute_map_offset = 0;
 
@@ -521,6 +554,7 @@ void ObjectManager::device_update_object_transform(UpdateObjectTransformState *s
   }
   state->object_flag[ob->index] = flag;
   state->object_volume_step[ob->index] = FLT_MAX;
+  state->object_volume_occupancy[ob->index].offset = -1;
 
   /* Have curves. */
   if (geom->geometry_type == Geometry::HAIR) {
@@ -540,6 +574,7 @@ void ObjectManager::device_update_transforms(DeviceScene *dscene, Scene *scene,
   state.objects = dscene->objects.alloc(scene->objects.size());
   state.object_flag = dscene->object_flag.alloc(scene->objects.size());
   state.object_volume_step = dscene->object_volume_step.alloc(scene->objects.size());
+  state.object_volume_occupancy = dscene->object_volume_occupancy.alloc(scene->objects.size());
   state.object_motion = NULL;
   state.object_motion_pass = NULL;
 
@@ -564,6 +599,31 @@ void ObjectManager::device_update_transforms(DeviceScene *dscene, Scene *scene,
     state.object_motion = dscene->object_motion.alloc(motion_offset);
   }
 
+  /* Data shared by all instances of a geometry. */
+  state.geometry_info.resize(scene->geometry.size());
+  parallel_for(size_t(0), scene->geometry.size(), [&](size_t i) {
+    Geometry *geom = scene->geometry[i];
+    UpdateObjectGeometryInfo &info = state.geometry_info[i];
+    geom->index = i;
+
+    info.flag = 0;
+    if (geom->geometry_type == Geometry::MESH) {
+      /* TODO: why only mesh? */
+      if (geom->attributes.find(ATTR_STD_MOTION_VERTEX_POSITION)) {
+        info.flag |= SD_OBJECT_HAS_VERTEX_MOTION;
+      }
+    }
+
+    info.numkeys = (geom->geometry_type == Geometry::HAIR) ?
+                       static_cast<Hair *>(geom)->get_curve_keys().size() :
+                       0;
+    info.numsteps = (geom->get_motion_steps() - 1) / 2;
+    info.numverts = (geom->geometry_type == Geometry::MESH ||
+                     geom->geometry_type == Geometry::VOLUME) ?
+                        static_cast<Mesh *>(geom)->get_verts().size() :
+                        0;
+  });
+
   /* Particle system device offsets
    * 0 is dummy particle, index starts at 1.
    */
@@ -621,6 +681,7 @@ void ObjectManager::device_update(Device *device,
     dscene->object_motion.tag_realloc();
     dscene->object_flag.tag_realloc();
     dscene->object_volume_step.tag_realloc();
+    dscene->object_volume_occupancy.tag_realloc();
   }
 
   if (update_flags & HOLDOUT_MODIFIED) {
@@ -658,6 +719,7 @@ void ObjectManager::device_update(Device *device,
         dscene->object_motion.tag_modified();
         dscene->object_flag.tag_modified();
         dscene->object_volume_step.tag_modified();
+        dscene->object_volume_occupancy.tag_modified();
       }
     }
   }
@@ -697,6 +759,62 @@ void ObjectManager::device_update(Device *device,
   }
 }
 
+void ObjectManager::device_update_object_flags(Object *object,
+                                               const vector<Object *> &volume_objects,
+                                               const bool has_volume_objects,
+                                               const bool bounds_valid,
+                                               uint *object_flag,
+                                               float *object_volume_step,
+                                               KernelVolumeOccupancy *object_volume_occupancy)
+{
+  uint &flag = object_flag[object->index];
+
+  if (object->geometry->has_volume) {
+    object_volume_step[object->index] = object->compute_volume_step_size();
+    object_volume_occupancy[object->index] = object->compute_volume_occupancy();
+
+    flag |= SD_OBJECT_HAS_VOLUME;
+    flag &= ~SD_OBJECT_HAS_VOLUME_ATTRIBUTES;
+
+    foreach (Attribute &attr, object->geometry->attributes.attributes) {
+      if (attr.element == ATTR_ELEMENT_VOXEL) {
+        flag |= SD_OBJECT_HAS_VOLUME_ATTRIBUTES;
+      }
+    }
+  }
+  else {
+    object_volume_step[object->index] = FLT_MAX;
+    object_volume_occupancy[object->index].offset = -1;
+
+    flag &= ~(SD_OBJECT_HAS_VOLUME | SD_OBJECT_HAS_VOLUME_ATTRIBUTES);
+  }
+
+  if (object->is_shadow_catcher) {
+    flag |= SD_OBJECT_SHADOW_CATCHER;
+  }
+  else {
+    flag &= ~SD_OBJECT_SHADOW_CATCHER;
+  }
+
+  if (bounds_valid) {
+    foreach (Object *volume_object, volume_objects) {
+      if (object == volume_object) {
+        continue;
+      }
+      if (object->bounds.intersects(volume_object->bounds)) {
+        flag |= SD_OBJECT_INTERSECTS_VOLUME;
+        break;
+      }
+    }
+  }
+  else if (has_volume_objects) {
+    /* Not really valid, but can't make more reliable in the case
+     * of bounds not being up to date.
+     */
+    flag |= SD_OBJECT_INTERSECTS_VOLUME;
+  }
+}
+
 void ObjectManager::device_update_flags(
     Device *, DeviceScene *dscene, Scene *scene, Progress & /*progress*/, bool bounds_valid)
 {
@@ -718,6 +836,7 @@ void ObjectManager::device_update_flags(
   /* Object info flag. */
   uint *object_flag = dscene->object_flag.data();
   float *object_volume_step = dscene->object_volume_step.data();
+  KernelVolumeOccupancy *object_volume_occupancy = dscene->object_volume_occupancy.data();
 
   /* Object volume intersection. */
   vector<Object *> volume_objects;
@@ -728,60 +847,33 @@ void ObjectManager::device_update_flags(
         volume_objects.push_back(object);
       }
       has_volume_objects = true;
-      object_volume_step[object->index] = object->compute_volume_step_size();
-    }
-    else {
-      object_volume_step[object->index] = FLT_MAX;
     }
   }
 
-  foreach (Object *object, scene->objects) {
-    if (object->geometry->has_volume) {
-      object_flag[object->index] |= SD_OBJECT_HAS_VOLUME;
-      object_flag[object->index] &= ~SD_OBJECT_HAS_VOLUME_ATTRIBUTES;
-
-      foreach (Attribute &attr, object->geometry->attributes.attributes) {
-        if (attr.element == ATTR_ELEMENT_VOXEL) {
-          object_flag[object->index] |= SD_OBJECT_HAS_VOLUME_ATTRIBUTES;
-        }
-      }
-    }
-    else {
-      object_flag[object->index] &= ~(SD_OBJECT_HAS_VOLUME | SD_OBJECT_HAS_VOLUME_ATTRIBUTES);
-    }
-
-    if (object->is_shadow_catcher) {
-      object_flag[object->index] |= SD_OBJECT_SHADOW_CATCHER;
-    }
-    else {
-      object_flag[object->index] &= ~SD_OBJECT_SHADOW_CATCHER;
-    }
-
-    if (bounds_valid) {
-      foreach (Object *volume_object, volume_objects) {
-        if (object == volume_object) {
-          continue;
-        }
-        if (object->bounds.intersects(volume_object->bounds)) {
-          object_flag[object->index] |= SD_OBJECT_INTERSECTS_VOLUME;
-          break;
-        }
-      }
-    }
-    else if (has_volume_objects) {
-      /* Not really valid, but can't make more reliable in the case
-       * of bounds not being up to date.
-       */
-      object_flag[object->index] |= SD_OBJECT_INTERSECTS_VOLUME;
-    }
-  }
+  /* Objects only write their own flags, so they can be updated in parallel. */
+  static const int OBJECTS_PER_TASK = 256;
+  parallel_for(blocked_range<size_t>(0, scene->objects.size(), OBJECTS_PER_TASK),
+               [&](const blocked_range<size_t> &r) {
+                 for (size_t i = r.begin(); i != r.end(); i++) {
+                   Object *object = scene->objects[i];
+                   device_update_object_flags(object,
+                                              volume_objects,
+                                              has_volume_objects,
+                                              bounds_valid,
+                                              object_flag,
+                                              object_volume_step,
+                                              object_volume_occupancy);
+                 }
+               });
 
   /* Copy object flag. */
   dscene->object_flag.copy_to_device();
   dscene->object_volume_step.copy_to_device();
+  dscene->object_volume_occupancy.copy_to_device();
 
   dscene->object_flag.clear_modified();
   dscene->object_volume_step.clear_modified();
+  dscene->object_volume_occupancy.clear_modified();
 }
 
 void ObjectManager::device_update_mesh_offsets(Device *, DeviceScene *dscene, Scene *scene)
@@ -836,6 +928,7 @@ void ObjectManager::device_free(Device *, DeviceScene *dscene, bool force_free)
   dscene->object_motion.free_if_need_realloc(force_free);
   dscene->object_flag.free_if_need_realloc(force_free);
   dscene->object_volume_step.free_if_need_realloc(force_free);
+  dscene->object_volume_occupancy.free_if_need_realloc(force_free);
 }
 
 void ObjectManager::apply_static_transforms(DeviceScene *dscene, Scene *scene, Progress &progress)
@@ -108,6 +108,7 @@ class Object : public Node {
 
   /* Compute step size from attributes, shaders, transforms. */
   float compute_volume_step_size() const;
+  KernelVolumeOccupancy compute_volume_occupancy() const;
 
  protected:
   /* Specifies the position of the object in scene->objects and
@@ -176,6 +177,13 @@ class ObjectManager {
                                       Object *ob,
                                       bool update_all);
   void device_update_object_transform_task(UpdateObjectTransformState *state);
+  void device_update_object_flags(Object *object,
+                                  const vector<Object *> &volume_objects,
+                                  const bool has_volume_objects,
+                                  const bool bounds_valid,
+                                  uint *object_flag,
+                                  float *object_volume_step,
+                                  KernelVolumeOccupancy *object_volume_occupancy);
   bool device_update_object_transform_pop_work(UpdateObjectTransformState *state,
                                                int *start_index,
                                                int *num_objects);
@@ -76,6 +76,13 @@ void ProceduralManager::update(Scene *scene, Progress &progress)
   need_update_ = false;
 }
 
+void ProceduralManager::collect_statistics(Scene *scene, RenderStats *stats)
+{
+  foreach (Procedural *procedural, scene->procedurals) {
+    procedural->collect_statistics(stats);
+  }
+}
+
 void ProceduralManager::tag_update()
 {
   need_update_ = true;
@@ -21,6 +21,7 @@
 CCL_NAMESPACE_BEGIN
 
 class Progress;
+class RenderStats;
 class Scene;
 
 /* A Procedural is a Node which can create other Nodes before rendering starts.
@@ -40,6 +41,11 @@ class Procedural : public Node, public NodeOwner {
    * point for the data generated by this Procedural. */
   virtual void generate(Scene *scene, Progress &progress) = 0;
 
+  /* Add statistics about the generated data to the render statistics. */
+  virtual void collect_statistics(RenderStats * /*stats*/)
+  {
+  }
+
   /* Create a node and set this Procedural as the owner. */
   template<typename T> T *create_node()
   {
@@ -65,6 +71,8 @@ class ProceduralManager {
 
   void update(Scene *scene, Progress &progress);
 
+  void collect_statistics(Scene *scene, RenderStats *stats);
+
   void tag_update();
 
   bool need_update() const;
@@ -51,6 +51,8 @@ DeviceScene::DeviceScene(Device *device)
       object_node(device, "__object_node", MEM_GLOBAL),
       prim_tri_index(device, "__prim_tri_index", MEM_GLOBAL),
       prim_tri_verts(device, "__prim_tri_verts", MEM_GLOBAL),
+      prim_curve_keys(device, "__prim_curve_keys", MEM_GLOBAL),
+      prim_curve_index(device, "__prim_curve_index", MEM_GLOBAL),
       prim_type(device, "__prim_type", MEM_GLOBAL),
       prim_visibility(device, "__prim_visibility", MEM_GLOBAL),
       prim_index(device, "__prim_index", MEM_GLOBAL),
@@ -61,22 +63,31 @@ DeviceScene::DeviceScene(Device *device)
       tri_vindex(device, "__tri_vindex", MEM_GLOBAL),
       tri_patch(device, "__tri_patch", MEM_GLOBAL),
       tri_patch_uv(device, "__tri_patch_uv", MEM_GLOBAL),
+      tri_vnormal_oct(device, "__tri_vnormal_oct", MEM_GLOBAL),
+      tri_vindex_compact(device, "__tri_vindex_compact", MEM_GLOBAL),
+      tri_vindex_verts(device, "__tri_vindex_verts", MEM_GLOBAL),
+      tri_vindex_overflow(device, "__tri_vindex_overflow", MEM_GLOBAL),
       curves(device, "__curves", MEM_GLOBAL),
       curve_keys(device, "__curve_keys", MEM_GLOBAL),
       patches(device, "__patches", MEM_GLOBAL),
+      volume_occupancy(device, "__volume_occupancy", MEM_GLOBAL),
       objects(device, "__objects", MEM_GLOBAL),
       object_motion_pass(device, "__object_motion_pass", MEM_GLOBAL),
       object_motion(device, "__object_motion", MEM_GLOBAL),
       object_flag(device, "__object_flag", MEM_GLOBAL),
       object_volume_step(device, "__object_volume_step", MEM_GLOBAL),
+      object_volume_occupancy(device, "__object_volume_occupancy", MEM_GLOBAL),
       camera_motion(device, "__camera_motion", MEM_GLOBAL),
       attributes_map(device, "__attributes_map", MEM_GLOBAL),
       attributes_float(device, "__attributes_float", MEM_GLOBAL),
       attributes_float2(device, "__attributes_float2", MEM_GLOBAL),
+      attributes_half2(device, "__attributes_half2", MEM_GLOBAL),
       attributes_float3(device, "__attributes_float3", MEM_GLOBAL),
       attributes_uchar4(device, "__attributes_uchar4", MEM_GLOBAL),
       light_distribution(device, "__light_distribution", MEM_GLOBAL),
       lights(device, "__lights", MEM_GLOBAL),
+      light_tree_nodes(device, "__light_tree_nodes", MEM_GLOBAL),
+      light_tree_leaf(device, "__light_tree_leaf", MEM_GLOBAL),
       light_background_marginal_cdf(device, "__light_background_marginal_cdf", MEM_GLOBAL),
       light_background_conditional_cdf(device, "__light_background_conditional_cdf", MEM_GLOBAL),
       particles(device, "__particles", MEM_GLOBAL),
@@ -84,7 +95,8 @@ DeviceScene::DeviceScene(Device *device)
       shaders(device, "__shaders", MEM_GLOBAL),
       lookup_table(device, "__lookup_table", MEM_GLOBAL),
       sample_pattern_lut(device, "__sample_pattern_lut", MEM_GLOBAL),
-      ies_lights(device, "__ies", MEM_GLOBAL)
+      ies_lights(device, "__ies", MEM_GLOBAL),
+      bake_rows(device, "__bake_rows", MEM_GLOBAL)
 {
   memset((void *)&data, 0, sizeof(data));
 }
@@ -117,6 +129,10 @@ Scene::Scene(const SceneParams &params_, Device *device)
   geometry_manager = new GeometryManager();
   object_manager = new ObjectManager();
   image_manager = new ImageManager(device->info);
+  /* With OSL, file images are sampled through the OSL texture system instead. */
+  if (!shader_manager->use_osl()) {
+    image_manager->texture_cache_init(params.texture_cache_size);
+  }
   particle_system_manager = new ParticleSystemManager();
   bake_manager = new BakeManager();
   procedural_manager = new ProceduralManager();
@@ -460,6 +476,7 @@ void Scene::collect_statistics(RenderStats *stats)
 {
   geometry_manager->collect_statistics(this, stats);
   image_manager->collect_statistics(stats);
+  procedural_manager->collect_statistics(this, stats);
 }
 
 void Scene::enable_update_stats()
@@ -76,6 +76,8 @@ class DeviceScene {
   device_vector<int> object_node;
   device_vector<uint> prim_tri_index;
   device_vector<float4> prim_tri_verts;
+  device_vector<float4> prim_curve_keys;
+  device_vector<uint> prim_curve_index;
   device_vector<int> prim_type;
   device_vector<uint> prim_visibility;
   device_vector<int> prim_index;
@@ -89,17 +91,27 @@ class DeviceScene {
   device_vector<uint> tri_patch;
   device_vector<float2> tri_patch_uv;
 
+  /* mesh, compact geometry storage */
+  device_vector<uint> tri_vnormal_oct;
+  device_vector<uint2> tri_vindex_compact;
+  device_vector<uint> tri_vindex_verts;
+  device_vector<uint2> tri_vindex_overflow;
+
   device_vector<float4> curves;
   device_vector<float4> curve_keys;
 
   device_vector<uint> patches;
 
+  /* volumes */
+  device_vector<uint> volume_occupancy;
+
   /* objects */
   device_vector<KernelObject> objects;
   device_vector<Transform> object_motion_pass;
   device_vector<DecomposedTransform> object_motion;
   device_vector<uint> object_flag;
   device_vector<float> object_volume_step;
+  device_vector<KernelVolumeOccupancy> object_volume_occupancy;
 
   /* cameras */
   device_vector<DecomposedTransform> camera_motion;
@@ -108,12 +120,15 @@ class DeviceScene {
   device_vector<uint4> attributes_map;
   device_vector<float> attributes_float;
   device_vector<float2> attributes_float2;
+  device_vector<uint> attributes_half2;
   device_vector<float4> attributes_float3;
   device_vector<uchar4> attributes_uchar4;
 
   /* lights */
   device_vector<KernelLightDistribution> light_distribution;
   device_vector<KernelLight> lights;
+  device_vector<KernelLightTreeNode> light_tree_nodes;
+  device_vector<uint> light_tree_leaf;
   device_vector<float2> light_background_marginal_cdf;
   device_vector<float2> light_background_conditional_cdf;
 
@@ -133,6 +148,9 @@ class DeviceScene {
   /* ies lights */
   device_vector<float> ies_lights;
 
+  /* bake */
+  device_vector<uint2> bake_rows;
+
   KernelData data;
 
   DeviceScene(Device *device);
@@ -175,10 +193,24 @@ class SceneParams {
   BVHType bvh_type;
   bool use_bvh_spatial_split;
   bool use_bvh_unaligned_nodes;
+  /* Store the control points of static curve segments with a bounding sphere in BVH2 leaves,
+   * so traversal can cull up to four segments of a leaf at once before intersecting them. Costs
+   * five float4 per segment. */
+  bool use_bvh_curve_leaf_keys;
   int num_bvh_time_steps;
   int hair_subdivisions;
   CurveShapeType hair_shape;
   int texture_limit;
+  /* Upper bound in bytes for the memory used by image textures, 0 when unlimited. Images are
+   * downscaled in power of two steps, largest first, until they fit. The reduced resolution is
+   * chosen at load time and kept for the whole render, textures are not streamed in on demand. */
+  size_t texture_downscale_limit;
+  /* Memory budget in bytes of the texture cache, 0 to load images fully into memory. File
+   * images are then sampled through the cache on the CPU with SVM, other devices ignore it. */
+  size_t texture_cache_size;
+  /* Store vertex normals, float2 attributes and triangle indices in a reduced precision
+   * encoding to lower geometry memory usage. */
+  bool compact_geometry;
 
   bool background;
 
@@ -189,10 +221,14 @@ class SceneParams {
     bvh_type = BVH_DYNAMIC;
     use_bvh_spatial_split = false;
     use_bvh_unaligned_nodes = true;
+    use_bvh_curve_leaf_keys = false;
     num_bvh_time_steps = 0;
     hair_subdivisions = 3;
     hair_shape = CURVE_RIBBON;
     texture_limit = 0;
+    texture_downscale_limit = 0;
+    texture_cache_size = 0;
+    compact_geometry = false;
     background = true;
   }
 
@@ -202,9 +238,13 @@ class SceneParams {
              bvh_type == params.bvh_type &&
              use_bvh_spatial_split == params.use_bvh_spatial_split &&
              use_bvh_unaligned_nodes == params.use_bvh_unaligned_nodes &&
+             use_bvh_curve_leaf_keys == params.use_bvh_curve_leaf_keys &&
              num_bvh_time_steps == params.num_bvh_time_steps &&
              hair_subdivisions == params.hair_subdivisions && hair_shape == params.hair_shape &&
-             texture_limit == params.texture_limit);
+             texture_limit == params.texture_limit &&
+             texture_downscale_limit == params.texture_downscale_limit &&
+             texture_cache_size == params.texture_cache_size &&
+             compact_geometry == params.compact_geometry);
   }
 
   int curve_subdivisions()
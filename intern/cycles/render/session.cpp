@@ -61,11 +61,14 @@ Session::Session(const SessionParams &params_)
 
   TaskScheduler::init(params.threads);
 
+  tile_manager.split_num_workers = TaskScheduler::num_threads();
+
   session_thread_ = NULL;
   scene = NULL;
 
   reset_time_ = 0.0;
   last_update_time_ = 0.0;
+  render_start_time_ = 0.0;
 
   delayed_reset_.do_reset = false;
   delayed_reset_.samples = 0;
@@ -273,6 +276,8 @@ void Session::run_gpu()
 
       device->task_wait();
 
+      update_tile_stats();
+
       if (!device->error_message().empty())
         progress.set_cancel(device->error_message());
 
@@ -433,6 +438,11 @@ bool Session::acquire_tile(RenderTile &rtile, Device *tile_device, uint tile_typ
       continue;
     }
 
+    if (tile_types & RenderTile::PATH_TRACE) {
+      /* This thread is done for the pass, it idles until the remaining tiles are finished. */
+      tile_idle_start_times_.push_back(time_dt());
+    }
+
     return false;
   }
 
@@ -687,6 +697,46 @@ void Session::unmap_neighbor_tiles(RenderTileNeighbors &neighbors, Device *tile_
   device->unmap_neighbor_tiles(tile_device, neighbors);
 }
 
+void Session::update_tile_stats()
+{
+  if (render_start_time_ == 0.0) {
+    return;
+  }
+
+  /* Every thread which took part in the pass reported when it ran out of tiles, the time from
+   * there to the end of the pass is the tail idle time. */
+  const double end_time = time_dt();
+  double idle_time = 0.0;
+  foreach (double idle_start_time, tile_idle_start_times_) {
+    idle_time += end_time - idle_start_time;
+  }
+
+  tile_stats_.num_tiles += tile_manager.state.num_tiles;
+  tile_stats_.num_split_tiles += tile_manager.state.num_split_tiles;
+  tile_stats_.tail_idle_time += idle_time;
+  tile_stats_.thread_time += (end_time - render_start_time_) * tile_idle_start_times_.size();
+
+  if (read_bake_tile_cb) {
+    /* Count the pixels of batch jobs without the padding at the end of their last row. */
+    const vector<BakeJob> &jobs = scene->bake_manager->get_jobs();
+    uint64_t num_pixels = (uint64_t)tile_manager.params.width * tile_manager.params.height;
+    if (!jobs.empty()) {
+      num_pixels = 0;
+      foreach (const BakeJob &job, jobs) {
+        num_pixels += job.num_pixels;
+      }
+    }
+    bake_stats_.num_pixels += num_pixels;
+    bake_stats_.time += end_time - render_start_time_;
+  }
+
+  VLOG(2) << "Pass tail idle time " << idle_time << "s over " << tile_idle_start_times_.size()
+          << " threads, " << tile_manager.state.num_split_tiles << " tiles split.";
+
+  render_start_time_ = 0.0;
+  tile_idle_start_times_.clear();
+}
+
 void Session::run_cpu()
 {
   bool tiles_written = false;
@@ -746,6 +796,10 @@ void Session::run_cpu()
 
     device->task_wait();
 
+    if (!no_tiles) {
+      update_tile_stats();
+    }
+
     {
       thread_scoped_lock reset_lock(delayed_reset_.mutex);
       thread_scoped_lock buffers_lock(buffers_mutex_);
@@ -1135,6 +1189,13 @@ void Session::render(bool need_denoise)
     return; /* Avoid empty launches. */
   }
 
+  render_start_time_ = time_dt();
+  tile_idle_start_times_.clear();
+  /* Split tiles only for CPU threads. GPUs need large tiles to be fully used, and the devices of
+   * a multi device would end up with tail tiles too small for them. */
+  tile_manager.split_tiles = params.adaptive_tiles && params.device.type == DEVICE_CPU &&
+                             !read_bake_tile_cb;
+
   /* Add path trace task. */
   DeviceTask task(DeviceTask::RENDER);
 
@@ -1152,6 +1213,11 @@ void Session::render(bool need_denoise)
   task.adaptive_sampling.use = (scene->integrator->get_sampling_pattern() ==
                                 SAMPLING_PATTERN_PMJ) &&
                                scene->dscene.data.film.pass_adaptive_aux_buffer;
+  /* The estimate models the NLM filter, the denoising data pass is also written for stored passes
+   * and the other denoisers so it does not tell which one will run. */
+  task.adaptive_sampling.use_denoising_estimate =
+      scene->integrator->get_adaptive_denoising_estimate() && params.denoising.use &&
+      params.denoising.type == DENOISER_NLM && scene->dscene.data.film.pass_denoising_data;
   task.adaptive_sampling.min_samples = scene->dscene.data.integrator.adaptive_min_samples;
   task.adaptive_sampling.adaptive_step = scene->dscene.data.integrator.adaptive_step;
 
@@ -1281,6 +1347,8 @@ void Session::device_free()
 void Session::collect_statistics(RenderStats *render_stats)
 {
   scene->collect_statistics(render_stats);
+  render_stats->tiles = tile_stats_;
+  render_stats->bake = bake_stats_;
   if (params.use_profiling && (params.device.type == DEVICE_CPU)) {
     render_stats->collect_profiling(scene, profiler);
   }
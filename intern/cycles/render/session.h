@@ -57,6 +57,7 @@ class SessionParams {
   int pixel_size;
   int threads;
   bool adaptive_sampling;
+  bool adaptive_tiles;
 
   bool use_profiling;
 
@@ -87,6 +88,7 @@ class SessionParams {
     pixel_size = 1;
     threads = 0;
     adaptive_sampling = false;
+    adaptive_tiles = false;
 
     use_profiling = false;
 
@@ -111,6 +113,7 @@ class SessionParams {
              tile_size == params.tile_size && start_resolution == params.start_resolution &&
              pixel_size == params.pixel_size && threads == params.threads &&
              adaptive_sampling == params.adaptive_sampling &&
+             adaptive_tiles == params.adaptive_tiles &&
              use_profiling == params.use_profiling &&
              display_buffer_linear == params.display_buffer_linear &&
              cancel_timeout == params.cancel_timeout && reset_timeout == params.reset_timeout &&
@@ -207,6 +210,8 @@ class Session {
   void map_neighbor_tiles(RenderTileNeighbors &neighbors, Device *tile_device);
   void unmap_neighbor_tiles(RenderTileNeighbors &neighbors, Device *tile_device);
 
+  void update_tile_stats();
+
   bool device_use_gl_;
 
   thread *session_thread_;
@@ -243,6 +248,13 @@ class Session {
   std::atomic<TileStealingState> tile_stealing_state_;
   int stealable_tiles_;
 
+  /* Time at which the current pass started, and at which each thread found no more tiles to
+   * render, to measure the idle time at the end of the pass. */
+  double render_start_time_;
+  vector<double> tile_idle_start_times_;
+  TileStats tile_stats_;
+  BakeStats bake_stats_;
+
   /* progressive refine */
   bool update_progressive_refine(bool cancel);
 };
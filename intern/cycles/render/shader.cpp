@@ -32,6 +32,7 @@
 #include "render/svm.h"
 #include "render/tables.h"
 
+#include "util/util_debug.h"
 #include "util/util_foreach.h"
 #include "util/util_murmurhash.h"
 #include "util/util_task.h"
@@ -212,8 +213,10 @@ Shader::Shader() : Node(get_node_type())
   has_volume_spatial_varying = false;
   has_volume_attribute_dependency = false;
   has_integrator_dependency = false;
+  svm_basic_surface = false;
   has_volume_connected = false;
   prev_volume_step_rate = 0.0f;
+  prev_has_volume_spatial_varying = false;
 
   displacement_method = DISPLACE_BUMP;
 
@@ -222,6 +225,7 @@ Shader::Shader() : Node(get_node_type())
   need_update_uvs = true;
   need_update_attribute = true;
   need_update_displacement = true;
+  need_update_volume_occupancy = false;
 }
 
 Shader::~Shader()
@@ -282,6 +286,7 @@ void Shader::set_graph(ShaderGraph *graph_)
    * are connected but proxy nodes should not count */
   if (graph_) {
     graph_->remove_proxy_nodes();
+    graph_->compute_hash();
 
     if (displacement_method != DISPLACE_BUMP) {
       graph_->compute_displacement_hash();
@@ -307,6 +312,21 @@ void Shader::set_graph(ShaderGraph *graph_)
   has_volume_connected = (graph->output()->input("Volume")->link != NULL);
 }
 
+bool Shader::graph_is_modified(ShaderGraph *graph_)
+{
+  /* Compare against the hash computed in set_graph() before graph optimization, since the
+   * current graph may already be simplified and compiled. Both graphs need to have the
+   * proxy nodes removed for the hashes to match. */
+  if (graph == NULL || graph_ == NULL) {
+    return graph != graph_;
+  }
+
+  graph_->remove_proxy_nodes();
+  graph_->compute_hash();
+
+  return graph->hash != graph_->hash;
+}
+
 void Shader::tag_update(Scene *scene)
 {
   /* update tag */
@@ -483,6 +503,17 @@ void ShaderManager::device_update(Device *device,
   assert(scene->default_empty->reference_count() != 0);
 
   device_update_specific(device, dscene, scene, progress);
+
+  /* Volume occupancy grids are only built for shaders without spatially varying nodes, which is
+   * only known after compiling. Rebuild the volume meshes when this changes. */
+  foreach (Shader *shader, scene->shaders) {
+    if (shader->has_volume_spatial_varying != shader->prev_has_volume_spatial_varying) {
+      shader->need_update_volume_occupancy = true;
+      shader->prev_has_volume_spatial_varying = shader->has_volume_spatial_varying;
+      scene->geometry_manager->tag_update(scene, GeometryManager::SHADER_VOLUME_MODIFIED);
+      scene->object_manager->need_flags_update = true;
+    }
+  }
 }
 
 void ShaderManager::device_update_common(Device *device,
@@ -540,6 +571,8 @@ void ShaderManager::device_update_common(Device *device,
       flag |= SD_HAS_BUMP;
     if (shader->get_displacement_method() != DISPLACE_BUMP)
       flag |= SD_HAS_DISPLACEMENT;
+    if (shader->svm_basic_surface && DebugFlags().cpu.svm_specialization)
+      flag |= SD_SVM_BASIC_SURFACE;
 
     /* constant emission check */
     float3 constant_emission = zero_float3();
@@ -98,11 +98,13 @@ class Shader : public Node {
   NODE_SOCKET_API(DisplacementMethod, displacement_method)
 
   float prev_volume_step_rate;
+  bool prev_has_volume_spatial_varying;
 
   /* synchronization */
   bool need_update_uvs;
   bool need_update_attribute;
   bool need_update_displacement;
+  bool need_update_volume_occupancy;
 
   /* If the shader has only volume components, the surface is assumed to
    * be transparent.
@@ -126,6 +128,8 @@ class Shader : public Node {
   bool has_volume_spatial_varying;
   bool has_volume_attribute_dependency;
   bool has_integrator_dependency;
+  /* Surface only uses nodes supported by the specialized SVM loop. */
+  bool svm_basic_surface;
 
   /* requested mesh attributes */
   AttributeRequestSet attributes;
@@ -151,6 +155,7 @@ class Shader : public Node {
   bool is_constant_emission(float3 *emission);
 
   void set_graph(ShaderGraph *graph);
+  bool graph_is_modified(ShaderGraph *graph);
   void tag_update(Scene *scene);
   void tag_used(Scene *scene);
 
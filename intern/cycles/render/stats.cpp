@@ -224,6 +224,31 @@ string NamedSampleCountStats::full_report(int indent_level)
   return result;
 }
 
+string NamedSampleCountStats::throughput_report(int indent_level)
+{
+  const string indent(indent_level * kIndentNumSpaces, ' ');
+
+  vector<NamedSampleCountPair> sorted_entries;
+  sorted_entries.reserve(entries.size());
+  foreach (entry_map::const_reference entry, entries) {
+    sorted_entries.push_back(entry.second);
+  }
+
+  sort(sorted_entries.begin(), sorted_entries.end(), namedSampleCountPairComparator);
+
+  string result = "";
+  foreach (const NamedSampleCountPair &entry, sorted_entries) {
+    const double seconds = entry.samples * 0.001;
+    const double per_second = entry.hits / seconds;
+
+    result += indent + string_printf("%-32s: %.2fs (%.3fM per second)\n",
+                                     entry.name.c_str(),
+                                     seconds,
+                                     per_second * 1e-6);
+  }
+  return result;
+}
+
 /* Mesh statistics. */
 
 MeshStats::MeshStats()
@@ -235,12 +260,23 @@ string MeshStats::full_report(int indent_level)
   const string indent(indent_level * kIndentNumSpaces, ' ');
   string result = "";
   result += indent + "Geometry:\n" + geometry.full_report(indent_level + 1);
+  if (!compact_geometry.entries.empty()) {
+    result += indent + "Compact geometry savings:\n" +
+              compact_geometry.full_report(indent_level + 1);
+  }
   return result;
 }
 
 /* Image statistics. */
 
 ImageStats::ImageStats()
+    : full_size(0),
+      num_downscaled(0),
+      cache_hits(0),
+      cache_misses(0),
+      cache_bytes_read(0),
+      cache_memory(0),
+      cache_memory_limit(0)
 {
 }
 
@@ -249,6 +285,143 @@ string ImageStats::full_report(int indent_level)
   const string indent(indent_level * kIndentNumSpaces, ' ');
   string result = "";
   result += indent + "Textures:\n" + textures.full_report(indent_level + 1);
+  if (num_downscaled > 0) {
+    result += string_printf("%sDownscaled textures: %d, full resolution memory: %s (%s)\n",
+                            indent.c_str(),
+                            num_downscaled,
+                            string_human_readable_size(full_size).c_str(),
+                            string_human_readable_number(full_size).c_str());
+  }
+  if (cache_memory_limit > 0) {
+    const uint64_t num_lookups = cache_hits + cache_misses;
+    result += string_printf("%sTexture cache: %llu hits, %llu misses (%.1f%% hit rate)\n",
+                            indent.c_str(),
+                            (unsigned long long)cache_hits,
+                            (unsigned long long)cache_misses,
+                            (num_lookups) ? 100.0 * cache_hits / num_lookups : 0.0);
+    result += string_printf("%sTexture cache read: %s, memory: %s (limit %s)\n",
+                            indent.c_str(),
+                            string_human_readable_size(cache_bytes_read).c_str(),
+                            string_human_readable_size(cache_memory).c_str(),
+                            string_human_readable_size(cache_memory_limit).c_str());
+  }
+  return result;
+}
+
+/* Tile statistics. */
+
+TileStats::TileStats() : num_tiles(0), num_split_tiles(0), tail_idle_time(0.0), thread_time(0.0)
+{
+}
+
+string TileStats::full_report(int indent_level)
+{
+  const string indent(indent_level * kIndentNumSpaces, ' ');
+  string result = "";
+  result += string_printf("%sTiles: %d (%d split at the end of a pass)\n",
+                          indent.c_str(),
+                          num_tiles,
+                          num_split_tiles);
+  if (thread_time > 0.0) {
+    result += string_printf("%sTail idle time: %.2fs (%.1f%% of thread time)\n",
+                            indent.c_str(),
+                            tail_idle_time,
+                            100.0 * tail_idle_time / thread_time);
+  }
+  return result;
+}
+
+/* Procedural statistics. */
+
+ProceduralStats::ProceduralStats()
+    : stream_hits(0), stream_misses(0), peak_memory(0), memory_limit(0)
+{
+}
+
+string ProceduralStats::full_report(int indent_level)
+{
+  const string indent(indent_level * kIndentNumSpaces, ' ');
+  const int num_lookups = stream_hits + stream_misses;
+  string result = "";
+  result += string_printf("%sStreamed data: %d hits, %d misses (%.1f%% hit rate)\n",
+                          indent.c_str(),
+                          stream_hits,
+                          stream_misses,
+                          (num_lookups) ? 100.0 * stream_hits / num_lookups : 0.0);
+  result += string_printf("%sPeak memory: %s (limit %s)\n",
+                          indent.c_str(),
+                          string_human_readable_size(peak_memory).c_str(),
+                          string_human_readable_size(memory_limit).c_str());
+  return result;
+}
+
+/* Bake statistics. */
+
+BakeStats::BakeStats() : num_pixels(0), time(0.0)
+{
+}
+
+string BakeStats::full_report(int indent_level)
+{
+  const string indent(indent_level * kIndentNumSpaces, ' ');
+  string result = "";
+  result += string_printf("%sPixels: %llu\n", indent.c_str(), (unsigned long long)num_pixels);
+  result += string_printf("%sTime: %.2fs (%.0f pixels per second)\n",
+                          indent.c_str(),
+                          time,
+                          (time > 0.0) ? num_pixels / time : 0.0);
+  return result;
+}
+
+/* Ray statistics. */
+
+static const char *ray_type_names[PROFILING_NUM_RAY_TYPES] = {"Camera", "Shadow", "Indirect"};
+static const char *ray_type_ids[PROFILING_NUM_RAY_TYPES] = {"camera", "shadow", "indirect"};
+
+RayStats::RayStats()
+{
+  for (int i = 0; i < PROFILING_NUM_RAY_TYPES; i++) {
+    rays[i] = 0;
+  }
+}
+
+bool RayStats::empty() const
+{
+  for (int i = 0; i < PROFILING_NUM_RAY_TYPES; i++) {
+    if (rays[i] + curve_segments[i].culled + curve_segments[i].tested > 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+string RayStats::full_report(int indent_level)
+{
+  const string indent(indent_level * kIndentNumSpaces, ' ');
+  string result = "";
+  for (int i = 0; i < PROFILING_NUM_RAY_TYPES; i++) {
+    const ProfilingCurveSegments &s = curve_segments[i];
+    const uint64_t total = s.culled + s.tested;
+    if (rays[i] == 0 && total == 0) {
+      continue;
+    }
+    result += string_printf("%s%-10s %llu rays\n",
+                            indent.c_str(),
+                            (string(ray_type_names[i]) + ":").c_str(),
+                            (unsigned long long)rays[i]);
+    if (total == 0) {
+      continue;
+    }
+    result += string_printf(
+        "%s%-10s %llu curve segments, %llu culled (%.1f%%), %llu tested, %llu hits\n",
+        indent.c_str(),
+        "",
+        (unsigned long long)total,
+        (unsigned long long)s.culled,
+        100.0 * s.culled / total,
+        (unsigned long long)s.tested,
+        (unsigned long long)s.hits);
+  }
   return result;
 }
 
@@ -312,6 +485,11 @@ void RenderStats::collect_profiling(Scene *scene, Profiler &prof)
   prefilter.add_entry("Detect Outliers", prof.get_event(PROFILING_DENOISING_DETECT_OUTLIERS));
   prefilter.add_entry("Combine Halves", prof.get_event(PROFILING_DENOISING_COMBINE_HALVES));
 
+  for (int i = 0; i < PROFILING_NUM_RAY_TYPES; i++) {
+    rays.rays[i] = prof.get_rays((ProfilingRayType)i);
+    rays.curve_segments[i] = prof.get_curve_segments((ProfilingRayType)i);
+  }
+
   shaders.entries.clear();
   foreach (Shader *shader, scene->shaders) {
     uint64_t samples, hits;
@@ -327,6 +505,219 @@ void RenderStats::collect_profiling(Scene *scene, Profiler &prof)
       objects.add(object->name, samples, hits);
     }
   }
+
+  shader_evals.entries.clear();
+  foreach (Shader *shader, scene->shaders) {
+    uint64_t samples, evals;
+    if (prof.get_shader_eval(shader->id, samples, evals)) {
+      shader_evals.add(shader->name, samples, evals);
+    }
+  }
+
+  object_intersections.clear();
+  foreach (Object *object, scene->objects) {
+    uint64_t samples;
+    if (prof.get_object_intersect(object->get_device_index(), samples)) {
+      object_intersections.add_entry(NamedTimeEntry(object->name.string(), samples * 0.001));
+    }
+  }
+}
+
+/* JSON export. */
+
+static string json_string(const string &str)
+{
+  string result = "\"";
+  foreach (char c, str) {
+    if (c == '"' || c == '\\') {
+      result += '\\';
+      result += c;
+    }
+    else if ((unsigned char)c < 0x20) {
+      result += string_printf("\\u%04x", (int)c);
+    }
+    else {
+      result += c;
+    }
+  }
+  return result + "\"";
+}
+
+static string json_trace_event(const string &name,
+                               const char *category,
+                               int tid,
+                               uint64_t start_samples,
+                               uint64_t samples,
+                               const string &args)
+{
+  /* Samples are taken every millisecond, trace timestamps are in microseconds. */
+  return string_printf(
+      "    {\"name\": %s, \"cat\": \"%s\", \"ph\": \"X\", \"pid\": 0, \"tid\": %d, "
+      "\"ts\": %llu, \"dur\": %llu, \"args\": {%s}}",
+      json_string(name).c_str(),
+      category,
+      tid,
+      (unsigned long long)start_samples * 1000,
+      (unsigned long long)samples * 1000,
+      args.c_str());
+}
+
+static void json_trace_nested_events(const NamedNestedSampleStats &stats,
+                                     uint64_t start_samples,
+                                     vector<string> &events)
+{
+  if (stats.sum_samples == 0) {
+    return;
+  }
+
+  events.push_back(
+      json_trace_event(stats.name, "kernel", 0, start_samples, stats.sum_samples, ""));
+
+  /* Lay out the sub-entries one after another inside their parent, like a flame graph. */
+  foreach (const NamedNestedSampleStats &entry, stats.entries) {
+    json_trace_nested_events(entry, start_samples, events);
+    start_samples += entry.sum_samples;
+  }
+}
+
+static string json_nested_stats(const NamedNestedSampleStats &stats)
+{
+  string result = string_printf("{\"name\": %s, \"time\": %.3f, \"self_time\": %.3f",
+                                json_string(stats.name).c_str(),
+                                stats.sum_samples * 0.001,
+                                stats.self_samples * 0.001);
+  if (!stats.entries.empty()) {
+    result += ", \"entries\": [";
+    for (size_t i = 0; i < stats.entries.size(); i++) {
+      result += (i > 0 ? ", " : "") + json_nested_stats(stats.entries[i]);
+    }
+    result += "]";
+  }
+  return result + "}";
+}
+
+static vector<NamedSampleCountPair> sorted_sample_count_entries(NamedSampleCountStats &stats)
+{
+  vector<NamedSampleCountPair> entries;
+  entries.reserve(stats.entries.size());
+  foreach (NamedSampleCountStats::entry_map::const_reference entry, stats.entries) {
+    entries.push_back(entry.second);
+  }
+  sort(entries.begin(), entries.end(), namedSampleCountPairComparator);
+  return entries;
+}
+
+/* Add a trace event for every entry on its own thread track, and return the entries as a JSON
+ * array with the time and count of every entry. */
+static string json_sample_count_stats(NamedSampleCountStats &stats,
+                                      const char *category,
+                                      const char *count_name,
+                                      int tid,
+                                      vector<string> &events)
+{
+  string result = "[";
+  uint64_t start_samples = 0;
+  const vector<NamedSampleCountPair> entries = sorted_sample_count_entries(stats);
+  for (size_t i = 0; i < entries.size(); i++) {
+    const NamedSampleCountPair &entry = entries[i];
+    const string count = string_printf(
+        "\"%s\": %llu", count_name, (unsigned long long)entry.hits);
+
+    events.push_back(
+        json_trace_event(entry.name.string(), category, tid, start_samples, entry.samples, count));
+    start_samples += entry.samples;
+
+    result += string_printf("%s\n    {\"name\": %s, \"time\": %.3f, %s}",
+                            (i > 0) ? "," : "",
+                            json_string(entry.name.string()).c_str(),
+                            entry.samples * 0.001,
+                            count.c_str());
+  }
+  return result + "]";
+}
+
+static string json_thread_name(int tid, const char *name)
+{
+  return string_printf(
+      "    {\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 0, \"tid\": %d, "
+      "\"args\": {\"name\": \"%s\"}}",
+      tid,
+      name);
+}
+
+string RenderStats::json_report()
+{
+  vector<string> events;
+  events.push_back(json_thread_name(0, "Kernel"));
+  events.push_back(json_thread_name(1, "Shaders"));
+  events.push_back(json_thread_name(2, "Objects"));
+  events.push_back(json_thread_name(3, "Shader Evaluation"));
+  events.push_back(json_thread_name(4, "Object Intersection"));
+
+  string stats = "";
+  if (has_profiling) {
+    kernel.update_sum();
+    json_trace_nested_events(kernel, 0, events);
+
+    stats += ",\n  \"kernel\": " + json_nested_stats(kernel);
+    stats += ",\n  \"shaders\": " +
+             json_sample_count_stats(shaders, "shader", "hits", 1, events);
+    stats += ",\n  \"objects\": " +
+             json_sample_count_stats(objects, "object", "hits", 2, events);
+    stats += ",\n  \"shader_evaluations\": " +
+             json_sample_count_stats(shader_evals, "shader_eval", "evaluations", 3, events);
+
+    sort(object_intersections.entries.begin(),
+         object_intersections.entries.end(),
+         namedTimeEntryComparator);
+    stats += ",\n  \"object_intersections\": [";
+    uint64_t start_samples = 0;
+    for (size_t i = 0; i < object_intersections.entries.size(); i++) {
+      const NamedTimeEntry &entry = object_intersections.entries[i];
+      const uint64_t samples = (uint64_t)(entry.time * 1000.0 + 0.5);
+      events.push_back(
+          json_trace_event(entry.name, "object_intersection", 4, start_samples, samples, ""));
+      start_samples += samples;
+
+      stats += string_printf("%s\n    {\"name\": %s, \"time\": %.3f}",
+                             (i > 0) ? "," : "",
+                             json_string(entry.name).c_str(),
+                             entry.time);
+    }
+    stats += "]";
+
+    stats += ",\n  \"rays\": {";
+    for (int i = 0; i < PROFILING_NUM_RAY_TYPES; i++) {
+      const ProfilingCurveSegments &segments = rays.curve_segments[i];
+      stats += string_printf(
+          "%s\n    \"%s\": {\"rays\": %llu, \"curve_segments_culled\": %llu, "
+          "\"curve_segments_tested\": %llu, \"curve_segments_hit\": %llu}",
+          (i > 0) ? "," : "",
+          ray_type_ids[i],
+          (unsigned long long)rays.rays[i],
+          (unsigned long long)segments.culled,
+          (unsigned long long)segments.tested,
+          (unsigned long long)segments.hits);
+    }
+    stats += "}";
+  }
+
+  if (bake.num_pixels > 0) {
+    stats += string_printf(
+        ",\n  \"bake\": {\"pixels\": %llu, \"time\": %.3f, \"pixels_per_second\": %.0f}",
+        (unsigned long long)bake.num_pixels,
+        bake.time,
+        (bake.time > 0.0) ? bake.num_pixels / bake.time : 0.0);
+  }
+
+  string result ="{\n  \"displayTimeUnit\": \"ms\",\n  \"traceEvents\": [\n";
+  for (size_t i = 0; i < events.size(); i++) {
+    result += events[i] + ((i + 1 < events.size()) ? ",\n" : "\n");
+  }
+  result += "  ]";
+  result += stats;
+  result += "\n}\n";
+  return result;
 }
 
 string RenderStats::full_report()
@@ -334,10 +725,24 @@ string RenderStats::full_report()
   string result = "";
   result += "Mesh statistics:\n" + mesh.full_report(1);
   result += "Image statistics:\n" + image.full_report(1);
+  result += "Tile statistics:\n" + tiles.full_report(1);
+  if (procedurals.stream_hits + procedurals.stream_misses > 0) {
+    result += "Procedural statistics:\n" + procedurals.full_report(1);
+  }
+  if (bake.num_pixels > 0) {
+    result += "Bake statistics:\n" + bake.full_report(1);
+  }
   if (has_profiling) {
     result += "Kernel statistics:\n" + kernel.full_report(1);
     result += "Shader statistics:\n" + shaders.full_report(1);
     result += "Object statistics:\n" + objects.full_report(1);
+    if (!object_intersections.entries.empty()) {
+      result += "Object intersection statistics:\n" + object_intersections.full_report(1);
+    }
+    if (!rays.empty()) {
+      result += "Ray statistics:\n" + rays.full_report(1);
+    }
+    result += "Shader evaluation throughput:\n" + shader_evals.throughput_report(1);
   }
   else {
     result += "Profiling information not available (only works with CPU rendering)";
@@ -363,6 +768,7 @@ string SceneUpdateStats::full_report()
   string result = "";
   result += "Scene:\n" + scene.full_report(1);
   result += "Geometry:\n" + geometry.full_report(1);
+  result += "BVH:\n" + bvh.full_report(1);
   result += "Light:\n" + light.full_report(1);
   result += "Object:\n" + object.full_report(1);
   result += "Image:\n" + image.full_report(1);
@@ -387,6 +793,7 @@ void SceneUpdateStats::clear()
   object.times.clear();
   background.times.clear();
   bake.times.clear();
+  bvh.times.clear();
   camera.times.clear();
   film.times.clear();
   integrator.times.clear();
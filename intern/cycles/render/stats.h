@@ -141,6 +141,8 @@ class NamedSampleCountStats {
   NamedSampleCountStats();
 
   string full_report(int indent_level = 0);
+  /* Report the number of processed items per second of thread time instead of relative cost. */
+  string throughput_report(int indent_level = 0);
   void add(const ustring &name, uint64_t samples, uint64_t hits);
 
   typedef unordered_map<ustring, NamedSampleCountPair, ustringHash> entry_map;
@@ -160,6 +162,9 @@ class MeshStats {
    * memory like BVH.
    */
   NamedSizeStats geometry;
+
+  /* Memory saved by compact geometry storage, per attribute category. */
+  NamedSizeStats compact_geometry;
 };
 
 /* Statistics about images held in memory. */
@@ -171,6 +176,86 @@ class ImageStats {
   string full_report(int indent_level = 0);
 
   NamedSizeStats textures;
+
+  /* Memory the textures would use at full resolution, and how many of them were downscaled to
+   * fit the texture size or memory limit. */
+  size_t full_size;
+  int num_downscaled;
+
+  /* Tile lookups of the texture cache that found the tile in memory and that had to read it
+   * from disk, bytes read from disk, and memory used by cached tiles against the budget. Zero
+   * when the texture cache is not used. */
+  uint64_t cache_hits;
+  uint64_t cache_misses;
+  uint64_t cache_bytes_read;
+  size_t cache_memory;
+  size_t cache_memory_limit;
+};
+
+/* Statistics about how tiles were scheduled on the render threads. */
+class TileStats {
+ public:
+  TileStats();
+
+  /* Generate full human-readable report. */
+  string full_report(int indent_level = 0);
+
+  /* Number of rendered tiles, and how many of them were created by splitting the remaining tiles
+   * at the end of a pass. */
+  int num_tiles;
+  int num_split_tiles;
+
+  /* Time threads spent idle at the end of each pass waiting for the last tiles to finish, summed
+   * over all threads, and the total time threads spent in the passes. */
+  double tail_idle_time;
+  double thread_time;
+};
+
+/* Statistics about data streamed in by procedurals. */
+class ProceduralStats {
+ public:
+  ProceduralStats();
+
+  /* Generate full human-readable report. */
+  string full_report(int indent_level = 0);
+
+  /* Number of times the data of an object for a new frame was already in memory, either resident
+   * or prefetched in the background, and number of times it had to be loaded on demand. */
+  int stream_hits;
+  int stream_misses;
+
+  /* Peak memory used by the resident and prefetched data, and the memory limit. */
+  size_t peak_memory;
+  size_t memory_limit;
+};
+
+/* Statistics about baking throughput. */
+class BakeStats {
+ public:
+  BakeStats();
+
+  /* Generate full human-readable report. */
+  string full_report(int indent_level = 0);
+
+  /* Number of baked pixels over all objects of a batch, and the time spent baking them, without
+   * scene synchronization. */
+  uint64_t num_pixels;
+  double time;
+};
+
+/* Statistics about rays traced and curve segments intersected during BVH traversal, per ray
+ * type. */
+class RayStats {
+ public:
+  RayStats();
+
+  /* Generate full human-readable report. */
+  string full_report(int indent_level = 0);
+
+  bool empty() const;
+
+  uint64_t rays[PROFILING_NUM_RAY_TYPES];
+  ProfilingCurveSegments curve_segments[PROFILING_NUM_RAY_TYPES];
 };
 
 /* Render process statistics. */
@@ -181,6 +266,11 @@ class RenderStats {
   /* Return full report as string. */
   string full_report();
 
+  /* Return profiling information as a JSON object in the Chrome trace event format, which can
+   * be opened in chrome://tracing or Perfetto. Next to the trace events it contains the
+   * statistics of every shader, object and ray type for processing by scripts. */
+  string json_report();
+
   /* Collect kernel sampling information from Stats. */
   void collect_profiling(Scene *scene, Profiler &prof);
 
@@ -188,9 +278,15 @@ class RenderStats {
 
   MeshStats mesh;
   ImageStats image;
+  TileStats tiles;
+  ProceduralStats procedurals;
+  BakeStats bake;
+  RayStats rays;
   NamedNestedSampleStats kernel;
   NamedSampleCountStats shaders;
   NamedSampleCountStats objects;
+  NamedSampleCountStats shader_evals;
+  NamedTimeStats object_intersections;
 };
 
 class UpdateTimeStats {
@@ -211,6 +307,7 @@ class SceneUpdateStats {
   UpdateTimeStats object;
   UpdateTimeStats background;
   UpdateTimeStats bake;
+  UpdateTimeStats bvh;
   UpdateTimeStats camera;
   UpdateTimeStats film;
   UpdateTimeStats integrator;
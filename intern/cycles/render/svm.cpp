@@ -172,6 +172,55 @@ void SVMShaderManager::device_free(Device *device, DeviceScene *dscene, Scene *s
   dscene->svm_nodes.free();
 }
 
+/* Nodes handled by svm_eval_nodes_basic_surface() in the kernel. These cover the most common
+ * surface shaders, BSDFs like the Principled BSDF driven by image textures with the usual
+ * coordinate, mapping and color adjustment nodes in between. */
+static bool svm_node_is_basic_surface(ShaderNodeType type)
+{
+  switch (type) {
+    case NODE_END:
+    case NODE_SHADER_JUMP:
+    case NODE_CLOSURE_BSDF:
+    case NODE_CLOSURE_EMISSION:
+    case NODE_CLOSURE_SET_WEIGHT:
+    case NODE_CLOSURE_WEIGHT:
+    case NODE_EMISSION_WEIGHT:
+    case NODE_MIX_CLOSURE:
+    case NODE_JUMP_IF_ZERO:
+    case NODE_JUMP_IF_ONE:
+    case NODE_GEOMETRY:
+    case NODE_CONVERT:
+    case NODE_TEX_COORD:
+    case NODE_VALUE_F:
+    case NODE_VALUE_V:
+    case NODE_ATTR:
+    case NODE_TEX_IMAGE:
+    case NODE_TEX_IMAGE_BOX:
+    case NODE_HSV:
+    case NODE_FRESNEL:
+    case NODE_LAYER_WEIGHT:
+    case NODE_MATH:
+    case NODE_VECTOR_MATH:
+    case NODE_RGB_RAMP:
+    case NODE_GAMMA:
+    case NODE_BRIGHTCONTRAST:
+    case NODE_TEXTURE_MAPPING:
+    case NODE_MAPPING:
+    case NODE_MIN_MAX:
+    case NODE_TANGENT:
+    case NODE_NORMAL_MAP:
+    case NODE_INVERT:
+    case NODE_MIX:
+    case NODE_SEPARATE_VECTOR:
+    case NODE_COMBINE_VECTOR:
+    case NODE_MAP_RANGE:
+    case NODE_CLAMP:
+      return true;
+    default:
+      return false;
+  }
+}
+
 /* Graph Compiler */
 
 SVMCompiler::SVMCompiler(Scene *scene) : scene(scene)
@@ -183,6 +232,7 @@ SVMCompiler::SVMCompiler(Scene *scene) : scene(scene)
   background = false;
   mix_weight_offset = SVM_STACK_INVALID;
   compile_failed = false;
+  basic_surface = true;
 }
 
 int SVMCompiler::stack_size(SocketType::Type type)
@@ -391,11 +441,17 @@ void SVMCompiler::add_node(int a, int b, int c, int d)
 
 void SVMCompiler::add_node(ShaderNodeType type, int a, int b, int c)
 {
+  if (current_type == SHADER_TYPE_SURFACE && !svm_node_is_basic_surface(type)) {
+    basic_surface = false;
+  }
   current_svm_nodes.push_back_slow(make_int4(type, a, b, c));
 }
 
 void SVMCompiler::add_node(ShaderNodeType type, const float3 &f)
 {
+  if (current_type == SHADER_TYPE_SURFACE && !svm_node_is_basic_surface(type)) {
+    basic_surface = false;
+  }
   current_svm_nodes.push_back_slow(
       make_int4(type, __float_as_int(f.x), __float_as_int(f.y), __float_as_int(f.z)));
 }
@@ -733,6 +789,7 @@ void SVMCompiler::compile_type(Shader *shader, ShaderGraph *graph, ShaderType ty
 
   current_type = type;
   current_graph = graph;
+  basic_surface = true;
 
   /* get input in output node */
   ShaderNode *output = graph->output();
@@ -876,6 +933,7 @@ void SVMCompiler::compile(Shader *shader, array<int4> &svm_nodes, int index, Sum
   shader->has_volume_spatial_varying = false;
   shader->has_volume_attribute_dependency = false;
   shader->has_integrator_dependency = false;
+  shader->svm_basic_surface = false;
 
   /* generate bump shader */
   if (has_bump) {
@@ -895,6 +953,7 @@ void SVMCompiler::compile(Shader *shader, array<int4> &svm_nodes, int index, Sum
       svm_nodes[index].y = svm_nodes.size();
     }
     svm_nodes.append(current_svm_nodes);
+    shader->svm_basic_surface = basic_surface && !has_bump;
   }
 
   /* generate volume shader */
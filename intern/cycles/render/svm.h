@@ -228,6 +228,7 @@ class SVMCompiler {
   int max_stack_use;
   uint mix_weight_offset;
   bool compile_failed;
+  bool basic_surface;
 };
 
 CCL_NAMESPACE_END
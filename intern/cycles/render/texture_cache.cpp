@@ -0,0 +1,182 @@
+/*
+ * Copyright 2011-2021 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "render/texture_cache.h"
+#include "render/colorspace.h"
+#include "render/stats.h"
+
+#include "util/util_logging.h"
+#include "util/util_math.h"
+
+#include <OpenImageIO/texture.h>
+
+CCL_NAMESPACE_BEGIN
+
+namespace {
+
+class OIIOTextureCacheImage : public TextureCacheImage {
+ public:
+  OIIOTextureCacheImage(TextureSystem *ts, ustring filepath, ColorSpaceProcessor *processor)
+      : ts(ts),
+        filepath(filepath),
+        handle(ts->get_texture_handle(filepath)),
+        processor(processor),
+        clip(false)
+  {
+  }
+
+  float4 lookup(float x, float y) const override
+  {
+    /* Transparent outside the image like in memory, black wrapping would fill in the alpha of
+     * images without an alpha channel. */
+    if (clip && (x < 0.0f || y < 0.0f || x > 1.0f || y > 1.0f)) {
+      return make_float4(0.0f, 0.0f, 0.0f, 0.0f);
+    }
+
+    /* SVM has no ray differentials for image textures, so lookups are done with zero
+     * derivatives and sample the finest mip level. */
+    TextureOpt texture_options = options;
+    float result[4];
+    if (!ts->texture(handle,
+                     ts->get_perthread_info(),
+                     texture_options,
+                     x,
+                     1.0f - y,
+                     0.0f,
+                     0.0f,
+                     0.0f,
+                     0.0f,
+                     4,
+                     result)) {
+      /* Prevents error messages from piling up in the texture system. */
+      ts->geterror();
+      return make_float4(
+          TEX_IMAGE_MISSING_R, TEX_IMAGE_MISSING_G, TEX_IMAGE_MISSING_B, TEX_IMAGE_MISSING_A);
+    }
+
+    if (processor) {
+      ColorSpaceManager::to_scene_linear(processor, result, 4);
+    }
+
+    /* Same as for images loaded into memory, avoid artifacts from fully changed hue. */
+    if (!isfinite_safe(result[0]) || !isfinite_safe(result[1]) || !isfinite_safe(result[2]) ||
+        !isfinite_safe(result[3])) {
+      return zero_float4();
+    }
+
+    return make_float4(result[0], result[1], result[2], result[3]);
+  }
+
+  TextureSystem *ts;
+  ustring filepath;
+  TextureSystem::TextureHandle *handle;
+  ColorSpaceProcessor *processor;
+  TextureOpt options;
+  bool clip;
+};
+
+TextureOpt::InterpMode texture_interpolation(InterpolationType interpolation)
+{
+  switch (interpolation) {
+    case INTERPOLATION_CLOSEST:
+      return TextureOpt::InterpClosest;
+    case INTERPOLATION_CUBIC:
+      return TextureOpt::InterpBicubic;
+    case INTERPOLATION_SMART:
+      return TextureOpt::InterpSmartBicubic;
+    default:
+      return TextureOpt::InterpBilinear;
+  }
+}
+
+TextureOpt::Wrap texture_wrap(ExtensionType extension)
+{
+  switch (extension) {
+    case EXTENSION_REPEAT:
+      return TextureOpt::WrapPeriodic;
+    case EXTENSION_EXTEND:
+      return TextureOpt::WrapClamp;
+    default:
+      return TextureOpt::WrapBlack;
+  }
+}
+
+}  // namespace
+
+TextureCache::TextureCache(const size_t memory_limit) : memory_limit(memory_limit)
+{
+  /* Not shared with the OSL texture system, so that the budget and statistics only cover the
+   * images sampled through this cache. */
+  ts = TextureSystem::create(false);
+
+  ts->attribute("automip", 1);
+  ts->attribute("autotile", 64);
+  ts->attribute("gray_to_rgb", 1);
+  ts->attribute("max_memory_MB", (float)((double)memory_limit / (1024.0 * 1024.0)));
+}
+
+TextureCache::~TextureCache()
+{
+  ts->invalidate_all(true);
+  TextureSystem::destroy(ts);
+}
+
+TextureCacheImage *TextureCache::add_image(ustring filepath,
+                                           ustring colorspace,
+                                           InterpolationType interpolation,
+                                           ExtensionType extension)
+{
+  OIIOTextureCacheImage *image = new OIIOTextureCacheImage(
+      ts, filepath, ColorSpaceManager::get_processor(colorspace));
+
+  if (image->handle == NULL) {
+    VLOG(1) << "Texture cache failed to open " << filepath << ": " << ts->geterror();
+  }
+
+  image->options.interpmode = texture_interpolation(interpolation);
+  image->options.swrap = texture_wrap(extension);
+  image->options.twrap = texture_wrap(extension);
+  /* Alpha of images without an alpha channel, like for images loaded into memory. */
+  image->options.fill = 1.0f;
+  image->clip = (extension == EXTENSION_CLIP);
+
+  return image;
+}
+
+void TextureCache::remove_image(TextureCacheImage *image)
+{
+  OIIOTextureCacheImage *oiio_image = (OIIOTextureCacheImage *)image;
+  ts->invalidate(oiio_image->filepath);
+  delete oiio_image;
+}
+
+void TextureCache::collect_statistics(RenderStats *stats)
+{
+  long long find_tile_calls = 0, bytes_read = 0, memory_used = 0;
+  int find_tile_cache_misses = 0;
+  ts->getattribute("stat:find_tile_calls", TypeDesc::INT64, &find_tile_calls);
+  ts->getattribute("stat:find_tile_cache_misses", TypeDesc::INT, &find_tile_cache_misses);
+  ts->getattribute("stat:bytes_read", TypeDesc::INT64, &bytes_read);
+  ts->getattribute("stat:cache_memory_used", TypeDesc::INT64, &memory_used);
+
+  stats->image.cache_hits += find_tile_calls - find_tile_cache_misses;
+  stats->image.cache_misses += find_tile_cache_misses;
+  stats->image.cache_bytes_read += bytes_read;
+  stats->image.cache_memory += memory_used;
+  stats->image.cache_memory_limit += memory_limit;
+}
+
+CCL_NAMESPACE_END
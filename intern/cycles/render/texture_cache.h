@@ -0,0 +1,61 @@
+/*
+ * Copyright 2011-2021 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __TEXTURE_CACHE_H__
+#define __TEXTURE_CACHE_H__
+
+#include "util/util_param.h"
+#include "util/util_texture.h"
+
+OIIO_NAMESPACE_BEGIN
+class TextureSystem;
+OIIO_NAMESPACE_END
+
+CCL_NAMESPACE_BEGIN
+
+class RenderStats;
+
+/* Texture Cache
+ *
+ * Samples image textures for the SVM kernel on the CPU through an OpenImageIO texture system,
+ * instead of loading the full images into memory. Images are read in tiles on first access,
+ * with mipmaps generated for untiled files, and the least recently used tiles are evicted when
+ * the memory budget is exceeded. */
+class TextureCache {
+ public:
+  explicit TextureCache(const size_t memory_limit);
+  ~TextureCache();
+
+  /* Create an image sampled from the given file. Pixels are converted from the given color
+   * space to scene linear at lookup time. */
+  TextureCacheImage *add_image(ustring filepath,
+                               ustring colorspace,
+                               InterpolationType interpolation,
+                               ExtensionType extension);
+  /* Free the image, and drop its tiles from the cache so that changes to the file are picked
+   * up when it is added again. */
+  void remove_image(TextureCacheImage *image);
+
+  void collect_statistics(RenderStats *stats);
+
+ protected:
+  OIIO::TextureSystem *ts;
+  size_t memory_limit;
+};
+
+CCL_NAMESPACE_END
+
+#endif /* __TEXTURE_CACHE_H__ */
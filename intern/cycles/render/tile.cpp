@@ -18,6 +18,7 @@
 
 #include "util/util_algorithm.h"
 #include "util/util_foreach.h"
+#include "util/util_time.h"
 #include "util/util_types.h"
 
 CCL_NAMESPACE_BEGIN
@@ -84,6 +85,13 @@ enum SpiralDirection {
   DIRECTION_RIGHT,
 };
 
+/* Tiles are not split further once their longer side would drop below this size, past that the
+ * per-tile overhead outweighs the gain in load balancing. */
+const int MIN_SPLIT_TILE_SIZE = 8;
+
+/* Room reserved for split tiles per worker, splitting stops once it is used up. */
+const int SPLIT_TILES_PER_WORKER = 4;
+
 } /* namespace */
 
 TileManager::TileManager(bool progressive_,
@@ -107,6 +115,9 @@ TileManager::TileManager(bool progressive_,
   preserve_tile_device = preserve_tile_device_;
   background = background_;
   schedule_denoising = false;
+  split_tiles = false;
+  split_num_workers = 1;
+  tile_cost_stride = 0;
 
   range_start_sample = 0;
   range_num_samples = -1;
@@ -154,6 +165,7 @@ void TileManager::reset(BufferParams &params_, int num_samples_)
   state.buffer = BufferParams();
   state.sample = range_start_sample - 1;
   state.num_tiles = 0;
+  state.num_split_tiles = 0;
   state.num_samples = 0;
   state.resolution_divider = get_divider(params.width, params.height, start_resolution);
   state.render_tiles.clear();
@@ -212,6 +224,14 @@ int TileManager::gen_tiles(bool sliced)
   state.render_tiles.resize(num);
   state.denoising_tiles.resize(num);
   state.tile_stride = tile_w;
+
+  if (!sliced) {
+    /* Tiles split at the end of the pass are appended to the tile list. Reserve room for them up
+     * front, so that the tile pointers handed out to devices stay valid. */
+    int tile_h = (tile_size.y >= image_h) ? 1 : divide_up(image_h, tile_size.y);
+    state.tiles.reserve(tile_w * tile_h + SPLIT_TILES_PER_WORKER * max(split_num_workers, 1));
+  }
+
   vector<list<int>>::iterator tile_list;
   tile_list = state.render_tiles.begin();
 
@@ -367,6 +387,8 @@ int TileManager::gen_tiles(bool sliced)
 
 void TileManager::gen_render_tiles()
 {
+  update_tile_cost_estimates();
+
   /* Regenerate just the render tiles for progressive render. */
   foreach (Tile &tile, state.tiles) {
     tile.state = Tile::RENDER;
@@ -380,7 +402,10 @@ void TileManager::set_tiles()
   int image_w = max(1, params.width / resolution);
   int image_h = max(1, params.height / resolution);
 
+  update_tile_cost_estimates();
+
   state.num_tiles = gen_tiles(!background);
+  state.num_split_tiles = 0;
 
   state.buffer.width = image_w;
   state.buffer.height = image_h;
@@ -389,6 +414,113 @@ void TileManager::set_tiles()
   state.buffer.full_y = params.full_y / resolution;
   state.buffer.full_width = max(1, params.full_width / resolution);
   state.buffer.full_height = max(1, params.full_height / resolution);
+
+  if (background) {
+    int tile_h = (tile_size.y >= image_h) ? 1 : divide_up(image_h, tile_size.y);
+    state.tile_times.resize(state.tile_stride * tile_h);
+  }
+}
+
+/* Tile splitting changes the tile layout, which is only possible for final renders where tiles
+ * are written independently of each other. Denoising during rendering relies on the regular tile
+ * grid to find neighbors, and progressive rendering keeps the tiles between passes. */
+bool TileManager::use_tile_splitting()
+{
+  return split_tiles && background && !progressive && !preserve_tile_device &&
+         !schedule_denoising;
+}
+
+/* Index of the cell of the regular tile grid that contains the tile. */
+int TileManager::tile_grid_index(const Tile &tile)
+{
+  return (tile.y / tile_size.y) * state.tile_stride + tile.x / tile_size.x;
+}
+
+/* Area of the cell of the regular tile grid that contains the tile, cells at the right and top
+ * border of the image can be smaller than the tile size. */
+int TileManager::tile_grid_cell_area(const Tile &tile)
+{
+  int x = (tile.x / tile_size.x) * tile_size.x;
+  int y = (tile.y / tile_size.y) * tile_size.y;
+  return min(tile_size.x, state.buffer.width - x) * min(tile_size.y, state.buffer.height - y);
+}
+
+double TileManager::estimate_tile_cost(const Tile &tile)
+{
+  double cost = tile.w * tile.h;
+  if (tile_cost_stride == state.tile_stride &&
+      tile_cost_estimates.size() == state.tile_times.size()) {
+    cost *= tile_cost_estimates[tile_grid_index(tile)];
+  }
+  return cost;
+}
+
+void TileManager::update_tile_cost_estimates()
+{
+  /* Only keep the times of passes where every tile was rendered, the times of a cancelled pass
+   * would make the skipped tiles look cheap. */
+  if (state.tile_times.empty()) {
+    return;
+  }
+  foreach (double time, state.tile_times) {
+    if (time == 0.0) {
+      state.tile_times.assign(state.tile_times.size(), 0.0);
+      return;
+    }
+  }
+
+  tile_cost_estimates.swap(state.tile_times);
+  tile_cost_stride = state.tile_stride;
+  state.tile_times.assign(state.tile_times.size(), 0.0);
+}
+
+/* Towards the end of a pass there are fewer tiles left than threads, and threads which run out
+ * of tiles sit idle until the last ones finish. Hand out the most expensive of the remaining
+ * tiles first and split it in half, so that another thread can pick up the other half. */
+int TileManager::next_split_tile(list<int> &tiles)
+{
+  list<int>::iterator best_it = tiles.begin();
+  double best_cost = estimate_tile_cost(state.tiles[*best_it]);
+  for (list<int>::iterator it = ++tiles.begin(); it != tiles.end(); it++) {
+    double cost = estimate_tile_cost(state.tiles[*it]);
+    if (cost > best_cost) {
+      best_it = it;
+      best_cost = cost;
+    }
+  }
+
+  int tile_index = *best_it;
+  tiles.erase(best_it);
+
+  Tile &tile = state.tiles[tile_index];
+  const bool split_x = tile.w >= tile.h;
+  const int size = split_x ? tile.w : tile.h;
+
+  /* Never grow past the reserved size, that would invalidate tiles which are being rendered. */
+  if (size < 2 * MIN_SPLIT_TILE_SIZE || state.tiles.size() == state.tiles.capacity()) {
+    return tile_index;
+  }
+
+  Tile split = tile;
+  split.index = state.tiles.size();
+  split.start_time = 0.0;
+  if (split_x) {
+    tile.w = size / 2;
+    split.x += tile.w;
+    split.w = size - tile.w;
+  }
+  else {
+    tile.h = size / 2;
+    split.y += tile.h;
+    split.h = size - tile.h;
+  }
+
+  state.tiles.push_back(split);
+  tiles.push_front(split.index);
+  state.num_tiles++;
+  state.num_split_tiles++;
+
+  return tile_index;
 }
 
 int TileManager::get_neighbor_index(int index, int neighbor)
@@ -447,6 +579,12 @@ bool TileManager::finish_tile(const int index, const bool need_denoise, bool &de
 
   switch (state.tiles[index].state) {
     case Tile::RENDER: {
+      const Tile &tile = state.tiles[index];
+      if (background && tile.start_time > 0.0) {
+        state.tile_times[tile_grid_index(tile)] += (time_dt() - tile.start_time) /
+                                                   tile_grid_cell_area(tile);
+      }
+
       if (!(schedule_denoising && need_denoise)) {
         state.tiles[index].state = Tile::DONE;
         delete_tile = !progressive;
@@ -542,13 +680,20 @@ bool TileManager::next_tile(Tile *&tile, int device, uint tile_types)
         }
       }
 
-      tile_index = state.render_tiles[logical_device].front();
-      state.render_tiles[logical_device].pop_front();
+      list<int> &tiles = state.render_tiles[logical_device];
+      if ((int)tiles.size() < split_num_workers && use_tile_splitting()) {
+        tile_index = next_split_tile(tiles);
+      }
+      else {
+        tile_index = tiles.front();
+        tiles.pop_front();
+      }
       break;
     }
 
     if (tile_index >= 0) {
       tile = &state.tiles[tile_index];
+      tile->start_time = time_dt();
       return true;
     }
   }
@@ -39,13 +39,23 @@ class Tile {
   typedef enum { RENDER = 0, RENDERED, DENOISE, DENOISED, DONE } State;
   State state;
   RenderBuffers *buffers;
+  /* Time at which rendering of the tile started, to estimate tile costs for the next pass. */
+  double start_time;
 
   Tile()
   {
   }
 
   Tile(int index_, int x_, int y_, int w_, int h_, int device_, State state_ = RENDER)
-      : index(index_), x(x_), y(y_), w(w_), h(h_), device(device_), state(state_), buffers(NULL)
+      : index(index_),
+        x(x_),
+        y(y_),
+        w(w_),
+        h(h_),
+        device(device_),
+        state(state_),
+        buffers(NULL),
+        start_time(0.0)
   {
   }
 };
@@ -77,6 +87,13 @@ class TileManager {
     int resolution_divider;
     int num_tiles;
 
+    /* Number of tiles created by splitting tiles at the end of the pass. */
+    int num_split_tiles;
+
+    /* Render time per pixel of the current pass, indexed by position in the regular tile grid,
+     * so that the times of split tiles add up to the tile they were split from. */
+    vector<double> tile_times;
+
     /* Total samples over all pixels: Generally num_samples*num_pixels,
      * but can be higher due to the initial resolution division for previews. */
     uint64_t total_pixel_samples;
@@ -133,6 +150,12 @@ class TileManager {
   /* Schedule tiles for denoising after they've been rendered. */
   bool schedule_denoising;
 
+  /* Split the most expensive of the remaining tiles at the end of a pass, so that threads which
+   * run out of tiles can help finishing the last ones instead of sitting idle. Splitting starts
+   * once fewer tiles than split_num_workers are left. */
+  bool split_tiles;
+  int split_num_workers;
+
  protected:
   void set_tiles();
 
@@ -162,9 +185,21 @@ class TileManager {
    */
   bool background;
 
+  /* Render time per pixel of the previous pass, used to estimate which of the remaining tiles
+   * is the most expensive one when splitting. Only valid while the tile grid is unchanged. */
+  vector<double> tile_cost_estimates;
+  int tile_cost_stride;
+
   /* Generate tile list, return number of tiles. */
   int gen_tiles(bool sliced);
   void gen_render_tiles();
+
+  bool use_tile_splitting();
+  int tile_grid_index(const Tile &tile);
+  int tile_grid_cell_area(const Tile &tile);
+  double estimate_tile_cost(const Tile &tile);
+  void update_tile_cost_estimates();
+  int next_split_tile(list<int> &tiles);
 };
 
 CCL_NAMESPACE_END
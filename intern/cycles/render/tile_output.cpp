@@ -0,0 +1,364 @@
+/*
+ * Copyright 2011-2021 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "render/tile_output.h"
+
+#include "render/film.h"
+
+#include "util/util_foreach.h"
+#include "util/util_logging.h"
+#include "util/util_math.h"
+
+CCL_NAMESPACE_BEGIN
+
+/* Pass Channels */
+
+static bool tile_output_use_pass(const Pass &pass)
+{
+  /* Internal passes that can't be converted to pixels. */
+  if (pass.type == PASS_ADAPTIVE_AUX_BUFFER || pass.type == PASS_SAMPLE_COUNT ||
+      pass.type == PASS_LIGHT || pass.type > PASS_CATEGORY_LIGHT_END) {
+    return false;
+  }
+
+  return pass.components > 0;
+}
+
+static int tile_output_pass_channels(const Pass &pass)
+{
+  /* Match the number of channels Blender uses for render passes, lighting passes are stored
+   * as RGBA in the render buffers but written as RGB. */
+  if (pass.components == 4 && pass.type != PASS_COMBINED && pass.type != PASS_MOTION &&
+      pass.type != PASS_CRYPTOMATTE) {
+    return 3;
+  }
+
+  return pass.components;
+}
+
+static string tile_output_pass_name(const Pass &pass)
+{
+  if (!pass.name.empty()) {
+    return pass.name.string();
+  }
+  else if (pass.type == PASS_COMBINED) {
+    return "Combined";
+  }
+
+  /* Unnamed passes use the identifier of their type, like "diffuse_color". */
+  const NodeEnum *pass_types = Pass::get_node_type()->find_input(ustring("type"))->enum_values;
+  if (pass_types->exists(pass.type)) {
+    return (*pass_types)[pass.type].string();
+  }
+
+  return string_printf("Pass%d", (int)pass.type);
+}
+
+static const char *tile_output_channel_ids(const Pass &pass, int channels)
+{
+  switch (pass.type) {
+    case PASS_DEPTH:
+    case PASS_MIST:
+      return "Z";
+    case PASS_NORMAL:
+      return "XYZ";
+    case PASS_UV:
+      return "UVA";
+    case PASS_MOTION:
+      return "XYZW";
+    default:
+      break;
+  }
+
+  return (channels == 1) ? "X" : "RGBA";
+}
+
+/* Tile Image Output */
+
+TileImageOutput::TileImageOutput()
+    : layer_name("View Layer"),
+      use_half(false),
+      tile_size(make_int2(64, 64)),
+      exposure(1.0f),
+      num_blocks_x(0),
+      num_blocks_y(0)
+{
+}
+
+TileImageOutput::~TileImageOutput()
+{
+  if (out) {
+    close();
+  }
+}
+
+bool TileImageOutput::open(const BufferParams &params_, int samples)
+{
+  if (out) {
+    error = "Output file " + filepath + " is already open";
+    return false;
+  }
+
+  params = params_;
+  pass_indices.clear();
+  pass_channels.clear();
+
+  vector<string> channel_names;
+
+  for (size_t pass_index = 0; pass_index < params.passes.size(); pass_index++) {
+    const Pass &pass = params.passes[pass_index];
+    if (!tile_output_use_pass(pass)) {
+      continue;
+    }
+
+    const int channels = tile_output_pass_channels(pass);
+    const string name = layer_name + "." + tile_output_pass_name(pass) + ".";
+    const char *ids = tile_output_channel_ids(pass, channels);
+
+    for (int i = 0; i < channels; i++) {
+      channel_names.push_back(name + ids[i]);
+    }
+
+    pass_indices.push_back(pass_index);
+    pass_channels.push_back(channels);
+  }
+
+  if (channel_names.empty()) {
+    error = "No passes to write to " + filepath;
+    return false;
+  }
+
+  spec = ImageSpec(params.width,
+                   params.height,
+                   channel_names.size(),
+                   use_half ? TypeDesc::HALF : TypeDesc::FLOAT);
+  spec.channelnames = channel_names;
+
+  /* Render buffers are stored bottom to top, image files top to bottom. */
+  spec.x = params.full_x;
+  spec.y = params.full_height - params.full_y - params.height;
+  spec.full_x = 0;
+  spec.full_y = 0;
+  spec.full_width = params.full_width;
+  spec.full_height = params.full_height;
+
+  spec.tile_width = tile_size.x;
+  spec.tile_height = tile_size.y;
+
+  /* Without random line order OpenEXR keeps tiles that arrive out of order in memory until
+   * all tiles before them are written. */
+  spec.attribute("openexr:lineOrder", "randomY");
+  spec.attribute("compression", "zip");
+  spec.attribute("cycles." + layer_name + ".samples", string_printf("%d", samples));
+
+  out = unique_ptr<ImageOutput>(ImageOutput::create(filepath));
+  if (!out) {
+    error = "Failed to create image output for " + filepath;
+    return false;
+  }
+
+  if (!out->supports("tiles")) {
+    error = "File format of " + filepath + " does not support tiles";
+    out.reset();
+    return false;
+  }
+
+  if (!out->open(filepath, spec)) {
+    error = "Failed to open file " + filepath + " for writing: " + out->geterror();
+    out.reset();
+    return false;
+  }
+
+  num_blocks_x = divide_up(spec.width, spec.tile_width);
+  num_blocks_y = divide_up(spec.height, spec.tile_height);
+  blocks.clear();
+  blocks_written.clear();
+  blocks_written.resize(num_blocks_x * num_blocks_y, false);
+
+  VLOG(1) << "Streaming " << spec.nchannels << " channels of " << params.width << "x"
+          << params.height << " tiles to " << filepath;
+
+  return true;
+}
+
+void TileImageOutput::block_bounds(int index, int &x, int &y, int &w, int &h) const
+{
+  x = (index % num_blocks_x) * spec.tile_width;
+  y = (index / num_blocks_x) * spec.tile_height;
+  w = min(spec.tile_width, spec.width - x);
+  h = min(spec.tile_height, spec.height - y);
+}
+
+bool TileImageOutput::write_block(int index, const Block &block)
+{
+  int x, y, w, h;
+  block_bounds(index, x, y, w, h);
+
+  /* Pixels are always passed as float, OpenImageIO converts them to half with rounding when
+   * the file stores half. */
+  if (!out->write_tile(spec.x + x, spec.y + y, 0, TypeDesc::FLOAT, block.pixels.data())) {
+    error = "Failed to write tile to file " + filepath + ": " + out->geterror();
+    return false;
+  }
+
+  blocks_written[index] = true;
+  return true;
+}
+
+bool TileImageOutput::write_tile(RenderTile &rtile)
+{
+  if (!out) {
+    return false;
+  }
+
+  /* Convert passes of the tile to interleaved channels, this does not need the lock. The tile
+   * may be part of a bigger buffer when not rendering with separate tile buffers. */
+  RenderBuffers *buffers = rtile.buffers;
+  const BufferParams &buffer_params = buffers->params;
+  const int buffer_x = rtile.x - buffer_params.full_x;
+  const int buffer_y = rtile.y - buffer_params.full_y;
+  const int num_channels = spec.nchannels;
+
+  vector<float> tile_pixels((size_t)rtile.w * rtile.h * num_channels, 0.0f);
+  vector<float> pass_pixels;
+
+  int channel_offset = 0;
+  for (size_t i = 0; i < pass_indices.size(); i++) {
+    const int channels = pass_channels[i];
+
+    /* Look up by index, built-in passes have no name. */
+    pass_pixels.resize((size_t)buffer_params.width * buffer_params.height * channels);
+    if (buffers->get_pass_rect(
+            pass_indices[i], exposure, rtile.sample, channels, pass_pixels.data())) {
+      for (int y = 0; y < rtile.h; y++) {
+        const float *in = pass_pixels.data() +
+                          ((size_t)(buffer_y + y) * buffer_params.width + buffer_x) * channels;
+        float *out_pixels = tile_pixels.data() + (size_t)y * rtile.w * num_channels +
+                            channel_offset;
+        for (int x = 0; x < rtile.w; x++, in += channels, out_pixels += num_channels) {
+          for (int c = 0; c < channels; c++) {
+            out_pixels[c] = in[c];
+          }
+        }
+      }
+    }
+
+    channel_offset += channels;
+  }
+
+  /* Copy into the file tiles overlapping the render tile, writing out those that are complete.
+   * Render tiles are usually aligned with file tiles, but not at the top of the image or when
+   * tiles were split. */
+  const int tile_x = rtile.x - params.full_x;
+  const int tile_y = params.height - (rtile.y - params.full_y) - rtile.h;
+
+  thread_scoped_lock lock(mutex);
+
+  const int block_x_begin = tile_x / spec.tile_width;
+  const int block_x_end = (tile_x + rtile.w - 1) / spec.tile_width;
+  const int block_y_begin = tile_y / spec.tile_height;
+  const int block_y_end = (tile_y + rtile.h - 1) / spec.tile_height;
+
+  for (int block_y = block_y_begin; block_y <= block_y_end; block_y++) {
+    for (int block_x = block_x_begin; block_x <= block_x_end; block_x++) {
+      const int index = block_y * num_blocks_x + block_x;
+      int x, y, w, h;
+      block_bounds(index, x, y, w, h);
+
+      Block &block = blocks[index];
+      if (block.pixels.empty()) {
+        block.pixels.resize((size_t)spec.tile_width * spec.tile_height * num_channels, 0.0f);
+        block.num_pixels_written = 0;
+      }
+
+      const int x_begin = max(x, tile_x);
+      const int x_end = min(x + w, tile_x + rtile.w);
+      const int y_begin = max(y, tile_y);
+      const int y_end = min(y + h, tile_y + rtile.h);
+      const int row_size = (x_end - x_begin) * num_channels;
+
+      for (int file_y = y_begin; file_y < y_end; file_y++) {
+        /* Flip rows, the first file row of the tile is its last render buffer row. */
+        const int row = tile_y + rtile.h - 1 - file_y;
+        const float *in = tile_pixels.data() +
+                          ((size_t)row * rtile.w + (x_begin - tile_x)) * num_channels;
+        const size_t offset = ((size_t)(file_y - y) * spec.tile_width + (x_begin - x)) *
+                              num_channels;
+        memcpy(block.pixels.data() + offset, in, sizeof(float) * row_size);
+      }
+
+      block.num_pixels_written += (x_end - x_begin) * (y_end - y_begin);
+
+      if (block.num_pixels_written >= w * h) {
+        const bool ok = write_block(index, block);
+        blocks.erase(index);
+        if (!ok) {
+          return false;
+        }
+      }
+    }
+  }
+
+  return true;
+}
+
+bool TileImageOutput::close()
+{
+  if (!out) {
+    return false;
+  }
+
+  thread_scoped_lock lock(mutex);
+
+  /* Write tiles that were not completely rendered, for example after cancelling, so the file
+   * has no missing tiles. */
+  bool ok = true;
+  Block empty_block;
+  empty_block.num_pixels_written = 0;
+
+  for (int index = 0; index < num_blocks_x * num_blocks_y && ok; index++) {
+    if (blocks_written[index]) {
+      continue;
+    }
+
+    map<int, Block>::iterator it = blocks.find(index);
+    if (it != blocks.end()) {
+      ok = write_block(index, it->second);
+      continue;
+    }
+
+    if (empty_block.pixels.empty()) {
+      empty_block.pixels.resize((size_t)spec.tile_width * spec.tile_height * spec.nchannels,
+                                0.0f);
+    }
+
+    ok = write_block(index, empty_block);
+  }
+
+  blocks.clear();
+  blocks_written.clear();
+
+  if (!out->close()) {
+    error = "Failed to save to file " + filepath + ": " + out->geterror();
+    ok = false;
+  }
+
+  out.reset();
+
+  return ok;
+}
+
+CCL_NAMESPACE_END
@@ -0,0 +1,97 @@
+/*
+ * Copyright 2011-2021 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __TILE_OUTPUT_H__
+#define __TILE_OUTPUT_H__
+
+#include "render/buffers.h"
+
+#include "util/util_image.h"
+#include "util/util_map.h"
+#include "util/util_string.h"
+#include "util/util_thread.h"
+#include "util/util_unique_ptr.h"
+#include "util/util_vector.h"
+
+CCL_NAMESPACE_BEGIN
+
+/* Tile Image Output
+ *
+ * Writes finished render tiles straight into a tiled multilayer OpenEXR file,
+ * so the render buffers of a tile can be freed as soon as it is written and
+ * the full frame never has to be resident in memory. Channels are named like
+ * Blender multilayer files, so the result can be read back by ImageMerger. */
+
+class TileImageOutput {
+ public:
+  TileImageOutput();
+  ~TileImageOutput();
+
+  /* Output filepath. */
+  string filepath;
+  /* Render layer name used as channel prefix. */
+  string layer_name;
+  /* Store pixels as half float instead of float. */
+  bool use_half;
+  /* Size of the tiles in the file. */
+  int2 tile_size;
+  /* Exposure applied to passes that use it. */
+  float exposure;
+
+  /* Error message in case of failure. */
+  string error;
+
+  /* Open file for an image with the size and passes of the buffer parameters. */
+  bool open(const BufferParams &params, int samples);
+  /* Convert and write the passes of a tile, render buffers must be copied from the device.
+   * Can be called from multiple threads. */
+  bool write_tile(RenderTile &rtile);
+  /* Write any remaining partially rendered tiles and close the file. */
+  bool close();
+
+  bool is_open() const
+  {
+    return out != NULL;
+  }
+
+ protected:
+  /* Pixels of one file tile, waiting for all render tiles that overlap it. Always the size of
+   * a full tile, as file tiles at the border of the image are still passed in full. */
+  struct Block {
+    vector<float> pixels;
+    int num_pixels_written;
+  };
+
+  void block_bounds(int index, int &x, int &y, int &w, int &h) const;
+  bool write_block(int index, const Block &block);
+
+  unique_ptr<ImageOutput> out;
+  ImageSpec spec;
+  BufferParams params;
+  /* Index in the buffer parameters of passes written to the file, with the number of channels
+   * for each. */
+  vector<int> pass_indices;
+  vector<int> pass_channels;
+  int num_blocks_x;
+  int num_blocks_y;
+  map<int, Block> blocks;
+  vector<bool> blocks_written;
+  thread_mutex mutex;
+};
+
+CCL_NAMESPACE_END
+
+#endif /* __TILE_OUTPUT_H__ */
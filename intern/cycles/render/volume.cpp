@@ -50,11 +50,13 @@ Volume::Volume() : Mesh(get_node_type(), Geometry::VOLUME)
   clipping = 0.001f;
   step_size = 0.0f;
   object_space = false;
+  occupancy_offset = 0;
 }
 
 void Volume::clear(bool preserve_shaders)
 {
   Mesh::clear(preserve_shaders, true);
+  occupancy.clear();
 }
 
 struct QuadData {
@@ -181,6 +183,8 @@ class VolumeMeshBuilder {
                              vector<int> &tris,
                              vector<float3> &face_normals);
 
+  void create_occupancy(VolumeOccupancy &occupancy);
+
   bool empty_grid() const;
 
 #ifdef WITH_OPENVDB
@@ -424,6 +428,78 @@ void VolumeMeshBuilder::convert_quads_to_tris(const vector<QuadData> &quads,
   }
 }
 
+/* Cells are the smallest power of two number of voxels that keeps the bitmask within this
+ * number of cells, but never larger than a leaf node as the mesh already bounds those. */
+#define VOLUME_OCCUPANCY_MIN_CELL_SIZE 2
+#define VOLUME_OCCUPANCY_MAX_CELLS (1 << 26)
+
+void VolumeMeshBuilder::create_occupancy(VolumeOccupancy &occupancy)
+{
+#ifdef WITH_OPENVDB
+  occupancy.clear();
+
+  const openvdb::CoordBBox voxel_bbox = topology_grid->evalActiveVoxelBoundingBox();
+  if (voxel_bbox.empty()) {
+    return;
+  }
+
+  static const int LEAF_DIM = openvdb::MaskGrid::TreeType::LeafNodeType::DIM;
+  const openvdb::Coord dim = voxel_bbox.dim();
+
+  int cell_size = VOLUME_OCCUPANCY_MIN_CELL_SIZE;
+  int3 resolution;
+
+  for (;; cell_size *= 2) {
+    resolution = make_int3(divide_up(dim.x(), cell_size),
+                           divide_up(dim.y(), cell_size),
+                           divide_up(dim.z(), cell_size));
+
+    const size_t num_cells = (size_t)resolution.x * resolution.y * resolution.z;
+    if (num_cells <= VOLUME_OCCUPANCY_MAX_CELLS) {
+      break;
+    }
+
+    if (cell_size >= LEAF_DIM) {
+      /* Not worth storing at a resolution the bounds mesh already has. */
+      return;
+    }
+  }
+
+  const size_t num_cells = (size_t)resolution.x * resolution.y * resolution.z;
+  occupancy.bits.resize(divide_up(num_cells, 32), 0);
+  occupancy.resolution = resolution;
+
+  const openvdb::Coord min = voxel_bbox.min();
+
+  for (auto leaf = topology_grid->tree().cbeginLeaf(); leaf; ++leaf) {
+    for (auto iter = leaf->cbeginValueOn(); iter; ++iter) {
+      const openvdb::Coord co = iter.getCoord() - min;
+      const size_t index = (size_t)(co.x() / cell_size) +
+                           resolution.x * ((size_t)(co.y() / cell_size) +
+                                           resolution.y * (size_t)(co.z() / cell_size));
+      occupancy.bits[index >> 5] |= (1u << (index & 31));
+    }
+  }
+
+  /* Same index to object space transform as the mesh vertices, voxel i spans [i, i + 1). */
+  openvdb::math::Mat4f grid_matrix =
+      topology_grid->transform().baseMap()->getAffineMap()->getMat4();
+  Transform index_to_object;
+  for (int col = 0; col < 4; col++) {
+    for (int row = 0; row < 3; row++) {
+      index_to_object[row][col] = (float)grid_matrix[col][row];
+    }
+  }
+
+  const float inv_cell_size = 1.0f / cell_size;
+  occupancy.object_to_cell = transform_scale(inv_cell_size, inv_cell_size, inv_cell_size) *
+                             transform_translate(-min.x(), -min.y(), -min.z()) *
+                             transform_inverse(index_to_object);
+#else
+  (void)occupancy;
+#endif
+}
+
 bool VolumeMeshBuilder::empty_grid() const
 {
 #ifdef WITH_OPENVDB
@@ -605,6 +681,12 @@ void GeometryManager::create_volume_mesh(Volume *volume, Progress &progress)
   vector<float3> face_normals;
   builder.create_mesh(vertices, indices, face_normals, face_overlap_avoidance);
 
+  /* Empty space inside the mesh can only be skipped if density comes from the voxel grids,
+   * not from other spatially varying nodes. */
+  if (!volume_shader->has_volume_spatial_varying) {
+    builder.create_occupancy(volume->occupancy);
+  }
+
   volume->reserve_mesh(vertices.size(), indices.size() / 3);
   volume->used_shaders.clear();
   volume->used_shaders.push_back_slow(volume_shader);
@@ -630,6 +712,42 @@ void GeometryManager::create_volume_mesh(Volume *volume, Progress &progress)
               indices.size() * sizeof(int)) /
                  (1024.0 * 1024.0)
           << "Mb.";
+  VLOG(1) << "Memory usage volume occupancy: "
+          << (volume->occupancy.bits.size() * sizeof(uint)) / (1024.0 * 1024.0) << "Mb.";
+}
+
+void GeometryManager::device_update_volume_occupancy(DeviceScene *dscene, Scene *scene)
+{
+  if (!dscene->volume_occupancy.need_realloc()) {
+    return;
+  }
+
+  size_t size = 0;
+
+  foreach (Geometry *geom, scene->geometry) {
+    if (geom->geometry_type == Geometry::VOLUME) {
+      Volume *volume = static_cast<Volume *>(geom);
+      volume->occupancy_offset = size;
+      size += volume->occupancy.bits.size();
+    }
+  }
+
+  if (size == 0) {
+    return;
+  }
+
+  uint *occupancy = dscene->volume_occupancy.alloc(size);
+
+  foreach (Geometry *geom, scene->geometry) {
+    if (geom->geometry_type == Geometry::VOLUME) {
+      Volume *volume = static_cast<Volume *>(geom);
+      std::copy(volume->occupancy.bits.begin(),
+                volume->occupancy.bits.end(),
+                occupancy + volume->occupancy_offset);
+    }
+  }
+
+  dscene->volume_occupancy.copy_to_device();
 }
 
 CCL_NAMESPACE_END
@@ -22,6 +22,26 @@
 
 CCL_NAMESPACE_BEGIN
 
+/* Coarse bitmask of cells of the voxel grids that contain active voxels, built from the same
+ * topology as the volume bounds mesh. Used by the kernel to skip empty space inside the mesh. */
+struct VolumeOccupancy {
+  vector<uint> bits;
+  int3 resolution;
+  /* Transform from object space to cell coordinates. */
+  Transform object_to_cell;
+
+  bool empty() const
+  {
+    return bits.empty();
+  }
+
+  void clear()
+  {
+    bits.clear();
+    bits.shrink_to_fit();
+  }
+};
+
 class Volume : public Mesh {
  public:
   NODE_DECLARE
@@ -32,6 +52,9 @@ class Volume : public Mesh {
   NODE_SOCKET_API(float, step_size)
   NODE_SOCKET_API(bool, object_space)
 
+  VolumeOccupancy occupancy;
+  size_t occupancy_offset;
+
   virtual void clear(bool preserve_shaders = false) override;
 };
 
@@ -20,6 +20,12 @@
 #include "subd/subd_dice.h"
 #include "subd/subd_patch.h"
 
+#include "util/util_foreach.h"
+#include "util/util_hash.h"
+#include "util/util_logging.h"
+#include "util/util_murmurhash.h"
+#include "util/util_tbb.h"
+
 CCL_NAMESPACE_BEGIN
 
 /* EdgeDice Base */
@@ -45,8 +51,13 @@ void EdgeDice::reserve(int num_verts, int num_triangles)
   vert_offset = mesh->get_verts().size();
   tri_offset = mesh->num_triangles();
 
-  mesh->resize_mesh(mesh->get_verts().size() + num_verts, mesh->num_triangles());
-  mesh->reserve_mesh(mesh->get_verts().size() + num_verts, mesh->num_triangles() + num_triangles);
+  /* Triangles are written in place, so dicing of subpatches can run in parallel. */
+  mesh->resize_mesh(vert_offset + num_verts, tri_offset + num_triangles);
+
+  mesh->tag_triangles_modified();
+  mesh->tag_shader_modified();
+  mesh->tag_smooth_modified();
+  mesh->tag_triangle_patch_modified();
 
   Attribute *attr_vN = mesh->attributes.add(ATTR_STD_VERTEX_NORMAL);
 
@@ -69,17 +80,22 @@ void EdgeDice::set_vert(Patch *patch, int index, float2 uv)
   params.mesh->vert_patch_uv[index + vert_offset] = make_float2(uv.x, uv.y);
 }
 
-void EdgeDice::add_triangle(Patch *patch, int v0, int v1, int v2)
+void EdgeDice::set_triangle(Patch *patch, int index, int v0, int v1, int v2)
 {
   Mesh *mesh = params.mesh;
+  const size_t tri = tri_offset + index;
 
-  mesh->add_triangle(v0 + vert_offset, v1 + vert_offset, v2 + vert_offset, patch->shader, true);
-  params.mesh->triangle_patch[params.mesh->num_triangles() - 1] = patch->patch_index;
+  assert(tri < mesh->num_triangles());
 
-  tri_offset++;
+  mesh->triangles[tri * 3 + 0] = v0 + vert_offset;
+  mesh->triangles[tri * 3 + 1] = v1 + vert_offset;
+  mesh->triangles[tri * 3 + 2] = v2 + vert_offset;
+  mesh->shader[tri] = patch->shader;
+  mesh->smooth[tri] = true;
+  mesh->triangle_patch[tri] = patch->patch_index;
 }
 
-void EdgeDice::stitch_triangles(Subpatch &sub, int edge)
+void EdgeDice::stitch_triangles(Subpatch &sub, int edge, int &tri_index)
 {
   int Mu = max(sub.edge_u0.T, sub.edge_u1.T);
   int Mv = max(sub.edge_v0.T, sub.edge_v1.T);
@@ -122,8 +138,145 @@ void EdgeDice::stitch_triangles(Subpatch &sub, int edge)
         v2 = sub.get_vert_along_grid_edge(edge, ++i);
     }
 
-    add_triangle(sub.patch, v1, v0, v2);
+    set_triangle(sub.patch, tri_index++, v1, v0, v2);
+  }
+}
+
+
+/* Hash of the control mesh the patches are evaluated from. */
+static uint dice_cache_control_hash(Mesh *mesh, size_t num_control_verts)
+{
+  uint hash = hash_uint2(num_control_verts, mesh->get_subdivision_type());
+
+  const array<float3> &verts = mesh->get_verts();
+  for (size_t i = 0; i < num_control_verts; i++) {
+    hash = hash_uint4(
+        __float_as_uint(verts[i].x), __float_as_uint(verts[i].y), __float_as_uint(verts[i].z), hash);
+  }
+
+  Attribute *attr_vN = mesh->subd_attributes.find(ATTR_STD_VERTEX_NORMAL);
+  if (attr_vN) {
+    const float3 *vN = attr_vN->data_float3();
+    for (size_t i = 0; i < num_control_verts; i++) {
+      hash = hash_uint4(
+          __float_as_uint(vN[i].x), __float_as_uint(vN[i].y), __float_as_uint(vN[i].z), hash);
+    }
+  }
+
+  const array<int> *int_arrays[] = {&mesh->get_subd_start_corner(),
+                                    &mesh->get_subd_num_corners(),
+                                    &mesh->get_subd_shader(),
+                                    &mesh->get_subd_ptex_offset(),
+                                    &mesh->get_subd_face_corners(),
+                                    &mesh->get_subd_creases_edge()};
+  for (const array<int> *data : int_arrays) {
+    hash = util_murmur_hash3(data->data(), data->size() * sizeof(int), hash);
+  }
+
+  const array<bool> &smooth = mesh->get_subd_smooth();
+  hash = util_murmur_hash3(smooth.data(), smooth.size() * sizeof(bool), hash);
+
+  const array<float> &creases_weight = mesh->get_subd_creases_weight();
+  hash = util_murmur_hash3(creases_weight.data(), creases_weight.size() * sizeof(float), hash);
+
+  return hash;
+}
+
+bool EdgeDice::load_cache(const vector<Subpatch> &subpatches)
+{
+  Mesh *mesh = params.mesh;
+
+  if (!params.use_dice_cache) {
+    delete mesh->dice_cache;
+    mesh->dice_cache = NULL;
+    return false;
+  }
+
+  /* Patches are evaluated from the control mesh, the edge factors depend on the dicing camera
+   * and parameters. Vertex and triangle offsets follow from the edge factors. */
+  cache_control_hash = dice_cache_control_hash(mesh, vert_offset);
+
+  /* Patch index and shader, and four values for each corner. */
+  const int subpatch_key_size = 2 + 4 * 4;
+  cache_subpatch_key.clear();
+  cache_subpatch_key.reserve(subpatches.size() * subpatch_key_size);
+
+  foreach (const Subpatch &sub, subpatches) {
+    cache_subpatch_key.push_back(sub.patch->patch_index);
+    cache_subpatch_key.push_back(sub.patch->shader);
+
+    for (int i = 0; i < 4; i++) {
+      cache_subpatch_key.push_back(__float_as_int(sub.corners[i].x));
+      cache_subpatch_key.push_back(__float_as_int(sub.corners[i].y));
+      cache_subpatch_key.push_back(sub.edges[i].T);
+      cache_subpatch_key.push_back(sub.get_vert_along_edge(i, 0));
+    }
+  }
+
+  DiceCache *cache = mesh->dice_cache;
+  const size_t num_verts = mesh->verts.size() - vert_offset;
+  const size_t num_triangles = mesh->num_triangles() - tri_offset;
+
+  if (!(cache && cache->control_hash == cache_control_hash &&
+        cache->subpatch_key == cache_subpatch_key && cache->P.size() == num_verts &&
+        cache->shader.size() == num_triangles)) {
+    return false;
   }
+
+  Attribute *attr_vN = mesh->attributes.find(ATTR_STD_VERTEX_NORMAL);
+
+  std::copy(cache->P.begin(), cache->P.end(), mesh->verts.begin() + vert_offset);
+  std::copy(cache->N.begin(), cache->N.end(), attr_vN->data_float3() + vert_offset);
+  std::copy(
+      cache->patch_uv.begin(), cache->patch_uv.end(), mesh->vert_patch_uv.begin() + vert_offset);
+
+  std::copy(
+      cache->triangles.begin(), cache->triangles.end(), mesh->triangles.begin() + tri_offset * 3);
+  std::copy(cache->shader.begin(), cache->shader.end(), mesh->shader.begin() + tri_offset);
+  std::fill(mesh->smooth.begin() + tri_offset, mesh->smooth.end(), true);
+  std::copy(cache->triangle_patch.begin(),
+            cache->triangle_patch.end(),
+            mesh->triangle_patch.begin() + tri_offset);
+
+  VLOG(1) << "Reused diced geometry for mesh " << mesh->name << ", " << num_triangles
+          << " triangles.";
+
+  return true;
+}
+
+template<typename T> static void dice_cache_copy(array<T> &dst, const T *src, size_t size)
+{
+  dst.resize(size);
+  std::copy(src, src + size, dst.data());
+}
+
+void EdgeDice::store_cache()
+{
+  Mesh *mesh = params.mesh;
+
+  if (!params.use_dice_cache) {
+    return;
+  }
+
+  if (!mesh->dice_cache) {
+    mesh->dice_cache = new DiceCache();
+  }
+
+  DiceCache *cache = mesh->dice_cache;
+  const size_t num_verts = mesh->verts.size() - vert_offset;
+  const size_t num_triangles = mesh->num_triangles() - tri_offset;
+
+  cache->control_hash = cache_control_hash;
+  cache->subpatch_key.swap(cache_subpatch_key);
+
+  dice_cache_copy(cache->P, mesh_P, num_verts);
+  dice_cache_copy(cache->N, mesh_N, num_verts);
+  dice_cache_copy(cache->patch_uv, mesh->vert_patch_uv.data() + vert_offset, num_verts);
+
+  dice_cache_copy(cache->triangles, mesh->triangles.data() + tri_offset * 3, num_triangles * 3);
+  dice_cache_copy(cache->shader, mesh->shader.data() + tri_offset, num_triangles);
+  dice_cache_copy(
+      cache->triangle_patch, mesh->triangle_patch.data() + tri_offset, num_triangles);
 }
 
 /* QuadDice */
@@ -157,12 +310,22 @@ void QuadDice::set_vert(Subpatch &sub, int index, float u, float v)
   EdgeDice::set_vert(sub.patch, index, map_uv(sub, u, v));
 }
 
-void QuadDice::set_side(Subpatch &sub, int edge)
+void QuadDice::set_side(Subpatch &sub,
+                        int edge,
+                        int sub_index,
+                        const vector<int> &edge_vert_owner)
 {
   int t = sub.edges[edge].T;
 
   /* set verts on the edge of the patch */
   for (int i = 0; i < t; i++) {
+    int index = sub.get_vert_along_edge(edge, i);
+
+    /* Verts are shared with adjacent subpatches, only one of them evaluates it. */
+    if (edge_vert_owner[index] != sub_index) {
+      continue;
+    }
+
     float f = i / (float)t;
 
     float u, v;
@@ -186,7 +349,7 @@ void QuadDice::set_side(Subpatch &sub, int edge)
         break;
     }
 
-    set_vert(sub, sub.get_vert_along_edge(edge, i), u, v);
+    set_vert(sub, index, u, v);
   }
 }
 
@@ -224,7 +387,7 @@ float QuadDice::scale_factor(Subpatch &sub, int Mu, int Mv)
   return S;
 }
 
-void QuadDice::add_grid(Subpatch &sub, int Mu, int Mv, int offset)
+void QuadDice::set_grid(Subpatch &sub, int Mu, int Mv, int offset)
 {
   /* create inner grid */
   float du = 1.0f / (float)Mu;
@@ -236,25 +399,30 @@ void QuadDice::add_grid(Subpatch &sub, int Mu, int Mv, int offset)
       float v = j * dv;
 
       set_vert(sub, offset + (i - 1) + (j - 1) * (Mu - 1), u, v);
+    }
+  }
+}
 
-      if (i < Mu - 1 && j < Mv - 1) {
-        int i1 = offset + (i - 1) + (j - 1) * (Mu - 1);
-        int i2 = offset + i + (j - 1) * (Mu - 1);
-        int i3 = offset + i + j * (Mu - 1);
-        int i4 = offset + (i - 1) + j * (Mu - 1);
-
-        add_triangle(sub.patch, i1, i2, i3);
-        add_triangle(sub.patch, i1, i3, i4);
-      }
+void QuadDice::add_grid(Subpatch &sub, int Mu, int Mv, int offset, int &tri_index)
+{
+  for (int j = 1; j < Mv - 1; j++) {
+    for (int i = 1; i < Mu - 1; i++) {
+      int i1 = offset + (i - 1) + (j - 1) * (Mu - 1);
+      int i2 = offset + i + (j - 1) * (Mu - 1);
+      int i3 = offset + i + j * (Mu - 1);
+      int i4 = offset + (i - 1) + j * (Mu - 1);
+
+      set_triangle(sub.patch, tri_index++, i1, i2, i3);
+      set_triangle(sub.patch, tri_index++, i1, i3, i4);
     }
   }
 }
 
-void QuadDice::dice(Subpatch &sub)
+void QuadDice::grid_size(Subpatch &sub, int &Mu, int &Mv)
 {
   /* compute inner grid size with scale factor */
-  int Mu = max(sub.edge_u0.T, sub.edge_u1.T);
-  int Mv = max(sub.edge_v0.T, sub.edge_v1.T);
+  Mu = max(sub.edge_u0.T, sub.edge_u1.T);
+  Mv = max(sub.edge_v0.T, sub.edge_v1.T);
 
 #if 0 /* Doesn't work very well, especially at grazing angles. */
   float S = scale_factor(sub, ef, Mu, Mv);
@@ -264,20 +432,81 @@ void QuadDice::dice(Subpatch &sub)
 
   Mu = max((int)ceilf(S * Mu), 2);  // XXX handle 0 & 1?
   Mv = max((int)ceilf(S * Mv), 2);  // XXX handle 0 & 1?
+}
+
+void QuadDice::dice_verts(Subpatch &sub, int sub_index, const vector<int> &edge_vert_owner)
+{
+  int Mu, Mv;
+  grid_size(sub, Mu, Mv);
 
   /* inner grid */
-  add_grid(sub, Mu, Mv, sub.inner_grid_vert_offset);
+  set_grid(sub, Mu, Mv, sub.inner_grid_vert_offset);
 
   /* sides */
-  set_side(sub, 0);
-  set_side(sub, 1);
-  set_side(sub, 2);
-  set_side(sub, 3);
-
-  stitch_triangles(sub, 0);
-  stitch_triangles(sub, 1);
-  stitch_triangles(sub, 2);
-  stitch_triangles(sub, 3);
+  set_side(sub, 0, sub_index, edge_vert_owner);
+  set_side(sub, 1, sub_index, edge_vert_owner);
+  set_side(sub, 2, sub_index, edge_vert_owner);
+  set_side(sub, 3, sub_index, edge_vert_owner);
+}
+
+void QuadDice::dice_triangles(Subpatch &sub)
+{
+  int Mu, Mv;
+  grid_size(sub, Mu, Mv);
+
+  int tri_index = sub.triangle_offset;
+
+  add_grid(sub, Mu, Mv, sub.inner_grid_vert_offset, tri_index);
+
+  stitch_triangles(sub, 0, tri_index);
+  stitch_triangles(sub, 1, tri_index);
+  stitch_triangles(sub, 2, tri_index);
+  stitch_triangles(sub, 3, tri_index);
+
+  assert(tri_index == sub.triangle_offset + sub.calc_num_triangles());
+}
+
+void QuadDice::dice(vector<Subpatch> &subpatches, int num_edge_verts)
+{
+  if (load_cache(subpatches)) {
+    return;
+  }
+
+  /* Verts on the edges of subpatches are evaluated by the last subpatch using them, same as
+   * when dicing serially, so the result does not depend on scheduling. */
+  vector<int> edge_vert_owner(num_edge_verts, -1);
+
+  for (size_t i = 0; i < subpatches.size(); i++) {
+    const Subpatch &sub = subpatches[i];
+
+    for (int edge = 0; edge < 4; edge++) {
+      for (int j = 0; j < sub.edges[edge].T; j++) {
+        int index = sub.get_vert_along_edge(edge, j);
+        assert(index < num_edge_verts);
+        edge_vert_owner[index] = i;
+      }
+    }
+  }
+
+  /* Evaluate all verts first, stitching of triangles along the edges compares the positions of
+   * verts evaluated by adjacent subpatches. */
+  static const int SUBPATCHES_PER_TASK = 16;
+
+  parallel_for(blocked_range<size_t>(0, subpatches.size(), SUBPATCHES_PER_TASK),
+               [&](const blocked_range<size_t> &r) {
+                 for (size_t i = r.begin(); i != r.end(); i++) {
+                   dice_verts(subpatches[i], i, edge_vert_owner);
+                 }
+               });
+
+  parallel_for(blocked_range<size_t>(0, subpatches.size(), SUBPATCHES_PER_TASK),
+               [&](const blocked_range<size_t> &r) {
+                 for (size_t i = r.begin(); i != r.end(); i++) {
+                   dice_triangles(subpatches[i]);
+                 }
+               });
+
+  store_cache();
 }
 
 CCL_NAMESPACE_END
@@ -22,6 +22,7 @@
  * DiagSplit. For more algorithm details, see the DiagSplit paper or the
  * ARB_tessellation_shader OpenGL extension, Section 2.X.2. */
 
+#include "util/util_array.h"
 #include "util/util_types.h"
 #include "util/util_vector.h"
 
@@ -44,6 +45,10 @@ struct SubdParams {
   Camera *camera;
   Transform objecttoworld;
 
+  /* Keep diced geometry in the mesh to skip dicing when tessellating again with the same
+   * patches and edge factors. */
+  bool use_dice_cache;
+
   SubdParams(Mesh *mesh_, bool ptex_ = false)
   {
     mesh = mesh_;
@@ -54,9 +59,34 @@ struct SubdParams {
     dicing_rate = 1.0f;
     max_level = 12;
     camera = NULL;
+    use_dice_cache = false;
   }
 };
 
+/* Dice Cache
+ *
+ * Diced geometry of a mesh along with the key it was diced for. The key covers the control
+ * mesh and the patch, corners and edge factors of every subpatch, so it only matches when the
+ * dicing camera and parameters produce the same tessellation.
+ *
+ * The cache is a full copy of the diced mesh: 40 bytes per vertex and 20 bytes per triangle,
+ * plus 72 bytes per subpatch for the key. It is only kept for meshes with adaptive subdivision
+ * in interactive sessions, where edits re-tessellate them, and freed as soon as a mesh is
+ * tessellated without it. */
+
+struct DiceCache {
+  uint control_hash;
+  vector<int> subpatch_key;
+
+  array<float3> P;
+  array<float3> N;
+  array<float2> patch_uv;
+
+  array<int> triangles;
+  array<int> shader;
+  array<int> triangle_patch;
+};
+
 /* EdgeDice Base */
 
 class EdgeDice {
@@ -72,9 +102,16 @@ class EdgeDice {
   void reserve(int num_verts, int num_triangles);
 
   void set_vert(Patch *patch, int index, float2 uv);
-  void add_triangle(Patch *patch, int v0, int v1, int v2);
+  void set_triangle(Patch *patch, int index, int v0, int v1, int v2);
+
+  void stitch_triangles(Subpatch &sub, int edge, int &tri_index);
 
-  void stitch_triangles(Subpatch &sub, int edge);
+  bool load_cache(const vector<Subpatch> &subpatches);
+  void store_cache();
+
+ protected:
+  uint cache_control_hash;
+  vector<int> cache_subpatch_key;
 };
 
 /* Quad EdgeDice */
@@ -88,14 +125,20 @@ class QuadDice : public EdgeDice {
   float2 map_uv(Subpatch &sub, float u, float v);
   void set_vert(Subpatch &sub, int index, float u, float v);
 
-  void add_grid(Subpatch &sub, int Mu, int Mv, int offset);
+  void set_grid(Subpatch &sub, int Mu, int Mv, int offset);
+  void add_grid(Subpatch &sub, int Mu, int Mv, int offset, int &tri_index);
 
-  void set_side(Subpatch &sub, int edge);
+  void set_side(Subpatch &sub, int edge, int sub_index, const vector<int> &edge_vert_owner);
 
   float quad_area(const float3 &a, const float3 &b, const float3 &c, const float3 &d);
   float scale_factor(Subpatch &sub, int Mu, int Mv);
+  void grid_size(Subpatch &sub, int &Mu, int &Mv);
+
+  void dice_verts(Subpatch &sub, int sub_index, const vector<int> &edge_vert_owner);
+  void dice_triangles(Subpatch &sub);
 
-  void dice(Subpatch &sub);
+  /* Dice all subpatches, vertices [0, num_edge_verts) are those on subpatch edges. */
+  void dice(vector<Subpatch> &subpatches, int num_edge_verts);
 };
 
 CCL_NAMESPACE_END
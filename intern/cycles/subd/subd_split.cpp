@@ -25,6 +25,7 @@
 #include "util/util_foreach.h"
 #include "util/util_hash.h"
 #include "util/util_math.h"
+#include "util/util_tbb.h"
 #include "util/util_types.h"
 
 CCL_NAMESPACE_BEGIN
@@ -339,23 +340,71 @@ Edge *DiagSplit::alloc_edge()
 
 void DiagSplit::split_patches(Patch *patches, size_t patches_byte_stride)
 {
+  const int num_faces = params.mesh->get_num_subd_faces();
+
+  /* Index of the first patch of each face. */
+  vector<int> face_patch_index(num_faces);
   int patch_index = 0;
 
-  for (int f = 0; f < params.mesh->get_num_subd_faces(); f++) {
+  for (int f = 0; f < num_faces; f++) {
     Mesh::SubdFace face = params.mesh->get_subd_face(f);
 
-    Patch *patch = (Patch *)(((char *)patches) + patch_index * patches_byte_stride);
+    face_patch_index[f] = patch_index;
+    patch_index += (face.is_quad()) ? 1 : face.num_corners;
+  }
+
+  /* Edges and vertices are never shared between faces, stitching across faces is done through
+   * the stitching maps. So blocks of faces can be split independently. */
+  static const int FACES_PER_BLOCK = 64;
+  const int num_blocks = divide_up(num_faces, FACES_PER_BLOCK);
+
+  blocks.clear();
+  for (int b = 0; b < num_blocks; b++) {
+    blocks.emplace_back(new DiagSplit(params));
+  }
+
+  parallel_for(blocked_range<int>(0, num_blocks, 1), [&](const blocked_range<int> &r) {
+    for (int b = r.begin(); b != r.end(); b++) {
+      DiagSplit *block = blocks[b].get();
+      const int face_end = min((b + 1) * FACES_PER_BLOCK, num_faces);
 
-    if (face.is_quad()) {
-      patch_index++;
+      for (int f = b * FACES_PER_BLOCK; f < face_end; f++) {
+        Mesh::SubdFace face = params.mesh->get_subd_face(f);
 
-      split_quad(face, patch);
+        Patch *patch = (Patch *)(((char *)patches) + face_patch_index[f] * patches_byte_stride);
+
+        if (face.is_quad()) {
+          block->split_quad(face, patch);
+        }
+        else {
+          block->split_ngon(face, patch, patches_byte_stride);
+        }
+      }
     }
-    else {
-      patch_index += face.num_corners;
+  });
 
-      split_ngon(face, patch, patches_byte_stride);
+  /* Merge blocks in order, offsetting vertex indices allocated by each block. */
+  size_t num_subpatches = subpatches.size();
+  foreach (unique_ptr<DiagSplit> &block, blocks) {
+    num_subpatches += block->subpatches.size();
+  }
+  subpatches.reserve(num_subpatches);
+
+  foreach (unique_ptr<DiagSplit> &block, blocks) {
+    const int vert_base = alloc_verts(block->num_alloced_verts);
+
+    foreach (Edge &edge, block->edges) {
+      if (edge.start_vert_index >= 0) {
+        edge.start_vert_index += vert_base;
+      }
+      if (edge.end_vert_index >= 0) {
+        edge.end_vert_index += vert_base;
+      }
     }
+
+    subpatches.insert(subpatches.end(), block->subpatches.begin(), block->subpatches.end());
+    block->subpatches.clear();
+    block->subpatches.shrink_to_fit();
   }
 
   params.mesh->vert_to_stitching_key_map.clear();
@@ -607,14 +656,16 @@ void DiagSplit::post_split()
 
   /* All patches are now split, and all T values known. */
 
-  foreach (Edge &edge, edges) {
-    if (edge.second_vert_index < 0) {
-      edge.second_vert_index = alloc_verts(edge.T - 1);
-    }
+  foreach (unique_ptr<DiagSplit> &block, blocks) {
+    foreach (Edge &edge, block->edges) {
+      if (edge.second_vert_index < 0) {
+        edge.second_vert_index = alloc_verts(edge.T - 1);
+      }
 
-    if (edge.is_stitch_edge) {
-      num_stitch_verts = max(num_stitch_verts,
-                             max(edge.stitch_start_vert_index, edge.stitch_end_vert_index));
+      if (edge.is_stitch_edge) {
+        num_stitch_verts = max(num_stitch_verts,
+                               max(edge.stitch_start_vert_index, edge.stitch_end_vert_index));
+      }
     }
   }
 
@@ -630,86 +681,92 @@ void DiagSplit::post_split()
   typedef unordered_map<pair<int, int>, int, pair_hasher> edge_stitch_verts_map_t;
   edge_stitch_verts_map_t edge_stitch_verts_map;
 
-  foreach (Edge &edge, edges) {
-    if (edge.is_stitch_edge) {
-      if (edge.stitch_edge_T == 0) {
-        edge.stitch_edge_T = edge.T;
-      }
+  foreach (unique_ptr<DiagSplit> &block, blocks) {
+    foreach (Edge &edge, block->edges) {
+      if (edge.is_stitch_edge) {
+        if (edge.stitch_edge_T == 0) {
+          edge.stitch_edge_T = edge.T;
+        }
 
-      if (edge_stitch_verts_map.find(edge.stitch_edge_key) == edge_stitch_verts_map.end()) {
-        edge_stitch_verts_map[edge.stitch_edge_key] = num_stitch_verts;
-        num_stitch_verts += edge.stitch_edge_T - 1;
+        if (edge_stitch_verts_map.find(edge.stitch_edge_key) == edge_stitch_verts_map.end()) {
+          edge_stitch_verts_map[edge.stitch_edge_key] = num_stitch_verts;
+          num_stitch_verts += edge.stitch_edge_T - 1;
+        }
       }
     }
   }
 
   /* Set start and end indices for edges generated from a split. */
-  foreach (Edge &edge, edges) {
-    if (edge.start_vert_index < 0) {
-      /* Fix up offsets. */
-      if (edge.top_indices_decrease) {
-        edge.top_offset = edge.top->T - edge.top_offset;
+  foreach (unique_ptr<DiagSplit> &block, blocks) {
+    foreach (Edge &edge, block->edges) {
+      if (edge.start_vert_index < 0) {
+        /* Fix up offsets. */
+        if (edge.top_indices_decrease) {
+          edge.top_offset = edge.top->T - edge.top_offset;
+        }
+
+        edge.start_vert_index = edge.top->get_vert_along_edge(edge.top_offset);
       }
 
-      edge.start_vert_index = edge.top->get_vert_along_edge(edge.top_offset);
-    }
+      if (edge.end_vert_index < 0) {
+        if (edge.bottom_indices_decrease) {
+          edge.bottom_offset = edge.bottom->T - edge.bottom_offset;
+        }
 
-    if (edge.end_vert_index < 0) {
-      if (edge.bottom_indices_decrease) {
-        edge.bottom_offset = edge.bottom->T - edge.bottom_offset;
+        edge.end_vert_index = edge.bottom->get_vert_along_edge(edge.bottom_offset);
       }
-
-      edge.end_vert_index = edge.bottom->get_vert_along_edge(edge.bottom_offset);
     }
   }
 
   int vert_offset = params.mesh->verts.size();
 
   /* Add verts to stitching map. */
-  foreach (const Edge &edge, edges) {
-    if (edge.is_stitch_edge) {
-      int second_stitch_vert_index = edge_stitch_verts_map[edge.stitch_edge_key];
-
-      for (int i = 0; i <= edge.T; i++) {
-        /* Get proper stitching key. */
-        int key;
+  foreach (unique_ptr<DiagSplit> &block, blocks) {
+    foreach (const Edge &edge, block->edges) {
+      if (edge.is_stitch_edge) {
+        int second_stitch_vert_index = edge_stitch_verts_map[edge.stitch_edge_key];
 
-        if (i == 0) {
-          key = edge.stitch_start_vert_index;
-        }
-        else if (i == edge.T) {
-          key = edge.stitch_end_vert_index;
-        }
-        else {
-          key = second_stitch_vert_index + i - 1 + edge.stitch_offset;
-        }
+        for (int i = 0; i <= edge.T; i++) {
+          /* Get proper stitching key. */
+          int key;
 
-        if (key == STITCH_NGON_SPLIT_EDGE_CENTER_VERT_TAG) {
           if (i == 0) {
-            key = second_stitch_vert_index - 1 + edge.stitch_offset;
+            key = edge.stitch_start_vert_index;
           }
           else if (i == edge.T) {
-            key = second_stitch_vert_index - 1 + edge.T;
-          }
-        }
-        else if (key < 0 && edge.top) { /* ngon spoke edge */
-          int s = edge_stitch_verts_map[edge.top->stitch_edge_key];
-          if (edge.stitch_top_offset >= 0) {
-            key = s - 1 + edge.stitch_top_offset;
+            key = edge.stitch_end_vert_index;
           }
           else {
-            key = s - 1 + edge.top->stitch_edge_T + edge.stitch_top_offset;
+            key = second_stitch_vert_index + i - 1 + edge.stitch_offset;
+          }
+
+          if (key == STITCH_NGON_SPLIT_EDGE_CENTER_VERT_TAG) {
+            if (i == 0) {
+              key = second_stitch_vert_index - 1 + edge.stitch_offset;
+            }
+            else if (i == edge.T) {
+              key = second_stitch_vert_index - 1 + edge.T;
+            }
+          }
+          else if (key < 0 && edge.top) { /* ngon spoke edge */
+            int s = edge_stitch_verts_map[edge.top->stitch_edge_key];
+            if (edge.stitch_top_offset >= 0) {
+              key = s - 1 + edge.stitch_top_offset;
+            }
+            else {
+              key = s - 1 + edge.top->stitch_edge_T + edge.stitch_top_offset;
+            }
           }
-        }
 
-        /* Get real vert index. */
-        int vert = edge.get_vert_along_edge(i) + vert_offset;
+          /* Get real vert index. */
+          int vert = edge.get_vert_along_edge(i) + vert_offset;
 
-        /* Add to map */
-        if (params.mesh->vert_to_stitching_key_map.find(vert) ==
-            params.mesh->vert_to_stitching_key_map.end()) {
-          params.mesh->vert_to_stitching_key_map[vert] = key;
-          params.mesh->vert_stitching_map.insert({key, vert});
+          /* Add to map */
+          if (params.mesh->vert_to_stitching_key_map.find(vert) ==
+              params.mesh->vert_to_stitching_key_map.end()) {
+            params.mesh->vert_to_stitching_key_map[vert] = key;
+            params.mesh->vert_stitching_map.insert({key, vert});
+          }
         }
       }
     }
@@ -721,14 +778,6 @@ void DiagSplit::post_split()
   int num_verts = num_alloced_verts;
   int num_triangles = 0;
 
-  for (size_t i = 0; i < subpatches.size(); i++) {
-    subpatches[i].inner_grid_vert_offset = num_verts;
-    num_verts += subpatches[i].calc_num_inner_verts();
-    num_triangles += subpatches[i].calc_num_triangles();
-  }
-
-  dice.reserve(num_verts, num_triangles);
-
   for (size_t i = 0; i < subpatches.size(); i++) {
     Subpatch &sub = subpatches[i];
 
@@ -737,12 +786,19 @@ void DiagSplit::post_split()
     sub.edge_v0.T = max(sub.edge_v0.T, 1);
     sub.edge_v1.T = max(sub.edge_v1.T, 1);
 
-    dice.dice(sub);
+    sub.inner_grid_vert_offset = num_verts;
+    sub.triangle_offset = num_triangles;
+    num_verts += sub.calc_num_inner_verts();
+    num_triangles += sub.calc_num_triangles();
   }
 
+  dice.reserve(num_verts, num_triangles);
+  dice.dice(subpatches, num_alloced_verts);
+
   /* Cleanup */
   subpatches.clear();
   edges.clear();
+  blocks.clear();
 }
 
 CCL_NAMESPACE_END
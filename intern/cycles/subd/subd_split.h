@@ -27,6 +27,7 @@
 
 #include "util/util_deque.h"
 #include "util/util_types.h"
+#include "util/util_unique_ptr.h"
 #include "util/util_vector.h"
 
 #include <deque>
@@ -43,6 +44,10 @@ class DiagSplit {
   /* `deque` is used so that element pointers remain valid when size is changed. */
   deque<Edge> edges;
 
+  /* Faces are split in parallel in blocks, each with its own subpatches, edges and vertices.
+   * Blocks are merged in face order, giving the same result as a serial split. */
+  vector<unique_ptr<DiagSplit>> blocks;
+
   float3 to_world(Patch *patch, float2 uv);
   int T(Patch *patch, float2 Pstart, float2 Pend, bool recursive_resolve = false);
 
@@ -0,0 +1,267 @@
+/*
+ * Copyright 2011-2021 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "testing/testing.h"
+
+#include "kernel/filter/filter.h"
+#include "kernel/kernel_types.h"
+
+#include "util/util_hash.h"
+#include "util/util_math.h"
+#include "util/util_vector.h"
+
+CCL_NAMESPACE_BEGIN
+
+namespace {
+
+/* Render buffer with only the denoising data pass and no sample count pass. */
+const int pass_stride = DENOISING_PASS_SIZE_BASE;
+const int estimate_radius = 4;
+
+class DenoisingBuffer {
+ public:
+  DenoisingBuffer(int width, int height)
+      : width(width), height(height), data((size_t)width * height * pass_stride, 0.0f)
+  {
+  }
+
+  float *pixel(int x, int y)
+  {
+    return &data[((size_t)y * width + x) * pass_stride];
+  }
+
+  /* Sums of n samples of constant features and a color with the given mean and per-sample
+   * variance, as written by kernel_write_denoising_features. */
+  void set_moments(int x, int y, int n, float3 normal, float3 color, float variance)
+  {
+    float *buffer = pixel(x, y);
+    set_float3_moments(buffer + DENOISING_PASS_NORMAL, normal * n, normal * normal * n);
+    set_float3_moments(buffer + DENOISING_PASS_ALBEDO,
+                       make_float3(0.5f, 0.5f, 0.5f) * n,
+                       make_float3(0.25f, 0.25f, 0.25f) * n);
+    buffer[DENOISING_PASS_DEPTH] = 2.0f * n;
+    buffer[DENOISING_PASS_DEPTH_VAR] = 4.0f * n;
+    /* The sample variance of the sums is exactly the given variance. */
+    set_float3_moments(buffer + DENOISING_PASS_COLOR,
+                       color * n,
+                       color * color * n + make_float3(variance, variance, variance) * (n - 1));
+  }
+
+  /* Add one sample of a flat surface, like kernel_write_denoising_features. */
+  void add_sample(int x, int y, float3 color)
+  {
+    float *buffer = pixel(x, y);
+    const float3 normal = make_float3(0.0f, 0.0f, 1.0f);
+    const float3 albedo = make_float3(0.5f, 0.5f, 0.5f);
+    set_float3_moments(buffer + DENOISING_PASS_NORMAL,
+                       get_float3(buffer + DENOISING_PASS_NORMAL) + normal,
+                       get_float3(buffer + DENOISING_PASS_NORMAL_VAR) + normal * normal);
+    set_float3_moments(buffer + DENOISING_PASS_ALBEDO,
+                       get_float3(buffer + DENOISING_PASS_ALBEDO) + albedo,
+                       get_float3(buffer + DENOISING_PASS_ALBEDO_VAR) + albedo * albedo);
+    buffer[DENOISING_PASS_DEPTH] += 2.0f;
+    buffer[DENOISING_PASS_DEPTH_VAR] += 4.0f;
+    set_float3_moments(buffer + DENOISING_PASS_COLOR,
+                       get_float3(buffer + DENOISING_PASS_COLOR) + color,
+                       get_float3(buffer + DENOISING_PASS_COLOR_VAR) + color * color);
+  }
+
+  float3 color_sum(int x, int y)
+  {
+    return get_float3(pixel(x, y) + DENOISING_PASS_COLOR);
+  }
+
+  float estimate_error(int x, int y, int sample)
+  {
+    int rect[4] = {0, 0, width, height};
+    float error;
+    kernel_cpu_filter_estimate_error(
+        x, y, sample, data.data(), rect, 0, width, pass_stride, 0, 0, estimate_radius, &error);
+    return error;
+  }
+
+  int width, height;
+
+ private:
+  static float3 get_float3(const float *buffer)
+  {
+    return make_float3(buffer[0], buffer[1], buffer[2]);
+  }
+
+  static void set_float3_moments(float *buffer, float3 sum, float3 sum_sq)
+  {
+    buffer[0] = sum.x;
+    buffer[1] = sum.y;
+    buffer[2] = sum.z;
+    buffer[3] = sum_sq.x;
+    buffer[4] = sum_sq.y;
+    buffer[5] = sum_sq.z;
+  }
+
+  vector<float> data;
+};
+
+/* Error of a pixel with n samples whose mean has the given variance and that is averaged with
+ * num_pixels neighbors of the same variance, on the scale of kernel_do_adaptive_stopping. */
+float expected_error(int n, float3 color, float variance, float num_pixels)
+{
+  const float denoised_var = variance / n / num_pixels;
+  return 3.0f * sqrtf(denoised_var) /
+         (n * 0.0001f + sqrtf(n * (color.x + color.y + color.z)));
+}
+
+/* Normally distributed noise from a hash, so that the test is deterministic. */
+float gaussian(uint i, uint j)
+{
+  const float u1 = max(hash_uint3_to_float(i, j, 0), 1e-7f);
+  const float u2 = hash_uint3_to_float(i, j, 1);
+  return sqrtf(-2.0f * logf(u1)) * cosf(M_2PI_F * u2);
+}
+
+}  // namespace
+
+TEST(kernel_filter, EstimateErrorFlatArea)
+{
+  const int n = 16;
+  const float3 color = make_float3(0.5f, 0.25f, 1.0f);
+  const float variance = 0.04f;
+
+  DenoisingBuffer buffer(16, 16);
+  for (int y = 0; y < buffer.height; y++) {
+    for (int x = 0; x < buffer.width; x++) {
+      buffer.set_moments(x, y, n, make_float3(0.0f, 0.0f, 1.0f), color, variance);
+    }
+  }
+
+  /* All neighbors in the window have the same features and are averaged with full weight. */
+  const float window = 2 * estimate_radius + 1;
+  EXPECT_NEAR(buffer.estimate_error(8, 8, n) / expected_error(n, color, variance, window * window),
+              1.0f,
+              1e-4f);
+  /* The window is cut off at the tile border. */
+  const float corner = estimate_radius + 1;
+  EXPECT_NEAR(buffer.estimate_error(0, 0, n) / expected_error(n, color, variance, corner * corner),
+              1.0f,
+              1e-4f);
+
+  /* No variance can be estimated from a single sample. */
+  buffer.set_moments(8, 8, 1, make_float3(0.0f, 0.0f, 1.0f), color, variance);
+  EXPECT_GT(buffer.estimate_error(8, 8, 1), 1e9f);
+}
+
+TEST(kernel_filter, EstimateErrorFeatureEdge)
+{
+  const int n = 16;
+  const float3 color = make_float3(0.5f, 0.5f, 0.5f);
+  const float variance = 0.04f;
+
+  /* Two halves facing different directions, pixels across the edge are not averaged. */
+  DenoisingBuffer buffer(16, 16);
+  for (int y = 0; y < buffer.height; y++) {
+    for (int x = 0; x < buffer.width; x++) {
+      const float3 normal = (x < 8) ? make_float3(0.0f, 0.0f, 1.0f) :
+                                      make_float3(1.0f, 0.0f, 0.0f);
+      buffer.set_moments(x, y, n, normal, color, variance);
+    }
+  }
+
+  const float window = 2 * estimate_radius + 1;
+  /* Columns 3 to 7 are on the same side as the pixel at the edge. */
+  EXPECT_NEAR(buffer.estimate_error(7, 8, n) / expected_error(n, color, variance, 5 * window),
+              1.0f,
+              1e-4f);
+  EXPECT_GT(buffer.estimate_error(7, 8, n), buffer.estimate_error(3, 8, n));
+}
+
+/* Render a noisy flat area one sample at a time, and compare the samples after which a tile
+ * stops with the per-pixel stopping condition and with the denoising estimate. The error after
+ * denoising is measured as the error of the average over the estimate window, which is what the
+ * denoiser converges to on a flat area. */
+TEST(kernel_filter, EstimateErrorFewerSamples)
+{
+  const int size = 32, tile_begin = 12, tile_end = 20;
+  const int max_samples = 4096, adaptive_step = 4;
+  const float threshold = 0.01f;
+  const float3 color = make_float3(0.5f, 0.5f, 0.5f);
+  const float sigma = 0.5f;
+
+  DenoisingBuffer buffer(size, size);
+  /* Sum of all samples and of every second sample scaled by two, as in the adaptive aux pass. */
+  vector<float3> sum(size * size, zero_float3()), half_sum(size * size, zero_float3());
+
+  int per_pixel_stop = 0, estimate_stop = 0;
+  float per_pixel_rms = 0.0f, estimate_rms = 0.0f;
+
+  for (int sample = 0; sample < max_samples && !per_pixel_stop; sample++) {
+    for (int y = 0; y < size; y++) {
+      for (int x = 0; x < size; x++) {
+        const uint i = y * size + x;
+        const float noise = sigma * gaussian(i, sample);
+        const float3 L = color + make_float3(noise, noise, noise);
+        buffer.add_sample(x, y, L);
+        sum[i] += L;
+        if (sample & 1) {
+          half_sum[i] += 2.0f * L;
+        }
+      }
+    }
+
+    const int n = sample + 1;
+    if (n % adaptive_step != 0) {
+      continue;
+    }
+
+    bool per_pixel_converged = true, estimate_converged = true;
+    float per_pixel_sq_error = 0.0f, estimate_sq_error = 0.0f;
+    for (int y = tile_begin; y < tile_end; y++) {
+      for (int x = tile_begin; x < tile_end; x++) {
+        const float3 I = sum[y * size + x], A = half_sum[y * size + x];
+        const float error = (fabsf(I.x - A.x) + fabsf(I.y - A.y) + fabsf(I.z - A.z)) /
+                            (n * 0.0001f + sqrtf(I.x + I.y + I.z));
+        per_pixel_converged &= (error < threshold * n);
+        estimate_converged &= (buffer.estimate_error(x, y, n) < threshold);
+
+        per_pixel_sq_error += sqr(I.x / n - color.x);
+        float3 average = zero_float3();
+        for (int y1 = y - estimate_radius; y1 <= y + estimate_radius; y1++) {
+          for (int x1 = x - estimate_radius; x1 <= x + estimate_radius; x1++) {
+            average += buffer.color_sum(x1, y1);
+          }
+        }
+        estimate_sq_error += sqr(average.x / (sqr(2 * estimate_radius + 1) * n) - color.x);
+      }
+    }
+
+    const int num_pixels = sqr(tile_end - tile_begin);
+    if (per_pixel_converged && !per_pixel_stop) {
+      per_pixel_stop = n;
+      per_pixel_rms = sqrtf(per_pixel_sq_error / num_pixels);
+    }
+    if (estimate_converged && !estimate_stop) {
+      estimate_stop = n;
+      estimate_rms = sqrtf(estimate_sq_error / num_pixels);
+    }
+  }
+
+  ASSERT_GT(per_pixel_stop, 0);
+  ASSERT_GT(estimate_stop, 0);
+  /* The denoising estimate stops with fewer samples and no more error after denoising than the
+   * per-pixel condition leaves without it. */
+  EXPECT_LT(estimate_stop * 4, per_pixel_stop);
+  EXPECT_LE(estimate_rms, per_pixel_rms);
+}
+
+CCL_NAMESPACE_END
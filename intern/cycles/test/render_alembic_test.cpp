@@ -0,0 +1,194 @@
+/*
+ * Copyright 2011-2021 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "testing/testing.h"
+
+#include "device/device.h"
+#include "render/alembic.h"
+#include "render/mesh.h"
+#include "render/object.h"
+#include "render/scene.h"
+#include "render/shader.h"
+#include "render/stats.h"
+
+#include "util/util_path.h"
+#include "util/util_progress.h"
+#include "util/util_stats.h"
+
+#include <Alembic/AbcCoreOgawa/All.h>
+
+CCL_NAMESPACE_BEGIN
+
+namespace {
+
+using namespace Alembic::AbcGeom;
+
+const int num_frames = 6;
+const double frame_rate = 24.0;
+
+/* Write a quad that moves by one unit along X every frame, with a face set for the second
+ * shader. Frame 1 is at the first sample. */
+void write_archive(const string &filepath)
+{
+  OArchive archive(Alembic::AbcCoreOgawa::WriteArchive(), filepath);
+  const uint32_t time_sampling = archive.addTimeSampling(
+      TimeSampling(1.0 / frame_rate, 1.0 / frame_rate));
+
+  OXform xform(archive.getTop(), "quad", time_sampling);
+  xform.getSchema().set(XformSample());
+
+  OPolyMesh polymesh(xform, "quadShape", time_sampling);
+  OPolyMeshSchema &schema = polymesh.getSchema();
+
+  const int32_t face_indices[4] = {0, 1, 2, 3};
+  const int32_t face_counts[1] = {4};
+
+  for (int frame = 1; frame <= num_frames; frame++) {
+    const float x = (float)frame;
+    const V3f positions[4] = {V3f(x, 0.0f, 0.0f),
+                             V3f(x + 1.0f, 0.0f, 0.0f),
+                             V3f(x + 1.0f, 1.0f, 0.0f),
+                             V3f(x, 1.0f, 0.0f)};
+
+    OPolyMeshSchema::Sample sample(V3fArraySample(positions, 4),
+                                   Int32ArraySample(face_indices, 4),
+                                   Int32ArraySample(face_counts, 1));
+    schema.set(sample);
+  }
+
+  const int32_t faces[1] = {0};
+  OFaceSet face_set = schema.createFaceSet("Red");
+  face_set.getSchema().set(OFaceSetSchema::Sample(Int32ArraySample(faces, 1)));
+}
+
+}  // namespace
+
+class RenderAlembic : public testing::Test {
+ protected:
+  Stats stats;
+  Profiler profiler;
+  DeviceInfo device_info;
+  Device *device_cpu;
+  Scene *scene;
+  Progress progress;
+  string filepath;
+
+  AlembicProcedural *procedural;
+  AlembicObject *abc_object;
+  array<Node *> used_shaders;
+
+  virtual void SetUp()
+  {
+    filepath = path_join(testing::TempDir(), "cycles_alembic_stream.abc");
+    write_archive(filepath);
+
+    device_cpu = Device::create(device_info, stats, profiler, true);
+    scene = new Scene(SceneParams(), device_cpu);
+
+    Shader *red_shader = scene->create_node<Shader>();
+    red_shader->name = ustring("Red");
+    red_shader->tag_update(scene);
+    used_shaders.push_back_slow(scene->default_surface);
+    used_shaders.push_back_slow(red_shader);
+
+    procedural = scene->create_node<AlembicProcedural>();
+    procedural->set_filepath(ustring(filepath));
+    procedural->set_start_frame(1.0f);
+    procedural->set_end_frame((float)num_frames);
+    procedural->set_frame_rate((float)frame_rate);
+    procedural->set_use_prefetch(true);
+    procedural->set_stream_window(2);
+
+    abc_object = procedural->get_or_create_object(ustring("/quad/quadShape"));
+  }
+
+  virtual void TearDown()
+  {
+    delete scene;
+    delete device_cpu;
+    path_remove(filepath);
+  }
+
+  /* What the Blender synchronization sets for every frame. */
+  void sync(int frame)
+  {
+    procedural->set_frame((float)frame);
+    procedural->set_default_radius(0.01f * frame);
+    abc_object->set_used_shaders(used_shaders);
+    abc_object->set_subd_dicing_rate(1.0f + frame);
+  }
+
+  void render_frame(int frame)
+  {
+    sync(frame);
+    procedural->generate(scene, progress);
+    ASSERT_FALSE(progress.get_error());
+
+    Object *object = abc_object->get_object();
+    ASSERT_TRUE(object != NULL);
+    Mesh *mesh = static_cast<Mesh *>(object->get_geometry());
+
+    ASSERT_EQ(mesh->get_verts().size(), 4);
+    for (const float3 &P : mesh->get_verts()) {
+      EXPECT_TRUE(P.x == (float)frame || P.x == (float)frame + 1.0f)
+          << "frame " << frame << " vertex at x " << P.x;
+    }
+
+    /* The face set assigns the second shader to both triangles of the quad. */
+    ASSERT_EQ(mesh->get_shader().size(), 2);
+    EXPECT_EQ(mesh->get_shader()[0], 1);
+    EXPECT_EQ(mesh->get_shader()[1], 1);
+  }
+
+  ProceduralStats stream_stats()
+  {
+    RenderStats render_stats;
+    procedural->collect_statistics(&render_stats);
+    return render_stats.procedurals;
+  }
+};
+
+TEST_F(RenderAlembic, PersistentDataFrameChange)
+{
+  /* With persistent data the procedural is kept between frames, the next window of frames is
+   * loaded while the current frame renders and the synchronization of the next frame runs. */
+  procedural->set_prefetch_next_window(true);
+
+  render_frame(1);
+  render_frame(2);
+  /* Frames 3 and 4 were prefetched while frame 1 rendered. */
+  render_frame(3);
+  render_frame(5);
+
+  const ProceduralStats procedural_stats = stream_stats();
+  EXPECT_EQ(procedural_stats.stream_misses, 1);
+  EXPECT_EQ(procedural_stats.stream_hits, 3);
+}
+
+TEST_F(RenderAlembic, FrameChangeWithoutPrefetch)
+{
+  render_frame(1);
+  render_frame(2);
+  render_frame(3);
+  render_frame(5);
+
+  /* Every new window of frames is loaded on demand. */
+  const ProceduralStats procedural_stats = stream_stats();
+  EXPECT_EQ(procedural_stats.stream_misses, 3);
+  EXPECT_EQ(procedural_stats.stream_hits, 1);
+}
+
+CCL_NAMESPACE_END
@@ -0,0 +1,236 @@
+/*
+ * Copyright 2011-2021 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "testing/testing.h"
+
+#include "render/bake.h"
+#include "render/buffers.h"
+#include "render/film.h"
+#include "render/graph.h"
+#include "render/mesh.h"
+#include "render/nodes.h"
+#include "render/object.h"
+#include "render/scene.h"
+#include "render/session.h"
+#include "render/shader.h"
+#include "render/stats.h"
+
+#include "util/util_math.h"
+#include "util/util_transform.h"
+#include "util/util_vector.h"
+
+CCL_NAMESPACE_BEGIN
+
+namespace {
+
+const int bake_width = 16;
+
+/* Fill in the primitive pass of a pixel, the same way for a job whether it is baked alone or as
+ * part of a batch. Every object is a quad of two triangles. */
+void bake_primitive(const BakeJob &job, int x, int job_row, float primitive[4])
+{
+  const int i = job_row * bake_width + x;
+  if (i >= job.num_pixels) {
+    primitive[0] = __uint_as_float(0);
+    primitive[1] = __int_as_float(-1);
+    primitive[2] = primitive[3] = 0.0f;
+    return;
+  }
+
+  primitive[0] = __uint_as_float(i);
+  primitive[1] = __int_as_float(i % 2);
+  primitive[2] = (i % 5) * 0.1f + 0.05f;
+  primitive[3] = (i % 3) * 0.2f + 0.05f;
+}
+
+class RenderBake : public testing::Test {
+ protected:
+  /* Bake the jobs in a new session, as a batch or with the single object API, and return the
+   * RGBA pixels of the whole bake buffer. */
+  vector<float> bake(vector<BakeJob> &jobs, bool batch, BakeStats *bake_stats = NULL)
+  {
+    SessionParams session_params;
+    session_params.background = true;
+    session_params.samples = 1;
+    /* Tiles span the rows of more than one job. */
+    session_params.tile_size = make_int2(8, 2);
+
+    Session *session = new Session(session_params);
+    Scene *scene = new Scene(SceneParams(), session->device);
+    session->scene = scene;
+
+    Shader *shader = add_position_shader(scene);
+    add_quad(scene, shader, "Quad", zero_float3());
+    add_quad(scene, shader, "Quad.001", make_float3(2.0f, 0.0f, 0.0f));
+
+    int height;
+    if (batch) {
+      height = scene->bake_manager->set_jobs(
+          scene, jobs, bake_width, SHADER_EVAL_EMISSION, BAKE_FILTER_NONE);
+    }
+    else {
+      EXPECT_EQ(jobs.size(), 1);
+      jobs[0].y = 0;
+      jobs[0].height = height = (int)divide_up(jobs[0].num_pixels, bake_width);
+      scene->bake_manager->set(
+          scene, jobs[0].object_name, SHADER_EVAL_EMISSION, BAKE_FILTER_NONE);
+    }
+    Pass::add(PASS_COMBINED, scene->passes, "Combined");
+
+    vector<float> pixels((size_t)bake_width * height * 4, 0.0f);
+
+    session->read_bake_tile_cb = [&](RenderTile &rtile) {
+      vector<float> primitive((size_t)rtile.w * rtile.h * 4);
+      vector<float> differential((size_t)rtile.w * rtile.h * 4, 0.0f);
+      for (int y = 0; y < rtile.h; y++) {
+        const BakeJob *job = (batch) ? scene->bake_manager->find_job(rtile.y + y) : &jobs[0];
+        ASSERT_TRUE(job != NULL);
+        for (int x = 0; x < rtile.w; x++) {
+          bake_primitive(
+              *job, rtile.x + x, rtile.y + y - job->y, &primitive[((size_t)y * rtile.w + x) * 4]);
+        }
+      }
+      rtile.buffers->set_pass_rect(PASS_BAKE_PRIMITIVE, 4, primitive.data(), rtile.num_samples);
+      rtile.buffers->set_pass_rect(
+          PASS_BAKE_DIFFERENTIAL, 4, differential.data(), rtile.num_samples);
+    };
+
+    session->write_render_tile_cb = [&](RenderTile &rtile) {
+      RenderBuffers *buffers = rtile.buffers;
+      ASSERT_TRUE(buffers->copy_from_device());
+      vector<float> tile_pixels((size_t)rtile.w * rtile.h * 4);
+      ASSERT_TRUE(buffers->get_pass_rect("Combined", 1.0f, rtile.sample, 4, tile_pixels.data()));
+      for (int y = 0; y < rtile.h; y++) {
+        memcpy(&pixels[((size_t)(rtile.y + y) * bake_width + rtile.x) * 4],
+               &tile_pixels[(size_t)y * rtile.w * 4],
+               sizeof(float) * rtile.w * 4);
+      }
+    };
+
+    BufferParams buffer_params;
+    buffer_params.width = buffer_params.full_width = bake_width;
+    buffer_params.height = buffer_params.full_height = height;
+    buffer_params.passes = scene->passes;
+
+    session->tile_manager.set_samples(session_params.samples);
+    session->reset(buffer_params, session_params.samples);
+    session->start();
+    session->wait();
+
+    if (bake_stats) {
+      RenderStats stats;
+      session->collect_statistics(&stats);
+      *bake_stats = stats.bake;
+    }
+
+    session->read_bake_tile_cb = function_null;
+    session->write_render_tile_cb = function_null;
+    delete session;
+
+    return pixels;
+  }
+
+  /* Emits the position, so that the result depends on the object, triangle and barycentric
+   * coordinates of every pixel. */
+  static Shader *add_position_shader(Scene *scene)
+  {
+    ShaderGraph *graph = new ShaderGraph();
+    GeometryNode *geometry = graph->create_node<GeometryNode>();
+    EmissionNode *emission = graph->create_node<EmissionNode>();
+    emission->set_strength(1.0f);
+    graph->add(geometry);
+    graph->add(emission);
+    graph->connect(geometry->output("Position"), emission->input("Color"));
+    graph->connect(emission->output("Emission"), graph->output()->input("Surface"));
+
+    Shader *shader = scene->create_node<Shader>();
+    shader->set_graph(graph);
+    shader->tag_update(scene);
+    return shader;
+  }
+
+  static void add_quad(Scene *scene, Shader *shader, const char *name, float3 offset)
+  {
+    Mesh *mesh = scene->create_node<Mesh>();
+    array<Node *> used_shaders;
+    used_shaders.push_back_slow(shader);
+    mesh->set_used_shaders(used_shaders);
+
+    mesh->reserve_mesh(4, 2);
+    mesh->add_vertex(make_float3(0.0f, 0.0f, 0.0f));
+    mesh->add_vertex(make_float3(1.0f, 0.0f, 0.0f));
+    mesh->add_vertex(make_float3(1.0f, 1.0f, 0.0f));
+    mesh->add_vertex(make_float3(0.0f, 1.0f, 0.0f));
+    mesh->add_triangle(0, 1, 2, 0, false);
+    mesh->add_triangle(0, 2, 3, 0, false);
+
+    Object *object = scene->create_node<Object>();
+    object->name = ustring(name);
+    object->set_geometry(mesh);
+    object->set_tfm(transform_translate(offset));
+  }
+};
+
+}  // namespace
+
+TEST_F(RenderBake, BatchMatchesSingleObjects)
+{
+  vector<BakeJob> jobs(2);
+  jobs[0].object_name = "Quad";
+  jobs[0].uv_map = "UVMap";
+  jobs[0].image_name = "Quad Bake";
+  jobs[0].num_pixels = 40;
+  jobs[1].object_name = "Quad.001";
+  jobs[1].uv_map = "UVMap";
+  jobs[1].image_name = "Quad.001 Bake";
+  jobs[1].num_pixels = 21;
+
+  BakeStats bake_stats;
+  const vector<float> batch_pixels = bake(jobs, true, &bake_stats);
+
+  /* Every job starts at a new row. */
+  EXPECT_EQ(jobs[0].y, 0);
+  EXPECT_EQ(jobs[0].height, 3);
+  EXPECT_EQ(jobs[1].y, 3);
+  EXPECT_EQ(jobs[1].height, 2);
+  ASSERT_EQ(batch_pixels.size(), bake_width * 5 * 4);
+
+  /* Padding at the end of the last row of a job is not counted. */
+  EXPECT_EQ(bake_stats.num_pixels, 40 + 21);
+  EXPECT_GT(bake_stats.time, 0.0);
+
+  for (size_t i = 0; i < jobs.size(); i++) {
+    vector<BakeJob> single_job(1, jobs[i]);
+    const vector<float> single_pixels = bake(single_job, false);
+    ASSERT_EQ(single_pixels.size(), bake_width * jobs[i].height * 4);
+
+    const float *batch_job_pixels = &batch_pixels[(size_t)jobs[i].y * bake_width * 4];
+    for (int p = 0; p < jobs[i].num_pixels; p++) {
+      /* The second quad is to the right of the first, its pixels must not be baked from the
+       * first object or with its triangle offset. */
+      const float x = single_pixels[p * 4];
+      EXPECT_TRUE((i == 0) ? (x >= 0.0f && x <= 1.0f) : (x >= 2.0f && x <= 3.0f))
+          << jobs[i].object_name << " pixel " << p << " baked at x " << x;
+
+      for (int c = 0; c < 3; c++) {
+        EXPECT_NEAR(batch_job_pixels[p * 4 + c], single_pixels[p * 4 + c], 1e-6f)
+            << jobs[i].object_name << " pixel " << p << " channel " << c;
+      }
+    }
+  }
+}
+
+CCL_NAMESPACE_END
@@ -0,0 +1,388 @@
+/*
+ * Copyright 2011-2021 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "testing/testing.h"
+
+#include "render/stats.h"
+
+#include "util/util_map.h"
+#include "util/util_string.h"
+#include "util/util_vector.h"
+
+CCL_NAMESPACE_BEGIN
+
+namespace {
+
+/* Minimal JSON parser, only as much as is needed to check the report. */
+
+struct JsonValue {
+  enum Type { NONE, STRING, NUMBER, ARRAY, OBJECT } type = NONE;
+  string str;
+  double number = 0.0;
+  vector<JsonValue> array;
+  vector<std::pair<string, JsonValue>> object;
+
+  const JsonValue *find(const string &key) const
+  {
+    for (const std::pair<string, JsonValue> &member : object) {
+      if (member.first == key) {
+        return &member.second;
+      }
+    }
+    return NULL;
+  }
+};
+
+class JsonParser {
+ public:
+  explicit JsonParser(const string &text) : text_(text), pos_(0)
+  {
+  }
+
+  /* Parse the whole text as a single value, returns false on any syntax error. */
+  bool parse(JsonValue &value)
+  {
+    if (!parse_value(value)) {
+      return false;
+    }
+    skip_whitespace();
+    return pos_ == text_.size();
+  }
+
+ private:
+  void skip_whitespace()
+  {
+    while (pos_ < text_.size() && strchr(" \t\r\n", text_[pos_])) {
+      pos_++;
+    }
+  }
+
+  bool consume(char c)
+  {
+    skip_whitespace();
+    if (pos_ < text_.size() && text_[pos_] == c) {
+      pos_++;
+      return true;
+    }
+    return false;
+  }
+
+  bool parse_string(string &str)
+  {
+    if (!consume('"')) {
+      return false;
+    }
+    while (pos_ < text_.size()) {
+      const char c = text_[pos_++];
+      if (c == '"') {
+        return true;
+      }
+      if ((unsigned char)c < 0x20) {
+        /* Control characters must be escaped. */
+        return false;
+      }
+      if (c != '\\') {
+        str += c;
+        continue;
+      }
+      if (pos_ >= text_.size()) {
+        return false;
+      }
+      const char escape = text_[pos_++];
+      switch (escape) {
+        case '"':
+        case '\\':
+        case '/':
+          str += escape;
+          break;
+        case 'n':
+          str += '\n';
+          break;
+        case 't':
+          str += '\t';
+          break;
+        case 'r':
+          str += '\r';
+          break;
+        case 'b':
+          str += '\b';
+          break;
+        case 'f':
+          str += '\f';
+          break;
+        case 'u': {
+          if (pos_ + 4 > text_.size()) {
+            return false;
+          }
+          const string hex = text_.substr(pos_, 4);
+          if (hex.find_first_not_of("0123456789abcdefABCDEF") != string::npos) {
+            return false;
+          }
+          const long code = strtol(hex.c_str(), NULL, 16);
+          /* Only used for control characters by the report. */
+          if (code >= 0x80) {
+            return false;
+          }
+          str += (char)code;
+          pos_ += 4;
+          break;
+        }
+        default:
+          return false;
+      }
+    }
+    return false;
+  }
+
+  bool parse_value(JsonValue &value)
+  {
+    skip_whitespace();
+    if (pos_ >= text_.size()) {
+      return false;
+    }
+
+    const char c = text_[pos_];
+    if (c == '"') {
+      value.type = JsonValue::STRING;
+      return parse_string(value.str);
+    }
+    if (c == '[') {
+      pos_++;
+      value.type = JsonValue::ARRAY;
+      if (consume(']')) {
+        return true;
+      }
+      do {
+        value.array.push_back(JsonValue());
+        if (!parse_value(value.array.back())) {
+          return false;
+        }
+      } while (consume(','));
+      return consume(']');
+    }
+    if (c == '{') {
+      pos_++;
+      value.type = JsonValue::OBJECT;
+      if (consume('}')) {
+        return true;
+      }
+      do {
+        string key;
+        if (!parse_string(key) || !consume(':')) {
+          return false;
+        }
+        value.object.push_back(std::make_pair(key, JsonValue()));
+        if (!parse_value(value.object.back().second)) {
+          return false;
+        }
+      } while (consume(','));
+      return consume('}');
+    }
+
+    const char *start = text_.c_str() + pos_;
+    char *end;
+    value.type = JsonValue::NUMBER;
+    value.number = strtod(start, &end);
+    if (end == start) {
+      return false;
+    }
+    pos_ += end - start;
+    return true;
+  }
+
+  const string &text_;
+  size_t pos_;
+};
+
+struct TraceEvent {
+  string name;
+  int tid;
+  uint64_t ts, dur;
+};
+
+static vector<TraceEvent> trace_events(const JsonValue &root)
+{
+  vector<TraceEvent> events;
+  const JsonValue *trace = root.find("traceEvents");
+  EXPECT_TRUE(trace != NULL && trace->type == JsonValue::ARRAY);
+  if (trace == NULL) {
+    return events;
+  }
+
+  for (const JsonValue &event : trace->array) {
+    const JsonValue *ph = event.find("ph");
+    EXPECT_TRUE(ph != NULL);
+    if (ph == NULL || ph->str != "X") {
+      continue;
+    }
+
+    const JsonValue *name = event.find("name"), *tid = event.find("tid");
+    const JsonValue *ts = event.find("ts"), *dur = event.find("dur");
+    EXPECT_TRUE(name && tid && ts && dur);
+    if (name && tid && ts && dur) {
+      TraceEvent trace_event;
+      trace_event.name = name->str;
+      trace_event.tid = (int)tid->number;
+      trace_event.ts = (uint64_t)ts->number;
+      trace_event.dur = (uint64_t)dur->number;
+      events.push_back(trace_event);
+    }
+  }
+  return events;
+}
+
+static const TraceEvent *find_event(const vector<TraceEvent> &events,
+                                    const string &name,
+                                    int tid)
+{
+  for (const TraceEvent &event : events) {
+    if (event.name == name && event.tid == tid) {
+      return &event;
+    }
+  }
+  return NULL;
+}
+
+static void fill_stats(RenderStats &stats)
+{
+  stats.has_profiling = true;
+
+  stats.kernel = NamedNestedSampleStats("Total render time", 5);
+  stats.kernel.add_entry("Ray setup", 10);
+  NamedNestedSampleStats &integrate = stats.kernel.add_entry("Path integration", 20);
+  integrate.add_entry("Scene intersection", 40);
+  integrate.add_entry("Shader evaluation", 25);
+
+  /* Names that need escaping. */
+  stats.shaders.add(ustring("Material \"A\" \\ B"), 30, 100);
+  stats.shaders.add(ustring("Tab\tName"), 12, 7);
+  stats.objects.add(ustring("Cube"), 50, 300);
+  stats.shader_evals.add(ustring("Material \"A\" \\ B"), 20, 1000);
+  stats.object_intersections.add_entry(NamedTimeEntry("Cube", 0.004));
+  stats.object_intersections.add_entry(NamedTimeEntry("Sphere", 0.002));
+
+  stats.rays.rays[PROFILING_RAY_CAMERA] = 1000;
+  stats.rays.rays[PROFILING_RAY_SHADOW] = 500;
+  stats.rays.rays[PROFILING_RAY_INDIRECT] = 250;
+}
+
+}  // namespace
+
+TEST(render_stats, JsonReportParses)
+{
+  RenderStats stats;
+  fill_stats(stats);
+
+  const string json = stats.json_report();
+  JsonValue root;
+  ASSERT_TRUE(JsonParser(json).parse(root)) << json;
+  ASSERT_EQ(root.type, JsonValue::OBJECT);
+
+  const JsonValue *shaders = root.find("shaders");
+  ASSERT_TRUE(shaders != NULL);
+  ASSERT_EQ(shaders->type, JsonValue::ARRAY);
+  ASSERT_EQ(shaders->array.size(), 2);
+  /* Sorted by time, names come back unescaped. */
+  EXPECT_EQ(shaders->array[0].find("name")->str, "Material \"A\" \\ B");
+  EXPECT_EQ(shaders->array[0].find("hits")->number, 100);
+  EXPECT_NEAR(shaders->array[0].find("time")->number, 0.030, 1e-9);
+  EXPECT_EQ(shaders->array[1].find("name")->str, "Tab\tName");
+
+  const JsonValue *rays = root.find("rays");
+  ASSERT_TRUE(rays != NULL);
+  EXPECT_EQ(rays->find("camera")->find("rays")->number, 1000);
+  EXPECT_EQ(rays->find("shadow")->find("rays")->number, 500);
+  EXPECT_EQ(rays->find("indirect")->find("rays")->number, 250);
+}
+
+TEST(render_stats, JsonReportTraceEvents)
+{
+  RenderStats stats;
+  fill_stats(stats);
+
+  JsonValue root;
+  ASSERT_TRUE(JsonParser(stats.json_report()).parse(root));
+  const vector<TraceEvent> events = trace_events(root);
+
+  /* Kernel categories are nested inside their parent, samples are milliseconds and trace
+   * timestamps microseconds. */
+  const TraceEvent *total = find_event(events, "Total render time", 0);
+  const TraceEvent *integrate = find_event(events, "Path integration", 0);
+  const TraceEvent *intersect = find_event(events, "Scene intersection", 0);
+  const TraceEvent *shade = find_event(events, "Shader evaluation", 0);
+  ASSERT_TRUE(total && integrate && intersect && shade);
+  EXPECT_EQ(total->ts, 0);
+  EXPECT_EQ(total->dur, (5 + 10 + 20 + 40 + 25) * 1000);
+  EXPECT_EQ(integrate->dur, (20 + 40 + 25) * 1000);
+  EXPECT_EQ(intersect->ts, integrate->ts);
+  EXPECT_EQ(shade->ts, intersect->ts + intersect->dur);
+
+  for (const TraceEvent &event : events) {
+    if (event.tid == 0) {
+      EXPECT_GE(event.ts, total->ts);
+      EXPECT_LE(event.ts + event.dur, total->ts + total->dur);
+    }
+  }
+  EXPECT_GE(intersect->ts, integrate->ts);
+  EXPECT_LE(shade->ts + shade->dur, integrate->ts + integrate->dur);
+
+  /* Other tracks have one event per entry, laid out one after another. */
+  for (int tid = 1; tid <= 4; tid++) {
+    uint64_t end = 0;
+    for (const TraceEvent &event : events) {
+      if (event.tid == tid) {
+        EXPECT_EQ(event.ts, end);
+        end = event.ts + event.dur;
+      }
+    }
+  }
+
+  const TraceEvent *material = find_event(events, "Material \"A\" \\ B", 1);
+  ASSERT_TRUE(material != NULL);
+  EXPECT_EQ(material->dur, 30 * 1000);
+  const TraceEvent *cube = find_event(events, "Cube", 4);
+  ASSERT_TRUE(cube != NULL);
+  EXPECT_EQ(cube->dur, 4 * 1000);
+}
+
+TEST(render_stats, JsonReportWithoutProfiling)
+{
+  RenderStats stats;
+
+  JsonValue root;
+  ASSERT_TRUE(JsonParser(stats.json_report()).parse(root));
+  EXPECT_TRUE(root.find("traceEvents") != NULL);
+  EXPECT_TRUE(trace_events(root).empty());
+  EXPECT_TRUE(root.find("shaders") == NULL);
+  EXPECT_TRUE(root.find("bake") == NULL);
+}
+
+TEST(render_stats, JsonReportBake)
+{
+  RenderStats stats;
+  stats.bake.num_pixels = 3000;
+  stats.bake.time = 1.5;
+
+  JsonValue root;
+  ASSERT_TRUE(JsonParser(stats.json_report()).parse(root));
+  const JsonValue *bake = root.find("bake");
+  ASSERT_TRUE(bake != NULL);
+  EXPECT_EQ(bake->find("pixels")->number, 3000);
+  EXPECT_NEAR(bake->find("time")->number, 1.5, 1e-9);
+  EXPECT_EQ(bake->find("pixels_per_second")->number, 2000);
+}
+
+CCL_NAMESPACE_END
@@ -0,0 +1,145 @@
+/*
+ * Copyright 2011-2021 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "testing/testing.h"
+
+#include "render/colorspace.h"
+#include "render/stats.h"
+#include "render/texture_cache.h"
+
+#include "util/util_image.h"
+#include "util/util_path.h"
+#include "util/util_unique_ptr.h"
+#include "util/util_vector.h"
+
+CCL_NAMESPACE_BEGIN
+
+namespace {
+
+const int image_size = 256;
+
+/* Value of a pixel, different for every pixel and channel. */
+float4 pixel_value(int x, int y)
+{
+  return make_float4(x / (float)image_size, y / (float)image_size, 0.25f, 1.0f);
+}
+
+/* Write an untiled RGB image, which the texture cache tiles and mipmaps itself. */
+void write_image(const string &filepath)
+{
+  vector<float> pixels((size_t)image_size * image_size * 3);
+  for (int y = 0; y < image_size; y++) {
+    for (int x = 0; x < image_size; x++) {
+      const float4 value = pixel_value(x, y);
+      /* Images are stored top to bottom. */
+      float *pixel = &pixels[((size_t)(image_size - 1 - y) * image_size + x) * 3];
+      pixel[0] = value.x;
+      pixel[1] = value.y;
+      pixel[2] = value.z;
+    }
+  }
+
+  unique_ptr<ImageOutput> out = unique_ptr<ImageOutput>(ImageOutput::create(filepath));
+  ASSERT_TRUE(out != NULL);
+  ImageSpec spec(image_size, image_size, 3, TypeDesc::FLOAT);
+  ASSERT_TRUE(out->open(filepath, spec));
+  ASSERT_TRUE(out->write_image(TypeDesc::FLOAT, pixels.data()));
+  out->close();
+}
+
+float4 lookup_pixel(const TextureCacheImage *image, int x, int y)
+{
+  return image->lookup((x + 0.5f) / image_size, (y + 0.5f) / image_size);
+}
+
+}  // namespace
+
+class RenderTextureCache : public testing::Test {
+ protected:
+  string filepath;
+
+  virtual void SetUp()
+  {
+    filepath = path_join(testing::TempDir(), "cycles_texture_cache.tif");
+    write_image(filepath);
+  }
+
+  virtual void TearDown()
+  {
+    path_remove(filepath);
+  }
+};
+
+TEST_F(RenderTextureCache, LookupMatchesPixels)
+{
+  TextureCache cache(1024 * 1024);
+  TextureCacheImage *image = cache.add_image(
+      ustring(filepath), u_colorspace_raw, INTERPOLATION_CLOSEST, EXTENSION_REPEAT);
+
+  const int coords[4][2] = {{0, 0}, {17, 200}, {128, 64}, {255, 255}};
+  for (int i = 0; i < 4; i++) {
+    const int x = coords[i][0], y = coords[i][1];
+    const float4 value = lookup_pixel(image, x, y);
+    const float4 expected = pixel_value(x, y);
+    EXPECT_NEAR(value.x, expected.x, 1e-6f) << "pixel " << x << ", " << y;
+    EXPECT_NEAR(value.y, expected.y, 1e-6f) << "pixel " << x << ", " << y;
+    EXPECT_NEAR(value.z, expected.z, 1e-6f) << "pixel " << x << ", " << y;
+    /* Images without alpha are opaque. */
+    EXPECT_EQ(value.w, 1.0f);
+  }
+
+  /* Repeats past the border. */
+  const float4 repeated = image->lookup(1.0f + 17.5f / image_size, 200.5f / image_size);
+  EXPECT_NEAR(repeated.x, pixel_value(17, 200).x, 1e-6f);
+
+  cache.remove_image(image);
+}
+
+TEST_F(RenderTextureCache, ClipOutsideImage)
+{
+  TextureCache cache(1024 * 1024);
+  TextureCacheImage *image = cache.add_image(
+      ustring(filepath), u_colorspace_raw, INTERPOLATION_CLOSEST, EXTENSION_CLIP);
+
+  const float4 value = image->lookup(1.5f, 0.5f);
+  EXPECT_EQ(value.x, 0.0f);
+  EXPECT_EQ(value.w, 0.0f);
+
+  cache.remove_image(image);
+}
+
+TEST_F(RenderTextureCache, Statistics)
+{
+  TextureCache cache(1024 * 1024);
+  TextureCacheImage *image = cache.add_image(
+      ustring(filepath), u_colorspace_raw, INTERPOLATION_CLOSEST, EXTENSION_REPEAT);
+
+  /* Only the tile that is sampled is read, looking it up again is a hit. */
+  lookup_pixel(image, 0, 0);
+  lookup_pixel(image, 1, 0);
+
+  RenderStats stats;
+  cache.collect_statistics(&stats);
+  EXPECT_EQ(stats.image.cache_misses, 1);
+  EXPECT_GE(stats.image.cache_hits, 1);
+  EXPECT_GT(stats.image.cache_bytes_read, 0);
+  EXPECT_LT(stats.image.cache_bytes_read, (uint64_t)image_size * image_size * 3 * sizeof(float));
+  EXPECT_EQ(stats.image.cache_memory_limit, 1024 * 1024);
+
+  cache.remove_image(image);
+}
+
+CCL_NAMESPACE_END
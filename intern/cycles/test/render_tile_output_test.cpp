@@ -0,0 +1,218 @@
+/*
+ * Copyright 2011-2021 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "testing/testing.h"
+
+#include "device/device.h"
+
+#include "render/buffers.h"
+#include "render/film.h"
+#include "render/tile_output.h"
+
+#include "util/util_foreach.h"
+#include "util/util_image.h"
+#include "util/util_path.h"
+#include "util/util_stats.h"
+#include "util/util_vector.h"
+
+CCL_NAMESPACE_BEGIN
+
+namespace {
+
+const int width = 50;
+const int height = 40;
+
+int pass_id(PassType type)
+{
+  return (type == PASS_COMBINED) ? 0 : (type == PASS_DEPTH) ? 1 : 2;
+}
+
+/* Value of a pass channel at a pixel, in render buffer coordinates. */
+float pass_value(int pass, int x, int y, int c)
+{
+  return 0.7f + pass * 100.0f + x + y * 0.5f + c * 0.25f;
+}
+
+class RenderTileOutput : public testing::Test {
+ protected:
+  Stats stats;
+  Profiler profiler;
+  DeviceInfo device_info;
+  Device *device_cpu;
+  BufferParams params;
+  RenderBuffers *buffers;
+
+  virtual void SetUp()
+  {
+    device_cpu = Device::create(device_info, stats, profiler, true);
+
+    params.width = params.full_width = width;
+    params.height = params.full_height = height;
+    /* Unnamed built-in passes next to the combined pass. */
+    Pass::add(PASS_DEPTH, params.passes);
+    Pass::add(PASS_NORMAL, params.passes);
+
+    buffers = new RenderBuffers(device_cpu);
+    buffers->reset(params);
+
+    const int samples = 2;
+    const int pass_stride = params.get_passes_size();
+    float *data = buffers->buffer.data();
+    int pass_offset = 0;
+
+    foreach (const Pass &pass, params.passes) {
+      const int id = pass_id(pass.type);
+      /* Filtered passes are divided by the number of samples. */
+      const float scale = pass.filter ? samples : 1.0f;
+      for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+          float *pixel = data + ((size_t)y * width + x) * pass_stride + pass_offset;
+          for (int c = 0; c < pass.components; c++) {
+            pixel[c] = pass_value(id, x, y, c) * scale;
+          }
+        }
+      }
+      pass_offset += pass.components;
+    }
+  }
+
+  virtual void TearDown()
+  {
+    delete buffers;
+    delete device_cpu;
+  }
+
+  /* Write the image in render tiles that are not aligned with the file tiles, in an order
+   * different from the file. */
+  void write(TileImageOutput &output, const int2 render_tile_size)
+  {
+    ASSERT_TRUE(output.open(params, 2)) << output.error;
+
+    vector<int4> tiles;
+    for (int y = 0; y < height; y += render_tile_size.y) {
+      for (int x = 0; x < width; x += render_tile_size.x) {
+        tiles.push_back(make_int4(
+            x, y, min(render_tile_size.x, width - x), min(render_tile_size.y, height - y)));
+      }
+    }
+
+    for (int i = tiles.size() - 1; i >= 0; i--) {
+      RenderTile rtile;
+      rtile.x = tiles[i].x;
+      rtile.y = tiles[i].y;
+      rtile.w = tiles[i].z;
+      rtile.h = tiles[i].w;
+      rtile.sample = 2;
+      rtile.buffers = buffers;
+      EXPECT_TRUE(output.write_tile(rtile)) << output.error;
+    }
+
+    EXPECT_TRUE(output.close()) << output.error;
+  }
+
+  /* Read the file back and compare with the render buffers, with a relative tolerance. */
+  void verify(const string &filepath, TypeDesc format, float tolerance)
+  {
+    unique_ptr<ImageInput> in(ImageInput::open(filepath));
+    ASSERT_TRUE(in);
+
+    const ImageSpec &spec = in->spec();
+    EXPECT_EQ(spec.width, width);
+    EXPECT_EQ(spec.height, height);
+    EXPECT_EQ(spec.tile_width, 16);
+    EXPECT_EQ(spec.tile_height, 16);
+    EXPECT_EQ(spec.format, format);
+
+    /* RGBA combined, Z depth and XYZ normal. */
+    const char *channel_names[] = {"View Layer.Combined.R",
+                                   "View Layer.Combined.G",
+                                   "View Layer.Combined.B",
+                                   "View Layer.Combined.A",
+                                   "View Layer.depth.Z",
+                                   "View Layer.normal.X",
+                                   "View Layer.normal.Y",
+                                   "View Layer.normal.Z"};
+    const int num_channels = sizeof(channel_names) / sizeof(*channel_names);
+    ASSERT_EQ(spec.nchannels, num_channels);
+
+    /* OpenEXR may store channels in a different order, look them up by name. */
+    int channel_index[num_channels];
+    for (int i = 0; i < num_channels; i++) {
+      channel_index[i] = spec.channelindex(channel_names[i]);
+      ASSERT_GE(channel_index[i], 0) << channel_names[i];
+    }
+
+    vector<float> pixels((size_t)width * height * num_channels);
+    ASSERT_TRUE(in->read_image(TypeDesc::FLOAT, pixels.data()));
+    in->close();
+
+    const int channel_pass[] = {pass_id(PASS_COMBINED),
+                                pass_id(PASS_COMBINED),
+                                pass_id(PASS_COMBINED),
+                                pass_id(PASS_COMBINED),
+                                pass_id(PASS_DEPTH),
+                                pass_id(PASS_NORMAL),
+                                pass_id(PASS_NORMAL),
+                                pass_id(PASS_NORMAL)};
+    const int channel_component[] = {0, 1, 2, 3, 0, 0, 1, 2};
+
+    for (int y = 0; y < height; y++) {
+      for (int x = 0; x < width; x++) {
+        /* Files are stored top to bottom. */
+        const float *pixel = pixels.data() + ((size_t)(height - 1 - y) * width + x) * num_channels;
+        for (int i = 0; i < num_channels; i++) {
+          float expected = pass_value(channel_pass[i], x, y, channel_component[i]);
+          if (i == 3) {
+            /* Alpha is clamped. */
+            expected = 1.0f;
+          }
+          ASSERT_NEAR(pixel[channel_index[i]], expected, expected * tolerance)
+              << channel_names[i] << " at " << x << ", " << y;
+        }
+      }
+    }
+  }
+};
+
+}  // namespace
+
+TEST_F(RenderTileOutput, Float)
+{
+  TileImageOutput output;
+  output.filepath = path_join(testing::TempDir(), "cycles_tile_output_float.exr");
+  output.tile_size = make_int2(16, 16);
+
+  write(output, make_int2(20, 12));
+  verify(output.filepath, TypeDesc::FLOAT, 1e-6f);
+
+  path_remove(output.filepath);
+}
+
+TEST_F(RenderTileOutput, Half)
+{
+  TileImageOutput output;
+  output.filepath = path_join(testing::TempDir(), "cycles_tile_output_half.exr");
+  output.tile_size = make_int2(16, 16);
+  output.use_half = true;
+
+  /* Rounded to the nearest half, truncating would give up to twice the error. */
+  write(output, make_int2(20, 12));
+  verify(output.filepath, TypeDesc::HALF, 1.0f / 2048.0f);
+
+  path_remove(output.filepath);
+}
+
+CCL_NAMESPACE_END
@@ -0,0 +1,126 @@
+/*
+ * Copyright 2011-2021 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "testing/testing.h"
+
+#include "kernel/kernel_types.h"
+
+#include "util/util_half.h"
+#include "util/util_hash.h"
+#include "util/util_math.h"
+
+CCL_NAMESPACE_BEGIN
+
+/* Encoding and decoding used for compact geometry storage. */
+
+static float3 random_unit_vector(uint i)
+{
+  const float u = hash_uint2_to_float(i, 0) * 2.0f - 1.0f;
+  const float phi = hash_uint2_to_float(i, 1) * M_2PI_F;
+  const float r = sqrtf(max(1.0f - u * u, 0.0f));
+  return make_float3(r * cosf(phi), r * sinf(phi), u);
+}
+
+TEST(compact_geometry, OctahedralNormal)
+{
+  /* Axes, diagonals and points near the fold of the octahedron. */
+  const float3 special[] = {make_float3(1.0f, 0.0f, 0.0f),
+                            make_float3(-1.0f, 0.0f, 0.0f),
+                            make_float3(0.0f, 1.0f, 0.0f),
+                            make_float3(0.0f, -1.0f, 0.0f),
+                            make_float3(0.0f, 0.0f, 1.0f),
+                            make_float3(0.0f, 0.0f, -1.0f),
+                            normalize(make_float3(1.0f, 1.0f, 1.0f)),
+                            normalize(make_float3(-1.0f, -1.0f, -1.0f)),
+                            normalize(make_float3(1.0f, -1.0f, -1e-6f)),
+                            normalize(make_float3(-1.0f, 1.0f, 1e-6f))};
+
+  const int num_special = sizeof(special) / sizeof(*special);
+  float max_angle = 0.0f;
+  for (int i = 0; i < 100000 + num_special; i++) {
+    const float3 n = (i < num_special) ? special[i] : random_unit_vector(i);
+    const float3 decoded = oct_to_float3(float3_to_oct(n));
+    EXPECT_NEAR(len(decoded), 1.0f, 1e-6f);
+    /* More precise than acos() of the dot product for small angles. */
+    max_angle = max(max_angle, atan2f(len(cross(n, decoded)), dot(n, decoded)));
+  }
+
+  /* Two 16 bit components give a maximum error of about 0.004 degrees. */
+  EXPECT_LT(max_angle, 0.005f * M_PI_F / 180.0f);
+
+  /* Zero vectors from degenerate faces survive encoding. */
+  EXPECT_EQ(oct_to_float3(float3_to_oct(zero_float3())), zero_float3());
+}
+
+TEST(compact_geometry, Half2)
+{
+  /* Exactly representable values. */
+  const float exact[] = {0.0f, 1.0f, -1.0f, 0.5f, 0.25f, 1024.0f, -2048.0f, 65504.0f};
+  for (const float f : exact) {
+    const float2 decoded = half2_to_float2(float2_to_half2(make_float2(f, -f)));
+    EXPECT_EQ(decoded.x, f);
+    EXPECT_EQ(decoded.y, -f);
+  }
+
+  /* Packing truncates the mantissa to 10 bits, so the relative error is below 2^-10. */
+  for (int i = 0; i < 100000; i++) {
+    const float2 uv = make_float2(hash_uint2_to_float(i, 0) * 4.0f - 2.0f,
+                                  hash_uint2_to_float(i, 1) * 100.0f);
+    const float2 decoded = half2_to_float2(float2_to_half2(uv));
+    if (fabsf(uv.x) >= 6.1035e-5f) {
+      EXPECT_LE(fabsf(decoded.x - uv.x), fabsf(uv.x) * (1.0f / 1024.0f));
+    }
+    if (fabsf(uv.y) >= 6.1035e-5f) {
+      EXPECT_LE(fabsf(decoded.y - uv.y), fabsf(uv.y) * (1.0f / 1024.0f));
+    }
+  }
+
+  /* Values too small for a normal half flush to zero. */
+  const float2 tiny = half2_to_float2(float2_to_half2(make_float2(1e-6f, -1e-6f)));
+  EXPECT_EQ(tiny.x, 0.0f);
+  EXPECT_EQ(tiny.y, 0.0f);
+}
+
+TEST(compact_geometry, TriangleIndexDeltas)
+{
+  const int max = TRI_VINDEX_DELTA_MAX;
+  const uint firsts[] = {(uint)max, 100000u, 0x7fffffffu, 0xffffffffu - (uint)max};
+  const int deltas[] = {0, 1, -1, 2, -2, 1000, -1000, max - 1, -max + 1, max, -max};
+
+  for (const uint v0 : firsts) {
+    for (const int d1 : deltas) {
+      for (const int d2 : deltas) {
+        const uint v1 = v0 + d1;
+        const uint v2 = v0 + d2;
+        uint packed;
+        ASSERT_TRUE(tri_vindex_pack_deltas(v0, v1, v2, &packed));
+        /* The overflow bit stays free. */
+        EXPECT_EQ(packed & TRI_VINDEX_OVERFLOW, 0);
+        const uint2 decoded = tri_vindex_unpack_deltas(v0, packed);
+        EXPECT_EQ(decoded.x, v1);
+        EXPECT_EQ(decoded.y, v2);
+      }
+    }
+  }
+
+  /* Offsets that do not fit go to the overflow table. */
+  uint packed;
+  EXPECT_FALSE(tri_vindex_pack_deltas(100000, 100000 + max + 1, 100000, &packed));
+  EXPECT_FALSE(tri_vindex_pack_deltas(100000, 100000, 100000 - max - 1, &packed));
+  EXPECT_FALSE(tri_vindex_pack_deltas(0, 0x7fffffff, 1, &packed));
+}
+
+CCL_NAMESPACE_END
@@ -82,6 +82,15 @@ class DebugFlags {
 
     /* Whether split kernel is used */
     bool split_kernel;
+
+    /* Number of path states each stage of the split kernel processes per
+     * invocation. Larger values keep more rays in flight, so every stage runs
+     * over a batch of rays and shader evaluation can be sorted by shader. */
+    int split_kernel_batch_size;
+
+    /* Whether surface shaders which only use the most common nodes are evaluated with the
+     * specialized SVM loop instead of the generic one. */
+    bool svm_specialization;
   };
 
   /* Descriptor of CUDA feature-set to be used. */
@@ -28,6 +28,23 @@ CCL_NAMESPACE_BEGIN
 
 /* Half Floats */
 
+/* Two half floats packed into a uint, as written by float2_to_half2(). Denormals are flushed to
+ * zero when packing, so only zero needs special handling. */
+ccl_device_inline float half2_component_to_float(uint h)
+{
+  const uint sign = (h & 0x8000) << 16;
+  if ((h & 0x7c00) == 0) {
+    return __uint_as_float(sign);
+  }
+  return __uint_as_float(sign | (((h & 0x7fff) + 0x1C000) << 13));
+}
+
+ccl_device_inline float2 half2_to_float2(uint packed)
+{
+  return make_float2(half2_component_to_float(packed & 0xffff),
+                     half2_component_to_float(packed >> 16));
+}
+
 #ifdef __KERNEL_OPENCL__
 
 #  define float4_store_half(h, f, scale) vstore_half4(f *(scale), 0, h);
@@ -160,6 +177,12 @@ ccl_device_inline half float_to_half(float f)
   return (value_bits | sign_bit);
 }
 
+ccl_device_inline uint float2_to_half2(float2 f)
+{
+  return (uint)(unsigned short)float_to_half(f.x) |
+         ((uint)(unsigned short)float_to_half(f.y) << 16);
+}
+
 #  endif
 
 #endif
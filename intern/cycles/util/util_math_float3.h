@@ -533,6 +533,47 @@ ccl_device_inline float3 ensure_finite3(float3 v)
   return v;
 }
 
+/* Octahedral encoding of a unit vector into two 16 bit signed normalized integers packed into
+ * a single uint. The otherwise unused value 0x80008000 is reserved for the zero vector, which
+ * degenerate faces can produce. */
+ccl_device_inline uint float3_to_oct(float3 n)
+{
+  const float len = fabsf(n.x) + fabsf(n.y) + fabsf(n.z);
+  if (!(len > 0.0f)) {
+    return 0x80008000;
+  }
+
+  float u = n.x / len;
+  float v = n.y / len;
+  if (n.z < 0.0f) {
+    const float fold_u = (1.0f - fabsf(v)) * signf(u);
+    const float fold_v = (1.0f - fabsf(u)) * signf(v);
+    u = fold_u;
+    v = fold_v;
+  }
+
+  const int qu = (int)floorf(clamp(u, -1.0f, 1.0f) * 32767.0f + 0.5f);
+  const int qv = (int)floorf(clamp(v, -1.0f, 1.0f) * 32767.0f + 0.5f);
+  return ((uint)qu & 0xffff) | ((uint)qv << 16);
+}
+
+ccl_device_inline float3 oct_to_float3(uint packed)
+{
+  if (packed == 0x80008000) {
+    return make_float3(0.0f, 0.0f, 0.0f);
+  }
+
+  /* Sign extend both 16 bit halves. */
+  const float u = (float)((int)(packed << 16) >> 16) * (1.0f / 32767.0f);
+  const float v = (float)((int)packed >> 16) * (1.0f / 32767.0f);
+  float3 n = make_float3(u, v, 1.0f - fabsf(u) - fabsf(v));
+  if (n.z < 0.0f) {
+    n.x = (1.0f - fabsf(v)) * signf(u);
+    n.y = (1.0f - fabsf(u)) * signf(v);
+  }
+  return normalize(n);
+}
+
 CCL_NAMESPACE_END
 
 #endif /* __UTIL_MATH_FLOAT3_H__ */
@@ -40,6 +40,7 @@ void Profiler::run()
       uint32_t cur_event = state->event;
       int32_t cur_shader = state->shader;
       int32_t cur_object = state->object;
+      int32_t cur_intersect_object = state->intersect_object;
 
       /* The state reads/writes should be atomic, but just to be sure
        * check the values for validity anyways. */
@@ -55,11 +56,19 @@ void Profiler::run()
              (cur_event <= PROFILING_CLOSURE_VOLUME_SAMPLE))) {
           shader_samples[cur_shader]++;
         }
+        if (cur_event == PROFILING_SHADER_EVAL) {
+          shader_eval_samples[cur_shader]++;
+        }
       }
 
       if (cur_object >= 0 && cur_object < object_samples.size()) {
         object_samples[cur_object]++;
       }
+
+      if (cur_intersect_object >= 0 && cur_intersect_object < object_intersect_samples.size() &&
+          cur_event >= PROFILING_INTERSECT && cur_event <= PROFILING_INTERSECT_VOLUME_ALL) {
+        object_intersect_samples[cur_intersect_object]++;
+      }
     }
     lock.unlock();
 
@@ -82,10 +91,18 @@ void Profiler::reset(int num_shaders, int num_objects)
   /* Resize and clear the accumulation vectors. */
   shader_hits.assign(num_shaders, 0);
   object_hits.assign(num_objects, 0);
+  shader_evals.assign(num_shaders, 0);
 
   event_samples.assign(PROFILING_NUM_EVENTS, 0);
   shader_samples.assign(num_shaders, 0);
   object_samples.assign(num_objects, 0);
+  shader_eval_samples.assign(num_shaders, 0);
+  object_intersect_samples.assign(num_objects, 0);
+
+  for (int i = 0; i < PROFILING_NUM_RAY_TYPES; i++) {
+    curve_segments[i] = ProfilingCurveSegments();
+    rays[i] = 0;
+  }
 
   if (running) {
     start();
@@ -121,11 +138,17 @@ void Profiler::add_state(ProfilingState *state)
   /* Resize thread-local hit counters. */
   state->shader_hits.assign(shader_hits.size(), 0);
   state->object_hits.assign(object_hits.size(), 0);
+  state->shader_evals.assign(shader_evals.size(), 0);
+  for (int i = 0; i < PROFILING_NUM_RAY_TYPES; i++) {
+    state->curve_segments[i] = ProfilingCurveSegments();
+    state->rays[i] = 0;
+  }
 
   /* Initialize the state. */
   state->event = PROFILING_UNKNOWN;
   state->shader = -1;
   state->object = -1;
+  state->intersect_object = -1;
   state->active = true;
 }
 
@@ -147,6 +170,18 @@ void Profiler::remove_state(ProfilingState *state)
   for (int i = 0; i < object_hits.size(); i++) {
     object_hits[i] += state->object_hits[i];
   }
+
+  assert(shader_evals.size() == state->shader_evals.size());
+  for (int i = 0; i < shader_evals.size(); i++) {
+    shader_evals[i] += state->shader_evals[i];
+  }
+
+  for (int i = 0; i < PROFILING_NUM_RAY_TYPES; i++) {
+    curve_segments[i].culled += state->curve_segments[i].culled;
+    curve_segments[i].tested += state->curve_segments[i].tested;
+    curve_segments[i].hits += state->curve_segments[i].hits;
+    rays[i] += state->rays[i];
+  }
 }
 
 uint64_t Profiler::get_event(ProfilingEvent event)
@@ -177,4 +212,37 @@ bool Profiler::get_object(int object, uint64_t &samples, uint64_t &hits)
   return true;
 }
 
+bool Profiler::get_shader_eval(int shader, uint64_t &samples, uint64_t &evals)
+{
+  assert(worker == NULL);
+  if (shader_eval_samples[shader] == 0) {
+    return false;
+  }
+  samples = shader_eval_samples[shader];
+  evals = shader_evals[shader];
+  return true;
+}
+
+bool Profiler::get_object_intersect(int object, uint64_t &samples)
+{
+  assert(worker == NULL);
+  if (object_intersect_samples[object] == 0) {
+    return false;
+  }
+  samples = object_intersect_samples[object];
+  return true;
+}
+
+ProfilingCurveSegments Profiler::get_curve_segments(ProfilingRayType ray_type)
+{
+  assert(worker == NULL);
+  return curve_segments[ray_type];
+}
+
+uint64_t Profiler::get_rays(ProfilingRayType ray_type)
+{
+  assert(worker == NULL);
+  return rays[ray_type];
+}
+
 CCL_NAMESPACE_END
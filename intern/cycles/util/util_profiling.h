@@ -64,6 +64,23 @@ enum ProfilingEvent : uint32_t {
   PROFILING_NUM_EVENTS,
 };
 
+/* Ray types for which traced rays and curve intersection statistics are counted separately. */
+enum ProfilingRayType : uint32_t {
+  PROFILING_RAY_CAMERA,
+  PROFILING_RAY_SHADOW,
+  PROFILING_RAY_INDIRECT,
+
+  PROFILING_NUM_RAY_TYPES,
+};
+
+/* Curve segments in BVH leaves: skipped by the bounding sphere test, fully intersected, and
+ * those that were hit. */
+struct ProfilingCurveSegments {
+  uint64_t culled = 0;
+  uint64_t tested = 0;
+  uint64_t hits = 0;
+};
+
 /* Contains the current execution state of a worker thread.
  * These values are constantly updated by the worker.
  * Periodically the profiler thread will wake up, read them
@@ -81,10 +98,32 @@ struct ProfilingState {
   volatile uint32_t event = PROFILING_UNKNOWN;
   volatile int32_t shader = -1;
   volatile int32_t object = -1;
+  /* Object whose primitives are being intersected during BVH traversal. */
+  volatile int32_t intersect_object = -1;
   volatile bool active = false;
 
   vector<uint64_t> shader_hits;
   vector<uint64_t> object_hits;
+  vector<uint64_t> shader_evals;
+  ProfilingCurveSegments curve_segments[PROFILING_NUM_RAY_TYPES];
+  uint64_t rays[PROFILING_NUM_RAY_TYPES];
+
+  inline void add_ray(ProfilingRayType ray_type)
+  {
+    if (active) {
+      rays[ray_type]++;
+    }
+  }
+
+  inline void add_curve_segments(ProfilingRayType ray_type, int culled, int tested, int hits)
+  {
+    if (active) {
+      ProfilingCurveSegments &segments = curve_segments[ray_type];
+      segments.culled += culled;
+      segments.tested += tested;
+      segments.hits += hits;
+    }
+  }
 };
 
 class Profiler {
@@ -103,6 +142,10 @@ class Profiler {
   uint64_t get_event(ProfilingEvent event);
   bool get_shader(int shader, uint64_t &samples, uint64_t &hits);
   bool get_object(int object, uint64_t &samples, uint64_t &hits);
+  bool get_shader_eval(int shader, uint64_t &samples, uint64_t &evals);
+  bool get_object_intersect(int object, uint64_t &samples);
+  ProfilingCurveSegments get_curve_segments(ProfilingRayType ray_type);
+  uint64_t get_rays(ProfilingRayType ray_type);
 
  protected:
   void run();
@@ -121,6 +164,20 @@ class Profiler {
   vector<uint64_t> shader_hits;
   vector<uint64_t> object_hits;
 
+  /* Tracks how often the worker was evaluating each shader while sampling, and how many times
+   * each shader was evaluated, which together give the shader evaluation throughput. */
+  vector<uint64_t> shader_eval_samples;
+  vector<uint64_t> shader_evals;
+
+  /* Tracks how often the worker was intersecting primitives of each object while sampling. */
+  vector<uint64_t> object_intersect_samples;
+
+  /* Tracks how many curve segments were culled and intersected during BVH traversal. */
+  ProfilingCurveSegments curve_segments[PROFILING_NUM_RAY_TYPES];
+
+  /* Number of rays traced of each type. */
+  uint64_t rays[PROFILING_NUM_RAY_TYPES];
+
   volatile bool do_stop_worker;
   thread *worker;
 
@@ -150,6 +207,14 @@ class ProfilingHelper {
     }
   }
 
+  inline void add_shader_eval(int shader)
+  {
+    if (state->active) {
+      assert(shader < state->shader_evals.size());
+      state->shader_evals[shader]++;
+    }
+  }
+
   inline void set_object(int object)
   {
     state->object = object;
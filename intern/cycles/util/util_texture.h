@@ -50,6 +50,7 @@ typedef enum ImageDataType {
   IMAGE_DATA_TYPE_USHORT = 7,
   IMAGE_DATA_TYPE_NANOVDB_FLOAT = 8,
   IMAGE_DATA_TYPE_NANOVDB_FLOAT3 = 9,
+  IMAGE_DATA_TYPE_TEXTURE_CACHE = 10,
 
   IMAGE_DATA_NUM_TYPES
 } ImageDataType;
@@ -96,6 +97,20 @@ typedef struct TextureInfo {
   Transform transform_3d;
 } TextureInfo;
 
+#ifndef __KERNEL_GPU__
+/* Image sampled on demand through a texture cache instead of being loaded into memory, only
+ * supported on the CPU. The texture data of such an image holds a pointer to it. */
+class TextureCacheImage {
+ public:
+  virtual ~TextureCacheImage()
+  {
+  }
+
+  /* RGBA in scene linear color space at image coordinates x and y. */
+  virtual float4 lookup(float x, float y) const = 0;
+};
+#endif
+
 CCL_NAMESPACE_END
 
 #endif /* __UTIL_TEXTURE_H__ */
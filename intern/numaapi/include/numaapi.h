@@ -25,6 +25,7 @@
 
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -33,6 +34,14 @@ extern "C" {
 #define NUMAAPI_VERSION_MAJOR 1
 #define NUMAAPI_VERSION_MINOR 0
 
+// Affinity of a thread, as stored by numaAPI_GetThreadAffinity().
+//
+// The storage is platform-specific and large enough for a cpu_set_t on Linux
+// and a GROUP_AFFINITY on Windows.
+typedef struct NUMAAPI_ThreadAffinity {
+  uint64_t data[16];
+} NUMAAPI_ThreadAffinity;
+
 typedef enum NUMAAPI_Result {
   NUMAAPI_SUCCESS       = 0,
   // NUMA is not available on this platform.
@@ -97,6 +106,18 @@ bool numaAPI_RunProcessOnNode(int node);
 // Returns truth if affinity has successfully changed.
 bool numaAPI_RunThreadOnNode(int node);
 
+// Store affinity of the current thread, so it can be restored after running
+// it on a specific node.
+//
+// Returns truth if affinity has successfully been stored.
+bool numaAPI_GetThreadAffinity(NUMAAPI_ThreadAffinity* affinity);
+
+// Restore affinity of the current thread previously stored with
+// numaAPI_GetThreadAffinity().
+//
+// Returns truth if affinity has successfully changed.
+bool numaAPI_SetThreadAffinity(const NUMAAPI_ThreadAffinity* affinity);
+
 ////////////////////////////////////////////////////////////////////////////////
 // Memory management.
 
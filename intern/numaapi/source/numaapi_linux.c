@@ -20,12 +20,18 @@
 //
 // Author: Sergey Sharybin <sergey.vfx@gmail.com>
 
+// Needed for sched_getaffinity() and sched_setaffinity().
+#ifndef _GNU_SOURCE
+#  define _GNU_SOURCE
+#endif
+
 #include "build_config.h"
 
 #if OS_LINUX
 
 #include "numaapi.h"
 
+#include <sched.h>
 #include <stdlib.h>
 
 #ifndef WITH_DYNLOAD
@@ -276,6 +282,22 @@ bool numaAPI_RunThreadOnNode(int node) {
   return true;
 }
 
+// NOTE: Running on a node changes the CPU affinity of the thread, so storing
+// and restoring that is enough to undo it. With pid 0 sched_getaffinity() and
+// sched_setaffinity() apply to the calling thread.
+
+bool numaAPI_GetThreadAffinity(NUMAAPI_ThreadAffinity* affinity) {
+  _Static_assert(sizeof(cpu_set_t) <= sizeof(affinity->data),
+                 "Thread affinity storage is too small");
+  return sched_getaffinity(0, sizeof(cpu_set_t),
+                           (cpu_set_t*)affinity->data) == 0;
+}
+
+bool numaAPI_SetThreadAffinity(const NUMAAPI_ThreadAffinity* affinity) {
+  return sched_setaffinity(0, sizeof(cpu_set_t),
+                           (const cpu_set_t*)affinity->data) == 0;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // Memory management.
 
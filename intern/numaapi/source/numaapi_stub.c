@@ -72,6 +72,16 @@ bool numaAPI_RunThreadOnNode(int node) {
   return false;
 }
 
+bool numaAPI_GetThreadAffinity(NUMAAPI_ThreadAffinity* affinity) {
+  (void) affinity;  // Ignored.
+  return false;
+}
+
+bool numaAPI_SetThreadAffinity(const NUMAAPI_ThreadAffinity* affinity) {
+  (void) affinity;  // Ignored.
+  return false;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // Memory management.
 
@@ -41,6 +41,7 @@
 
 #include <stdlib.h>
 #include <stdint.h>
+#include <string.h>
 #include <windows.h>
 
 #if ARCH_CPU_64_BITS
@@ -262,6 +263,24 @@ bool numaAPI_RunThreadOnNode(int node) {
   return true;
 }
 
+bool numaAPI_GetThreadAffinity(NUMAAPI_ThreadAffinity* affinity) {
+  if (_GetThreadGroupAffinity == NULL) {
+    return false;
+  }
+  GROUP_AFFINITY* group_affinity = (GROUP_AFFINITY*)affinity->data;
+  memset(group_affinity, 0, sizeof(*group_affinity));
+  return _GetThreadGroupAffinity(GetCurrentThread(), group_affinity) != 0;
+}
+
+bool numaAPI_SetThreadAffinity(const NUMAAPI_ThreadAffinity* affinity) {
+  if (_SetThreadGroupAffinity == NULL) {
+    return false;
+  }
+  return _SetThreadGroupAffinity(GetCurrentThread(),
+                                 (const GROUP_AFFINITY*)affinity->data,
+                                 NULL) != 0;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // Memory management.
 
@@ -275,7 +275,10 @@ void BKE_mesh_calc_normals_poly_and_vertex(MVert *mvert,
 
   /* First go through and calculate normals for all the polys. */
   if (vnors == nullptr) {
-    vnors = (float(*)[3])MEM_calloc_arrayN((size_t)mvert_len, sizeof(*vnors), __func__);
+    /* Zeroed split over NUMA nodes, so the temporary normals are local to the threads
+     * finalizing them. */
+    vnors = (float(*)[3])MEM_malloc_arrayN((size_t)mvert_len, sizeof(*vnors), __func__);
+    BLI_task_numa_first_touch(vnors, sizeof(*vnors), mvert_len);
     free_vnors = true;
   }
   else {
@@ -293,7 +296,9 @@ void BKE_mesh_calc_normals_poly_and_vertex(MVert *mvert,
   BLI_task_parallel_range(
       0, mpoly_len, &data, mesh_calc_normals_poly_and_vertex_accum_fn, &settings);
 
-  /* Normalize and validate computed vertex normals (`vnors`). */
+  /* Normalize and validate computed vertex normals (`vnors`).
+   * Vertices are processed in order, so the same split over NUMA nodes as for zeroing applies. */
+  settings.use_numa_affinity = true;
   BLI_task_parallel_range(
       0, mvert_len, &data, mesh_calc_normals_poly_and_vertex_finalize_fn, &settings);
 
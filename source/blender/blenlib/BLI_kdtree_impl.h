@@ -27,6 +27,7 @@
 #define BLI_kdtree_nd_(id) _BLI_CONCAT(KDTREE_PREFIX_ID, _##id)
 
 struct KDTree;
+struct MemArena;
 typedef struct KDTree KDTree;
 
 typedef struct KDTreeNearest {
@@ -67,6 +68,19 @@ void BLI_kdtree_nd_(range_search_cb)(
     bool (*search_cb)(void *user_data, int index, const float co[KD_DIMS], float dist_sq),
     void *user_data);
 
+/* Batched searches, for many points at once using multiple threads. */
+void BLI_kdtree_nd_(find_nearest_batch)(const KDTree *tree,
+                                        const float (*co)[KD_DIMS],
+                                        const uint co_len,
+                                        KDTreeNearest *r_nearest) ATTR_NONNULL(1, 4);
+int BLI_kdtree_nd_(range_search_batch)(const KDTree *tree,
+                                       const float (*co)[KD_DIMS],
+                                       const uint co_len,
+                                       const float range,
+                                       struct MemArena *arena,
+                                       KDTreeNearest **r_nearest,
+                                       uint *r_nearest_offsets) ATTR_NONNULL(1, 5, 6, 7);
+
 int BLI_kdtree_nd_(calc_duplicates_fast)(const KDTree *tree,
                                          const float range,
                                          bool use_index_order,
@@ -47,6 +47,9 @@ struct BLI_mempool;
 void BLI_task_scheduler_init(void);
 void BLI_task_scheduler_exit(void);
 int BLI_task_scheduler_num_threads(void);
+/* Number of NUMA nodes work can be split over,
+ * 1 when all processors are on a single node or NUMA is not supported. */
+int BLI_task_scheduler_num_numa_nodes(void);
 
 /* Task Pool
  *
@@ -176,6 +179,13 @@ typedef struct TaskParallelSettings {
    * having a global use_threading switch based on just range size.
    */
   int min_iter_per_thread;
+  /* Split the range over NUMA nodes first, in proportion to their number of processors,
+   * each part is only processed by threads running on its node.
+   * A range is always split the same way, so memory first written by such a loop
+   * (see #BLI_task_numa_first_touch) is local to the threads processing it in later loops.
+   * Has no effect when there is a single NUMA node.
+   */
+  bool use_numa_affinity;
 } TaskParallelSettings;
 
 BLI_INLINE void BLI_parallel_range_settings_defaults(TaskParallelSettings *settings);
@@ -186,6 +196,12 @@ void BLI_task_parallel_range(const int start,
                              TaskParallelRangeFunc func,
                              const TaskParallelSettings *settings);
 
+/* Fill a newly allocated array with zeros, split over NUMA nodes the same way as a range
+ * with #TaskParallelSettings.use_numa_affinity.
+ * Operating systems put memory on the node of the thread that first writes to it,
+ * so this places the items of each node in its local memory. */
+void BLI_task_numa_first_touch(void *data, const size_t item_size, const int items_num);
+
 /* This data is shared between all tasks, its access needs thread lock or similar protection.
  */
 typedef struct TaskParallelIteratorStateShared {
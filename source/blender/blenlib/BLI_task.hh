@@ -43,11 +43,22 @@
 #  endif
 #endif
 
+#include "BLI_function_ref.hh"
 #include "BLI_index_range.hh"
 #include "BLI_utildefines.h"
 
 namespace blender::threading {
 
+namespace detail {
+/**
+ * Split the range over NUMA nodes in proportion to their number of processors and call the
+ * function for each part in a task running on its node. Without multiple nodes, the function is
+ * called for the whole range on the calling thread.
+ */
+void numa_nodes_execute(IndexRange range,
+                        FunctionRef<void(int node_index, IndexRange node_range)> function);
+}  // namespace detail
+
 template<typename Range, typename Function>
 void parallel_for_each(Range &range, const Function &function)
 {
@@ -77,6 +88,23 @@ void parallel_for(IndexRange range, int64_t grain_size, const Function &function
 #endif
 }
 
+/**
+ * Same as #parallel_for, with the range split over NUMA nodes first (see
+ * #TaskParallelSettings.use_numa_affinity), so arrays first written by such a loop are processed
+ * from local memory by later loops.
+ */
+template<typename Function>
+void parallel_for_numa(IndexRange range, int64_t grain_size, const Function &function)
+{
+  if (range.size() == 0) {
+    return;
+  }
+  detail::numa_nodes_execute(range,
+                             [&](const int /*node_index*/, const IndexRange node_range) {
+                               parallel_for(node_range, grain_size, function);
+                             });
+}
+
 template<typename Value, typename Function, typename Reduction>
 Value parallel_reduce(IndexRange range,
                       int64_t grain_size,
@@ -2077,6 +2077,329 @@ void BLI_bvhtree_ray_cast_all(BVHTree *tree,
 
 /** \} */
 
+/* -------------------------------------------------------------------- */
+/** \name BLI_bvhtree_find_nearest_batch / BLI_bvhtree_ray_cast_batch
+ *
+ * Queries are first ordered along a Morton curve, so neighboring queries visit the same nodes,
+ * then processed in parallel in packets of #BVH_BATCH_PACKET_SIZE queries.
+ *
+ * Nearest point queries in a packet are traversed together, each node is loaded once and tested
+ * against all queries of the packet that are still active. Rays diverge too much for that to
+ * pay off, they are traversed one after the other and only benefit from the ordering.
+ *
+ * \{ */
+
+#define BVH_BATCH_PACKET_SIZE 8
+#define BVH_BATCH_PACKETS_PER_THREAD 16
+/* Resolution of the grid used to order queries, bits per axis. */
+#define BVH_BATCH_SORT_BITS 5
+
+typedef struct BVHNearestPacket {
+  int len;
+  BVHNearestData data[BVH_BATCH_PACKET_SIZE];
+} BVHNearestPacket;
+
+typedef struct BVHBatchData {
+  BVHTree *tree;
+  const float (*co)[3];
+  const float (*dir)[3];
+  float radius;
+  const int *order;
+  int len;
+
+  BVHTreeNearest *nearest;
+  BVHTree_NearestPointCallback nearest_callback;
+  BVHTreeRayHit *hit;
+  BVHTree_RayCastCallback raycast_callback;
+  void *userdata;
+  int flag;
+} BVHBatchData;
+
+/* Spread the lower 10 bits of \a v, so there are two zero bits between each of them. */
+static uint bvh_batch_morton_expand(uint v)
+{
+  v &= 0x3ff;
+  v = (v | (v << 16)) & 0x030000ff;
+  v = (v | (v << 8)) & 0x0300f00f;
+  v = (v | (v << 4)) & 0x030c30c3;
+  v = (v | (v << 2)) & 0x09249249;
+  return v;
+}
+
+/**
+ * Order queries by the Morton code of their cell in a grid over the query bounds, with a
+ * counting sort since the order only needs to be coherent, not exact.
+ * Rays are grouped by the octant of their direction first.
+ *
+ * \return Array of query indices, to be freed by the caller.
+ */
+static int *bvh_batch_sort_order(const float (*co)[3], const float (*dir)[3], const int len)
+{
+  const uint cells = 1u << BVH_BATCH_SORT_BITS;
+  const int buckets_len = 1 << (3 * BVH_BATCH_SORT_BITS + (dir ? 3 : 0));
+  float min[3], max[3], scale[3];
+
+  INIT_MINMAX(min, max);
+  minmax_v3v3_v3_array(min, max, co, len);
+  for (int axis = 0; axis < 3; axis++) {
+    const float extent = max[axis] - min[axis];
+    scale[axis] = (extent > 0.0f) ? (float)(cells - 1) / extent : 0.0f;
+  }
+
+  uint *codes = MEM_mallocN(sizeof(*codes) * (size_t)len, __func__);
+  int *buckets = MEM_callocN(sizeof(*buckets) * (size_t)(buckets_len + 1), __func__);
+  int *order = MEM_mallocN(sizeof(*order) * (size_t)len, __func__);
+
+  for (int i = 0; i < len; i++) {
+    uint code = 0;
+    for (int axis = 0; axis < 3; axis++) {
+      const uint cell = (uint)((co[i][axis] - min[axis]) * scale[axis]);
+      code |= bvh_batch_morton_expand(MIN2(cell, cells - 1)) << axis;
+    }
+    if (dir) {
+      uint octant = 0;
+      octant |= (dir[i][0] < 0.0f) ? 1 : 0;
+      octant |= (dir[i][1] < 0.0f) ? 2 : 0;
+      octant |= (dir[i][2] < 0.0f) ? 4 : 0;
+      code |= octant << (3 * BVH_BATCH_SORT_BITS);
+    }
+    codes[i] = code;
+    buckets[code + 1]++;
+  }
+
+  for (int i = 0; i < buckets_len; i++) {
+    buckets[i + 1] += buckets[i];
+  }
+  for (int i = 0; i < len; i++) {
+    order[buckets[codes[i]]++] = i;
+  }
+
+  MEM_freeN(codes);
+  MEM_freeN(buckets);
+  return order;
+}
+
+static void bvhtree_batch_run(BVHBatchData *batch, TaskParallelRangeFunc func)
+{
+  const int packets_len = (batch->len + BVH_BATCH_PACKET_SIZE - 1) / BVH_BATCH_PACKET_SIZE;
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.use_threading = (batch->len > KDOPBVH_THREAD_LEAF_THRESHOLD);
+  settings.min_iter_per_thread = BVH_BATCH_PACKETS_PER_THREAD;
+  BLI_task_parallel_range(0, packets_len, batch, func, &settings);
+}
+
+/* Packet version of #dfs_find_nearest_dfs, \a active is a bit mask of queries to test. */
+static void dfs_find_nearest_packet(BVHNearestPacket *packet, BVHNode *node, uint active)
+{
+  float nearest[3];
+  uint inside = 0;
+  int first = -1;
+
+  for (int i = 0; i < packet->len; i++) {
+    if ((active & (1u << i)) &&
+        calc_nearest_point_squared(packet->data[i].proj, node, nearest) <
+            packet->data[i].nearest.dist_sq) {
+      inside |= 1u << i;
+      if (first == -1) {
+        first = i;
+      }
+    }
+  }
+
+  if (inside == 0) {
+    return;
+  }
+
+  if (node->totnode == 0) {
+    for (int i = first; i < packet->len; i++) {
+      if (inside & (1u << i)) {
+        BVHNearestData *data = &packet->data[i];
+        if (data->callback) {
+          data->callback(data->userdata, node->index, data->co, &data->nearest);
+        }
+        else {
+          data->nearest.index = node->index;
+          data->nearest.dist_sq = calc_nearest_point_squared(data->proj, node, data->nearest.co);
+        }
+      }
+    }
+  }
+  else {
+    /* Same heuristic as the single query to pick the closest node to dive on,
+     * using the first query still in the packet. */
+    if (packet->data[first].proj[node->main_axis] <=
+        node->children[0]->bv[node->main_axis * 2 + 1]) {
+      for (int i = 0; i != node->totnode; i++) {
+        dfs_find_nearest_packet(packet, node->children[i], inside);
+      }
+    }
+    else {
+      for (int i = node->totnode - 1; i >= 0; i--) {
+        dfs_find_nearest_packet(packet, node->children[i], inside);
+      }
+    }
+  }
+}
+
+static void bvhtree_find_nearest_batch_task_cb(void *__restrict userdata,
+                                               const int packet_index,
+                                               const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const BVHBatchData *batch = userdata;
+  const BVHTree *tree = batch->tree;
+  BVHNode *root = tree->nodes[tree->totleaf];
+  const int begin = packet_index * BVH_BATCH_PACKET_SIZE;
+  BVHNearestPacket packet;
+
+  packet.len = min_ii(BVH_BATCH_PACKET_SIZE, batch->len - begin);
+
+  for (int i = 0; i < packet.len; i++) {
+    const int index = batch->order[begin + i];
+    BVHNearestData *data = &packet.data[i];
+
+    data->tree = tree;
+    data->co = batch->co[index];
+    data->callback = batch->nearest_callback;
+    data->userdata = batch->userdata;
+
+    for (axis_t axis_iter = tree->start_axis; axis_iter != tree->stop_axis; axis_iter++) {
+      data->proj[axis_iter] = dot_v3v3(data->co, bvhtree_kdop_axes[axis_iter]);
+    }
+
+    memcpy(&data->nearest, &batch->nearest[index], sizeof(data->nearest));
+  }
+
+  if (root) {
+    if (batch->flag & BVH_NEAREST_OPTIMAL_ORDER) {
+      /* The priority queue is specific to each query. */
+      for (int i = 0; i < packet.len; i++) {
+        heap_find_nearest_begin(&packet.data[i], root);
+      }
+    }
+    else {
+      dfs_find_nearest_packet(&packet, root, (1u << packet.len) - 1);
+    }
+  }
+
+  for (int i = 0; i < packet.len; i++) {
+    memcpy(&batch->nearest[batch->order[begin + i]],
+           &packet.data[i].nearest,
+           sizeof(BVHTreeNearest));
+  }
+}
+
+/**
+ * Find the nearest node for each of the given coordinates, like #BLI_bvhtree_find_nearest_ex.
+ *
+ * \param r_nearest: Array of \a co_len items, must be initialized like the \a nearest
+ * argument of a single query, with the index and the squared distance to search within.
+ * \note Queries run in parallel, so the callback must be thread-safe.
+ */
+void BLI_bvhtree_find_nearest_batch(BVHTree *tree,
+                                    const float (*co)[3],
+                                    const int co_len,
+                                    BVHTreeNearest *r_nearest,
+                                    BVHTree_NearestPointCallback callback,
+                                    void *userdata,
+                                    int flag)
+{
+  if (co_len == 0) {
+    return;
+  }
+
+  BVHBatchData batch = {NULL};
+  batch.tree = tree;
+  batch.co = co;
+  batch.len = co_len;
+  batch.order = bvh_batch_sort_order(co, NULL, co_len);
+  batch.nearest = r_nearest;
+  batch.nearest_callback = callback;
+  batch.userdata = userdata;
+  batch.flag = flag;
+
+  bvhtree_batch_run(&batch, bvhtree_find_nearest_batch_task_cb);
+
+  MEM_freeN((void *)batch.order);
+}
+
+static void bvhtree_ray_cast_batch_task_cb(void *__restrict userdata,
+                                           const int packet_index,
+                                           const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const BVHBatchData *batch = userdata;
+  const BVHTree *tree = batch->tree;
+  BVHNode *root = tree->nodes[tree->totleaf];
+  const int begin = packet_index * BVH_BATCH_PACKET_SIZE;
+  const int end = min_ii(begin + BVH_BATCH_PACKET_SIZE, batch->len);
+  BVHRayCastData data;
+
+  data.tree = tree;
+  data.callback = batch->raycast_callback;
+  data.userdata = batch->userdata;
+  data.ray.radius = batch->radius;
+
+  for (int i = begin; i < end; i++) {
+    const int index = batch->order[i];
+
+    BLI_ASSERT_UNIT_V3(batch->dir[index]);
+
+    copy_v3_v3(data.ray.origin, batch->co[index]);
+    copy_v3_v3(data.ray.direction, batch->dir[index]);
+
+    bvhtree_ray_cast_data_precalc(&data, batch->flag);
+
+    memcpy(&data.hit, &batch->hit[index], sizeof(data.hit));
+
+    if (root) {
+      dfs_raycast(&data, root);
+    }
+
+    memcpy(&batch->hit[index], &data.hit, sizeof(data.hit));
+  }
+}
+
+/**
+ * Cast a ray for each of the given origins and directions, like #BLI_bvhtree_ray_cast_ex.
+ *
+ * \param r_hit: Array of \a ray_len items, must be initialized like the \a hit argument
+ * of a single ray cast, with index -1 and the maximum distance.
+ * \note Rays are cast in parallel, so the callback must be thread-safe.
+ */
+void BLI_bvhtree_ray_cast_batch(BVHTree *tree,
+                                const float (*co)[3],
+                                const float (*dir)[3],
+                                const int ray_len,
+                                float radius,
+                                BVHTreeRayHit *r_hit,
+                                BVHTree_RayCastCallback callback,
+                                void *userdata,
+                                int flag)
+{
+  if (ray_len == 0) {
+    return;
+  }
+
+  BVHBatchData batch = {NULL};
+  batch.tree = tree;
+  batch.co = co;
+  batch.dir = dir;
+  batch.radius = radius;
+  batch.len = ray_len;
+  batch.order = bvh_batch_sort_order(co, dir, ray_len);
+  batch.hit = r_hit;
+  batch.raycast_callback = callback;
+  batch.userdata = userdata;
+  batch.flag = flag;
+
+  bvhtree_batch_run(&batch, bvhtree_ray_cast_batch_task_cb);
+
+  MEM_freeN((void *)batch.order);
+}
+
+/** \} */
+
 /* -------------------------------------------------------------------- */
 /** \name BLI_bvhtree_range_query
  *
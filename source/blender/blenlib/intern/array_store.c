@@ -91,6 +91,7 @@
  *
  * An array is created to store hash values at every 'stride',
  * then stepped over to search for matching chunks.
+ * For large arrays the hash values are calculated in parallel.
  *
  * Once a match is found, there is a high chance next chunks match too,
  * so this is checked to avoid performing so many hash-lookups.
@@ -102,8 +103,10 @@
 
 #include "MEM_guardedalloc.h"
 
+#include "BLI_bitmap.h"
 #include "BLI_listbase.h"
 #include "BLI_mempool.h"
+#include "BLI_task.h"
 
 #include "BLI_strict_flags.h"
 
@@ -169,6 +172,17 @@
 #  define HASH_TABLE_KEY_FALLBACK ((uint64_t)-2)
 #endif
 
+/* Store a bit for each key in the table (a bloom filter with a single hash),
+ * so most values that can't match a chunk skip the table lookup,
+ * this is the common case for new data.
+ */
+#if defined(USE_HASH_TABLE_ACCUMULATE) && defined(USE_HASH_TABLE_KEY_CACHE)
+#  define USE_HASH_TABLE_KEY_FILTER
+/* How many bits to use per chunk in the table (rounded up to a power of 2).
+ */
+#  define BCHUNK_HASH_TABLE_KEY_FILTER_MUL 8
+#endif
+
 /* How much larger the table is then the total number of chunks.
  */
 #define BCHUNK_HASH_TABLE_MUL 3
@@ -753,12 +767,22 @@ BLI_INLINE uint hash_data_single(const uchar p)
   return ((HASH_INIT << 5) + HASH_INIT) + (unsigned int)(*((signed char *)&p));
 }
 
-/* hash bytes, from BLI_ghashutil_strhash_n */
+/**
+ * Hash bytes, based on #BLI_ghashutil_strhash_n.
+ *
+ * Whole words are hashed at once, most arrays have a stride that's a multiple of 4
+ * (float & int types), so this takes a quarter of the steps of hashing them byte by byte.
+ */
 static uint hash_data(const uchar *key, size_t n)
 {
   const signed char *p;
   unsigned int h = HASH_INIT;
 
+  for (; n >= sizeof(uint); n -= sizeof(uint), key += sizeof(uint)) {
+    uint word;
+    memcpy(&word, key, sizeof(word));
+    h = ((h << 5) + h) + word;
+  }
   for (p = (const signed char *)key; n--; p++) {
     h = ((h << 5) + h) + (unsigned int)*p;
   }
@@ -940,6 +964,82 @@ static const BChunkRef *table_lookup(const BArrayInfo *info,
   return NULL;
 }
 
+#  ifdef USE_HASH_TABLE_KEY_FILTER
+BLI_INLINE size_t key_filter_index(const hash_key key, const uint key_filter_shift)
+{
+  /* Fibonacci hashing, the high bits depend on all bits of the key. */
+  return (size_t)((key * 0x9E3779B97F4A7C15ull) >> key_filter_shift);
+}
+#  endif
+
+/**
+ * Number of elements hashed by each task of #hash_array_from_data_accum.
+ */
+#  define BCHUNK_HASH_TASK_LEN (1 << 16)
+
+typedef struct HashArrayTaskData {
+  const BArrayInfo *info;
+  const uchar *data;
+  hash_key *hash_array;
+  size_t hash_array_len;
+} HashArrayTaskData;
+
+static void hash_array_from_data_accum_fn(void *__restrict userdata,
+                                          const int task_index,
+                                          const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const HashArrayTaskData *task_data = userdata;
+  const BArrayInfo *info = task_data->info;
+  const size_t i_start = (size_t)task_index * BCHUNK_HASH_TASK_LEN;
+  const size_t i_end = MIN2(i_start + BCHUNK_HASH_TASK_LEN, task_data->hash_array_len);
+
+  /* Accumulating reads ahead of each hash, so also hash the start of the next range,
+   * this way each range can be accumulated on its own, giving the same values as
+   * accumulating the whole array at once. */
+  const size_t i_read_end = MIN2(i_end + (info->accum_read_ahead_len - 1),
+                                 task_data->hash_array_len);
+  const size_t hash_store_len = i_read_end - i_start;
+  hash_key *hash_store = MEM_mallocN(sizeof(*hash_store) * hash_store_len, __func__);
+  hash_array_from_data(info,
+                       &task_data->data[i_start * info->chunk_stride],
+                       hash_store_len * info->chunk_stride,
+                       hash_store);
+  hash_accum(hash_store, hash_store_len, info->accum_steps);
+
+  memcpy(&task_data->hash_array[i_start], hash_store, sizeof(*hash_store) * (i_end - i_start));
+  MEM_freeN(hash_store);
+}
+
+/**
+ * Equivalent to #hash_array_from_data followed by #hash_accum,
+ * large arrays are split into ranges which are hashed in parallel.
+ */
+static void hash_array_from_data_accum(const BArrayInfo *info,
+                                       const uchar *data,
+                                       const size_t data_len,
+                                       hash_key *hash_array)
+{
+  HashArrayTaskData task_data = {
+      .info = info,
+      .data = data,
+      .hash_array = hash_array,
+      .hash_array_len = data_len / info->chunk_stride,
+  };
+  const size_t tasks_len = (task_data.hash_array_len + (BCHUNK_HASH_TASK_LEN - 1)) /
+                           BCHUNK_HASH_TASK_LEN;
+
+  if (tasks_len <= 1) {
+    hash_array_from_data(info, data, data_len, hash_array);
+    hash_accum(hash_array, task_data.hash_array_len, info->accum_steps);
+    return;
+  }
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = 1;
+  BLI_task_parallel_range(0, (int)tasks_len, &task_data, hash_array_from_data_accum_fn, &settings);
+}
+
 #else /* USE_HASH_TABLE_ACCUMULATE */
 
 /* NON USE_HASH_TABLE_ACCUMULATE code (simply hash each chunk) */
@@ -1205,9 +1305,7 @@ static BChunkList *bchunk_list_from_data_merge(const BArrayInfo *info,
     const size_t table_hash_array_len = (data_len - i_prev) / info->chunk_stride;
     hash_key *table_hash_array = MEM_mallocN(sizeof(*table_hash_array) * table_hash_array_len,
                                              __func__);
-    hash_array_from_data(info, &data[i_prev], data_len - i_prev, table_hash_array);
-
-    hash_accum(table_hash_array, table_hash_array_len, info->accum_steps);
+    hash_array_from_data_accum(info, &data[i_prev], data_len - i_prev, table_hash_array);
 #else
     /* dummy vars */
     uint i_table_start = 0;
@@ -1224,6 +1322,16 @@ static BChunkList *bchunk_list_from_data_merge(const BArrayInfo *info,
     const size_t table_len = chunk_list_reference_remaining_len * BCHUNK_HASH_TABLE_MUL;
     BTableRef **table = MEM_callocN(table_len * sizeof(*table), __func__);
 
+#ifdef USE_HASH_TABLE_KEY_FILTER
+    uint key_filter_bits = 1;
+    while (((size_t)1 << key_filter_bits) <
+           (size_t)chunk_list_reference_remaining_len * BCHUNK_HASH_TABLE_KEY_FILTER_MUL) {
+      key_filter_bits++;
+    }
+    const uint key_filter_shift = 64 - key_filter_bits;
+    BLI_bitmap *key_filter = BLI_BITMAP_NEW((size_t)1 << key_filter_bits, __func__);
+#endif
+
     /* table_make - inline
      * include one matching chunk, to allow for repeating values */
     {
@@ -1275,6 +1383,11 @@ static BChunkList *bchunk_list_from_data_merge(const BArrayInfo *info,
         tref->next = tref_prev;
         table[key_index] = tref;
 
+#ifdef USE_HASH_TABLE_KEY_FILTER
+        /* Use the cached key since that's what #table_lookup compares against. */
+        BLI_BITMAP_ENABLE(key_filter, key_filter_index(cref->link->key, key_filter_shift));
+#endif
+
         chunk_list_reference_bytes_remaining -= cref->link->data_len;
         cref = cref->next;
       }
@@ -1291,6 +1404,22 @@ static BChunkList *bchunk_list_from_data_merge(const BArrayInfo *info,
     for (size_t i = i_prev; i < data_len;) {
       /* Assumes exiting chunk isn't a match! */
 
+#ifdef USE_HASH_TABLE_KEY_FILTER
+      {
+        /* Step over all values which can't match a chunk in the table. */
+        size_t i_hash = (i - i_table_start) / info->chunk_stride;
+        while ((i_hash != table_hash_array_len) &&
+               !BLI_BITMAP_TEST(key_filter,
+                                key_filter_index(table_hash_array[i_hash], key_filter_shift))) {
+          i_hash++;
+        }
+        i = i_table_start + (i_hash * info->chunk_stride);
+        if (i == data_len) {
+          break;
+        }
+      }
+#endif
+
       const BChunkRef *cref_found = table_lookup(
           info, table, table_len, i_table_start, data, data_len, i, table_hash_array);
       if (cref_found != NULL) {
@@ -1339,6 +1468,9 @@ static BChunkList *bchunk_list_from_data_merge(const BArrayInfo *info,
 
 #ifdef USE_HASH_TABLE_ACCUMULATE
     MEM_freeN(table_hash_array);
+#endif
+#ifdef USE_HASH_TABLE_KEY_FILTER
+    MEM_freeN(key_filter);
 #endif
     MEM_freeN(table);
     MEM_freeN(table_ref_stack);
@@ -22,6 +22,8 @@
 
 #include "BLI_kdtree_impl.h"
 #include "BLI_math.h"
+#include "BLI_memarena.h"
+#include "BLI_task.h"
 #include "BLI_strict_flags.h"
 #include "BLI_utildefines.h"
 
@@ -45,10 +47,10 @@ typedef struct KDTreeNode {
 struct KDTree {
   KDTreeNode *nodes;
   uint nodes_len;
+  uint nodes_len_capacity; /* max size of the tree */
   uint root;
 #ifdef DEBUG
-  bool is_balanced;        /* ensure we call balance first */
-  uint nodes_len_capacity; /* max size of the tree */
+  bool is_balanced; /* ensure we call balance first */
 #endif
 };
 
@@ -58,11 +60,12 @@ struct KDTree {
 
 #define KD_NODE_UNSET ((uint)-1)
 
-/**
- * When set we know all values are unbalanced,
- * otherwise clear them when re-balancing: see T62210.
- */
-#define KD_NODE_ROOT_IS_INIT ((uint)-2)
+/* Sub-trees with fewer nodes are balanced by a single task. */
+#define KD_BALANCE_TASK_NODES_MIN 4096
+/* Number of levels of the tree that are split up front to balance the sub-trees in parallel. */
+#define KD_BALANCE_TASK_LEVELS 6
+
+#define KD_BATCH_CHUNK_SIZE 256 /* number of queries handled together in batched searches */
 
 /* -------------------------------------------------------------------- */
 /** \name Local Math API
@@ -103,11 +106,11 @@ KDTree *BLI_kdtree_nd_(new)(uint nodes_len_capacity)
   tree = MEM_mallocN(sizeof(KDTree), "KDTree");
   tree->nodes = MEM_mallocN(sizeof(KDTreeNode) * nodes_len_capacity, "KDTreeNode");
   tree->nodes_len = 0;
-  tree->root = KD_NODE_ROOT_IS_INIT;
+  tree->nodes_len_capacity = nodes_len_capacity;
+  tree->root = KD_NODE_UNSET;
 
 #ifdef DEBUG
   tree->is_balanced = false;
-  tree->nodes_len_capacity = nodes_len_capacity;
 #endif
 
   return tree;
@@ -128,9 +131,7 @@ void BLI_kdtree_nd_(insert)(KDTree *tree, int index, const float co[KD_DIMS])
 {
   KDTreeNode *node = &tree->nodes[tree->nodes_len++];
 
-#ifdef DEBUG
   BLI_assert(tree->nodes_len <= tree->nodes_len_capacity);
-#endif
 
   /* NOTE: array isn't calloc'd,
    * need to initialize all struct members */
@@ -145,20 +146,24 @@ void BLI_kdtree_nd_(insert)(KDTree *tree, int index, const float co[KD_DIMS])
 #endif
 }
 
-static uint kdtree_balance(KDTreeNode *nodes, uint nodes_len, uint axis, const uint ofs)
+/* -------------------------------------------------------------------- */
+/** \name Balancing
+ *
+ * Nodes are first sorted in place into a balanced tree, where each median is at the middle
+ * of its range with its left and right sub-trees before and after it. This is then copied
+ * into depth-first order, where each node is followed by its left sub-tree and then its right
+ * sub-tree, so most steps of a search go to a node that is next to its parent in memory.
+ *
+ * The top levels of the tree are split up front, after which the sub-trees are balanced in
+ * parallel. The result is the same as balancing on a single thread.
+ * \{ */
+
+/* Quick-sort style partitioning around the median. */
+static void kdtree_partition(KDTreeNode *nodes, uint nodes_len, uint axis)
 {
-  KDTreeNode *node;
   float co;
   uint left, right, median, i, j;
 
-  if (nodes_len <= 0) {
-    return KD_NODE_UNSET;
-  }
-  else if (nodes_len == 1) {
-    return 0 + ofs;
-  }
-
-  /* Quick-sort style sorting around median. */
   left = 0;
   right = nodes_len - 1;
   median = nodes_len / 2;
@@ -189,34 +194,179 @@ static uint kdtree_balance(KDTreeNode *nodes, uint nodes_len, uint axis, const u
       left = i + 1;
     }
   }
+}
+
+static void kdtree_balance(KDTreeNode *nodes, uint nodes_len, uint axis)
+{
+  if (nodes_len <= 1) {
+    return;
+  }
+
+  const uint median = nodes_len / 2;
+  kdtree_partition(nodes, nodes_len, axis);
 
-  /* set node and sort subnodes */
-  node = &nodes[median];
-  node->d = axis;
   axis = (axis + 1) % KD_DIMS;
-  node->left = kdtree_balance(nodes, median, axis, ofs);
-  node->right = kdtree_balance(
-      nodes + median + 1, (nodes_len - (median + 1)), axis, (median + 1) + ofs);
+  kdtree_balance(nodes, median, axis);
+  kdtree_balance(nodes + median + 1, nodes_len - (median + 1), axis);
+}
+
+/**
+ * Copy the root of the balanced \a nodes to \a dst_index in depth-first order.
+ * \return the number of nodes before its right sub-tree.
+ */
+static uint kdtree_layout_node(const KDTreeNode *nodes,
+                               uint nodes_len,
+                               uint axis,
+                               KDTreeNode *nodes_dst,
+                               uint dst_index)
+{
+  const uint median = nodes_len / 2;
+  KDTreeNode *node = &nodes_dst[dst_index];
+
+  *node = nodes[median];
+  /* The axis of a leaf is only used to skip testing it, which can differ from the distance
+   * test by rounding. Leaves always used the first axis, keep it so results don't change. */
+  node->d = (nodes_len != 1) ? axis : 0;
+  node->left = (median != 0) ? dst_index + 1 : KD_NODE_UNSET;
+  node->right = (nodes_len - (median + 1) != 0) ? dst_index + 1 + median : KD_NODE_UNSET;
 
-  return median + ofs;
+  return median;
+}
+
+static void kdtree_layout(
+    const KDTreeNode *nodes, uint nodes_len, uint axis, KDTreeNode *nodes_dst, uint dst_index)
+{
+  while (nodes_len != 0) {
+    const uint median = kdtree_layout_node(nodes, nodes_len, axis, nodes_dst, dst_index);
+    axis = (axis + 1) % KD_DIMS;
+    kdtree_layout(nodes, median, axis, nodes_dst, dst_index + 1);
+
+    /* Loop for the right sub-tree. */
+    nodes += median + 1;
+    nodes_len -= median + 1;
+    dst_index += median + 1;
+  }
+}
+
+/* A sub-tree, its nodes are in the balancing array and its root goes at `dst_index`. */
+typedef struct KDTreeBalanceRange {
+  uint ofs, len, axis, dst_index;
+} KDTreeBalanceRange;
+
+typedef struct KDTreeBalanceData {
+  KDTreeNode *nodes;
+  KDTreeNode *nodes_dst;
+  const KDTreeBalanceRange *ranges;
+} KDTreeBalanceData;
+
+static void kdtree_partition_range_cb(void *__restrict userdata,
+                                      const int i,
+                                      const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const KDTreeBalanceData *data = userdata;
+  const KDTreeBalanceRange *range = &data->ranges[i];
+  if (range->len >= KD_BALANCE_TASK_NODES_MIN) {
+    kdtree_partition(data->nodes + range->ofs, range->len, range->axis);
+  }
+}
+
+static void kdtree_balance_range_cb(void *__restrict userdata,
+                                    const int i,
+                                    const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const KDTreeBalanceData *data = userdata;
+  const KDTreeBalanceRange *range = &data->ranges[i];
+  kdtree_balance(data->nodes + range->ofs, range->len, range->axis);
+  kdtree_layout(
+      data->nodes + range->ofs, range->len, range->axis, data->nodes_dst, range->dst_index);
 }
 
 void BLI_kdtree_nd_(balance)(KDTree *tree)
 {
-  if (tree->root != KD_NODE_ROOT_IS_INIT) {
-    for (uint i = 0; i < tree->nodes_len; i++) {
-      tree->nodes[i].left = KD_NODE_UNSET;
-      tree->nodes[i].right = KD_NODE_UNSET;
+  KDTreeBalanceRange ranges_buf[2][1 << KD_BALANCE_TASK_LEVELS];
+  KDTreeBalanceRange *ranges = ranges_buf[0];
+  KDTreeNode *nodes_dst;
+  uint ranges_len = 0;
+
+  if (tree->nodes_len == 0) {
+    tree->root = KD_NODE_UNSET;
+#ifdef DEBUG
+    tree->is_balanced = true;
+#endif
+    return;
+  }
+
+  nodes_dst = MEM_mallocN(sizeof(KDTreeNode) * tree->nodes_len_capacity, "KDTreeNode");
+
+  KDTreeBalanceData data = {
+      .nodes = tree->nodes,
+      .nodes_dst = nodes_dst,
+  };
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = 1;
+
+  ranges[ranges_len++] = (KDTreeBalanceRange){
+      .ofs = 0, .len = tree->nodes_len, .axis = 0, .dst_index = 0};
+
+  /* Split the top levels, partitioning each level of sub-trees in parallel. */
+  for (uint level = 0; level < KD_BALANCE_TASK_LEVELS; level++) {
+    KDTreeBalanceRange *ranges_next = ranges_buf[(level + 1) % 2];
+    uint ranges_next_len = 0;
+
+    bool is_split = false;
+
+    data.ranges = ranges;
+    settings.use_threading = (ranges_len > 1);
+    BLI_task_parallel_range(0, (int)ranges_len, &data, kdtree_partition_range_cb, &settings);
+
+    for (uint i = 0; i < ranges_len; i++) {
+      const KDTreeBalanceRange *range = &ranges[i];
+      if (range->len < KD_BALANCE_TASK_NODES_MIN) {
+        ranges_next[ranges_next_len++] = *range;
+        continue;
+      }
+      is_split = true;
+      const uint median = kdtree_layout_node(
+          tree->nodes + range->ofs, range->len, range->axis, nodes_dst, range->dst_index);
+      const uint axis = (range->axis + 1) % KD_DIMS;
+      if (median != 0) {
+        ranges_next[ranges_next_len++] = (KDTreeBalanceRange){
+            .ofs = range->ofs, .len = median, .axis = axis, .dst_index = range->dst_index + 1};
+      }
+      if (range->len - (median + 1) != 0) {
+        ranges_next[ranges_next_len++] = (KDTreeBalanceRange){
+            .ofs = range->ofs + median + 1,
+            .len = range->len - (median + 1),
+            .axis = axis,
+            .dst_index = range->dst_index + median + 1};
+      }
+    }
+
+    ranges = ranges_next;
+    ranges_len = ranges_next_len;
+
+    if (!is_split) {
+      break;
     }
   }
 
-  tree->root = kdtree_balance(tree->nodes, tree->nodes_len, 0, 0);
+  data.ranges = ranges;
+  settings.use_threading = (tree->nodes_len >= KD_BALANCE_TASK_NODES_MIN);
+  BLI_task_parallel_range(0, (int)ranges_len, &data, kdtree_balance_range_cb, &settings);
+
+  MEM_freeN(tree->nodes);
+  tree->nodes = nodes_dst;
+  tree->root = 0;
 
 #ifdef DEBUG
   tree->is_balanced = true;
 #endif
 }
 
+/** \} */
+
 static uint *realloc_nodes(uint *stack, uint *stack_len_capacity, const bool is_alloc)
 {
   uint *stack_new = MEM_mallocN((*stack_len_capacity + KD_NEAR_ALLOC_INC) * sizeof(uint),
@@ -625,8 +775,10 @@ static void nearest_add_in_range(KDTreeNearest **r_nearest,
   KDTreeNearest *to;
 
   if (UNLIKELY(nearest_index >= *nearest_len_capacity)) {
+    /* Grow geometrically, batched searches collect the results of many points at once. */
+    *nearest_len_capacity = MAX2(*nearest_len_capacity * 2, (uint)KD_FOUND_ALLOC_INC);
     *r_nearest = MEM_reallocN_id(
-        *r_nearest, (*nearest_len_capacity += KD_FOUND_ALLOC_INC) * sizeof(KDTreeNode), __func__);
+        *r_nearest, *nearest_len_capacity * sizeof(KDTreeNearest), __func__);
   }
 
   to = (*r_nearest) + nearest_index;
@@ -637,40 +789,24 @@ static void nearest_add_in_range(KDTreeNearest **r_nearest,
 }
 
 /**
- * Range search returns number of points nearest_len, with results in nearest
- *
- * \param r_nearest: Allocated array of nearest nearest_len (caller is responsible for freeing).
+ * Append the nodes in range of \a co to \a nearest, without sorting them.
  */
-int BLI_kdtree_nd_(range_search_with_len_squared_cb)(
-    const KDTree *tree,
-    const float co[KD_DIMS],
-    KDTreeNearest **r_nearest,
-    const float range,
-    float (*len_sq_fn)(const float co_search[KD_DIMS],
-                       const float co_test[KD_DIMS],
-                       const void *user_data),
-    const void *user_data)
+static void kdtree_range_search_append(const KDTree *tree,
+                                       const float co[KD_DIMS],
+                                       const float range,
+                                       float (*len_sq_fn)(const float co_search[KD_DIMS],
+                                                          const float co_test[KD_DIMS],
+                                                          const void *user_data),
+                                       const void *user_data,
+                                       KDTreeNearest **nearest,
+                                       uint *nearest_len,
+                                       uint *nearest_len_capacity)
 {
   const KDTreeNode *nodes = tree->nodes;
   uint *stack, stack_default[KD_STACK_INIT];
-  KDTreeNearest *nearest = NULL;
   const float range_sq = range * range;
   float dist_sq;
   uint stack_len_capacity, cur = 0;
-  uint nearest_len = 0, nearest_len_capacity = 0;
-
-#ifdef DEBUG
-  BLI_assert(tree->is_balanced == true);
-#endif
-
-  if (UNLIKELY(tree->root == KD_NODE_UNSET)) {
-    return 0;
-  }
-
-  if (len_sq_fn == NULL) {
-    len_sq_fn = len_squared_vnvn_cb;
-    BLI_assert(user_data == NULL);
-  }
 
   stack = stack_default;
   stack_len_capacity = ARRAY_SIZE(stack_default);
@@ -694,7 +830,7 @@ int BLI_kdtree_nd_(range_search_with_len_squared_cb)(
       dist_sq = len_sq_fn(co, node->co, user_data);
       if (dist_sq <= range_sq) {
         nearest_add_in_range(
-            &nearest, nearest_len++, &nearest_len_capacity, node->index, dist_sq, node->co);
+            nearest, (*nearest_len)++, nearest_len_capacity, node->index, dist_sq, node->co);
       }
 
       if (node->left != KD_NODE_UNSET) {
@@ -713,6 +849,41 @@ int BLI_kdtree_nd_(range_search_with_len_squared_cb)(
   if (stack != stack_default) {
     MEM_freeN(stack);
   }
+}
+
+/**
+ * Range search returns number of points nearest_len, with results in nearest
+ *
+ * \param r_nearest: Allocated array of nearest nearest_len (caller is responsible for freeing).
+ */
+int BLI_kdtree_nd_(range_search_with_len_squared_cb)(
+    const KDTree *tree,
+    const float co[KD_DIMS],
+    KDTreeNearest **r_nearest,
+    const float range,
+    float (*len_sq_fn)(const float co_search[KD_DIMS],
+                       const float co_test[KD_DIMS],
+                       const void *user_data),
+    const void *user_data)
+{
+  KDTreeNearest *nearest = NULL;
+  uint nearest_len = 0, nearest_len_capacity = 0;
+
+#ifdef DEBUG
+  BLI_assert(tree->is_balanced == true);
+#endif
+
+  if (UNLIKELY(tree->root == KD_NODE_UNSET)) {
+    return 0;
+  }
+
+  if (len_sq_fn == NULL) {
+    len_sq_fn = len_squared_vnvn_cb;
+    BLI_assert(user_data == NULL);
+  }
+
+  kdtree_range_search_append(
+      tree, co, range, len_sq_fn, user_data, &nearest, &nearest_len, &nearest_len_capacity);
 
   if (nearest_len) {
     qsort(nearest, nearest_len, sizeof(KDTreeNearest), nearest_cmp_dist);
@@ -806,6 +977,261 @@ finally:
   }
 }
 
+/* -------------------------------------------------------------------- */
+/** \name Batched Searches
+ *
+ * Search for many points at once, in parallel. Points are first sorted by the node they reach
+ * when descending the tree, then handled in chunks of #KD_BATCH_CHUNK_SIZE, so each thread
+ * searches points that are close together and mostly visits nodes that are already in cache.
+ * \{ */
+
+/**
+ * \return the indices of \a co, ordered by the node each point reaches when descending the tree.
+ * Nodes are stored depth-first, so this is the order of the tree leaves in space.
+ */
+static uint *kdtree_batch_order(const KDTree *tree, const float (*co)[KD_DIMS], const uint co_len)
+{
+  const KDTreeNode *nodes = tree->nodes;
+  uint *order = MEM_mallocN(sizeof(uint) * co_len, __func__);
+  uint *leaf = MEM_mallocN(sizeof(uint) * co_len, __func__);
+  uint *leaf_offsets = MEM_callocN(sizeof(uint) * (tree->nodes_len + 1), __func__);
+
+  for (uint i = 0; i < co_len; i++) {
+    uint cur = tree->root;
+    while (true) {
+      const KDTreeNode *node = &nodes[cur];
+      const uint next = (co[i][node->d] < node->co[node->d]) ? node->left : node->right;
+      if (next == KD_NODE_UNSET) {
+        break;
+      }
+      cur = next;
+    }
+    leaf[i] = cur;
+    leaf_offsets[cur + 1]++;
+  }
+
+  /* Counting sort, stable so the input order is kept for points reaching the same node. */
+  for (uint i = 0; i < tree->nodes_len; i++) {
+    leaf_offsets[i + 1] += leaf_offsets[i];
+  }
+  for (uint i = 0; i < co_len; i++) {
+    order[leaf_offsets[leaf[i]]++] = i;
+  }
+
+  MEM_freeN(leaf);
+  MEM_freeN(leaf_offsets);
+
+  return order;
+}
+
+typedef struct KDTreeNearestBatchData {
+  const KDTree *tree;
+  const float (*co)[KD_DIMS];
+  const uint *order;
+  uint co_len;
+  KDTreeNearest *r_nearest;
+} KDTreeNearestBatchData;
+
+static void kdtree_find_nearest_batch_cb(void *__restrict userdata,
+                                         const int chunk_index,
+                                         const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const KDTreeNearestBatchData *data = userdata;
+  const uint start = (uint)chunk_index * KD_BATCH_CHUNK_SIZE;
+  const uint end = MIN2(start + KD_BATCH_CHUNK_SIZE, data->co_len);
+
+  for (uint i = start; i < end; i++) {
+    const uint index = data->order[i];
+    BLI_kdtree_nd_(find_nearest)(data->tree, data->co[index], &data->r_nearest[index]);
+  }
+}
+
+/**
+ * Find the nearest node for each point in \a co.
+ *
+ * \param r_nearest: An array of nearest, sized at least \a co_len.
+ * The index is -1 when the tree is empty.
+ */
+void BLI_kdtree_nd_(find_nearest_batch)(const KDTree *tree,
+                                        const float (*co)[KD_DIMS],
+                                        const uint co_len,
+                                        KDTreeNearest *r_nearest)
+{
+#ifdef DEBUG
+  BLI_assert(tree->is_balanced == true);
+#endif
+
+  if (UNLIKELY(tree->root == KD_NODE_UNSET)) {
+    for (uint i = 0; i < co_len; i++) {
+      r_nearest[i].index = -1;
+      r_nearest[i].dist = FLT_MAX;
+    }
+    return;
+  }
+
+  KDTreeNearestBatchData data = {
+      .tree = tree,
+      .co = co,
+      .order = kdtree_batch_order(tree, co, co_len),
+      .co_len = co_len,
+      .r_nearest = r_nearest,
+  };
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.use_threading = (co_len > KD_BATCH_CHUNK_SIZE);
+  settings.min_iter_per_thread = 1;
+  BLI_task_parallel_range(0,
+                          (int)((co_len + KD_BATCH_CHUNK_SIZE - 1) / KD_BATCH_CHUNK_SIZE),
+                          &data,
+                          kdtree_find_nearest_batch_cb,
+                          &settings);
+
+  MEM_freeN((void *)data.order);
+}
+
+/* Results of the range searches of one chunk of points. */
+typedef struct KDTreeRangeBatchChunk {
+  KDTreeNearest *nearest;
+  uint nearest_len, nearest_len_capacity;
+} KDTreeRangeBatchChunk;
+
+typedef struct KDTreeRangeBatchData {
+  const KDTree *tree;
+  const float (*co)[KD_DIMS];
+  const uint *order;
+  uint co_len;
+  float range;
+  KDTreeRangeBatchChunk *chunks;
+  uint *nearest_offsets;
+  KDTreeNearest *nearest;
+} KDTreeRangeBatchData;
+
+static void kdtree_range_search_batch_cb(void *__restrict userdata,
+                                         const int chunk_index,
+                                         const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const KDTreeRangeBatchData *data = userdata;
+  KDTreeRangeBatchChunk *chunk = &data->chunks[chunk_index];
+  const uint start = (uint)chunk_index * KD_BATCH_CHUNK_SIZE;
+  const uint end = MIN2(start + KD_BATCH_CHUNK_SIZE, data->co_len);
+
+  for (uint i = start; i < end; i++) {
+    const uint index = data->order[i];
+    const uint nearest_start = chunk->nearest_len;
+    kdtree_range_search_append(data->tree,
+                               data->co[index],
+                               data->range,
+                               len_squared_vnvn_cb,
+                               NULL,
+                               &chunk->nearest,
+                               &chunk->nearest_len,
+                               &chunk->nearest_len_capacity);
+
+    const uint nearest_len = chunk->nearest_len - nearest_start;
+    if (nearest_len > 1) {
+      qsort(
+          chunk->nearest + nearest_start, nearest_len, sizeof(KDTreeNearest), nearest_cmp_dist);
+    }
+    /* Counts for now, accumulated into offsets once all chunks are done. */
+    data->nearest_offsets[index + 1] = nearest_len;
+  }
+}
+
+static void kdtree_range_search_batch_copy_cb(void *__restrict userdata,
+                                              const int chunk_index,
+                                              const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const KDTreeRangeBatchData *data = userdata;
+  KDTreeRangeBatchChunk *chunk = &data->chunks[chunk_index];
+  const uint start = (uint)chunk_index * KD_BATCH_CHUNK_SIZE;
+  const uint end = MIN2(start + KD_BATCH_CHUNK_SIZE, data->co_len);
+  const KDTreeNearest *nearest = chunk->nearest;
+
+  for (uint i = start; i < end; i++) {
+    const uint index = data->order[i];
+    const uint nearest_len = data->nearest_offsets[index + 1] - data->nearest_offsets[index];
+    if (nearest_len) {
+      memcpy(data->nearest + data->nearest_offsets[index],
+             nearest,
+             sizeof(KDTreeNearest) * nearest_len);
+      nearest += nearest_len;
+    }
+  }
+  MEM_SAFE_FREE(chunk->nearest);
+}
+
+/**
+ * Range search for each point in \a co, the results are sorted by distance like
+ * #BLI_kdtree_3d_range_search, but stored in a single array allocated from \a arena
+ * instead of an allocation per point.
+ *
+ * \param r_nearest: All results, the results for point `i` are in
+ * `[r_nearest_offsets[i], r_nearest_offsets[i + 1])`. NULL when nothing is found.
+ * \param r_nearest_offsets: An array sized at least `co_len + 1`.
+ * \returns The total number of results.
+ */
+int BLI_kdtree_nd_(range_search_batch)(const KDTree *tree,
+                                       const float (*co)[KD_DIMS],
+                                       const uint co_len,
+                                       const float range,
+                                       MemArena *arena,
+                                       KDTreeNearest **r_nearest,
+                                       uint *r_nearest_offsets)
+{
+  const uint chunks_len = (co_len + KD_BATCH_CHUNK_SIZE - 1) / KD_BATCH_CHUNK_SIZE;
+
+#ifdef DEBUG
+  BLI_assert(tree->is_balanced == true);
+#endif
+
+  *r_nearest = NULL;
+  r_nearest_offsets[0] = 0;
+
+  if (UNLIKELY(tree->root == KD_NODE_UNSET)) {
+    for (uint i = 0; i < co_len; i++) {
+      r_nearest_offsets[i + 1] = 0;
+    }
+    return 0;
+  }
+
+  KDTreeRangeBatchData data = {
+      .tree = tree,
+      .co = co,
+      .order = kdtree_batch_order(tree, co, co_len),
+      .co_len = co_len,
+      .range = range,
+      .chunks = MEM_callocN(sizeof(KDTreeRangeBatchChunk) * MAX2(chunks_len, 1u), __func__),
+      .nearest_offsets = r_nearest_offsets,
+  };
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.use_threading = (co_len > KD_BATCH_CHUNK_SIZE);
+  settings.min_iter_per_thread = 1;
+  BLI_task_parallel_range(0, (int)chunks_len, &data, kdtree_range_search_batch_cb, &settings);
+
+  for (uint i = 0; i < co_len; i++) {
+    r_nearest_offsets[i + 1] += r_nearest_offsets[i];
+  }
+
+  const uint nearest_len = r_nearest_offsets[co_len];
+  if (nearest_len) {
+    data.nearest = BLI_memarena_alloc(arena, sizeof(KDTreeNearest) * nearest_len);
+  }
+  BLI_task_parallel_range(
+      0, (int)chunks_len, &data, kdtree_range_search_batch_copy_cb, &settings);
+
+  MEM_freeN((void *)data.order);
+  MEM_freeN(data.chunks);
+
+  *r_nearest = data.nearest;
+
+  return (int)nearest_len;
+}
+
+/** \} */
+
 /**
  * Use when we want to loop over nodes ordered by index.
  * Requires indices to be aligned with nodes.
@@ -820,6 +1246,34 @@ static uint *kdtree_order(const KDTree *tree)
   return order;
 }
 
+/**
+ * Use when we want to loop over nodes in the order they had before the tree was stored
+ * depth-first (sorted by the median splits), so results don't depend on the memory layout.
+ */
+static void kdtree_order_balanced_recursive(const KDTreeNode *nodes,
+                                            uint i,
+                                            uint *order,
+                                            uint *order_len)
+{
+  while (i != KD_NODE_UNSET) {
+    const KDTreeNode *node = &nodes[i];
+    if (node->left != KD_NODE_UNSET) {
+      kdtree_order_balanced_recursive(nodes, node->left, order, order_len);
+    }
+    order[(*order_len)++] = i;
+    i = node->right;
+  }
+}
+
+static uint *kdtree_order_balanced(const KDTree *tree)
+{
+  uint *order = MEM_mallocN(sizeof(uint) * tree->nodes_len, __func__);
+  uint order_len = 0;
+  kdtree_order_balanced_recursive(tree->nodes, tree->root, order, &order_len);
+  BLI_assert(order_len == tree->nodes_len);
+  return order;
+}
+
 /* -------------------------------------------------------------------- */
 /** \name BLI_kdtree_3d_calc_duplicates_fast
  * \{ */
@@ -917,8 +1371,9 @@ int BLI_kdtree_nd_(calc_duplicates_fast)(const KDTree *tree,
     MEM_freeN(order);
   }
   else {
+    uint *order = kdtree_order_balanced(tree);
     for (uint i = 0; i < tree->nodes_len; i++) {
-      const uint node_index = i;
+      const uint node_index = order[i];
       const int index = p.nodes[node_index].index;
       if (ELEM(duplicates[index], -1, index)) {
         p.search = index;
@@ -931,6 +1386,7 @@ int BLI_kdtree_nd_(calc_duplicates_fast)(const KDTree *tree,
         }
       }
     }
+    MEM_freeN(order);
   }
   return found;
 }
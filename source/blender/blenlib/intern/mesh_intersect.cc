@@ -1193,7 +1193,6 @@ static inline mpq3 tti_interp(
 /**
  * Return +1, 0, -1 as a + ad is above, on, or below the oriented plane containing a, b, c in CCW
  * order. This is the same as -oriented(a, b, c, a + ad), but uses fewer arithmetic operations.
- * TODO: change arguments to `const Vert *` and use floating filters.
  * The ba, ca, n, and dotbuf arguments are used as temporaries; declaring them
  * in the caller can avoid many allocs and frees of mpq3 and mpq_class structures.
  */
@@ -1218,6 +1217,97 @@ static inline int tti_above(const mpq3 &a,
   return sgn(mpq3::dot_with_buffer(ad, n, dotbuf));
 }
 
+/**
+ * Index of `dot(d - a, cross(b - a, c - a))` when the inputs have index 1.
+ * The differences have index 2, the cross product coordinates index 6, and the dot product
+ * adds 1 for the multiply and 2 for the sums.
+ */
+constexpr int index_tti_above = 11;
+
+/**
+ * Floating point filter for #tti_above, using the double coordinates of the vertices.
+ * The answer will be 1 if d is definitely above the plane of a, b, c, -1 if it is definitely
+ * below, and 0 if we are unsure.
+ */
+static inline int filter_tti_above(const double3 &a,
+                                   const double3 &b,
+                                   const double3 &c,
+                                   const double3 &d)
+{
+  double3 ba = b - a;
+  double3 ca = c - a;
+  double3 ad = d - a;
+  double3 n(ba.y * ca.z - ba.z * ca.y, ba.z * ca.x - ba.x * ca.z, ba.x * ca.y - ba.y * ca.x);
+  double det = double3::dot(ad, n);
+  if (det == 0.0) {
+    return 0;
+  }
+  double3 abs_a = double3::abs(a);
+  double3 abs_ba = abs_a + double3::abs(b);
+  double3 abs_ca = abs_a + double3::abs(c);
+  double3 abs_ad = abs_a + double3::abs(d);
+  double3 abs_n(abs_ba.y * abs_ca.z + abs_ba.z * abs_ca.y,
+                abs_ba.z * abs_ca.x + abs_ba.x * abs_ca.z,
+                abs_ba.x * abs_ca.y + abs_ba.y * abs_ca.x);
+  double supremum = double3::dot(abs_ad, abs_n);
+  double err_bound = supremum * index_tti_above * DBL_EPSILON;
+  if (fabs(det) > err_bound) {
+    return det > 0 ? 1 : -1;
+  }
+  return 0;
+}
+
+/**
+ * Like #tti_above with `ad = d - a`, but first tries the floating point filter
+ * and only falls back on exact arithmetic if the filter can't decide.
+ */
+static int tti_above_filtered(const Vert *a, const Vert *b, const Vert *c, const Vert *d)
+{
+  int ans = filter_tti_above(a->co, b->co, c->co, d->co);
+  if (ans != 0) {
+#  ifdef PERFDEBUG
+    incperfcount(5); /* Orientation tests decided by filter. */
+#  endif
+    return ans;
+  }
+#  ifdef PERFDEBUG
+  incperfcount(6); /* Orientation tests decided by exact arithmetic. */
+#  endif
+  mpq3 ad = d->co_exact - a->co_exact;
+  mpq3 buf[4];
+  return tti_above(a->co_exact, b->co_exact, c->co_exact, ad, buf[0], buf[1], buf[2], buf[3]);
+}
+
+/**
+ * Return the overlap of the segments [i,j] and [k,l] of the plane-plane intersection line,
+ * where the ends are the intersections of a1b1 with the plane containing c1 with normal n_1,
+ * and of a2b2 with the plane containing c2 with normal n_2.
+ */
+static ITT_value tti_overlap(const mpq3 &a1,
+                             const mpq3 &b1,
+                             const mpq3 &c1,
+                             const mpq3 &n_1,
+                             const mpq3 &a2,
+                             const mpq3 &b2,
+                             const mpq3 &c2,
+                             const mpq3 &n_2)
+{
+  constexpr int dbg_level = 0;
+  mpq3 buf[3];
+  mpq3 intersect_1 = tti_interp(a1, b1, c1, n_1, buf[0], buf[1], buf[2]);
+  mpq3 intersect_2 = tti_interp(a2, b2, c2, n_2, buf[0], buf[1], buf[2]);
+  if (intersect_1 == intersect_2) {
+    if (dbg_level > 0) {
+      std::cout << "single intersect: " << intersect_1 << "\n";
+    }
+    return ITT_value(IPOINT, intersect_1);
+  }
+  if (dbg_level > 0) {
+    std::cout << "intersect segment: " << intersect_1 << ", " << intersect_2 << "\n";
+  }
+  return ITT_value(ISEGMENT, intersect_1, intersect_2);
+}
+
 /**
  * Given that triangles (p1, q1, r1) and (p2, q2, r2) are in canonical order,
  * use the classification chart in the Guigue and Devillers paper to find out
@@ -1230,17 +1320,25 @@ static inline int tti_above(const mpq3 &a,
  * (b) p1 is on the plane both q1 and r1 are on the same side
  *   of the plane and at least one of q1 and r1 are off the plane.
  * Similarly for p2, q2, r2 with respect to the first triangle's plane.
+ * The classification tests use floating point filters, so exact arithmetic
+ * is usually only needed to compute the intersection points when there is overlap.
  */
-static ITT_value itt_canon2(const mpq3 &p1,
-                            const mpq3 &q1,
-                            const mpq3 &r1,
-                            const mpq3 &p2,
-                            const mpq3 &q2,
-                            const mpq3 &r2,
+static ITT_value itt_canon2(const Vert *vp1,
+                            const Vert *vq1,
+                            const Vert *vr1,
+                            const Vert *vp2,
+                            const Vert *vq2,
+                            const Vert *vr2,
                             const mpq3 &n1,
                             const mpq3 &n2)
 {
   constexpr int dbg_level = 0;
+  const mpq3 &p1 = vp1->co_exact;
+  const mpq3 &q1 = vq1->co_exact;
+  const mpq3 &r1 = vr1->co_exact;
+  const mpq3 &p2 = vp2->co_exact;
+  const mpq3 &q2 = vq2->co_exact;
+  const mpq3 &r2 = vr2->co_exact;
   if (dbg_level > 0) {
     std::cout << "\ntri_tri_intersect_canon:\n";
     std::cout << "p1=" << p1 << " q1=" << q1 << " r1=" << r1 << "\n";
@@ -1256,97 +1354,65 @@ static ITT_value itt_canon2(const mpq3 &p1,
     std::cout << "n1=(" << n1[0].get_d() << "," << n1[1].get_d() << "," << n1[2].get_d() << ")\n";
     std::cout << "n2=(" << n2[0].get_d() << "," << n2[1].get_d() << "," << n2[2].get_d() << ")\n";
   }
-  mpq3 p1p2 = p2 - p1;
-  mpq3 intersect_1;
-  mpq3 intersect_2;
-  mpq3 buf[4];
-  bool no_overlap = false;
   /* Top test in classification tree. */
-  if (tti_above(p1, q1, r2, p1p2, buf[0], buf[1], buf[2], buf[3]) > 0) {
+  if (tti_above_filtered(vp1, vq1, vr2, vp2) > 0) {
     /* Middle right test in classification tree. */
-    if (tti_above(p1, r1, r2, p1p2, buf[0], buf[1], buf[2], buf[3]) <= 0) {
+    if (tti_above_filtered(vp1, vr1, vr2, vp2) <= 0) {
       /* Bottom right test in classification tree. */
-      if (tti_above(p1, r1, q2, p1p2, buf[0], buf[1], buf[2], buf[3]) > 0) {
+      if (tti_above_filtered(vp1, vr1, vq2, vp2) > 0) {
         /* Overlap is [k [i l] j]. */
         if (dbg_level > 0) {
           std::cout << "overlap [k [i l] j]\n";
         }
         /* i is intersect with p1r1. l is intersect with p2r2. */
-        intersect_1 = tti_interp(p1, r1, p2, n2, buf[0], buf[1], buf[2]);
-        intersect_2 = tti_interp(p2, r2, p1, n1, buf[0], buf[1], buf[2]);
-      }
-      else {
-        /* Overlap is [i [k l] j]. */
-        if (dbg_level > 0) {
-          std::cout << "overlap [i [k l] j]\n";
-        }
-        /* k is intersect with p2q2. l is intersect is p2r2. */
-        intersect_1 = tti_interp(p2, q2, p1, n1, buf[0], buf[1], buf[2]);
-        intersect_2 = tti_interp(p2, r2, p1, n1, buf[0], buf[1], buf[2]);
-      }
-    }
-    else {
-      /* No overlap: [k l] [i j]. */
-      if (dbg_level > 0) {
-        std::cout << "no overlap: [k l] [i j]\n";
+        return tti_overlap(p1, r1, p2, n2, p2, r2, p1, n1);
       }
-      no_overlap = true;
-    }
-  }
-  else {
-    /* Middle left test in classification tree. */
-    if (tti_above(p1, q1, q2, p1p2, buf[0], buf[1], buf[2], buf[3]) < 0) {
-      /* No overlap: [i j] [k l]. */
+      /* Overlap is [i [k l] j]. */
       if (dbg_level > 0) {
-        std::cout << "no overlap: [i j] [k l]\n";
+        std::cout << "overlap [i [k l] j]\n";
       }
-      no_overlap = true;
+      /* k is intersect with p2q2. l is intersect is p2r2. */
+      return tti_overlap(p2, q2, p1, n1, p2, r2, p1, n1);
     }
-    else {
-      /* Bottom left test in classification tree. */
-      if (tti_above(p1, r1, q2, p1p2, buf[0], buf[1], buf[2], buf[3]) >= 0) {
-        /* Overlap is [k [i j] l]. */
-        if (dbg_level > 0) {
-          std::cout << "overlap [k [i j] l]\n";
-        }
-        /* i is intersect with p1r1. j is intersect with p1q1. */
-        intersect_1 = tti_interp(p1, r1, p2, n2, buf[0], buf[1], buf[2]);
-        intersect_2 = tti_interp(p1, q1, p2, n2, buf[0], buf[1], buf[2]);
-      }
-      else {
-        /* Overlap is [i [k j] l]. */
-        if (dbg_level > 0) {
-          std::cout << "overlap [i [k j] l]\n";
-        }
-        /* k is intersect with p2q2. j is intersect with p1q1. */
-        intersect_1 = tti_interp(p2, q2, p1, n1, buf[0], buf[1], buf[2]);
-        intersect_2 = tti_interp(p1, q1, p2, n2, buf[0], buf[1], buf[2]);
-      }
+    /* No overlap: [k l] [i j]. */
+    if (dbg_level > 0) {
+      std::cout << "no overlap: [k l] [i j]\n";
     }
+    return ITT_value(INONE);
   }
-  if (no_overlap) {
+  /* Middle left test in classification tree. */
+  if (tti_above_filtered(vp1, vq1, vq2, vp2) < 0) {
+    /* No overlap: [i j] [k l]. */
+    if (dbg_level > 0) {
+      std::cout << "no overlap: [i j] [k l]\n";
+    }
     return ITT_value(INONE);
   }
-  if (intersect_1 == intersect_2) {
+  /* Bottom left test in classification tree. */
+  if (tti_above_filtered(vp1, vr1, vq2, vp2) >= 0) {
+    /* Overlap is [k [i j] l]. */
     if (dbg_level > 0) {
-      std::cout << "single intersect: " << intersect_1 << "\n";
+      std::cout << "overlap [k [i j] l]\n";
     }
-    return ITT_value(IPOINT, intersect_1);
+    /* i is intersect with p1r1. j is intersect with p1q1. */
+    return tti_overlap(p1, r1, p2, n2, p1, q1, p2, n2);
   }
+  /* Overlap is [i [k j] l]. */
   if (dbg_level > 0) {
-    std::cout << "intersect segment: " << intersect_1 << ", " << intersect_2 << "\n";
+    std::cout << "overlap [i [k j] l]\n";
   }
-  return ITT_value(ISEGMENT, intersect_1, intersect_2);
+  /* k is intersect with p2q2. j is intersect with p1q1. */
+  return tti_overlap(p2, q2, p1, n1, p1, q1, p2, n2);
 }
 
 /* Helper function for intersect_tri_tri. Arguments have been canonicalized for triangle 1. */
 
-static ITT_value itt_canon1(const mpq3 &p1,
-                            const mpq3 &q1,
-                            const mpq3 &r1,
-                            const mpq3 &p2,
-                            const mpq3 &q2,
-                            const mpq3 &r2,
+static ITT_value itt_canon1(const Vert *p1,
+                            const Vert *q1,
+                            const Vert *r1,
+                            const Vert *p2,
+                            const Vert *q2,
+                            const Vert *r2,
                             const mpq3 &n1,
                             const mpq3 &n2,
                             int sp2,
@@ -1548,49 +1614,49 @@ static ITT_value intersect_tri_tri(const IMesh &tm, int t1, int t2)
   ITT_value ans;
   if (sp1 > 0) {
     if (sq1 > 0) {
-      ans = itt_canon1(r1, p1, q1, p2, r2, q2, n1, n2, sp2, sr2, sq2);
+      ans = itt_canon1(vr1, vp1, vq1, vp2, vr2, vq2, n1, n2, sp2, sr2, sq2);
     }
     else if (sr1 > 0) {
-      ans = itt_canon1(q1, r1, p1, p2, r2, q2, n1, n2, sp2, sr2, sq2);
+      ans = itt_canon1(vq1, vr1, vp1, vp2, vr2, vq2, n1, n2, sp2, sr2, sq2);
     }
     else {
-      ans = itt_canon1(p1, q1, r1, p2, q2, r2, n1, n2, sp2, sq2, sr2);
+      ans = itt_canon1(vp1, vq1, vr1, vp2, vq2, vr2, n1, n2, sp2, sq2, sr2);
     }
   }
   else if (sp1 < 0) {
     if (sq1 < 0) {
-      ans = itt_canon1(r1, p1, q1, p2, q2, r2, n1, n2, sp2, sq2, sr2);
+      ans = itt_canon1(vr1, vp1, vq1, vp2, vq2, vr2, n1, n2, sp2, sq2, sr2);
     }
     else if (sr1 < 0) {
-      ans = itt_canon1(q1, r1, p1, p2, q2, r2, n1, n2, sp2, sq2, sr2);
+      ans = itt_canon1(vq1, vr1, vp1, vp2, vq2, vr2, n1, n2, sp2, sq2, sr2);
     }
     else {
-      ans = itt_canon1(p1, q1, r1, p2, r2, q2, n1, n2, sp2, sr2, sq2);
+      ans = itt_canon1(vp1, vq1, vr1, vp2, vr2, vq2, n1, n2, sp2, sr2, sq2);
     }
   }
   else {
     if (sq1 < 0) {
       if (sr1 >= 0) {
-        ans = itt_canon1(q1, r1, p1, p2, r2, q2, n1, n2, sp2, sr2, sq2);
+        ans = itt_canon1(vq1, vr1, vp1, vp2, vr2, vq2, n1, n2, sp2, sr2, sq2);
       }
       else {
-        ans = itt_canon1(p1, q1, r1, p2, q2, r2, n1, n2, sp2, sq2, sr2);
+        ans = itt_canon1(vp1, vq1, vr1, vp2, vq2, vr2, n1, n2, sp2, sq2, sr2);
       }
     }
     else if (sq1 > 0) {
       if (sr1 > 0) {
-        ans = itt_canon1(p1, q1, r1, p2, r2, q2, n1, n2, sp2, sr2, sq2);
+        ans = itt_canon1(vp1, vq1, vr1, vp2, vr2, vq2, n1, n2, sp2, sr2, sq2);
       }
       else {
-        ans = itt_canon1(q1, r1, p1, p2, q2, r2, n1, n2, sp2, sq2, sr2);
+        ans = itt_canon1(vq1, vr1, vp1, vp2, vq2, vr2, n1, n2, sp2, sq2, sr2);
       }
     }
     else {
       if (sr1 > 0) {
-        ans = itt_canon1(r1, p1, q1, p2, q2, r2, n1, n2, sp2, sq2, sr2);
+        ans = itt_canon1(vr1, vp1, vq1, vp2, vq2, vr2, n1, n2, sp2, sq2, sr2);
       }
       else if (sr1 < 0) {
-        ans = itt_canon1(r1, p1, q1, p2, r2, q2, n1, n2, sp2, sr2, sq2);
+        ans = itt_canon1(vr1, vp1, vq1, vp2, vr2, vq2, n1, n2, sp2, sr2, sq2);
       }
       else {
         if (dbg_level > 0) {
@@ -3235,6 +3301,14 @@ static void perfdata_init(void)
   perfdata->count.append(0);
   perfdata->count_name.append("final non-NONE intersects");
 
+  /* count 5. */
+  perfdata->count.append(0);
+  perfdata->count_name.append("orientation tests decided by filter");
+
+  /* count 6. */
+  perfdata->count.append(0);
+  perfdata->count_name.append("orientation tests decided by exact arithmetic");
+
   /* max 0. */
   perfdata->max.append(0);
   perfdata->max_name.append("total faces");
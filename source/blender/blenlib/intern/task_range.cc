@@ -21,12 +21,16 @@
  */
 
 #include <cstdlib>
+#include <cstring>
+#include <memory>
 
 #include "MEM_guardedalloc.h"
 
 #include "DNA_listBase.h"
 
+#include "BLI_array.hh"
 #include "BLI_task.h"
+#include "BLI_task.hh"
 #include "BLI_threads.h"
 
 #include "atomic_ops.h"
@@ -103,6 +107,40 @@ struct RangeTask {
   }
 };
 
+/* Split the range over NUMA nodes first, with a task per node that is reduced into the root
+ * task in node order. */
+static void parallel_range_numa(const int start,
+                                const int stop,
+                                const size_t grainsize,
+                                RangeTask &root_task)
+{
+  using namespace blender;
+  const TaskParallelSettings *settings = root_task.settings;
+  Array<std::unique_ptr<RangeTask>> node_tasks(BLI_task_scheduler_num_numa_nodes());
+
+  threading::detail::numa_nodes_execute(
+      IndexRange(start, stop - start), [&](const int node_index, const IndexRange node_range) {
+        node_tasks[node_index] = std::make_unique<RangeTask>(root_task);
+        RangeTask &task = *node_tasks[node_index];
+        const tbb::blocked_range<int> range(
+            (int)node_range.first(), (int)node_range.one_after_last(), grainsize);
+        if (settings->func_reduce) {
+          parallel_reduce(range, task);
+        }
+        else {
+          parallel_for(range, task);
+        }
+      });
+
+  if (settings->func_reduce) {
+    for (const std::unique_ptr<RangeTask> &task : node_tasks) {
+      if (task) {
+        root_task.join(*task);
+      }
+    }
+  }
+}
+
 #endif
 
 void BLI_task_parallel_range(const int start,
@@ -118,7 +156,13 @@ void BLI_task_parallel_range(const int start,
     const size_t grainsize = MAX2(settings->min_iter_per_thread, 1);
     const tbb::blocked_range<int> range(start, stop, grainsize);
 
-    if (settings->func_reduce) {
+    if (settings->use_numa_affinity && BLI_task_scheduler_num_numa_nodes() > 1) {
+      parallel_range_numa(start, stop, grainsize, task);
+      if (settings->func_reduce && settings->userdata_chunk) {
+        memcpy(settings->userdata_chunk, task.userdata_chunk, settings->userdata_chunk_size);
+      }
+    }
+    else if (settings->func_reduce) {
       parallel_reduce(range, task);
       if (settings->userdata_chunk) {
         memcpy(settings->userdata_chunk, task.userdata_chunk, settings->userdata_chunk_size);
@@ -143,6 +187,20 @@ void BLI_task_parallel_range(const int start,
   }
 }
 
+void BLI_task_numa_first_touch(void *data, const size_t item_size, const int items_num)
+{
+  using namespace blender;
+  if (BLI_task_scheduler_num_numa_nodes() == 1) {
+    memset(data, 0, item_size * (size_t)items_num);
+    return;
+  }
+  /* Zero in pages rather than items, so every page is written by a thread of its node. */
+  threading::parallel_for_numa(
+      IndexRange(items_num), (int64_t)(4096 / item_size) + 1, [&](const IndexRange range) {
+        memset(POINTER_OFFSET(data, item_size * range.start()), 0, item_size * range.size());
+      });
+}
+
 int BLI_task_parallel_thread_id(const TaskParallelTLS *UNUSED(tls))
 {
 #ifdef WITH_TBB
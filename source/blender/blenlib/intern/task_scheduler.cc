@@ -20,15 +20,23 @@
  * Task scheduler initialization.
  */
 
+#include <memory>
+
 #include "MEM_guardedalloc.h"
 
 #include "BLI_task.h"
+#include "BLI_task.hh"
 #include "BLI_threads.h"
+#include "BLI_vector.hh"
+
+#include "numaapi.h"
 
 #ifdef WITH_TBB
 /* Need to include at least one header to get the version define. */
 #  include <tbb/blocked_range.h>
 #  include <tbb/task_arena.h>
+#  include <tbb/task_group.h>
+#  include <tbb/task_scheduler_observer.h>
 #  if TBB_INTERFACE_VERSION_MAJOR >= 10
 #    include <tbb/global_control.h>
 #    define WITH_TBB_GLOBAL_CONTROL
@@ -42,6 +50,119 @@ static int task_scheduler_num_threads = 1;
 static tbb::global_control *task_scheduler_global_control = nullptr;
 #endif
 
+/* NUMA Nodes
+ *
+ * On systems with multiple NUMA nodes, each node gets a task arena. Threads working in an arena
+ * are put on its node, so work split over the arenas accesses memory local to the node. */
+
+#ifdef WITH_TBB
+
+/* Node of the arena the thread is working in, -1 when not in a node arena. */
+static thread_local int task_scheduler_thread_numa_node = -1;
+/* Affinity of the thread before entering a node arena, restored when leaving it. Threads that
+ * start work in the arena may have been given an affinity by the caller. */
+static thread_local NUMAAPI_ThreadAffinity task_scheduler_thread_affinity;
+static thread_local bool task_scheduler_thread_affinity_stored = false;
+
+class NumaNodeObserver : public tbb::task_scheduler_observer {
+ private:
+  int node_;
+
+ public:
+  NumaNodeObserver(tbb::task_arena &arena, const int node)
+      : tbb::task_scheduler_observer(arena), node_(node)
+  {
+    observe(true);
+  }
+
+  ~NumaNodeObserver()
+  {
+    observe(false);
+  }
+
+  void on_scheduler_entry(bool /*is_worker*/) override
+  {
+    task_scheduler_thread_affinity_stored = numaAPI_GetThreadAffinity(
+        &task_scheduler_thread_affinity);
+    numaAPI_RunThreadOnNode(node_);
+    task_scheduler_thread_numa_node = node_;
+  }
+
+  void on_scheduler_exit(bool /*is_worker*/) override
+  {
+    if (task_scheduler_thread_affinity_stored) {
+      numaAPI_SetThreadAffinity(&task_scheduler_thread_affinity);
+      task_scheduler_thread_affinity_stored = false;
+    }
+    task_scheduler_thread_numa_node = -1;
+  }
+};
+
+struct NumaNode {
+  int node;
+  int num_processors;
+  /* Number of processors of all nodes before this one. */
+  int processors_offset;
+  tbb::task_arena arena;
+  NumaNodeObserver observer;
+
+  /* Besides the workers for every processor of the node, reserve a slot for every thread that
+   * could start work in the arena, so these never have to wait for a free slot. */
+  NumaNode(const int node,
+           const int num_processors,
+           const int processors_offset,
+           const int num_threads)
+      : node(node),
+        num_processors(num_processors),
+        processors_offset(processors_offset),
+        arena(num_processors + num_threads, (unsigned)num_threads),
+        observer(arena, node)
+  {
+  }
+};
+
+static blender::Vector<NumaNode *> task_scheduler_numa_nodes;
+static int task_scheduler_numa_num_processors = 0;
+
+static void task_scheduler_numa_init()
+{
+  if (task_scheduler_num_threads == 1 || numaAPI_Initialize() != NUMAAPI_SUCCESS) {
+    return;
+  }
+
+  int processors_offset = 0;
+  for (int node = 0; node < numaAPI_GetNumNodes(); node++) {
+    if (!numaAPI_IsNodeAvailable(node)) {
+      continue;
+    }
+    const int num_processors = numaAPI_GetNumNodeProcessors(node);
+    if (num_processors == 0) {
+      continue;
+    }
+    task_scheduler_numa_nodes.append(OBJECT_GUARDED_NEW(
+        NumaNode, node, num_processors, processors_offset, task_scheduler_num_threads));
+    processors_offset += num_processors;
+  }
+  task_scheduler_numa_num_processors = processors_offset;
+
+  /* Nothing to gain from arenas when all processors are on the same node. */
+  if (task_scheduler_numa_nodes.size() == 1) {
+    OBJECT_GUARDED_DELETE(task_scheduler_numa_nodes[0], NumaNode);
+    task_scheduler_numa_nodes.clear();
+  }
+}
+
+static void task_scheduler_numa_exit()
+{
+  for (NumaNode *numa_node : task_scheduler_numa_nodes) {
+    OBJECT_GUARDED_DELETE(numa_node, NumaNode);
+  }
+  task_scheduler_numa_nodes.clear_and_make_inline();
+  task_scheduler_numa_num_processors = 0;
+}
+
+#endif
+
 void BLI_task_scheduler_init()
 {
 #ifdef WITH_TBB_GLOBAL_CONTROL
@@ -64,10 +185,17 @@ void BLI_task_scheduler_init()
 #else
   task_scheduler_num_threads = BLI_system_thread_count();
 #endif
+
+#ifdef WITH_TBB
+  task_scheduler_numa_init();
+#endif
 }
 
 void BLI_task_scheduler_exit()
 {
+#ifdef WITH_TBB
+  task_scheduler_numa_exit();
+#endif
 #ifdef WITH_TBB_GLOBAL_CONTROL
   OBJECT_GUARDED_DELETE(task_scheduler_global_control, tbb::global_control);
 #endif
@@ -78,6 +206,15 @@ int BLI_task_scheduler_num_threads()
   return task_scheduler_num_threads;
 }
 
+int BLI_task_scheduler_num_numa_nodes()
+{
+#ifdef WITH_TBB
+  return task_scheduler_numa_nodes.is_empty() ? 1 : (int)task_scheduler_numa_nodes.size();
+#else
+  return 1;
+#endif
+}
+
 void BLI_task_isolate(void (*func)(void *userdata), void *userdata)
 {
 #ifdef WITH_TBB
@@ -86,3 +223,44 @@ void BLI_task_isolate(void (*func)(void *userdata), void *userdata)
   func(userdata);
 #endif
 }
+
+namespace blender::threading::detail {
+
+void numa_nodes_execute(const IndexRange range,
+                        const FunctionRef<void(int node_index, IndexRange node_range)> function)
+{
+#ifdef WITH_TBB
+  /* Work started from within a node arena stays on that node. */
+  const int nodes_num = (int)task_scheduler_numa_nodes.size();
+  if (nodes_num > 1 && task_scheduler_thread_numa_node == -1) {
+    std::unique_ptr<tbb::task_group[]> task_groups = std::make_unique<tbb::task_group[]>(
+        nodes_num);
+    for (const int node_index : IndexRange(nodes_num)) {
+      NumaNode &numa_node = *task_scheduler_numa_nodes[node_index];
+      /* Split in proportion to the number of processors, always the same way for a range. */
+      const int64_t begin = range.size() * numa_node.processors_offset /
+                            task_scheduler_numa_num_processors;
+      const int64_t end = range.size() *
+                          (numa_node.processors_offset + numa_node.num_processors) /
+                          task_scheduler_numa_num_processors;
+      if (begin == end) {
+        continue;
+      }
+      const IndexRange node_range(range.start() + begin, end - begin);
+      numa_node.arena.execute([&]() {
+        task_groups[node_index].run([&, node_index, node_range]() {
+          function(node_index, node_range);
+        });
+      });
+    }
+    for (const int node_index : IndexRange(nodes_num)) {
+      task_scheduler_numa_nodes[node_index]->arena.execute(
+          [&]() { task_groups[node_index].wait(); });
+    }
+    return;
+  }
+#endif
+  function(0, range);
+}
+
+}  // namespace blender::threading::detail
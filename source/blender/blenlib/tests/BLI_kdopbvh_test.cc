@@ -132,3 +132,160 @@ TEST(kdopbvh, OptimalFindNearest_500)
 {
   find_nearest_points_test(500, 1.0, 1000, 12, true);
 }
+
+/* -------------------------------------------------------------------- */
+/* Batched Queries */
+
+#define SPHERE_RADIUS 0.02f
+
+static void raycast_sphere_callback(void *userdata,
+                                    int index,
+                                    const BVHTreeRay *ray,
+                                    BVHTreeRayHit *hit)
+{
+  const float(*centers)[3] = (const float(*)[3])userdata;
+  float v[3];
+
+  sub_v3_v3v3(v, ray->origin, centers[index]);
+  const float b = dot_v3v3(v, ray->direction);
+  const float c = dot_v3v3(v, v) - SPHERE_RADIUS * SPHERE_RADIUS;
+  const float discriminant = b * b - c;
+  if (discriminant < 0.0f) {
+    return;
+  }
+
+  const float dist = -b - sqrtf(discriminant);
+  if (dist >= 0.0f && dist < hit->dist) {
+    hit->index = index;
+    hit->dist = dist;
+    madd_v3_v3v3fl(hit->co, ray->origin, ray->direction, dist);
+  }
+}
+
+/**
+ * Batched queries must give the same results as running each query on its own.
+ */
+static void find_nearest_batch_test(int points_len, int queries_len, int random_seed)
+{
+  struct RNG *rng = BLI_rng_new(random_seed);
+  BVHTree *tree = BLI_bvhtree_new(points_len, 0.0, 8, 8);
+
+  float(*points)[3] = (float(*)[3])MEM_mallocN(sizeof(float[3]) * points_len, __func__);
+  float(*queries)[3] = (float(*)[3])MEM_mallocN(sizeof(float[3]) * queries_len, __func__);
+  BVHTreeNearest *nearest = (BVHTreeNearest *)MEM_mallocN(sizeof(BVHTreeNearest) * queries_len,
+                                                          __func__);
+
+  for (int i = 0; i < points_len; i++) {
+    rng_v3_round(points[i], 3, rng, 1000, 1.0f);
+    BLI_bvhtree_insert(tree, i, points[i], 1);
+  }
+  BLI_bvhtree_balance(tree);
+
+  for (int i = 0; i < queries_len; i++) {
+    BLI_rng_get_float_unit_v3(rng, queries[i]);
+    nearest[i].index = -1;
+    nearest[i].dist_sq = FLT_MAX;
+  }
+
+  BLI_bvhtree_find_nearest_batch(tree, queries, queries_len, nearest, nullptr, nullptr, 0);
+
+  for (int i = 0; i < queries_len; i++) {
+    BVHTreeNearest single;
+    single.index = -1;
+    single.dist_sq = FLT_MAX;
+    BLI_bvhtree_find_nearest(tree, queries[i], &single, nullptr, nullptr);
+
+    EXPECT_GE(nearest[i].index, 0);
+    EXPECT_FLOAT_EQ(nearest[i].dist_sq, single.dist_sq);
+  }
+
+  BLI_bvhtree_free(tree);
+  BLI_rng_free(rng);
+  MEM_freeN(points);
+  MEM_freeN(queries);
+  MEM_freeN(nearest);
+}
+
+static void ray_cast_batch_test(int spheres_len, int rays_len, int random_seed)
+{
+  struct RNG *rng = BLI_rng_new(random_seed);
+  BVHTree *tree = BLI_bvhtree_new(spheres_len, 0.0, 8, 8);
+
+  float(*centers)[3] = (float(*)[3])MEM_mallocN(sizeof(float[3]) * spheres_len, __func__);
+  float(*origins)[3] = (float(*)[3])MEM_mallocN(sizeof(float[3]) * rays_len, __func__);
+  float(*directions)[3] = (float(*)[3])MEM_mallocN(sizeof(float[3]) * rays_len, __func__);
+  BVHTreeRayHit *hits = (BVHTreeRayHit *)MEM_mallocN(sizeof(BVHTreeRayHit) * rays_len, __func__);
+
+  for (int i = 0; i < spheres_len; i++) {
+    float bounds[2][3];
+    rng_v3_round(centers[i], 3, rng, 1000, 1.0f);
+    copy_v3_v3(bounds[0], centers[i]);
+    copy_v3_v3(bounds[1], centers[i]);
+    add_v3_fl(bounds[0], -SPHERE_RADIUS);
+    add_v3_fl(bounds[1], SPHERE_RADIUS);
+    BLI_bvhtree_insert(tree, i, bounds[0], 2);
+  }
+  BLI_bvhtree_balance(tree);
+
+  for (int i = 0; i < rays_len; i++) {
+    BLI_rng_get_float_unit_v3(rng, origins[i]);
+    mul_v3_fl(origins[i], 2.0f);
+    /* Aim at a sphere, other spheres may still be hit first. */
+    const int target = BLI_rng_get_int(rng) % spheres_len;
+    sub_v3_v3v3(directions[i], centers[target], origins[i]);
+    normalize_v3(directions[i]);
+    hits[i].index = -1;
+    hits[i].dist = BVH_RAYCAST_DIST_MAX;
+  }
+
+  BLI_bvhtree_ray_cast_batch(tree,
+                             origins,
+                             directions,
+                             rays_len,
+                             0.0f,
+                             hits,
+                             raycast_sphere_callback,
+                             centers,
+                             BVH_RAYCAST_DEFAULT);
+
+  int hits_len = 0;
+  for (int i = 0; i < rays_len; i++) {
+    BVHTreeRayHit single;
+    single.index = -1;
+    single.dist = BVH_RAYCAST_DIST_MAX;
+    BLI_bvhtree_ray_cast(
+        tree, origins[i], directions[i], 0.0f, &single, raycast_sphere_callback, centers);
+
+    EXPECT_EQ(hits[i].index, single.index);
+    if (single.index != -1) {
+      EXPECT_FLOAT_EQ(hits[i].dist, single.dist);
+      hits_len++;
+    }
+  }
+  EXPECT_EQ(hits_len, rays_len);
+
+  BLI_bvhtree_free(tree);
+  BLI_rng_free(rng);
+  MEM_freeN(centers);
+  MEM_freeN(origins);
+  MEM_freeN(directions);
+  MEM_freeN(hits);
+}
+
+TEST(kdopbvh, FindNearestBatch_1)
+{
+  find_nearest_batch_test(1, 10, 1234);
+}
+TEST(kdopbvh, FindNearestBatch_500)
+{
+  find_nearest_batch_test(500, 5000, 12);
+}
+
+TEST(kdopbvh, RayCastBatch_1)
+{
+  ray_cast_batch_test(1, 10, 1234);
+}
+TEST(kdopbvh, RayCastBatch_500)
+{
+  ray_cast_batch_test(500, 5000, 12);
+}
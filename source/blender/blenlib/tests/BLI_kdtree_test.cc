@@ -0,0 +1,222 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_kdtree.h"
+#include "BLI_math_vector.h"
+#include "BLI_memarena.h"
+#include "BLI_rand.h"
+
+/* -------------------------------------------------------------------- */
+/* Helper Functions */
+
+static KDTree_3d *kdtree_3d_random(float (*co)[3], int co_len, struct RNG *rng)
+{
+  KDTree_3d *tree = BLI_kdtree_3d_new(co_len);
+  for (int i = 0; i < co_len; i++) {
+    BLI_rng_get_float_unit_v3(rng, co[i]);
+    mul_v3_fl(co[i], BLI_rng_get_float(rng));
+    BLI_kdtree_3d_insert(tree, i, co[i]);
+  }
+  BLI_kdtree_3d_balance(tree);
+  return tree;
+}
+
+static float brute_force_nearest_dist(const float (*co)[3], int co_len, const float point[3])
+{
+  float dist_sq = FLT_MAX;
+  for (int i = 0; i < co_len; i++) {
+    dist_sq = min_ff(dist_sq, len_squared_v3v3(co[i], point));
+  }
+  return sqrtf(dist_sq);
+}
+
+/* -------------------------------------------------------------------- */
+/* Tests */
+
+TEST(kdtree, Empty)
+{
+  KDTree_3d *tree = BLI_kdtree_3d_new(0);
+  BLI_kdtree_3d_balance(tree);
+
+  const float co[1][3] = {{0.0f, 0.0f, 0.0f}};
+  KDTreeNearest_3d nearest;
+  EXPECT_EQ(BLI_kdtree_3d_find_nearest(tree, co[0], &nearest), -1);
+
+  BLI_kdtree_3d_find_nearest_batch(tree, co, 1, &nearest);
+  EXPECT_EQ(nearest.index, -1);
+
+  MemArena *arena = BLI_memarena_new(BLI_MEMARENA_STD_BUFSIZE, __func__);
+  KDTreeNearest_3d *nearest_range;
+  uint nearest_offsets[2];
+  EXPECT_EQ(
+      BLI_kdtree_3d_range_search_batch(tree, co, 1, 1.0f, arena, &nearest_range, nearest_offsets),
+      0);
+  EXPECT_EQ(nearest_range, nullptr);
+  EXPECT_EQ(nearest_offsets[1], 0);
+  BLI_memarena_free(arena);
+
+  BLI_kdtree_3d_free(tree);
+}
+
+static void find_nearest_test(int tree_len, int points_len)
+{
+  struct RNG *rng = BLI_rng_new(tree_len);
+  float(*co)[3] = (float(*)[3])MEM_malloc_arrayN(tree_len, sizeof(float[3]), __func__);
+  float(*points)[3] = (float(*)[3])MEM_malloc_arrayN(points_len, sizeof(float[3]), __func__);
+  KDTree_3d *tree = kdtree_3d_random(co, tree_len, rng);
+
+  for (int i = 0; i < points_len; i++) {
+    BLI_rng_get_float_unit_v3(rng, points[i]);
+  }
+
+  KDTreeNearest_3d *nearest_batch = (KDTreeNearest_3d *)MEM_malloc_arrayN(
+      points_len, sizeof(KDTreeNearest_3d), __func__);
+  BLI_kdtree_3d_find_nearest_batch(tree, points, points_len, nearest_batch);
+
+  for (int i = 0; i < points_len; i++) {
+    KDTreeNearest_3d nearest;
+    const int index = BLI_kdtree_3d_find_nearest(tree, points[i], &nearest);
+    EXPECT_FLOAT_EQ(nearest.dist, brute_force_nearest_dist(co, tree_len, points[i]));
+    EXPECT_EQ(nearest_batch[i].index, index);
+    EXPECT_EQ(nearest_batch[i].dist, nearest.dist);
+  }
+
+  BLI_kdtree_3d_free(tree);
+  BLI_rng_free(rng);
+  MEM_freeN(co);
+  MEM_freeN(points);
+  MEM_freeN(nearest_batch);
+}
+
+TEST(kdtree, FindNearest_1)
+{
+  find_nearest_test(1, 100);
+}
+
+TEST(kdtree, FindNearest_500)
+{
+  find_nearest_test(500, 1000);
+}
+
+/* Large enough for the tree to be balanced in parallel. */
+TEST(kdtree, FindNearest_50000)
+{
+  find_nearest_test(50000, 1000);
+}
+
+static void range_search_test(int tree_len, int points_len, float range)
+{
+  struct RNG *rng = BLI_rng_new(tree_len);
+  float(*co)[3] = (float(*)[3])MEM_malloc_arrayN(tree_len, sizeof(float[3]), __func__);
+  float(*points)[3] = (float(*)[3])MEM_malloc_arrayN(points_len, sizeof(float[3]), __func__);
+  KDTree_3d *tree = kdtree_3d_random(co, tree_len, rng);
+
+  for (int i = 0; i < points_len; i++) {
+    BLI_rng_get_float_unit_v3(rng, points[i]);
+    mul_v3_fl(points[i], BLI_rng_get_float(rng));
+  }
+
+  MemArena *arena = BLI_memarena_new(BLI_MEMARENA_STD_BUFSIZE, __func__);
+  KDTreeNearest_3d *nearest_batch;
+  uint *nearest_offsets = (uint *)MEM_malloc_arrayN(points_len + 1, sizeof(uint), __func__);
+  const int nearest_batch_len = BLI_kdtree_3d_range_search_batch(
+      tree, points, points_len, range, arena, &nearest_batch, nearest_offsets);
+  EXPECT_EQ(nearest_batch_len, nearest_offsets[points_len]);
+
+  int nearest_total = 0;
+  for (int i = 0; i < points_len; i++) {
+    KDTreeNearest_3d *nearest = nullptr;
+    const int nearest_len = BLI_kdtree_3d_range_search(tree, points[i], &nearest, range);
+
+    int brute_force_len = 0;
+    for (int j = 0; j < tree_len; j++) {
+      brute_force_len += (len_v3v3(co[j], points[i]) <= range);
+    }
+    EXPECT_EQ(nearest_len, brute_force_len);
+
+    EXPECT_EQ(nearest_offsets[i + 1] - nearest_offsets[i], nearest_len);
+    for (int j = 0; j < nearest_len; j++) {
+      EXPECT_EQ(nearest_batch[nearest_offsets[i] + j].index, nearest[j].index);
+      EXPECT_EQ(nearest_batch[nearest_offsets[i] + j].dist, nearest[j].dist);
+    }
+    nearest_total += nearest_len;
+
+    MEM_SAFE_FREE(nearest);
+  }
+  EXPECT_EQ(nearest_batch_len, nearest_total);
+
+  BLI_memarena_free(arena);
+  BLI_kdtree_3d_free(tree);
+  BLI_rng_free(rng);
+  MEM_freeN(co);
+  MEM_freeN(points);
+  MEM_freeN(nearest_offsets);
+}
+
+TEST(kdtree, RangeSearch_500)
+{
+  range_search_test(500, 1000, 0.2f);
+}
+
+TEST(kdtree, RangeSearch_50000)
+{
+  range_search_test(50000, 1000, 0.05f);
+}
+
+TEST(kdtree, CalcDuplicates)
+{
+  /* Every point of a grid is inserted twice. */
+  const int grid_size = 32;
+  const int points_len = grid_size * grid_size * grid_size;
+  KDTree_3d *tree = BLI_kdtree_3d_new(points_len * 2);
+  for (int i = 0; i < points_len * 2; i++) {
+    const int p = i % points_len;
+    const float co[3] = {
+        (float)(p % grid_size),
+        (float)((p / grid_size) % grid_size),
+        (float)(p / (grid_size * grid_size))};
+    BLI_kdtree_3d_insert(tree, i, co);
+  }
+  BLI_kdtree_3d_balance(tree);
+
+  for (int use_index_order = 0; use_index_order < 2; use_index_order++) {
+    int *duplicates = (int *)MEM_malloc_arrayN(points_len * 2, sizeof(int), __func__);
+    copy_vn_i(duplicates, points_len * 2, -1);
+    EXPECT_EQ(BLI_kdtree_3d_calc_duplicates_fast(tree, 0.1f, use_index_order, duplicates),
+              points_len);
+    for (int i = 0; i < points_len * 2; i++) {
+      EXPECT_TRUE(ELEM(duplicates[i], i, (i + points_len) % (points_len * 2)));
+    }
+    MEM_freeN(duplicates);
+  }
+
+  BLI_kdtree_3d_free(tree);
+}
+
+TEST(kdtree, FindNearest_2d)
+{
+  const int tree_len = 10000;
+  struct RNG *rng = BLI_rng_new(0);
+  float(*co)[2] = (float(*)[2])MEM_malloc_arrayN(tree_len, sizeof(float[2]), __func__);
+  KDTree_2d *tree = BLI_kdtree_2d_new(tree_len);
+  for (int i = 0; i < tree_len; i++) {
+    BLI_rng_get_float_unit_v2(rng, co[i]);
+    BLI_kdtree_2d_insert(tree, i, co[i]);
+  }
+  BLI_kdtree_2d_balance(tree);
+
+  for (int i = 0; i < tree_len; i++) {
+    /* Points on the circle may be duplicates, so check coordinates instead of index. */
+    KDTreeNearest_2d nearest;
+    const int index = BLI_kdtree_2d_find_nearest(tree, co[i], &nearest);
+    EXPECT_TRUE(equals_v2v2(co[index], co[i]));
+    EXPECT_EQ(nearest.dist, 0.0f);
+  }
+
+  BLI_kdtree_2d_free(tree);
+  BLI_rng_free(rng);
+  MEM_freeN(co);
+}
@@ -1239,6 +1239,54 @@ static void gridgrid_test(int x_level_1,
   BLI_task_scheduler_exit();
 }
 
+static void manysphere_test(int nrings, int num_per_side, double spacing)
+{
+  /* Make a `num_per_side ^ 3` block of uv-spheres of radius 1, with nrings rings and
+   * 2*nrings segments, spaced so that each one overlaps its neighbors. This is like
+   * a boolean union of many kit-bashed parts, where most triangle pairs whose bounding
+   * boxes overlap don't actually intersect. */
+  if (nrings < 2 || num_per_side < 1) {
+    return;
+  }
+  BLI_task_scheduler_init(); /* Without this, no parallelism. */
+  double time_start = PIL_check_seconds_timer();
+  IMeshArena arena;
+  int nsegs = 2 * nrings;
+  int num_sphere_verts;
+  int num_sphere_tris;
+  get_sphere_params(nrings, nsegs, true, &num_sphere_verts, &num_sphere_tris);
+  int num_spheres = num_per_side * num_per_side * num_per_side;
+  Array<Face *> tris(num_spheres * num_sphere_tris);
+  arena.reserve(3 * num_spheres * num_sphere_verts, 4 * num_spheres * num_sphere_tris);
+  for (int i = 0; i < num_spheres; ++i) {
+    double3 center(spacing * (i % num_per_side),
+                   spacing * ((i / num_per_side) % num_per_side),
+                   spacing * (i / (num_per_side * num_per_side)));
+    fill_sphere_data(nrings,
+                     nsegs,
+                     center,
+                     1.0,
+                     true,
+                     MutableSpan<Face *>(tris.begin() + i * num_sphere_tris, num_sphere_tris),
+                     i * num_sphere_verts,
+                     i * num_sphere_tris,
+                     &arena);
+  }
+  IMesh mesh(tris);
+  double time_create = PIL_check_seconds_timer();
+  int nf = num_sphere_tris;
+  IMesh out = trimesh_nary_intersect(
+      mesh, num_spheres, [nf](int t) { return t / nf; }, false, &arena);
+  double time_intersect = PIL_check_seconds_timer();
+  std::cout << "Create time: " << time_create - time_start << "\n";
+  std::cout << "Intersect time: " << time_intersect - time_create << "\n";
+  std::cout << "Total time: " << time_intersect - time_start << "\n";
+  if (DO_OBJ) {
+    write_obj_mesh(out, "manysphere");
+  }
+  BLI_task_scheduler_exit();
+}
+
 TEST(mesh_intersect_perf, SphereSphere)
 {
   spheresphere_test(512, 0.5, false);
@@ -1269,6 +1317,11 @@ TEST(mesh_intersect_perf, GridGridTilt)
   gridgrid_test(8, 2, 4, 2, 0.0, 0.0, 1.0, false);
 }
 
+TEST(mesh_intersect_perf, ManySphere)
+{
+  manysphere_test(32, 4, 1.5);
+}
+
 #  endif
 
 }  // namespace blender::meshintersect::tests
@@ -13,6 +13,8 @@
 #include "BLI_mempool.h"
 #include "BLI_task.h"
 
+#include "numaapi.h"
+
 #define NUM_ITEMS 10000
 
 /* *** Parallel iterations over range of integer values. *** */
@@ -65,6 +67,54 @@ TEST(task, RangeIter)
   BLI_threadapi_exit();
 }
 
+TEST(task, RangeIterNumaAffinity)
+{
+  const int items_num = 1000000;
+  int *data = (int *)MEM_malloc_arrayN(items_num, sizeof(int), __func__);
+  int sum = 0;
+
+  BLI_threadapi_init();
+  BLI_task_scheduler_init();
+
+  /* The calling thread works in the node arenas too, its affinity must be restored after. */
+  NUMAAPI_ThreadAffinity affinity_before, affinity_after;
+  const bool has_affinity = numaAPI_GetThreadAffinity(&affinity_before);
+
+  /* Memory is zeroed, whether split over NUMA nodes or not. */
+  memset(data, 0xff, sizeof(int) * items_num);
+  BLI_task_numa_first_touch(data, sizeof(int), items_num);
+  for (int i = 0; i < items_num; i++) {
+    EXPECT_EQ(data[i], 0);
+  }
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.use_numa_affinity = true;
+  settings.min_iter_per_thread = 1;
+
+  settings.userdata_chunk = &sum;
+  settings.userdata_chunk_size = sizeof(sum);
+  settings.func_reduce = task_range_iter_reduce_func;
+
+  BLI_task_parallel_range(0, NUM_ITEMS, data, task_range_iter_func, &settings);
+
+  int expected_sum = 0;
+  for (int i = 0; i < NUM_ITEMS; i++) {
+    EXPECT_EQ(data[i], i);
+    expected_sum += i;
+  }
+  EXPECT_EQ(sum, expected_sum);
+
+  if (has_affinity) {
+    EXPECT_TRUE(numaAPI_GetThreadAffinity(&affinity_after));
+    EXPECT_EQ(memcmp(&affinity_before, &affinity_after, sizeof(affinity_before)), 0);
+  }
+
+  BLI_task_scheduler_exit();
+  BLI_threadapi_exit();
+  MEM_freeN(data);
+}
+
 /* *** Parallel iterations over mempool items. *** */
 
 static void task_mempool_iter_func(void *userdata,
@@ -0,0 +1,148 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_array_store.h"
+#include "BLI_rand.h"
+#include "BLI_task.h"
+#include "BLI_utildefines.h"
+
+#include "PIL_time.h"
+
+/* Chunk size used by mesh undo. */
+#define CHUNK_COUNT 256
+#define STEPS 8
+
+/* *** Add states of a changing array of vertex positions, like undo steps of a mesh. *** */
+
+enum ChangeType {
+  /* Move vertices in a few places, like a sculpt stroke. */
+  CHANGE_MOVE,
+  /* Add and remove vertices in a few places, like topology changes. */
+  CHANGE_INSERT,
+  /* Change all vertices, so nothing can be de-duplicated. */
+  CHANGE_ALL,
+};
+
+static void change_array(float (**r_co)[3], int *co_len, const ChangeType change, struct RNG *rng)
+{
+  float(*co)[3] = *r_co;
+  const int regions = 16;
+  const int region_len = *co_len / 1000;
+
+  switch (change) {
+    case CHANGE_MOVE:
+      for (int r = 0; r < regions; r++) {
+        const int start = (int)(BLI_rng_get_uint(rng) % (uint)(*co_len - region_len));
+        for (int i = start; i < start + region_len; i++) {
+          co[i][2] += 0.01f;
+        }
+      }
+      break;
+    case CHANGE_INSERT: {
+      /* Alternate between adding and removing, keeping the size roughly constant. */
+      const int len_delta = (BLI_rng_get_uint(rng) & 1) ? region_len : -region_len;
+      const int co_len_new = *co_len + len_delta;
+      float(*co_new)[3] = (float(*)[3])MEM_malloc_arrayN(co_len_new, sizeof(float[3]), __func__);
+      const int split = (int)(BLI_rng_get_uint(rng) % (uint)(*co_len - region_len));
+      memcpy(co_new, co, sizeof(float[3]) * split);
+      if (len_delta > 0) {
+        for (int i = split; i < split + len_delta; i++) {
+          BLI_rng_get_float_unit_v3(rng, co_new[i]);
+        }
+        memcpy(co_new[split + len_delta], co[split], sizeof(float[3]) * (*co_len - split));
+      }
+      else {
+        memcpy(co_new[split], co[split - len_delta], sizeof(float[3]) * (co_len_new - split));
+      }
+      MEM_freeN(co);
+      *r_co = co_new;
+      *co_len = co_len_new;
+      break;
+    }
+    case CHANGE_ALL:
+      for (int i = 0; i < *co_len; i++) {
+        BLI_rng_get_float_unit_v3(rng, co[i]);
+      }
+      break;
+  }
+}
+
+static void array_store_test(const char *id, const int points_len, const ChangeType change)
+{
+  printf("\n========== STARTING %s ==========\n", id);
+
+  BLI_threadapi_init();
+
+  struct RNG *rng = BLI_rng_new(1234);
+  int co_len = points_len;
+  float(*co)[3] = (float(*)[3])MEM_malloc_arrayN(co_len, sizeof(float[3]), __func__);
+  for (int i = 0; i < co_len; i++) {
+    BLI_rng_get_float_unit_v3(rng, co[i]);
+  }
+
+  BArrayStore *bs = BLI_array_store_create(sizeof(float[3]), CHUNK_COUNT);
+  BArrayState *states[STEPS];
+  states[0] = BLI_array_store_state_add(bs, co, sizeof(float[3]) * co_len, nullptr);
+
+  size_t bytes_added = 0;
+  double time = 0.0;
+  for (int step = 1; step < STEPS; step++) {
+    change_array(&co, &co_len, change, rng);
+
+    const double time_start = PIL_check_seconds_timer();
+    states[step] = BLI_array_store_state_add(bs, co, sizeof(float[3]) * co_len, states[step - 1]);
+    time += PIL_check_seconds_timer() - time_start;
+    bytes_added += sizeof(float[3]) * co_len;
+  }
+
+  /* The last state must be stored as-is. */
+  size_t data_len;
+  void *data = BLI_array_store_state_data_get_alloc(states[STEPS - 1], &data_len);
+  EXPECT_EQ(data_len, sizeof(float[3]) * co_len);
+  EXPECT_EQ(memcmp(data, co, data_len), 0);
+  MEM_freeN(data);
+
+  const size_t size_expanded = BLI_array_store_calc_size_expanded_get(bs);
+  const size_t size_compacted = BLI_array_store_calc_size_compacted_get(bs);
+  printf("\tAdd state: %fs (%.2f MB/s)\n", time, bytes_added / time * 1e-6);
+  printf("\tExpanded: %.2f MB, compacted: %.2f MB, de-duplication ratio: %.2f\n",
+         size_expanded * 1e-6,
+         size_compacted * 1e-6,
+         (double)size_expanded / (double)size_compacted);
+
+  BLI_array_store_destroy(bs);
+  BLI_rng_free(rng);
+  MEM_freeN(co);
+
+  BLI_threadapi_exit();
+
+  printf("========== ENDED %s ==========\n\n", id);
+}
+
+TEST(array_store, Move1M)
+{
+  array_store_test("Array store - 1000000 points - move", 1000000, CHANGE_MOVE);
+}
+
+TEST(array_store, Insert1M)
+{
+  array_store_test("Array store - 1000000 points - insert", 1000000, CHANGE_INSERT);
+}
+
+TEST(array_store, All1M)
+{
+  array_store_test("Array store - 1000000 points - change all", 1000000, CHANGE_ALL);
+}
+
+TEST(array_store, Move10M)
+{
+  array_store_test("Array store - 10000000 points - move", 10000000, CHANGE_MOVE);
+}
+
+TEST(array_store, Insert10M)
+{
+  array_store_test("Array store - 10000000 points - insert", 10000000, CHANGE_INSERT);
+}
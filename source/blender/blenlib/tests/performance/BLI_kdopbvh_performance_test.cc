@@ -0,0 +1,219 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_kdopbvh.h"
+#include "BLI_math_vector.h"
+#include "BLI_rand.h"
+#include "BLI_task.h"
+#include "BLI_utildefines.h"
+
+#include "PIL_time.h"
+
+#define TREE_SIZE 100000
+#define SPHERE_RADIUS 0.005f
+
+/* *** Find nearest and ray cast of many queries, one at a time and batched. *** */
+
+struct QueryData {
+  BVHTree *tree;
+  const float (*co)[3];
+  const float (*dir)[3];
+  const float (*centers)[3];
+  BVHTreeNearest *nearest;
+  BVHTreeRayHit *hits;
+};
+
+static void raycast_sphere_callback(void *userdata,
+                                    int index,
+                                    const BVHTreeRay *ray,
+                                    BVHTreeRayHit *hit)
+{
+  const float(*centers)[3] = (const float(*)[3])userdata;
+  float v[3];
+
+  sub_v3_v3v3(v, ray->origin, centers[index]);
+  const float b = dot_v3v3(v, ray->direction);
+  const float c = dot_v3v3(v, v) - SPHERE_RADIUS * SPHERE_RADIUS;
+  const float discriminant = b * b - c;
+  if (discriminant < 0.0f) {
+    return;
+  }
+
+  const float dist = -b - sqrtf(discriminant);
+  if (dist >= 0.0f && dist < hit->dist) {
+    hit->index = index;
+    hit->dist = dist;
+    madd_v3_v3v3fl(hit->co, ray->origin, ray->direction, dist);
+  }
+}
+
+static void find_nearest_single_iter_func(void *__restrict userdata,
+                                          const int i,
+                                          const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  QueryData *data = (QueryData *)userdata;
+  BLI_bvhtree_find_nearest(data->tree, data->co[i], &data->nearest[i], nullptr, nullptr);
+}
+
+static void ray_cast_single_iter_func(void *__restrict userdata,
+                                      const int i,
+                                      const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  QueryData *data = (QueryData *)userdata;
+  BLI_bvhtree_ray_cast(data->tree,
+                       data->co[i],
+                       data->dir[i],
+                       0.0f,
+                       &data->hits[i],
+                       raycast_sphere_callback,
+                       (void *)data->centers);
+}
+
+static void query_reset(QueryData *data, const int queries_len)
+{
+  for (int i = 0; i < queries_len; i++) {
+    data->nearest[i].index = -1;
+    data->nearest[i].dist_sq = FLT_MAX;
+    data->hits[i].index = -1;
+    data->hits[i].dist = BVH_RAYCAST_DIST_MAX;
+  }
+}
+
+static void kdopbvh_query_test(const char *id, const int queries_len)
+{
+  printf("\n========== STARTING %s ==========\n", id);
+
+  BLI_threadapi_init();
+
+  struct RNG *rng = BLI_rng_new(1234);
+  BVHTree *tree = BLI_bvhtree_new(TREE_SIZE, 0.0f, 4, 6);
+
+  float(*centers)[3] = (float(*)[3])MEM_malloc_arrayN(TREE_SIZE, sizeof(float[3]), __func__);
+  float(*co)[3] = (float(*)[3])MEM_malloc_arrayN(queries_len, sizeof(float[3]), __func__);
+  float(*dir)[3] = (float(*)[3])MEM_malloc_arrayN(queries_len, sizeof(float[3]), __func__);
+
+  /* Spheres in a unit sphere. */
+  for (int i = 0; i < TREE_SIZE; i++) {
+    float bounds[2][3];
+    BLI_rng_get_float_unit_v3(rng, centers[i]);
+    mul_v3_fl(centers[i], BLI_rng_get_float(rng));
+    copy_v3_v3(bounds[0], centers[i]);
+    copy_v3_v3(bounds[1], centers[i]);
+    add_v3_fl(bounds[0], -SPHERE_RADIUS);
+    add_v3_fl(bounds[1], SPHERE_RADIUS);
+    BLI_bvhtree_insert(tree, i, bounds[0], 2);
+  }
+  BLI_bvhtree_balance(tree);
+
+  /* Project points on an enclosing sphere towards the center, like shrink-wrapping a mesh. */
+  for (int i = 0; i < queries_len; i++) {
+    float jitter[3];
+    BLI_rng_get_float_unit_v3(rng, co[i]);
+    mul_v3_fl(co[i], 1.5f);
+    BLI_rng_get_float_unit_v3(rng, jitter);
+    mul_v3_fl(jitter, 0.3f);
+    madd_v3_v3v3fl(dir[i], jitter, co[i], -1.0f);
+    normalize_v3(dir[i]);
+  }
+
+  QueryData data;
+  data.tree = tree;
+  data.co = co;
+  data.dir = dir;
+  data.centers = centers;
+  data.nearest = (BVHTreeNearest *)MEM_malloc_arrayN(
+      queries_len, sizeof(BVHTreeNearest), __func__);
+  data.hits = (BVHTreeRayHit *)MEM_malloc_arrayN(queries_len, sizeof(BVHTreeRayHit), __func__);
+
+  BVHTreeNearest *nearest_batch = (BVHTreeNearest *)MEM_malloc_arrayN(
+      queries_len, sizeof(BVHTreeNearest), __func__);
+  BVHTreeRayHit *hits_batch = (BVHTreeRayHit *)MEM_malloc_arrayN(
+      queries_len, sizeof(BVHTreeRayHit), __func__);
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+
+  double time;
+
+  /* Find nearest. */
+  query_reset(&data, queries_len);
+  time = PIL_check_seconds_timer();
+  BLI_task_parallel_range(0, queries_len, &data, find_nearest_single_iter_func, &settings);
+  const double nearest_single_time = PIL_check_seconds_timer() - time;
+
+  for (int i = 0; i < queries_len; i++) {
+    nearest_batch[i].index = -1;
+    nearest_batch[i].dist_sq = FLT_MAX;
+  }
+  time = PIL_check_seconds_timer();
+  BLI_bvhtree_find_nearest_batch(tree, co, queries_len, nearest_batch, nullptr, nullptr, 0);
+  const double nearest_batch_time = PIL_check_seconds_timer() - time;
+
+  /* Ray cast. */
+  time = PIL_check_seconds_timer();
+  BLI_task_parallel_range(0, queries_len, &data, ray_cast_single_iter_func, &settings);
+  const double raycast_single_time = PIL_check_seconds_timer() - time;
+
+  for (int i = 0; i < queries_len; i++) {
+    hits_batch[i].index = -1;
+    hits_batch[i].dist = BVH_RAYCAST_DIST_MAX;
+  }
+  time = PIL_check_seconds_timer();
+  BLI_bvhtree_ray_cast_batch(tree,
+                             co,
+                             dir,
+                             queries_len,
+                             0.0f,
+                             hits_batch,
+                             raycast_sphere_callback,
+                             centers,
+                             BVH_RAYCAST_DEFAULT);
+  const double raycast_batch_time = PIL_check_seconds_timer() - time;
+
+  /* Batched queries must find the same results. */
+  int raycast_hits_len = 0;
+  for (int i = 0; i < queries_len; i++) {
+    EXPECT_EQ(nearest_batch[i].dist_sq, data.nearest[i].dist_sq);
+    EXPECT_EQ(hits_batch[i].index, data.hits[i].index);
+    raycast_hits_len += (data.hits[i].index != -1);
+  }
+
+  printf("\tFind nearest: single %fs (%.2fM queries/s), batch %fs (%.2fM queries/s)\n",
+         nearest_single_time,
+         queries_len / nearest_single_time * 1e-6,
+         nearest_batch_time,
+         queries_len / nearest_batch_time * 1e-6);
+  printf("\tRay cast: single %fs (%.2fM rays/s), batch %fs (%.2fM rays/s), %d hits\n",
+         raycast_single_time,
+         queries_len / raycast_single_time * 1e-6,
+         raycast_batch_time,
+         queries_len / raycast_batch_time * 1e-6,
+         raycast_hits_len);
+
+  BLI_bvhtree_free(tree);
+  BLI_rng_free(rng);
+  MEM_freeN(centers);
+  MEM_freeN(co);
+  MEM_freeN(dir);
+  MEM_freeN(data.nearest);
+  MEM_freeN(data.hits);
+  MEM_freeN(nearest_batch);
+  MEM_freeN(hits_batch);
+
+  BLI_threadapi_exit();
+
+  printf("========== ENDED %s ==========\n\n", id);
+}
+
+TEST(kdopbvh, Query100k)
+{
+  kdopbvh_query_test("BVH tree queries - 100000 queries", 100000);
+}
+
+TEST(kdopbvh, Query1M)
+{
+  kdopbvh_query_test("BVH tree queries - 1000000 queries", 1000000);
+}
@@ -0,0 +1,156 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_kdtree.h"
+#include "BLI_math_vector.h"
+#include "BLI_memarena.h"
+#include "BLI_rand.h"
+#include "BLI_task.h"
+#include "BLI_utildefines.h"
+
+#include "PIL_time.h"
+
+#define SEARCH_RANGE 0.01f
+
+/* *** Build a tree and search it for every point, one at a time and batched. *** */
+
+struct QueryData {
+  KDTree_3d *tree;
+  const float (*co)[3];
+  KDTreeNearest_3d *nearest;
+  int nearest_range_len;
+};
+
+static void find_nearest_single_iter_func(void *__restrict userdata,
+                                          const int i,
+                                          const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  QueryData *data = (QueryData *)userdata;
+  BLI_kdtree_3d_find_nearest(data->tree, data->co[i], &data->nearest[i]);
+}
+
+static void range_search_single_iter_func(void *__restrict userdata,
+                                          const int i,
+                                          const TaskParallelTLS *__restrict tls)
+{
+  QueryData *data = (QueryData *)userdata;
+  KDTreeNearest_3d *nearest = nullptr;
+  const int nearest_len = BLI_kdtree_3d_range_search(
+      data->tree, data->co[i], &nearest, SEARCH_RANGE);
+  *(int *)tls->userdata_chunk += nearest_len;
+  MEM_SAFE_FREE(nearest);
+}
+
+static void range_search_single_reduce(const void *__restrict UNUSED(userdata),
+                                       void *__restrict chunk_join,
+                                       void *__restrict chunk)
+{
+  *(int *)chunk_join += *(int *)chunk;
+}
+
+static void kdtree_query_test(const char *id, const int points_len)
+{
+  printf("\n========== STARTING %s ==========\n", id);
+
+  BLI_threadapi_init();
+
+  struct RNG *rng = BLI_rng_new(1234);
+  float(*co)[3] = (float(*)[3])MEM_malloc_arrayN(points_len, sizeof(float[3]), __func__);
+
+  /* Points on a noisy sphere, like the vertices of a scanned mesh. */
+  for (int i = 0; i < points_len; i++) {
+    BLI_rng_get_float_unit_v3(rng, co[i]);
+    mul_v3_fl(co[i], 1.0f + BLI_rng_get_float(rng) * 0.01f);
+  }
+
+  double time = PIL_check_seconds_timer();
+  KDTree_3d *tree = BLI_kdtree_3d_new(points_len);
+  for (int i = 0; i < points_len; i++) {
+    BLI_kdtree_3d_insert(tree, i, co[i]);
+  }
+  BLI_kdtree_3d_balance(tree);
+  const double build_time = PIL_check_seconds_timer() - time;
+
+  QueryData data;
+  data.tree = tree;
+  data.co = co;
+  data.nearest = (KDTreeNearest_3d *)MEM_malloc_arrayN(
+      points_len, sizeof(KDTreeNearest_3d), __func__);
+  data.nearest_range_len = 0;
+
+  KDTreeNearest_3d *nearest_batch = (KDTreeNearest_3d *)MEM_malloc_arrayN(
+      points_len, sizeof(KDTreeNearest_3d), __func__);
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+
+  /* Find nearest. */
+  time = PIL_check_seconds_timer();
+  BLI_task_parallel_range(0, points_len, &data, find_nearest_single_iter_func, &settings);
+  const double nearest_single_time = PIL_check_seconds_timer() - time;
+
+  time = PIL_check_seconds_timer();
+  BLI_kdtree_3d_find_nearest_batch(tree, co, points_len, nearest_batch);
+  const double nearest_batch_time = PIL_check_seconds_timer() - time;
+
+  /* Range search. */
+  int nearest_range_len = 0;
+  settings.userdata_chunk = &nearest_range_len;
+  settings.userdata_chunk_size = sizeof(nearest_range_len);
+  settings.func_reduce = range_search_single_reduce;
+  time = PIL_check_seconds_timer();
+  BLI_task_parallel_range(0, points_len, &data, range_search_single_iter_func, &settings);
+  const double range_single_time = PIL_check_seconds_timer() - time;
+
+  MemArena *arena = BLI_memarena_new(BLI_MEMARENA_STD_BUFSIZE, __func__);
+  KDTreeNearest_3d *nearest_range_batch;
+  uint *nearest_offsets = (uint *)MEM_malloc_arrayN(points_len + 1, sizeof(uint), __func__);
+  time = PIL_check_seconds_timer();
+  const int nearest_range_batch_len = BLI_kdtree_3d_range_search_batch(
+      tree, co, points_len, SEARCH_RANGE, arena, &nearest_range_batch, nearest_offsets);
+  const double range_batch_time = PIL_check_seconds_timer() - time;
+
+  /* Batched searches must find the same results. */
+  for (int i = 0; i < points_len; i++) {
+    EXPECT_EQ(nearest_batch[i].index, data.nearest[i].index);
+  }
+  EXPECT_EQ(nearest_range_batch_len, nearest_range_len);
+
+  printf("\tBuild: %fs\n", build_time);
+  printf("\tFind nearest: single %fs (%.2fM points/s), batch %fs (%.2fM points/s)\n",
+         nearest_single_time,
+         points_len / nearest_single_time * 1e-6,
+         nearest_batch_time,
+         points_len / nearest_batch_time * 1e-6);
+  printf("\tRange search: single %fs (%.2fM points/s), batch %fs (%.2fM points/s), %d found\n",
+         range_single_time,
+         points_len / range_single_time * 1e-6,
+         range_batch_time,
+         points_len / range_batch_time * 1e-6,
+         nearest_range_batch_len);
+
+  BLI_memarena_free(arena);
+  BLI_kdtree_3d_free(tree);
+  BLI_rng_free(rng);
+  MEM_freeN(co);
+  MEM_freeN(data.nearest);
+  MEM_freeN(nearest_batch);
+  MEM_freeN(nearest_offsets);
+
+  BLI_threadapi_exit();
+
+  printf("========== ENDED %s ==========\n\n", id);
+}
+
+TEST(kdtree, Query100k)
+{
+  kdtree_query_test("KD tree queries - 100000 points", 100000);
+}
+
+TEST(kdtree, Query1M)
+{
+  kdtree_query_test("KD tree queries - 1000000 points", 1000000);
+}
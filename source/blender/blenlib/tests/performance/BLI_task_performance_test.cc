@@ -14,6 +14,7 @@
 #include "BLI_listbase.h"
 #include "BLI_mempool.h"
 #include "BLI_task.h"
+#include "BLI_threads.h"
 
 #include "PIL_time.h"
 
@@ -208,3 +209,106 @@ TEST(task, ListBaseIter100k)
 {
   task_listbase_test("ListBase parallel iteration - Threaded - 100000 items", 100000, true);
 }
+
+/* *** Scaling of memory bound parallel ranges with the number of threads. *** */
+
+#define RANGE_BLOCK_SIZE 4096
+#define RANGE_NUM_RUNS 10
+
+struct RangeScalingData {
+  float *a;
+  const float *b;
+  const float *c;
+};
+
+static void task_range_triad_iter_func(void *__restrict userdata,
+                                       const int index,
+                                       const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  RangeScalingData *data = (RangeScalingData *)userdata;
+  const int start = index * RANGE_BLOCK_SIZE;
+  for (int i = start; i < start + RANGE_BLOCK_SIZE; i++) {
+    data->a[i] = data->b[i] * 0.5f + data->c[i];
+  }
+}
+
+static double task_range_scaling_do(const int num_items, const bool use_numa)
+{
+  float *arrays[3];
+  for (int i = 0; i < 3; i++) {
+    arrays[i] = (float *)MEM_malloc_arrayN(num_items, sizeof(float), __func__);
+    if (use_numa) {
+      BLI_task_numa_first_touch(arrays[i], sizeof(float), num_items);
+    }
+    else {
+      memset(arrays[i], 0, sizeof(float) * num_items);
+    }
+  }
+
+  RangeScalingData data = {arrays[0], arrays[1], arrays[2]};
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.use_numa_affinity = use_numa;
+
+  double timing = 0.0;
+  for (int run = 0; run < RANGE_NUM_RUNS; run++) {
+    const double init_time = PIL_check_seconds_timer();
+    BLI_task_parallel_range(
+        0, num_items / RANGE_BLOCK_SIZE, &data, task_range_triad_iter_func, &settings);
+    timing += PIL_check_seconds_timer() - init_time;
+  }
+
+  for (int i = 0; i < 3; i++) {
+    MEM_freeN(arrays[i]);
+  }
+  return timing / RANGE_NUM_RUNS;
+}
+
+static void task_range_scaling_test(const char *id, const int num_items)
+{
+  printf("\n========== STARTING %s ==========\n", id);
+
+  BLI_threadapi_init();
+
+  const int num_processors = BLI_system_thread_count();
+  const double bytes = 3.0 * sizeof(float) * num_items;
+  double time_single = 0.0;
+
+  for (int num_threads = 1; num_threads <= 128; num_threads *= 2) {
+    if (num_threads > num_processors) {
+      printf("\tSkipping %d threads and more, only %d processors\n", num_threads, num_processors);
+      break;
+    }
+    BLI_system_num_threads_override_set(num_threads);
+    BLI_task_scheduler_init();
+
+    const double time = task_range_scaling_do(num_items, false);
+    const double time_numa = task_range_scaling_do(num_items, true);
+    if (num_threads == 1) {
+      time_single = time;
+    }
+    printf(
+        "\t%3d threads, %d NUMA nodes: %fs (%.2f GB/s, %.2fx), NUMA affinity %fs (%.2f GB/s, "
+        "%.2fx)\n",
+        num_threads,
+        BLI_task_scheduler_num_numa_nodes(),
+        time,
+        bytes / time * 1e-9,
+        time_single / time,
+        time_numa,
+        bytes / time_numa * 1e-9,
+        time_single / time_numa);
+
+    BLI_task_scheduler_exit();
+  }
+
+  BLI_system_num_threads_override_set(0);
+  BLI_threadapi_exit();
+
+  printf("========== ENDED %s ==========\n\n", id);
+}
+
+TEST(task, RangeScaling16M)
+{
+  task_range_scaling_test("Range parallel iteration scaling - 16M items", 16 * 1024 * 1024);
+}
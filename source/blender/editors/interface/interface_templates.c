@@ -6500,6 +6500,10 @@ void uiTemplateCacheFile(uiLayout *layout,
   uiLayoutSetEnabled(sub, use_prefetch && use_render_procedural);
   uiItemR(sub, &fileptr, "prefetch_cache_size", 0, NULL, ICON_NONE);
 
+  sub = uiLayoutRow(layout, false);
+  uiLayoutSetEnabled(sub, use_prefetch && use_render_procedural);
+  uiItemR(sub, &fileptr, "stream_window", 0, NULL, ICON_NONE);
+
   row = uiLayoutRowWithHeading(layout, true, IFACE_("Override Frame"));
   sub = uiLayoutRow(row, true);
   uiLayoutSetPropDecorate(sub, false);
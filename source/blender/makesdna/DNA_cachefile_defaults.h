@@ -42,6 +42,7 @@
     .handle_readers = NULL, \
     .use_prefetch = 1, \
     .prefetch_cache_size = 4096, \
+    .stream_window = 0, \
   }
 
 /** \} */
@@ -109,7 +109,10 @@ typedef struct CacheFile {
   /** Size in megabytes for the prefetch cache used by the Cycles Procedural. */
   int prefetch_cache_size;
 
-  char _pad2[7];
+  /** Number of frames kept in memory by the Cycles Procedural when prefetching, 0 for all. */
+  int stream_window;
+
+  char _pad2[3];
 
   char velocity_unit;
   /* Name of the velocity property in the archive. */
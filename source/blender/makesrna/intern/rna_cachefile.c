@@ -167,6 +167,15 @@ static void rna_def_cachefile(BlenderRNA *brna)
       "fit within the limit, rendering is aborted");
   RNA_def_property_update(prop, 0, "rna_CacheFile_update");
 
+  prop = RNA_def_property(srna, "stream_window", PROP_INT, PROP_UNSIGNED);
+  RNA_def_property_range(prop, 0, MAXFRAME);
+  RNA_def_property_ui_text(
+      prop,
+      "Stream Window",
+      "Number of frames the Cycles Procedural keeps in memory, loading the next frames in the "
+      "background during final renders with persistent data (0 to load the entire animation)");
+  RNA_def_property_update(prop, 0, "rna_CacheFile_update");
+
   /* ----------------- Axis Conversion ----------------- */
 
   prop = RNA_def_property(srna, "forward_axis", PROP_ENUM, PROP_NONE);
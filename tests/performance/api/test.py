@@ -24,6 +24,13 @@ class Test:
         """
         return False
 
+    def use_by_default(self) -> bool:
+        """
+        Test runs when its category matches a wildcard filter. Tests that return
+        False only run when their category is listed by name in the config.
+        """
+        return True
+
     @abc.abstractmethod
     def run(self, env, device_id: str) -> Dict:
         """
@@ -53,6 +60,8 @@ class TestCollection:
                         found = True
                 if not found:
                     continue
+                if not test.use_by_default() and test_category not in categories_filter:
+                    continue
 
                 test_name = test.name()
                 found = False
@@ -16,6 +16,7 @@ def _run(args):
     scene.render.filepath = args['render_filepath']
     scene.render.image_settings.file_format = 'PNG'
     scene.cycles.device = 'CPU' if device_type == 'CPU' else 'GPU'
+    scene.cycles.debug_use_cpu_split_kernel = args['use_split_kernel']
 
     if scene.cycles.device == 'GPU':
         # Enable specified GPU in preferences.
@@ -42,24 +43,31 @@ def _run(args):
 
 
 class CyclesTest(api.Test):
-    def __init__(self, filepath):
+    def __init__(self, filepath, use_split_kernel=False):
         self.filepath = filepath
+        self.use_split_kernel = use_split_kernel
 
     def name(self):
         return self.filepath.stem
 
     def category(self):
-        return "cycles"
+        return "cycles_split_kernel" if self.use_split_kernel else "cycles"
 
     def use_device(self):
         return True
 
+    def use_by_default(self):
+        # Split kernel benchmarks double the suite time, only run them when the
+        # config lists the cycles_split_kernel category.
+        return not self.use_split_kernel
+
     def run(self, env, device_id):
         tokens = device_id.split('_')
         device_type = tokens[0]
         device_index = int(tokens[1]) if len(tokens) > 1 else 0
         args = {'device_type': device_type,
                 'device_index': device_index,
+                'use_split_kernel': self.use_split_kernel,
                 'render_filepath': str(env.log_file.parent / (env.log_file.stem + '.png'))}
 
         _, lines = env.run_in_blender(_run, args, ['--debug-cycles', '--verbose', '1', self.filepath])
@@ -67,8 +75,10 @@ class CyclesTest(api.Test):
         # Parse render time from output
         prefix_time = "Render time (without synchronization): "
         prefix_memory = "Peak: "
+        prefix_samples_per_second = "Render samples per second: "
         time = None
         memory = None
+        samples_per_second = None
         for line in lines:
             line = line.strip()
             offset = line.find(prefix_time)
@@ -80,13 +90,24 @@ class CyclesTest(api.Test):
                 memory = line[offset + len(prefix_memory):]
                 memory = memory.split()[0].replace(',', '')
                 memory = float(memory)
+            offset = line.find(prefix_samples_per_second)
+            if offset != -1:
+                samples_per_second = line[offset + len(prefix_samples_per_second):]
+                samples_per_second = float(samples_per_second)
 
         if not (time and memory):
             raise Exception("Error parsing render time output")
 
-        return {'time': time, 'peak_memory': memory}
+        output = {'time': time, 'peak_memory': memory}
+        if samples_per_second:
+            output['samples_per_second'] = samples_per_second
+        return output
 
 
 def generate(env):
     filepaths = env.find_blend_files('cycles-x/*')
-    return [CyclesTest(filepath) for filepath in filepaths]
+    tests = [CyclesTest(filepath) for filepath in filepaths]
+    # Compare the megakernel against the CPU split kernel, which processes
+    # batches of rays through each integrator stage. Opt-in, see use_by_default().
+    tests += [CyclesTest(filepath, use_split_kernel=True) for filepath in filepaths]
+    return tests
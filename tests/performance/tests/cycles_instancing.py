@@ -0,0 +1,104 @@
+# Apache License, Version 2.0
+
+import api
+
+
+def _run(args):
+    import _cycles
+    import bpy
+    import math
+
+    num_instances = args['num_instances']
+
+    scene = bpy.context.scene
+    scene.render.engine = 'CYCLES'
+    scene.render.resolution_x = 64
+    scene.render.resolution_y = 64
+    scene.render.filepath = args['render_filepath']
+    scene.render.image_settings.file_format = 'PNG'
+    scene.cycles.device = 'CPU'
+    scene.cycles.samples = 1
+
+    # Forest of instances, an ico sphere on every vertex of a grid.
+    grid_size = int(math.ceil(math.sqrt(num_instances)))
+    coords = []
+    for i in range(num_instances):
+        coords += [(i % grid_size) - grid_size * 0.5, (i // grid_size) - grid_size * 0.5, 0.0]
+
+    mesh = bpy.data.meshes.new("Instancer")
+    mesh.vertices.add(num_instances)
+    mesh.vertices.foreach_set("co", coords)
+    mesh.update()
+
+    instancer = bpy.data.objects.new("Instancer", mesh)
+    instancer.instance_type = 'VERTS'
+    scene.collection.objects.link(instancer)
+
+    bpy.ops.mesh.primitive_ico_sphere_add(subdivisions=2, radius=0.4)
+    instance = bpy.context.active_object
+    instance.parent = instancer
+
+    camera = scene.camera
+    camera.location = (0.0, 0.0, grid_size * 1.5)
+    camera.rotation_euler = (0.0, 0.0, 0.0)
+
+    # Print the scene update statistics, to measure the time spent in the object and geometry
+    # managers next to the Blender synchronization.
+    _cycles.enable_print_stats()
+
+    bpy.ops.render.render(write_still=True)
+
+    return None
+
+
+class CyclesInstancingTest(api.Test):
+    def __init__(self, num_instances):
+        self.num_instances = num_instances
+
+    def name(self):
+        return f"instances_{self.num_instances}"
+
+    def category(self):
+        return "cycles_instancing"
+
+    def run(self, env, device_id):
+        args = {'num_instances': self.num_instances,
+                'render_filepath': str(env.log_file.parent / (env.log_file.stem + '.png'))}
+
+        _, lines = env.run_in_blender(_run, args, ['--debug-cycles', '--verbose', '1'])
+
+        # Parse synchronization time and scene update times from output. The update statistics
+        # list a total time for every manager, each under a line with the manager name.
+        prefix_sync_time = "Total time spent synchronizing data: "
+        prefix_update_time = "Total time: "
+        update_sections = {"Scene:": 'update_time',
+                           "Object:": 'object_update_time',
+                           "Geometry:": 'geometry_update_time'}
+        output = {'sync_time': None}
+        section = None
+        for line in lines:
+            offset = line.find(prefix_sync_time)
+            if offset != -1:
+                sync_time = float(line[offset + len(prefix_sync_time):].strip())
+                output['sync_time'] = (output['sync_time'] or 0.0) + sync_time
+                continue
+
+            if line and not line[0].isspace():
+                section = update_sections.get(line.strip())
+                continue
+
+            offset = line.find(prefix_update_time)
+            if section and offset != -1:
+                update_time = float(line[offset + len(prefix_update_time):].strip().rstrip('s'))
+                output[section] = output.get(section, 0.0) + update_time
+
+        if output['sync_time'] is None or 'update_time' not in output:
+            raise Exception("Error parsing synchronization time output")
+
+        output['time'] = output['sync_time'] + output['update_time']
+        return output
+
+
+def generate(env):
+    # Scene synchronization time for increasing numbers of instances of the same mesh.
+    return [CyclesInstancingTest(num_instances) for num_instances in (10000, 100000, 1000000)]